@@ -39,7 +39,8 @@ public class AugmentaUnreal : ModuleRules
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
-				"OSC"
+				"Networking",
+				"Sockets"
 			}
 			);
 		
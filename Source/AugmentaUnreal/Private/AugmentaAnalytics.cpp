@@ -0,0 +1,320 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaAnalytics.h"
+#include "AugmentaTracker.h"
+
+namespace AugmentaAnalytics
+{
+	/** The largest quantized coordinate, mapped to the bottom right of the scene. */
+	constexpr float MaxQuantized = 65535.f;
+
+	inline uint16 Quantize(double Value)
+	{
+		return static_cast<uint16>(FMath::RoundToInt32(FMath::Clamp(static_cast<float>(Value), 0.f, 1.f) * MaxQuantized));
+	}
+
+	inline FVector2f ToMeters(const FAugmentaPerson& Object, const FVector2D& SceneSize)
+	{
+		return FVector2f(Object.Centroid * SceneSize);
+	}
+}
+
+void FAugmentaTrajectoryStore::SetCapacity(int32 MaxObjects, int32 InSamplesPerObject)
+{
+	MaxObjects = FMath::Max(MaxObjects, 0);
+	SamplesPerObject = MaxObjects > 0 ? FMath::Max(InSamplesPerObject, 1) : 0;
+
+	Samples.Empty(MaxObjects * SamplesPerObject);
+	Samples.SetNumUninitialized(MaxObjects * SamplesPerObject);
+	FreeBlocks.Empty(MaxObjects);
+	Reset();
+}
+
+void FAugmentaTrajectoryStore::Reset()
+{
+	Trajectories.Reset();
+
+	// Hand out the blocks from the start of the pool
+	const int32 NumBlocks = SamplesPerObject > 0 ? Samples.Num() / SamplesPerObject : 0;
+	FreeBlocks.Reset();
+	for (int32 Block = NumBlocks - 1; Block >= 0; --Block)
+	{
+		FreeBlocks.Add(Block * SamplesPerObject);
+	}
+	DroppedTrajectories = 0;
+}
+
+bool FAugmentaTrajectoryStore::AddSample(int32 Pid, const FVector2D& Position, uint32 TimeMillis)
+{
+	using namespace AugmentaAnalytics;
+
+	int32 Slot = Trajectories.FindSlot(Pid);
+	if (Slot == INDEX_NONE)
+	{
+		if (FreeBlocks.Num() == 0)
+		{
+			++DroppedTrajectories;
+			return false;
+		}
+
+		bool bAdded;
+		Slot = Trajectories.FindOrAddSlot(Pid, bAdded);
+		FTrajectory& NewTrajectory = Trajectories.GetValue(Slot);
+		NewTrajectory.Block = FreeBlocks.Pop(false);
+		NewTrajectory.Head = 0;
+		NewTrajectory.Num = 0;
+	}
+
+	FTrajectory& Trajectory = Trajectories.GetValue(Slot);
+	FAugmentaTrajectorySample& Sample = Samples[Trajectory.Block + Trajectory.Head];
+	Sample.X = Quantize(Position.X);
+	Sample.Y = Quantize(Position.Y);
+	Sample.TimeMillis = TimeMillis;
+
+	Trajectory.Head = Trajectory.Head + 1 < SamplesPerObject ? Trajectory.Head + 1 : 0;
+	Trajectory.Num = FMath::Min(Trajectory.Num + 1, SamplesPerObject);
+	return true;
+}
+
+void FAugmentaTrajectoryStore::Remove(int32 Pid)
+{
+	FTrajectory Trajectory;
+	int32 Slot;
+	if (Trajectories.Remove(Pid, Trajectory, Slot))
+	{
+		FreeBlocks.Add(Trajectory.Block);
+	}
+}
+
+bool FAugmentaTrajectoryStore::GetTrajectory(int32 Pid, TArray<FVector2D>& OutPositions) const
+{
+	using namespace AugmentaAnalytics;
+
+	TConstArrayView<FAugmentaTrajectorySample> BlockSamples;
+	int32 Oldest;
+	if (!GetSamples(Pid, BlockSamples, Oldest))
+	{
+		OutPositions.Reset();
+		return false;
+	}
+
+	OutPositions.Reset(BlockSamples.Num());
+	for (int32 Index = 0; Index < BlockSamples.Num(); ++Index)
+	{
+		const FAugmentaTrajectorySample& Sample = BlockSamples[(Oldest + Index) % BlockSamples.Num()];
+		OutPositions.Emplace(Sample.X / MaxQuantized, Sample.Y / MaxQuantized);
+	}
+	return true;
+}
+
+bool FAugmentaTrajectoryStore::GetSamples(int32 Pid, TConstArrayView<FAugmentaTrajectorySample>& OutSamples, int32& OutOldest) const
+{
+	const FTrajectory* Trajectory = Trajectories.Find(Pid);
+	if (!Trajectory)
+	{
+		return false;
+	}
+
+	// Until the block is full, the oldest sample is the first one
+	OutSamples = TConstArrayView<FAugmentaTrajectorySample>(&Samples[Trajectory->Block], Trajectory->Num);
+	OutOldest = Trajectory->Num < SamplesPerObject ? 0 : Trajectory->Head;
+	return true;
+}
+
+FAugmentaAnalytics::FAugmentaAnalytics()
+{
+	Configure(0, 0, DwellBinDuration, 30);
+}
+
+void FAugmentaAnalytics::Configure(int32 MaxTrajectories, int32 TrajectoryLength, float InDwellBinDuration, int32 NumDwellBins)
+{
+	Trajectories.SetCapacity(MaxTrajectories, TrajectoryLength);
+	DwellBinDuration = FMath::Max(InDwellBinDuration, UE_KINDA_SMALL_NUMBER);
+	DwellHistogram.SetNumZeroed(FMath::Max(NumDwellBins, 1));
+	Reset();
+}
+
+void FAugmentaAnalytics::Reset()
+{
+	Visitors.Reset();
+	Trajectories.Reset();
+	StartTime = -1.0;
+
+	FMemory::Memzero(WindowEntries);
+	FMemory::Memzero(WindowExits);
+	WindowSecond = INDEX_NONE;
+	EntriesInWindow = 0;
+	ExitsInWindow = 0;
+
+	FMemory::Memzero(DwellHistogram.GetData(), DwellHistogram.Num() * sizeof(int64));
+	TotalVisitors = 0;
+	TotalLeft = 0;
+	TotalDwellTime = 0.0;
+	TotalPathLength = 0.0;
+	VelocitySum = FVector2D::ZeroVector;
+
+	LeftVisitors.Reset();
+}
+
+void FAugmentaAnalytics::ApplyEvents(const FAugmentaFrameEvents& Events, const FVector2D& SceneSize, double Time)
+{
+	if (StartTime < 0.0)
+	{
+		StartTime = Time;
+	}
+	Tick(Time);
+
+	LeftVisitors.Reset();
+	for (const FAugmentaEventRecord& Event : Events.Sequence)
+	{
+		switch (Event.Type)
+		{
+		case EAugmentaEventType::ObjectEntered:
+			AddVisitor(Events.EnteredObjects[Event.Index], SceneSize, Time);
+			break;
+		case EAugmentaEventType::ObjectUpdated:
+			UpdateVisitor(Events.UpdatedObjects[Event.Index], SceneSize, Time);
+			break;
+		case EAugmentaEventType::ObjectLeft:
+			RemoveVisitor(Events.LeftObjects[Event.Index], SceneSize, Time);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Do not let the rounding errors of the incremental sum outlive the crowd
+	if (Visitors.Num() == 0)
+	{
+		VelocitySum = FVector2D::ZeroVector;
+	}
+}
+
+void FAugmentaAnalytics::Tick(double Time)
+{
+	const int64 Second = FMath::FloorToInt64(Time);
+	if (WindowSecond == INDEX_NONE)
+	{
+		WindowSecond = Second;
+		return;
+	}
+
+	// Clear the seconds that left the window, at most the whole window
+	const int64 LastSecond = FMath::Min(Second, WindowSecond + WindowSeconds);
+	for (int64 ClearedSecond = WindowSecond + 1; ClearedSecond <= LastSecond; ++ClearedSecond)
+	{
+		const int32 Bucket = static_cast<int32>(ClearedSecond % WindowSeconds);
+		EntriesInWindow -= WindowEntries[Bucket];
+		ExitsInWindow -= WindowExits[Bucket];
+		WindowEntries[Bucket] = 0;
+		WindowExits[Bucket] = 0;
+	}
+	WindowSecond = FMath::Max(WindowSecond, Second);
+}
+
+FAugmentaAnalyticsSummary FAugmentaAnalytics::GetSummary() const
+{
+	FAugmentaAnalyticsSummary Summary;
+	Summary.TotalVisitors = TotalVisitors;
+	Summary.CurrentVisitors = Visitors.Num();
+	Summary.EntriesPerMinute = EntriesInWindow;
+	Summary.ExitsPerMinute = ExitsInWindow;
+	Summary.AverageDwellTime = TotalLeft > 0 ? static_cast<float>(TotalDwellTime / TotalLeft) : 0.f;
+	Summary.AverageSpeed = TotalDwellTime > 0.0 ? static_cast<float>(TotalPathLength / TotalDwellTime) : 0.f;
+	Summary.FlowVelocity = Visitors.Num() > 0 ? VelocitySum / Visitors.Num() : FVector2D::ZeroVector;
+	return Summary;
+}
+
+void FAugmentaAnalytics::AddVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time)
+{
+	bool bAdded;
+	FVisitor& Visitor = Visitors.FindOrAdd(Object.Pid, bAdded);
+	if (!bAdded)
+	{
+		// Entered again without having left, e.g. after a lost leave message
+		UpdateVisitor(Object, SceneSize, Time);
+		return;
+	}
+
+	Visitor = FVisitor();
+	Visitor.EnterTime = Time;
+	Visitor.LastTime = Time;
+	Visitor.EnterPosition = AugmentaAnalytics::ToMeters(Object, SceneSize);
+	Visitor.LastPosition = Visitor.EnterPosition;
+
+	++TotalVisitors;
+	++EntriesInWindow;
+	++WindowEntries[WindowSecond % WindowSeconds];
+
+	AddTrajectorySample(Object, Visitor, Time);
+}
+
+void FAugmentaAnalytics::UpdateVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time)
+{
+	FVisitor* Visitor = Visitors.Find(Object.Pid);
+	if (!Visitor)
+	{
+		// Already in the scene when the analytics started
+		AddVisitor(Object, SceneSize, Time);
+		return;
+	}
+
+	const FVector2f Position = AugmentaAnalytics::ToMeters(Object, SceneSize);
+	const FVector2f Delta = Position - Visitor->LastPosition;
+	Visitor->PathLength += Delta.Size();
+
+	// Several updates can share a receive time, the velocity only changes over a positive duration
+	const double Elapsed = Time - Visitor->LastTime;
+	if (Elapsed > 0.0)
+	{
+		const FVector2f Velocity = Delta / static_cast<float>(Elapsed);
+		VelocitySum += FVector2D(Velocity - Visitor->Velocity);
+		Visitor->Velocity = Velocity;
+		Visitor->LastTime = Time;
+	}
+	Visitor->LastPosition = Position;
+
+	AddTrajectorySample(Object, *Visitor, Time);
+}
+
+void FAugmentaAnalytics::RemoveVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time)
+{
+	FVisitor Visitor;
+	int32 Slot;
+	if (!Visitors.Remove(Object.Pid, Visitor, Slot))
+	{
+		return;
+	}
+	Trajectories.Remove(Object.Pid);
+
+	const FVector2f Position = AugmentaAnalytics::ToMeters(Object, SceneSize);
+	Visitor.PathLength += (Position - Visitor.LastPosition).Size();
+	VelocitySum -= FVector2D(Visitor.Velocity);
+
+	const double DwellTime = Time - Visitor.EnterTime;
+	const int32 Bin = FMath::Min(FMath::FloorToInt32(DwellTime / DwellBinDuration), DwellHistogram.Num() - 1);
+	++DwellHistogram[FMath::Max(Bin, 0)];
+
+	++TotalLeft;
+	TotalDwellTime += DwellTime;
+	TotalPathLength += Visitor.PathLength;
+	++ExitsInWindow;
+	++WindowExits[WindowSecond % WindowSeconds];
+
+	FAugmentaVisitorRecord& Record = LeftVisitors.AddDefaulted_GetRef();
+	Record.LeaveTime = Time - StartTime;
+	Record.Pid = Object.Pid;
+	Record.DwellTime = static_cast<float>(DwellTime);
+	Record.PathLength = Visitor.PathLength;
+	Record.AverageSpeed = DwellTime > 0.0 ? static_cast<float>(Visitor.PathLength / DwellTime) : 0.f;
+	Record.EnterX = Visitor.EnterPosition.X;
+	Record.EnterY = Visitor.EnterPosition.Y;
+	Record.LeaveX = Position.X;
+	Record.LeaveY = Position.Y;
+}
+
+void FAugmentaAnalytics::AddTrajectorySample(const FAugmentaPerson& Object, const FVisitor& Visitor, double Time)
+{
+	const uint32 TimeMillis = static_cast<uint32>(FMath::Max(Time - Visitor.EnterTime, 0.0) * 1000.0);
+	Trajectories.AddSample(Object.Pid, Object.Centroid, TimeMillis);
+}
@@ -0,0 +1,97 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaAnalyticsWriter.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+
+using namespace AugmentaAnalyticsStream;
+
+namespace AugmentaAnalyticsStream
+{
+	/** How long the thread waits for records before checking if it should stop, in milliseconds. */
+	constexpr uint32 WaitTimeMillis = 100;
+
+	const TCHAR* const CsvHeader = TEXT("LeaveTime,Pid,DwellTime,PathLength,AverageSpeed,EnterX,EnterY,LeaveX,LeaveY\n");
+
+	void WriteText(FArchive& Writer, const FString& Text)
+	{
+		FTCHARToUTF8 Utf8(*Text);
+		Writer.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+	}
+}
+
+FAugmentaAnalyticsWriter::FAugmentaAnalyticsWriter(TUniquePtr<FArchive> InWriter, bool bInBinary)
+	: Writer(MoveTemp(InWriter))
+	, bBinary(bInBinary)
+{
+	if (bBinary)
+	{
+		FFileHeader Header = { FileMagic, AugmentaAnalyticsStream::Version, sizeof(FAugmentaVisitorRecord), 0 };
+		Writer->Serialize(&Header, sizeof(Header));
+	}
+	else
+	{
+		WriteText(*Writer, CsvHeader);
+	}
+
+	WakeUpEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("AugmentaAnalyticsWriter"), 0, TPri_BelowNormal);
+}
+
+FAugmentaAnalyticsWriter::~FAugmentaAnalyticsWriter()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	// The thread is gone, write what it left in the queue
+	WriteQueuedRecords();
+	Writer->Close();
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeUpEvent);
+	WakeUpEvent = nullptr;
+}
+
+void FAugmentaAnalyticsWriter::Write(const FAugmentaVisitorRecord& Record)
+{
+	Queue.Enqueue(Record);
+	WakeUpEvent->Trigger();
+}
+
+uint32 FAugmentaAnalyticsWriter::Run()
+{
+	while (!bStopping)
+	{
+		WakeUpEvent->Wait(WaitTimeMillis);
+		WriteQueuedRecords();
+	}
+	return 0;
+}
+
+void FAugmentaAnalyticsWriter::Stop()
+{
+	bStopping = true;
+	WakeUpEvent->Trigger();
+}
+
+void FAugmentaAnalyticsWriter::WriteQueuedRecords()
+{
+	FAugmentaVisitorRecord Record;
+	while (Queue.Dequeue(Record))
+	{
+		if (bBinary)
+		{
+			Writer->Serialize(&Record, sizeof(Record));
+		}
+		else
+		{
+			WriteText(*Writer, FString::Printf(TEXT("%.3f,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),
+				Record.LeaveTime, Record.Pid, Record.DwellTime, Record.PathLength, Record.AverageSpeed,
+				Record.EnterX, Record.EnterY, Record.LeaveX, Record.LeaveY));
+		}
+	}
+}
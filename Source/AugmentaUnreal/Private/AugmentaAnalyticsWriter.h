@@ -0,0 +1,74 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaAnalytics.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+/** Forward Declarations */
+class FEvent;
+class FRunnableThread;
+
+/**
+ * The Augmenta visitor stream format : a header followed by one FAugmentaVisitorRecord per visitor, written as is.
+ * Every value is little endian. The CSV stream has one line per visitor with the same fields instead.
+ */
+namespace AugmentaAnalyticsStream
+{
+	/** "AUGV" */
+	constexpr uint32 FileMagic = 0x56475541;
+	constexpr uint32 Version = 1;
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 RecordSize;
+		uint32 Reserved;
+	};
+
+	static_assert(sizeof(FFileHeader) == 16 && sizeof(FAugmentaVisitorRecord) == 40, "The visitor stream structures are written as is.");
+}
+
+/**
+ * A thread writing the visitor records into a file, so that the game thread only queues them.
+ * The records are handed over through a lock-free single producer single consumer queue.
+ */
+class FAugmentaAnalyticsWriter : public FRunnable
+{
+public:
+	/**
+	 * Writes the header and starts the thread.
+	 *
+	 * @param InWriter The file to write the records into.
+	 * @param bInBinary Whether the records are written as binary records instead of CSV lines.
+	 */
+	FAugmentaAnalyticsWriter(TUniquePtr<FArchive> InWriter, bool bInBinary);
+	/** Writes the queued records, stops the thread and closes the file. */
+	virtual ~FAugmentaAnalyticsWriter();
+
+	/** Queues a record, from the thread that created the writer. */
+	void Write(const FAugmentaVisitorRecord& Record);
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable interface
+
+private:
+	/** Writes every queued record. */
+	void WriteQueuedRecords();
+
+	TUniquePtr<FArchive> Writer;
+	bool bBinary = false;
+
+	TQueue<FAugmentaVisitorRecord, EQueueMode::Spsc> Queue;
+	/** Wakes the thread up when records are queued. */
+	FEvent* WakeUpEvent = nullptr;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+};
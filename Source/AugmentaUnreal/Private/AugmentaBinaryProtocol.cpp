@@ -0,0 +1,294 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaBinaryProtocol.h"
+
+#include <cstring>
+
+namespace AugmentaBinaryProtocol
+{
+	// The records are the decoded messages themselves, made of 4 byte fields only
+	static_assert(sizeof(FAugmentaSceneMessage) == 4 * 4, "The scene record must be made of 4 byte fields.");
+	static_assert(sizeof(FAugmentaVideoOutputMessage) == 6 * 4, "The video output record must be made of 4 byte fields.");
+	static_assert(sizeof(FAugmentaObjectMessage) == 15 * 4, "The object record must be made of 4 byte fields.");
+	static_assert(sizeof(FAugmentaObjectExtraMessage) == 7 * 4, "The extra data record must be made of 4 byte fields.");
+
+	inline bool IsLittleEndian()
+	{
+		const uint32_t Value = 1;
+		uint8_t FirstByte;
+		memcpy(&FirstByte, &Value, 1);
+		return FirstByte == 1;
+	}
+
+	inline uint16_t ReadUInt16(const uint8_t* Data)
+	{
+		return static_cast<uint16_t>(Data[0] | (Data[1] << 8));
+	}
+
+	inline void WriteUInt16(uint8_t* Data, uint16_t Value)
+	{
+		Data[0] = static_cast<uint8_t>(Value);
+		Data[1] = static_cast<uint8_t>(Value >> 8);
+	}
+
+	/** Swaps the bytes of every 4 byte field, to convert a record from or to little endian on a big endian host. */
+	inline void SwapFields(uint8_t* Record, size_t RecordSize)
+	{
+		for (size_t Offset = 0; Offset + 4 <= RecordSize; Offset += 4)
+		{
+			uint8_t* Field = Record + Offset;
+			const uint8_t Byte0 = Field[0];
+			const uint8_t Byte1 = Field[1];
+			Field[0] = Field[3];
+			Field[1] = Field[2];
+			Field[2] = Byte1;
+			Field[3] = Byte0;
+		}
+	}
+
+	/** Returns the size of the records of a type, or 0 if the type has no record. */
+	inline size_t GetRecordSize(EAugmentaMessageType Type)
+	{
+		switch (Type)
+		{
+		case EAugmentaMessageType::Scene:
+			return sizeof(FAugmentaSceneMessage);
+		case EAugmentaMessageType::VideoOutput:
+			return sizeof(FAugmentaVideoOutputMessage);
+		case EAugmentaMessageType::ObjectEnter:
+		case EAugmentaMessageType::ObjectUpdate:
+		case EAugmentaMessageType::ObjectLeave:
+			return sizeof(FAugmentaObjectMessage);
+		case EAugmentaMessageType::ObjectExtraEnter:
+		case EAugmentaMessageType::ObjectExtraUpdate:
+		case EAugmentaMessageType::ObjectExtraLeave:
+			return sizeof(FAugmentaObjectExtraMessage);
+		default:
+			return 0;
+		}
+	}
+
+	/**
+	 * Returns a record as a message : in place when the host is little endian and the record is aligned,
+	 * otherwise copied into Scratch and converted.
+	 */
+	template <typename MessageType>
+	inline const MessageType& ReadRecord(const uint8_t* Record, MessageType& Scratch, bool& bOutInPlace)
+	{
+		bOutInPlace = IsLittleEndian() && (reinterpret_cast<uintptr_t>(Record) & (alignof(MessageType) - 1)) == 0;
+		if (bOutInPlace)
+		{
+			return *reinterpret_cast<const MessageType*>(Record);
+		}
+
+		memcpy(&Scratch, Record, sizeof(MessageType));
+		if (!IsLittleEndian())
+		{
+			SwapFields(reinterpret_cast<uint8_t*>(&Scratch), sizeof(MessageType));
+		}
+		return Scratch;
+	}
+}
+
+FAugmentaBinaryEncoder::FAugmentaBinaryEncoder(uint8_t* InBuffer, size_t InCapacity)
+	: Buffer(InBuffer)
+	, Capacity(InCapacity)
+{
+}
+
+void FAugmentaBinaryEncoder::Reset()
+{
+	Size = 0;
+	NumMessages = 0;
+	BlockOffset = 0;
+	BlockType = EAugmentaMessageType::Unknown;
+	BlockRecords = 0;
+}
+
+bool FAugmentaBinaryEncoder::WriteScene(const FAugmentaSceneMessage& Scene)
+{
+	return WriteRecord(EAugmentaMessageType::Scene, &Scene, sizeof(Scene));
+}
+
+bool FAugmentaBinaryEncoder::WriteVideoOutput(const FAugmentaVideoOutputMessage& VideoOutput)
+{
+	return WriteRecord(EAugmentaMessageType::VideoOutput, &VideoOutput, sizeof(VideoOutput));
+}
+
+bool FAugmentaBinaryEncoder::WriteObject(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object)
+{
+	if (Type != EAugmentaMessageType::ObjectEnter && Type != EAugmentaMessageType::ObjectUpdate && Type != EAugmentaMessageType::ObjectLeave)
+	{
+		return false;
+	}
+	return WriteRecord(Type, &Object, sizeof(Object));
+}
+
+bool FAugmentaBinaryEncoder::WriteObjectExtra(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra)
+{
+	if (Type != EAugmentaMessageType::ObjectExtraEnter && Type != EAugmentaMessageType::ObjectExtraUpdate && Type != EAugmentaMessageType::ObjectExtraLeave)
+	{
+		return false;
+	}
+	return WriteRecord(Type, &Extra, sizeof(Extra));
+}
+
+bool FAugmentaBinaryEncoder::WriteRecord(EAugmentaMessageType Type, const void* Record, size_t RecordSize)
+{
+	using namespace AugmentaBinaryProtocol;
+
+	const bool bNewPacket = Size == 0;
+	const bool bNewBlock = bNewPacket || Type != BlockType || BlockRecords == MaxRecordsPerBlock;
+	const size_t RequiredSize = (bNewPacket ? HeaderSize : 0) + (bNewBlock ? BlockHeaderSize : 0) + RecordSize;
+	if (RequiredSize > Capacity - Size)
+	{
+		return false;
+	}
+
+	if (bNewPacket)
+	{
+		memcpy(Buffer, Magic, sizeof(Magic));
+		WriteUInt16(Buffer + 4, Version);
+		WriteUInt16(Buffer + 6, static_cast<uint16_t>(HeaderSize));
+		Size = HeaderSize;
+	}
+
+	if (bNewBlock)
+	{
+		BlockOffset = Size;
+		BlockType = Type;
+		BlockRecords = 0;
+		Buffer[Size] = static_cast<uint8_t>(Type);
+		Buffer[Size + 1] = static_cast<uint8_t>(RecordSize);
+		Size += BlockHeaderSize;
+	}
+
+	uint8_t* Destination = Buffer + Size;
+	memcpy(Destination, Record, RecordSize);
+	if (!IsLittleEndian())
+	{
+		SwapFields(Destination, RecordSize);
+	}
+	Size += RecordSize;
+
+	WriteUInt16(Buffer + BlockOffset + 2, ++BlockRecords);
+	++NumMessages;
+	return true;
+}
+
+bool FAugmentaBinaryDecoder::IsBinaryPacket(const uint8_t* Data, size_t Size)
+{
+	return Size >= sizeof(AugmentaBinaryProtocol::Magic) && memcmp(Data, AugmentaBinaryProtocol::Magic, sizeof(AugmentaBinaryProtocol::Magic)) == 0;
+}
+
+bool FAugmentaBinaryDecoder::Decode(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener)
+{
+	using namespace AugmentaBinaryProtocol;
+
+	if (Size < HeaderSize || !IsBinaryPacket(Data, Size))
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+
+	const size_t PacketHeaderSize = ReadUInt16(Data + 6);
+	if (PacketHeaderSize < HeaderSize || PacketHeaderSize > Size || (PacketHeaderSize & 3) != 0)
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+
+	// Validate every block before forwarding anything
+	for (size_t Offset = PacketHeaderSize; Offset < Size;)
+	{
+		if (BlockHeaderSize > Size - Offset)
+		{
+			MalformedPackets.Increment();
+			return false;
+		}
+
+		const EAugmentaMessageType Type = static_cast<EAugmentaMessageType>(Data[Offset]);
+		const size_t RecordSize = Data[Offset + 1];
+		const size_t NumRecords = ReadUInt16(Data + Offset + 2);
+		const size_t KnownRecordSize = GetRecordSize(Type);
+		Offset += BlockHeaderSize;
+
+		if ((RecordSize & 3) != 0 || RecordSize < KnownRecordSize || RecordSize * NumRecords > Size - Offset)
+		{
+			MalformedPackets.Increment();
+			return false;
+		}
+		Offset += RecordSize * NumRecords;
+	}
+
+	for (size_t Offset = PacketHeaderSize; Offset < Size;)
+	{
+		const EAugmentaMessageType Type = static_cast<EAugmentaMessageType>(Data[Offset]);
+		const size_t RecordSize = Data[Offset + 1];
+		const size_t NumRecords = ReadUInt16(Data + Offset + 2);
+		Offset += BlockHeaderSize;
+
+		// The blocks of unknown types are skipped
+		if (GetRecordSize(Type) > 0)
+		{
+			DecodeBlock(Type, Data + Offset, RecordSize, NumRecords, Listener);
+		}
+		Offset += RecordSize * NumRecords;
+	}
+
+	PacketsDecoded.Increment();
+	return true;
+}
+
+void FAugmentaBinaryDecoder::ResetCounters()
+{
+	PacketsDecoded.Reset();
+	MessagesDecoded.Reset();
+	RecordsInPlace.Reset();
+	MalformedPackets.Reset();
+}
+
+void FAugmentaBinaryDecoder::DecodeBlock(EAugmentaMessageType Type, const uint8_t* Records, size_t RecordSize, size_t NumRecords, IAugmentaDecoderListener& Listener)
+{
+	using namespace AugmentaBinaryProtocol;
+
+	uint64_t NumInPlace = 0;
+	bool bInPlace = false;
+	for (size_t Index = 0; Index < NumRecords; ++Index)
+	{
+		const uint8_t* Record = Records + Index * RecordSize;
+		switch (Type)
+		{
+		case EAugmentaMessageType::Scene:
+		{
+			FAugmentaSceneMessage Scratch;
+			Listener.OnSceneDecoded(ReadRecord(Record, Scratch, bInPlace));
+			break;
+		}
+		case EAugmentaMessageType::VideoOutput:
+		{
+			FAugmentaVideoOutputMessage Scratch;
+			Listener.OnVideoOutputDecoded(ReadRecord(Record, Scratch, bInPlace));
+			break;
+		}
+		case EAugmentaMessageType::ObjectEnter:
+		case EAugmentaMessageType::ObjectUpdate:
+		case EAugmentaMessageType::ObjectLeave:
+		{
+			FAugmentaObjectMessage Scratch;
+			Listener.OnObjectDecoded(Type, ReadRecord(Record, Scratch, bInPlace));
+			break;
+		}
+		default:
+		{
+			FAugmentaObjectExtraMessage Scratch;
+			Listener.OnObjectExtraDecoded(Type, ReadRecord(Record, Scratch, bInPlace));
+			break;
+		}
+		}
+		NumInPlace += bInPlace;
+	}
+
+	MessagesDecoded.Increment(NumRecords);
+	RecordsInPlace.Increment(NumInPlace);
+}
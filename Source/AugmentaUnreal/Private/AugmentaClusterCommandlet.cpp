@@ -0,0 +1,124 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaClusterCommandlet.h"
+#include "AugmentaClusterProtocol.h"
+#include "AugmentaLoadGenerator.h"
+#include "AugmentaReceiver.h"
+#include "AugmentaUnreal.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+namespace AugmentaClusterCommandlet
+{
+	/** The hash of every HashInterval-th frame is logged. */
+	constexpr int32 HashInterval = 60;
+}
+
+UAugmentaClusterCommandlet::UAugmentaClusterCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Runs the primary or a secondary node of an Augmenta render cluster, logging the hash of its tracking state.");
+}
+
+int32 UAugmentaClusterCommandlet::Main(const FString& Params)
+{
+	FString Role;
+	FParse::Value(*Params, TEXT("Role="), Role);
+	const bool bPrimary = Role.Equals(TEXT("Primary"), ESearchCase::IgnoreCase);
+	if (!bPrimary && !Role.Equals(TEXT("Secondary"), ESearchCase::IgnoreCase))
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("-Role=Primary or -Role=Secondary is required."));
+		return 1;
+	}
+
+	FAugmentaLoadSettings Settings;
+	FParse::Value(*Params, TEXT("Objects="), Settings.ObjectCount);
+	FParse::Value(*Params, TEXT("FrameRate="), Settings.FrameRate);
+	FParse::Value(*Params, TEXT("Port="), Settings.Port);
+	FParse::Value(*Params, TEXT("Duration="), Settings.Duration);
+	FParse::Value(*Params, TEXT("TickRate="), Settings.TickRate);
+
+	FString ClusterAddress = TEXT("239.255.42.99");
+	int32 ClusterPort = 12100;
+	int32 KeyframeInterval = 60;
+	FParse::Value(*Params, TEXT("ClusterAddress="), ClusterAddress);
+	FParse::Value(*Params, TEXT("ClusterPort="), ClusterPort);
+	FParse::Value(*Params, TEXT("KeyframeInterval="), KeyframeInterval);
+
+	UAugmentaReceiver* Receiver = NewObject<UAugmentaReceiver>();
+	// Keep the receiver alive while it is ticked outside of the engine loop
+	Receiver->AddToRoot();
+	Receiver->bFrameAssembly = true;
+	if (bPrimary)
+	{
+		Receiver->Connect(FString(), Settings.Port);
+		Receiver->ClusterKeyframeInterval = KeyframeInterval;
+		if (Receiver->IsConnected() && !Receiver->StartClusterPublisher(ClusterAddress, ClusterPort))
+		{
+			Receiver->Stop();
+		}
+	}
+	else
+	{
+		// The tracker does not expire the objects of a cluster stream, whatever the timeouts
+		Receiver->Connect(ClusterAddress, ClusterPort);
+	}
+	if (!Receiver->IsConnected())
+	{
+		Receiver->RemoveFromRoot();
+		return 1;
+	}
+
+	// The primary is fed with the synthetic crowd of the load tests
+	TUniquePtr<FAugmentaLoadGenerator> Generator;
+	if (bPrimary && FParse::Param(*Params, TEXT("Generate")))
+	{
+		Generator = MakeUnique<FAugmentaLoadGenerator>(Settings);
+	}
+
+	int64 FramesHashed = 0;
+	const FDelegateHandle FrameHandle = Receiver->OnFrameNative.AddLambda([&FramesHashed](const FAugmentaFrameSnapshot& Snapshot, const FAugmentaFrameEvents&)
+	{
+		if (Snapshot.Frame % AugmentaClusterCommandlet::HashInterval == 0)
+		{
+			UE_LOG(LogAugmenta, Display, TEXT("Frame %d hash %08x, %d objects"), Snapshot.Frame, AugmentaClusterProtocol::HashSnapshot(Snapshot), Snapshot.Objects.Num());
+			++FramesHashed;
+		}
+	});
+
+	UE_LOG(LogAugmenta, Display, TEXT("Running the %s node for %.1f s, cluster %s:%d."), bPrimary ? TEXT("primary") : TEXT("secondary"), Settings.Duration, *ClusterAddress, ClusterPort);
+
+	const double TickInterval = 1.0 / FMath::Max(Settings.TickRate, 1.f);
+	const double EndTime = FPlatformTime::Seconds() + Settings.Duration;
+	double LastTickTime = FPlatformTime::Seconds();
+	while (LastTickTime < EndTime)
+	{
+		FPlatformProcess::Sleep(FMath::Max(static_cast<float>(LastTickTime + TickInterval - FPlatformTime::Seconds()), 0.f));
+		const double Now = FPlatformTime::Seconds();
+		Receiver->Tick(static_cast<float>(Now - LastTickTime));
+		LastTickTime = Now;
+	}
+
+	Generator.Reset();
+	const FAugmentaReceiverCounters Counters = Receiver->GetCounters();
+	TArray<FString> Lines;
+	Counters.ToString().ParseIntoArrayLines(Lines);
+	for (const FString& Line : Lines)
+	{
+		UE_LOG(LogAugmenta, Display, TEXT("%s"), *Line);
+	}
+
+	Receiver->OnFrameNative.Remove(FrameHandle);
+	Receiver->Stop();
+	Receiver->RemoveFromRoot();
+
+	if (FramesHashed == 0)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("The node did not hold any frame to hash."));
+		return 1;
+	}
+	return 0;
+}
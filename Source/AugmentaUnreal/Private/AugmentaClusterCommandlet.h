@@ -0,0 +1,31 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AugmentaClusterCommandlet.generated.h"
+
+/**
+ * Runs one node of a render cluster on its own, so that a primary and several secondaries can be run as separate processes
+ * on the same host (see UAugmentaReceiver::StartClusterPublisher). Every node logs the hash of the tracking state of every
+ * 60th Augmenta frame it holds : the secondaries log the same hashes as the primary for the frames they applied.
+ *
+ * The primary listens to Port, optionally fed by a synthetic crowd sent over the loopback, and publishes to the cluster address.
+ * The secondaries listen to the cluster address.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=AugmentaCluster -Role=Primary|Secondary [-Generate] [-Objects=100] [-FrameRate=60]
+ *     [-Port=12000] [-ClusterAddress=239.255.42.99] [-ClusterPort=12100] [-KeyframeInterval=60] [-Duration=10] [-TickRate=60]
+ */
+UCLASS()
+class UAugmentaClusterCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaClusterCommandlet();
+
+	//~ Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet interface
+};
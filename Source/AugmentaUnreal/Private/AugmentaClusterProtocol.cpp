@@ -0,0 +1,848 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaClusterProtocol.h"
+#include "AugmentaTracker.h"
+#include "Misc/Crc.h"
+
+namespace AugmentaClusterProtocol
+{
+	/** How a quantized field is written. */
+	enum class EFieldKind : uint8
+	{
+		VarInt,
+		Int16,
+		UInt16,
+		Int32,
+	};
+
+	const EFieldKind ObjectFieldKinds[NumObjectFields] = {
+		EFieldKind::VarInt, // Oid
+		EFieldKind::VarInt, // Age
+		EFieldKind::Int16, // CentroidX
+		EFieldKind::Int16, // CentroidY
+		EFieldKind::Int16, // VelocityX
+		EFieldKind::Int16, // VelocityY
+		EFieldKind::UInt16, // Orientation
+		EFieldKind::Int16, // BoundingRectPosX
+		EFieldKind::Int16, // BoundingRectPosY
+		EFieldKind::Int16, // BoundingRectSizeX
+		EFieldKind::Int16, // BoundingRectSizeY
+		EFieldKind::UInt16, // BoundingRectRotation
+		EFieldKind::Int16, // Height
+	};
+
+	const EFieldKind ExtraFieldKinds[NumExtraFields] = {
+		EFieldKind::VarInt, // Oid
+		EFieldKind::Int16, // HighestX
+		EFieldKind::Int16, // HighestY
+		EFieldKind::Int16, // Distance
+		EFieldKind::Int32, // Reflectivity
+	};
+
+	constexpr uint32 AllObjectFields = (1u << NumObjectFields) - 1;
+	constexpr uint32 AllExtraFields = (1u << NumExtraFields) - 1;
+
+	/** How many frames late a keyframe can be, an older one is taken for a primary whose restart frame was lost. */
+	constexpr int32 MaxLateFrames = 64;
+
+	/** The normalized positions and sizes, up to two scenes away from the origin. */
+	constexpr float PositionScale = 16000.f;
+	/** The normalized velocities. */
+	constexpr float VelocityScale = 1000.f;
+	/** The heights and distances, to the mm. */
+	constexpr float LengthScale = 1000.f;
+	/** The ages, to the tenth of a second so that a standing object is not updated every frame. */
+	constexpr float AgeScale = 10.f;
+
+	int32 QuantizeInt16(float Value, float Scale)
+	{
+		return FMath::Clamp(FMath::RoundToInt(FMath::Clamp(Value * Scale, -32768.f, 32767.f)), -32768, 32767);
+	}
+
+	int32 QuantizeAngle(float Degrees)
+	{
+		return FMath::RoundToInt(FMath::Fmod(Degrees, 360.f) * (65536.f / 360.f)) & 0xFFFF;
+	}
+
+	float DequantizeAngle(int32 Value)
+	{
+		return Value * (360.f / 65536.f);
+	}
+
+	int32 QuantizeFloat(float Value)
+	{
+		int32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	float DequantizeFloat(int32 Bits)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	void QuantizeObject(const FAugmentaPerson& Object, int32* Fields)
+	{
+		Fields[static_cast<int32>(EObjectField::Oid)] = Object.Oid;
+		Fields[static_cast<int32>(EObjectField::Age)] = FMath::RoundToInt(FMath::Clamp(Object.Age * AgeScale, -1e9f, 1e9f));
+		Fields[static_cast<int32>(EObjectField::CentroidX)] = QuantizeInt16(Object.Centroid.X, PositionScale);
+		Fields[static_cast<int32>(EObjectField::CentroidY)] = QuantizeInt16(Object.Centroid.Y, PositionScale);
+		Fields[static_cast<int32>(EObjectField::VelocityX)] = QuantizeInt16(Object.Velocity.X, VelocityScale);
+		Fields[static_cast<int32>(EObjectField::VelocityY)] = QuantizeInt16(Object.Velocity.Y, VelocityScale);
+		Fields[static_cast<int32>(EObjectField::Orientation)] = QuantizeAngle(Object.Orientation);
+		Fields[static_cast<int32>(EObjectField::BoundingRectPosX)] = QuantizeInt16(Object.BoundingRectPos.X, PositionScale);
+		Fields[static_cast<int32>(EObjectField::BoundingRectPosY)] = QuantizeInt16(Object.BoundingRectPos.Y, PositionScale);
+		Fields[static_cast<int32>(EObjectField::BoundingRectSizeX)] = QuantizeInt16(Object.BoundingRectSize.X, PositionScale);
+		Fields[static_cast<int32>(EObjectField::BoundingRectSizeY)] = QuantizeInt16(Object.BoundingRectSize.Y, PositionScale);
+		Fields[static_cast<int32>(EObjectField::BoundingRectRotation)] = QuantizeAngle(Object.BoundingRectRotation);
+		Fields[static_cast<int32>(EObjectField::Height)] = QuantizeInt16(Object.Height, LengthScale);
+	}
+
+	void ToObjectMessage(int32 Pid, int32 Frame, const int32* Fields, FAugmentaObjectMessage& Message)
+	{
+		Message.Frame = Frame;
+		Message.Pid = Pid;
+		Message.Oid = Fields[static_cast<int32>(EObjectField::Oid)];
+		Message.Age = Fields[static_cast<int32>(EObjectField::Age)] / AgeScale;
+		Message.CentroidX = Fields[static_cast<int32>(EObjectField::CentroidX)] / PositionScale;
+		Message.CentroidY = Fields[static_cast<int32>(EObjectField::CentroidY)] / PositionScale;
+		Message.VelocityX = Fields[static_cast<int32>(EObjectField::VelocityX)] / VelocityScale;
+		Message.VelocityY = Fields[static_cast<int32>(EObjectField::VelocityY)] / VelocityScale;
+		Message.Orientation = DequantizeAngle(Fields[static_cast<int32>(EObjectField::Orientation)]);
+		Message.BoundingRectPosX = Fields[static_cast<int32>(EObjectField::BoundingRectPosX)] / PositionScale;
+		Message.BoundingRectPosY = Fields[static_cast<int32>(EObjectField::BoundingRectPosY)] / PositionScale;
+		Message.BoundingRectSizeX = Fields[static_cast<int32>(EObjectField::BoundingRectSizeX)] / PositionScale;
+		Message.BoundingRectSizeY = Fields[static_cast<int32>(EObjectField::BoundingRectSizeY)] / PositionScale;
+		Message.BoundingRectRotation = DequantizeAngle(Fields[static_cast<int32>(EObjectField::BoundingRectRotation)]);
+		Message.Height = Fields[static_cast<int32>(EObjectField::Height)] / LengthScale;
+	}
+
+	void QuantizeExtra(const FAugmentaObjectExtra& Extra, int32* Fields)
+	{
+		Fields[static_cast<int32>(EExtraField::Oid)] = Extra.Oid;
+		Fields[static_cast<int32>(EExtraField::HighestX)] = QuantizeInt16(Extra.Highest.X, PositionScale);
+		Fields[static_cast<int32>(EExtraField::HighestY)] = QuantizeInt16(Extra.Highest.Y, PositionScale);
+		Fields[static_cast<int32>(EExtraField::Distance)] = QuantizeInt16(Extra.Distance, LengthScale);
+		Fields[static_cast<int32>(EExtraField::Reflectivity)] = QuantizeFloat(Extra.Reflectivity);
+	}
+
+	void ToExtraMessage(int32 Id, int32 Frame, const int32* Fields, FAugmentaObjectExtraMessage& Message)
+	{
+		Message.Frame = Frame;
+		Message.Id = Id;
+		Message.Oid = Fields[static_cast<int32>(EExtraField::Oid)];
+		Message.HighestX = Fields[static_cast<int32>(EExtraField::HighestX)] / PositionScale;
+		Message.HighestY = Fields[static_cast<int32>(EExtraField::HighestY)] / PositionScale;
+		Message.Distance = Fields[static_cast<int32>(EExtraField::Distance)] / LengthScale;
+		Message.Reflectivity = DequantizeFloat(Fields[static_cast<int32>(EExtraField::Reflectivity)]);
+	}
+
+	void WriteUInt16At(uint8* Data, uint16 Value)
+	{
+		Data[0] = static_cast<uint8>(Value);
+		Data[1] = static_cast<uint8>(Value >> 8);
+	}
+
+	void WriteUInt32At(uint8* Data, uint32 Value)
+	{
+		WriteUInt16At(Data, static_cast<uint16>(Value));
+		WriteUInt16At(Data + 2, static_cast<uint16>(Value >> 16));
+	}
+
+	uint16 ReadUInt16At(const uint8* Data)
+	{
+		return static_cast<uint16>(Data[0] | (Data[1] << 8));
+	}
+
+	uint32 ReadUInt32At(const uint8* Data)
+	{
+		return ReadUInt16At(Data) | (static_cast<uint32>(ReadUInt16At(Data + 2)) << 16);
+	}
+
+	void WriteVarInt(TArray<uint8>& Out, int32 Value)
+	{
+		uint32 ZigZag = (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+		while (ZigZag >= 0x80)
+		{
+			Out.Add(static_cast<uint8>(ZigZag | 0x80));
+			ZigZag >>= 7;
+		}
+		Out.Add(static_cast<uint8>(ZigZag));
+	}
+
+	void WriteField(TArray<uint8>& Out, EFieldKind Kind, int32 Value)
+	{
+		switch (Kind)
+		{
+		case EFieldKind::VarInt:
+			WriteVarInt(Out, Value);
+			break;
+		case EFieldKind::Int16:
+		case EFieldKind::UInt16:
+			WriteUInt16At(&Out[Out.AddUninitialized(2)], static_cast<uint16>(Value));
+			break;
+		case EFieldKind::Int32:
+			WriteUInt32At(&Out[Out.AddUninitialized(4)], static_cast<uint32>(Value));
+			break;
+		}
+	}
+
+	/** Reads the records of a packet, failing on the first read past its end. */
+	struct FReader
+	{
+		const uint8* Data;
+		int32 Size;
+		int32 Offset = 0;
+		bool bError = false;
+
+		FReader(const uint8* InData, int32 InSize)
+			: Data(InData)
+			, Size(InSize)
+		{
+		}
+
+		bool IsDone() const { return bError || Offset == Size; }
+
+		bool CanRead(int32 NumBytes)
+		{
+			bError |= NumBytes > Size - Offset;
+			return !bError;
+		}
+
+		uint8 ReadUInt8()
+		{
+			return CanRead(1) ? Data[Offset++] : 0;
+		}
+
+		uint16 ReadUInt16()
+		{
+			if (!CanRead(2))
+			{
+				return 0;
+			}
+			Offset += 2;
+			return ReadUInt16At(Data + Offset - 2);
+		}
+
+		uint32 ReadUInt32()
+		{
+			if (!CanRead(4))
+			{
+				return 0;
+			}
+			Offset += 4;
+			return ReadUInt32At(Data + Offset - 4);
+		}
+
+		int32 ReadVarInt()
+		{
+			uint32 ZigZag = 0;
+			for (int32 Shift = 0; Shift < 35 && CanRead(1); Shift += 7)
+			{
+				const uint8 Byte = Data[Offset++];
+				ZigZag |= static_cast<uint32>(Byte & 0x7F) << Shift;
+				if ((Byte & 0x80) == 0)
+				{
+					return static_cast<int32>(ZigZag >> 1) ^ -static_cast<int32>(ZigZag & 1);
+				}
+			}
+			bError = true;
+			return 0;
+		}
+
+		float ReadFloat()
+		{
+			return DequantizeFloat(static_cast<int32>(ReadUInt32()));
+		}
+
+		int32 ReadField(EFieldKind Kind)
+		{
+			switch (Kind)
+			{
+			case EFieldKind::VarInt:
+				return ReadVarInt();
+			case EFieldKind::Int16:
+				return static_cast<int16>(ReadUInt16());
+			case EFieldKind::UInt16:
+				return ReadUInt16();
+			default:
+				return static_cast<int32>(ReadUInt32());
+			}
+		}
+	};
+
+	uint32 HashSnapshot(const FAugmentaFrameSnapshot& Snapshot)
+	{
+		// A sum of the hashes of the objects, so that it does not depend on their order
+		uint32 Hash = 0;
+		int32 Fields[NumObjectFields];
+		for (const FAugmentaPerson& Object : Snapshot.Objects.GetObjects())
+		{
+			QuantizeObject(Object, Fields);
+			Hash += FCrc::MemCrc32(Fields, sizeof(Fields), static_cast<uint32>(Object.Pid));
+		}
+		int32 ExtraFields[NumExtraFields];
+		for (const FAugmentaObjectExtra& Extra : Snapshot.ObjectExtras.GetExtras())
+		{
+			QuantizeExtra(Extra, ExtraFields);
+			Hash += FCrc::MemCrc32(ExtraFields, sizeof(ExtraFields), ~static_cast<uint32>(Extra.Id));
+		}
+		return Hash;
+	}
+}
+
+FAugmentaClusterEncoder::FAugmentaClusterEncoder(int32 InMaxPacketSize, int32 InKeyframeInterval)
+	: MaxPacketSize(FMath::Max(InMaxPacketSize, AugmentaClusterProtocol::HeaderSize + 128))
+	, KeyframeInterval(FMath::Max(InKeyframeInterval, 1))
+{
+}
+
+void FAugmentaClusterEncoder::Reset()
+{
+	Objects.Reset();
+	Extras.Reset();
+	VideoOutput = FAugmentaVideoOutputMessage();
+	bHasState = false;
+	FramesSinceKeyframe = 0;
+}
+
+void FAugmentaClusterEncoder::Encode(const FAugmentaFrameSnapshot& Snapshot)
+{
+	using namespace AugmentaClusterProtocol;
+
+	const bool bRestart = !bHasState;
+	const bool bKeyframe = bRestart || ++FramesSinceKeyframe >= KeyframeInterval;
+	if (bKeyframe)
+	{
+		FramesSinceKeyframe = 0;
+	}
+	bHasState = true;
+
+	const uint32 BaseSequence = Sequence++;
+	PacketData.Reset();
+	PacketOffsets.Reset();
+
+	// The scene is sent with every frame, it holds the number of objects
+	Record.Reset();
+	Record.Add(static_cast<uint8>(EAugmentaMessageType::Scene));
+	WriteVarInt(Record, Snapshot.Scene.NumPeople);
+	WriteField(Record, EFieldKind::Int32, QuantizeFloat(Snapshot.Scene.SceneSize.X));
+	WriteField(Record, EFieldKind::Int32, QuantizeFloat(Snapshot.Scene.SceneSize.Y));
+	CommitRecord();
+
+	FAugmentaVideoOutputMessage NewVideoOutput;
+	NewVideoOutput.OffsetX = Snapshot.VideoOutput.Offset.X;
+	NewVideoOutput.OffsetY = Snapshot.VideoOutput.Offset.Y;
+	NewVideoOutput.SizeX = Snapshot.VideoOutput.Size.X;
+	NewVideoOutput.SizeY = Snapshot.VideoOutput.Size.Y;
+	NewVideoOutput.ResolutionX = Snapshot.VideoOutput.Resolution.X;
+	NewVideoOutput.ResolutionY = Snapshot.VideoOutput.Resolution.Y;
+	const FAugmentaVideoOutputMessage DefaultVideoOutput;
+	const bool bVideoOutputChanged = FMemory::Memcmp(&NewVideoOutput, &VideoOutput, sizeof(VideoOutput)) != 0;
+	if (bVideoOutputChanged || (bKeyframe && FMemory::Memcmp(&NewVideoOutput, &DefaultVideoOutput, sizeof(VideoOutput)) != 0))
+	{
+		VideoOutput = NewVideoOutput;
+		Record.Reset();
+		Record.Add(static_cast<uint8>(EAugmentaMessageType::VideoOutput));
+		WriteField(Record, EFieldKind::Int32, QuantizeFloat(VideoOutput.OffsetX));
+		WriteField(Record, EFieldKind::Int32, QuantizeFloat(VideoOutput.OffsetY));
+		WriteField(Record, EFieldKind::Int32, QuantizeFloat(VideoOutput.SizeX));
+		WriteField(Record, EFieldKind::Int32, QuantizeFloat(VideoOutput.SizeY));
+		WriteVarInt(Record, VideoOutput.ResolutionX);
+		WriteVarInt(Record, VideoOutput.ResolutionY);
+		CommitRecord();
+	}
+
+	// The new objects and the keyframes hold every field, the updates only the fields that changed once quantized
+	int32 Fields[NumObjectFields];
+	for (const FAugmentaPerson& Object : Snapshot.Objects.GetObjects())
+	{
+		QuantizeObject(Object, Fields);
+
+		bool bAdded;
+		FObjectState& State = Objects.FindOrAdd(Object.Pid, bAdded);
+		State.Sequence = Sequence;
+		const bool bFull = bAdded || bKeyframe;
+		uint32 Mask = bFull ? AllObjectFields : 0;
+		for (int32 Field = 0; Field < NumObjectFields && !bFull; ++Field)
+		{
+			Mask |= State.Fields[Field] != Fields[Field] ? 1u << Field : 0;
+		}
+		if (Mask == 0)
+		{
+			continue;
+		}
+		FMemory::Memcpy(State.Fields, Fields, sizeof(Fields));
+
+		Record.Reset();
+		Record.Add(static_cast<uint8>(bFull ? EAugmentaMessageType::ObjectEnter : EAugmentaMessageType::ObjectUpdate));
+		WriteVarInt(Record, Object.Pid);
+		if (!bFull)
+		{
+			WriteField(Record, EFieldKind::UInt16, static_cast<int32>(Mask));
+		}
+		for (int32 Field = 0; Field < NumObjectFields; ++Field)
+		{
+			if (Mask & (1u << Field))
+			{
+				WriteField(Record, ObjectFieldKinds[Field], Fields[Field]);
+			}
+		}
+		CommitRecord();
+	}
+
+	// The objects the snapshot does not hold anymore left
+	LeftIds.Reset();
+	for (int32 Slot = 0; Slot < Objects.Num(); ++Slot)
+	{
+		if (Objects.GetValue(Slot).Sequence != Sequence)
+		{
+			LeftIds.Add(Objects.GetIds()[Slot]);
+		}
+	}
+	for (const int32 Pid : LeftIds)
+	{
+		FObjectState Removed;
+		int32 RemovedSlot;
+		Objects.Remove(Pid, Removed, RemovedSlot);
+
+		Record.Reset();
+		Record.Add(static_cast<uint8>(EAugmentaMessageType::ObjectLeave));
+		WriteVarInt(Record, Pid);
+		CommitRecord();
+	}
+
+	int32 ExtraFields[NumExtraFields];
+	for (const FAugmentaObjectExtra& Extra : Snapshot.ObjectExtras.GetExtras())
+	{
+		QuantizeExtra(Extra, ExtraFields);
+
+		bool bAdded;
+		FExtraState& State = Extras.FindOrAdd(Extra.Id, bAdded);
+		State.Sequence = Sequence;
+		const bool bFull = bAdded || bKeyframe;
+		uint32 Mask = bFull ? AllExtraFields : 0;
+		for (int32 Field = 0; Field < NumExtraFields && !bFull; ++Field)
+		{
+			Mask |= State.Fields[Field] != ExtraFields[Field] ? 1u << Field : 0;
+		}
+		if (Mask == 0)
+		{
+			continue;
+		}
+		FMemory::Memcpy(State.Fields, ExtraFields, sizeof(ExtraFields));
+
+		Record.Reset();
+		Record.Add(static_cast<uint8>(bFull ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectExtraUpdate));
+		WriteVarInt(Record, Extra.Id);
+		if (!bFull)
+		{
+			Record.Add(static_cast<uint8>(Mask));
+		}
+		for (int32 Field = 0; Field < NumExtraFields; ++Field)
+		{
+			if (Mask & (1u << Field))
+			{
+				WriteField(Record, ExtraFieldKinds[Field], ExtraFields[Field]);
+			}
+		}
+		CommitRecord();
+	}
+
+	LeftIds.Reset();
+	for (int32 Slot = 0; Slot < Extras.Num(); ++Slot)
+	{
+		if (Extras.GetValue(Slot).Sequence != Sequence)
+		{
+			LeftIds.Add(Extras.GetIds()[Slot]);
+		}
+	}
+	for (const int32 Id : LeftIds)
+	{
+		FExtraState Removed;
+		int32 RemovedSlot;
+		Extras.Remove(Id, Removed, RemovedSlot);
+
+		Record.Reset();
+		Record.Add(static_cast<uint8>(EAugmentaMessageType::ObjectExtraLeave));
+		WriteVarInt(Record, Id);
+		CommitRecord();
+	}
+
+	// The number of packets is only known once every record is written
+	const int32 NumPackets = PacketOffsets.Num();
+	for (int32 PacketIndex = 0; PacketIndex < NumPackets; ++PacketIndex)
+	{
+		uint8* Header = PacketData.GetData() + PacketOffsets[PacketIndex];
+		FMemory::Memcpy(Header, Magic, sizeof(Magic));
+		WriteUInt16At(Header + 4, Version);
+		Header[6] = (bKeyframe ? KeyframeFlag : 0) | (bRestart ? RestartFlag : 0);
+		Header[7] = 0;
+		WriteUInt32At(Header + 8, Sequence);
+		WriteUInt32At(Header + 12, BaseSequence);
+		WriteUInt32At(Header + 16, static_cast<uint32>(Snapshot.Frame));
+		WriteUInt16At(Header + 20, static_cast<uint16>(PacketIndex));
+		WriteUInt16At(Header + 22, static_cast<uint16>(NumPackets));
+	}
+}
+
+TConstArrayView<uint8> FAugmentaClusterEncoder::GetPacket(int32 Index) const
+{
+	const int32 Begin = PacketOffsets[Index];
+	const int32 End = Index + 1 < PacketOffsets.Num() ? PacketOffsets[Index + 1] : PacketData.Num();
+	return TConstArrayView<uint8>(PacketData.GetData() + Begin, End - Begin);
+}
+
+void FAugmentaClusterEncoder::CommitRecord()
+{
+	// The header is written once the number of packets is known
+	if (PacketOffsets.Num() == 0 || PacketData.Num() - PacketOffsets.Last() + Record.Num() > MaxPacketSize)
+	{
+		PacketOffsets.Add(PacketData.Num());
+		PacketData.AddZeroed(AugmentaClusterProtocol::HeaderSize);
+	}
+	PacketData.Append(Record);
+}
+
+bool FAugmentaClusterDecoder::IsClusterPacket(const uint8* Data, int32 Size)
+{
+	return Size >= static_cast<int32>(sizeof(AugmentaClusterProtocol::Magic))
+		&& FMemory::Memcmp(Data, AugmentaClusterProtocol::Magic, sizeof(AugmentaClusterProtocol::Magic)) == 0;
+}
+
+void FAugmentaClusterDecoder::Reset()
+{
+	bAssembling = false;
+	bSynchronized = false;
+	Objects.Reset();
+	Extras.Reset();
+}
+
+bool FAugmentaClusterDecoder::Decode(const uint8* Data, int32 Size, IAugmentaDecoderListener& Listener)
+{
+	using namespace AugmentaClusterProtocol;
+
+	if (Size < HeaderSize || !IsClusterPacket(Data, Size) || ReadUInt16At(Data + 4) != Version)
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+
+	const bool bKeyframe = (Data[6] & KeyframeFlag) != 0;
+	const bool bRestart = (Data[6] & RestartFlag) != 0;
+	const uint32 PacketSequence = ReadUInt32At(Data + 8);
+	const uint32 BaseSequence = ReadUInt32At(Data + 12);
+	const int32 Frame = static_cast<int32>(ReadUInt32At(Data + 16));
+	const int32 PacketIndex = ReadUInt16At(Data + 20);
+	const int32 NumPackets = ReadUInt16At(Data + 22);
+	if (PacketIndex >= NumPackets)
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+
+	// The late packets of a frame already applied or given up are ignored. A late sequence only resynchronizes on the restart
+	// frame of the primary, or on a keyframe far behind if that frame was lost, never on a late delta.
+	if (bAssembling || bSynchronized)
+	{
+		const int32 Lateness = static_cast<int32>((bAssembling ? AssemblingSequence : AppliedSequence) - PacketSequence);
+		if (Lateness > 0 && (bRestart || (bKeyframe && Lateness > MaxLateFrames)))
+		{
+			bAssembling = false;
+			bSynchronized = false;
+		}
+		else if (Lateness > 0 || (Lateness == 0 && !bAssembling))
+		{
+			return false;
+		}
+	}
+
+	if (bAssembling && PacketSequence != AssemblingSequence)
+	{
+		// The frame being assembled lost a packet
+		FramesDropped.Increment();
+		bAssembling = false;
+	}
+
+	if (!bAssembling)
+	{
+		bAssembling = true;
+		AssemblingSequence = PacketSequence;
+		AssemblingBaseSequence = BaseSequence;
+		AssemblingFrame = Frame;
+		bAssemblingKeyframe = bKeyframe;
+		Packets.SetNum(NumPackets);
+		for (TArray<uint8>& Packet : Packets)
+		{
+			Packet.Reset();
+		}
+		ReceivedPackets.Init(false, NumPackets);
+		NumReceivedPackets = 0;
+	}
+	else if (NumPackets != Packets.Num())
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+
+	if (ReceivedPackets[PacketIndex])
+	{
+		return false;
+	}
+	ReceivedPackets[PacketIndex] = true;
+	++NumReceivedPackets;
+	Packets[PacketIndex].Append(Data + HeaderSize, Size - HeaderSize);
+	if (NumReceivedPackets < Packets.Num())
+	{
+		return false;
+	}
+	bAssembling = false;
+
+	// A delta only applies on top of its base frame, otherwise the next keyframe is awaited
+	if (!bAssemblingKeyframe && (!bSynchronized || AppliedSequence != AssemblingBaseSequence))
+	{
+		bSynchronized = false;
+		FramesDropped.Increment();
+		return false;
+	}
+
+	// Validate every record before applying anything
+	if (!ReadFrame(nullptr))
+	{
+		bSynchronized = false;
+		MalformedPackets.Increment();
+		FramesDropped.Increment();
+		return false;
+	}
+
+	ReadFrame(&Listener);
+	AppliedSequence = AssemblingSequence;
+	bSynchronized = true;
+	FramesApplied.Increment();
+	return true;
+}
+
+void FAugmentaClusterDecoder::ResetCounters()
+{
+	FramesApplied.Reset();
+	FramesDropped.Reset();
+	MalformedPackets.Reset();
+}
+
+bool FAugmentaClusterDecoder::ReadFrame(IAugmentaDecoderListener* Listener)
+{
+	using namespace AugmentaClusterProtocol;
+
+	for (const TArray<uint8>& Packet : Packets)
+	{
+		FReader Reader(Packet.GetData(), Packet.Num());
+		while (!Reader.IsDone())
+		{
+			const EAugmentaMessageType Type = static_cast<EAugmentaMessageType>(Reader.ReadUInt8());
+			switch (Type)
+			{
+			case EAugmentaMessageType::Scene:
+			{
+				FAugmentaSceneMessage Message;
+				Message.Frame = AssemblingFrame;
+				Message.ObjectCount = Reader.ReadVarInt();
+				Message.SizeX = Reader.ReadFloat();
+				Message.SizeY = Reader.ReadFloat();
+				if (Listener && !Reader.bError)
+				{
+					Listener->OnSceneDecoded(Message);
+				}
+				break;
+			}
+			case EAugmentaMessageType::VideoOutput:
+			{
+				FAugmentaVideoOutputMessage Message;
+				Message.OffsetX = Reader.ReadFloat();
+				Message.OffsetY = Reader.ReadFloat();
+				Message.SizeX = Reader.ReadFloat();
+				Message.SizeY = Reader.ReadFloat();
+				Message.ResolutionX = Reader.ReadVarInt();
+				Message.ResolutionY = Reader.ReadVarInt();
+				if (Listener && !Reader.bError)
+				{
+					Listener->OnVideoOutputDecoded(Message);
+				}
+				break;
+			}
+			case EAugmentaMessageType::ObjectEnter:
+			case EAugmentaMessageType::ObjectUpdate:
+			{
+				const int32 Pid = Reader.ReadVarInt();
+				const uint32 Mask = Type == EAugmentaMessageType::ObjectEnter ? AllObjectFields : Reader.ReadUInt16();
+				const int32 Slot = Objects.FindSlot(Pid);
+				if ((Mask & ~AllObjectFields) != 0 || (Type == EAugmentaMessageType::ObjectUpdate && Slot == INDEX_NONE))
+				{
+					return false;
+				}
+
+				int32 Fields[NumObjectFields] = {};
+				if (Slot != INDEX_NONE)
+				{
+					FMemory::Memcpy(Fields, Objects.GetValue(Slot).Fields, sizeof(Fields));
+				}
+				bool bChanged = false;
+				for (int32 Field = 0; Field < NumObjectFields; ++Field)
+				{
+					if (Mask & (1u << Field))
+					{
+						const int32 Value = Reader.ReadField(ObjectFieldKinds[Field]);
+						bChanged |= Value != Fields[Field];
+						Fields[Field] = Value;
+					}
+				}
+				if (!Listener || Reader.bError)
+				{
+					break;
+				}
+
+				bool bAdded;
+				FObjectState& State = Objects.FindOrAdd(Pid, bAdded);
+				FMemory::Memcpy(State.Fields, Fields, sizeof(Fields));
+				State.Sequence = AssemblingSequence;
+				if (bAdded || bChanged)
+				{
+					FAugmentaObjectMessage Message;
+					ToObjectMessage(Pid, AssemblingFrame, Fields, Message);
+					Listener->OnObjectDecoded(bAdded ? EAugmentaMessageType::ObjectEnter : EAugmentaMessageType::ObjectUpdate, Message);
+				}
+				break;
+			}
+			case EAugmentaMessageType::ObjectLeave:
+			{
+				const int32 Pid = Reader.ReadVarInt();
+				if (Listener && !Reader.bError)
+				{
+					RemoveObject(Pid, *Listener);
+				}
+				break;
+			}
+			case EAugmentaMessageType::ObjectExtraEnter:
+			case EAugmentaMessageType::ObjectExtraUpdate:
+			{
+				const int32 Id = Reader.ReadVarInt();
+				const uint32 Mask = Type == EAugmentaMessageType::ObjectExtraEnter ? AllExtraFields : Reader.ReadUInt8();
+				const int32 Slot = Extras.FindSlot(Id);
+				if ((Mask & ~AllExtraFields) != 0 || (Type == EAugmentaMessageType::ObjectExtraUpdate && Slot == INDEX_NONE))
+				{
+					return false;
+				}
+
+				int32 Fields[NumExtraFields] = {};
+				if (Slot != INDEX_NONE)
+				{
+					FMemory::Memcpy(Fields, Extras.GetValue(Slot).Fields, sizeof(Fields));
+				}
+				bool bChanged = false;
+				for (int32 Field = 0; Field < NumExtraFields; ++Field)
+				{
+					if (Mask & (1u << Field))
+					{
+						const int32 Value = Reader.ReadField(ExtraFieldKinds[Field]);
+						bChanged |= Value != Fields[Field];
+						Fields[Field] = Value;
+					}
+				}
+				if (!Listener || Reader.bError)
+				{
+					break;
+				}
+
+				bool bAdded;
+				FExtraState& State = Extras.FindOrAdd(Id, bAdded);
+				FMemory::Memcpy(State.Fields, Fields, sizeof(Fields));
+				State.Sequence = AssemblingSequence;
+				if (bAdded || bChanged)
+				{
+					FAugmentaObjectExtraMessage Message;
+					ToExtraMessage(Id, AssemblingFrame, Fields, Message);
+					Listener->OnObjectExtraDecoded(bAdded ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectExtraUpdate, Message);
+				}
+				break;
+			}
+			case EAugmentaMessageType::ObjectExtraLeave:
+			{
+				const int32 Id = Reader.ReadVarInt();
+				if (Listener && !Reader.bError)
+				{
+					RemoveExtra(Id, *Listener);
+				}
+				break;
+			}
+			default:
+				return false;
+			}
+
+			if (Reader.bError)
+			{
+				return false;
+			}
+		}
+	}
+
+	// A keyframe holds the whole state, the objects it does not hold left while the secondary was not synchronized
+	if (Listener && bAssemblingKeyframe)
+	{
+		LeftIds.Reset();
+		for (int32 Slot = 0; Slot < Objects.Num(); ++Slot)
+		{
+			if (Objects.GetValue(Slot).Sequence != AssemblingSequence)
+			{
+				LeftIds.Add(Objects.GetIds()[Slot]);
+			}
+		}
+		for (const int32 Pid : LeftIds)
+		{
+			RemoveObject(Pid, *Listener);
+		}
+
+		LeftIds.Reset();
+		for (int32 Slot = 0; Slot < Extras.Num(); ++Slot)
+		{
+			if (Extras.GetValue(Slot).Sequence != AssemblingSequence)
+			{
+				LeftIds.Add(Extras.GetIds()[Slot]);
+			}
+		}
+		for (const int32 Id : LeftIds)
+		{
+			RemoveExtra(Id, *Listener);
+		}
+	}
+
+	return true;
+}
+
+void FAugmentaClusterDecoder::RemoveObject(int32 Pid, IAugmentaDecoderListener& Listener)
+{
+	AugmentaClusterProtocol::FObjectState Removed;
+	int32 RemovedSlot;
+	if (!Objects.Remove(Pid, Removed, RemovedSlot))
+	{
+		return;
+	}
+
+	FAugmentaObjectMessage Message;
+	AugmentaClusterProtocol::ToObjectMessage(Pid, AssemblingFrame, Removed.Fields, Message);
+	Listener.OnObjectDecoded(EAugmentaMessageType::ObjectLeave, Message);
+}
+
+void FAugmentaClusterDecoder::RemoveExtra(int32 Id, IAugmentaDecoderListener& Listener)
+{
+	AugmentaClusterProtocol::FExtraState Removed;
+	int32 RemovedSlot;
+	if (!Extras.Remove(Id, Removed, RemovedSlot))
+	{
+		return;
+	}
+
+	FAugmentaObjectExtraMessage Message;
+	AugmentaClusterProtocol::ToExtraMessage(Id, AssemblingFrame, Removed.Fields, Message);
+	Listener.OnObjectExtraDecoded(EAugmentaMessageType::ObjectExtraLeave, Message);
+}
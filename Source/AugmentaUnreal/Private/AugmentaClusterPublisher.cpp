@@ -0,0 +1,78 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaClusterPublisher.h"
+#include "AugmentaStats.h"
+#include "AugmentaUnreal.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace AugmentaClusterPublisher
+{
+	/** The size of the socket send buffer, large enough for the keyframe of a dense scene. */
+	constexpr int32 SocketSendBufferSize = 1024 * 1024;
+	/** Keeps the multicast packets on the local network. */
+	constexpr int32 MulticastTtl = 1;
+}
+
+FAugmentaClusterPublisher::FAugmentaClusterPublisher(FSocket* InSocket, TSharedRef<FInternetAddr> InDestination, int32 KeyframeInterval)
+	: Socket(InSocket)
+	, Destination(MoveTemp(InDestination))
+	, Encoder(AugmentaClusterProtocol::DefaultPacketSize, KeyframeInterval)
+{
+}
+
+FAugmentaClusterPublisher::~FAugmentaClusterPublisher()
+{
+	Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+}
+
+TSharedPtr<FAugmentaClusterPublisher> FAugmentaClusterPublisher::Create(const FString& DestinationAddress, int32 Port, int32 KeyframeInterval)
+{
+	FIPv4Address Address;
+	if (!FIPv4Address::Parse(DestinationAddress, Address))
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Invalid cluster ip address '%s'."), *DestinationAddress);
+		return nullptr;
+	}
+
+	FSocket* NewSocket = FUdpSocketBuilder(TEXT("AugmentaClusterPublisher"))
+		.AsNonBlocking()
+		.AsReusable()
+		.WithMulticastLoopback()
+		.WithMulticastTtl(AugmentaClusterPublisher::MulticastTtl)
+		.WithSendBufferSize(AugmentaClusterPublisher::SocketSendBufferSize)
+		.Build();
+	if (!NewSocket)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to open the cluster socket to %s:%d."), *Address.ToString(), Port);
+		return nullptr;
+	}
+
+	return MakeShared<FAugmentaClusterPublisher>(NewSocket, FIPv4Endpoint(Address, Port).ToInternetAddr(), KeyframeInterval);
+}
+
+void FAugmentaClusterPublisher::Publish(const FAugmentaFrameSnapshot& Snapshot)
+{
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaPublishCluster);
+
+	Encoder.Encode(Snapshot);
+
+	// A packet that cannot be sent is lost like on the network, the secondaries wait for the next keyframe
+	for (int32 PacketIndex = 0; PacketIndex < Encoder.GetNumPackets(); ++PacketIndex)
+	{
+		const TConstArrayView<uint8> Packet = Encoder.GetPacket(PacketIndex);
+		int32 BytesSent = 0;
+		if (Socket->SendTo(Packet.GetData(), Packet.Num(), BytesSent, *Destination) && BytesSent == Packet.Num())
+		{
+			++PacketsSent;
+		}
+		else
+		{
+			++SendFailures;
+		}
+	}
+	++FramesSent;
+}
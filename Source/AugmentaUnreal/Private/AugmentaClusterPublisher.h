@@ -0,0 +1,53 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaClusterProtocol.h"
+
+/** Forward Declarations */
+class FInternetAddr;
+class FSocket;
+
+/**
+ * Sends the tracking state of a primary receiver to the secondary receivers of a render cluster, see
+ * UAugmentaReceiver::StartClusterPublisher. Every published snapshot is encoded as a cluster frame (see AugmentaClusterProtocol)
+ * and its packets are sent from the game thread, to a multicast group or to a single secondary.
+ */
+class FAugmentaClusterPublisher
+{
+public:
+	/**
+	 * @param InSocket The socket to send the packets from, closed with the publisher.
+	 * @param InDestination The address the packets are sent to.
+	 * @param KeyframeInterval The number of frames between two keyframes.
+	 */
+	FAugmentaClusterPublisher(FSocket* InSocket, TSharedRef<FInternetAddr> InDestination, int32 KeyframeInterval);
+	/** Closes the socket. */
+	~FAugmentaClusterPublisher();
+
+	/**
+	 * Opens a non blocking UDP socket sending to the given ip address and port, looping the multicast packets back so that
+	 * the secondaries can run on the same host. Returns null on failure.
+	 */
+	static TSharedPtr<FAugmentaClusterPublisher> Create(const FString& DestinationAddress, int32 Port, int32 KeyframeInterval);
+
+	/** Sends the changes of a snapshot since the last published one. */
+	void Publish(const FAugmentaFrameSnapshot& Snapshot);
+
+	void SetKeyframeInterval(int32 KeyframeInterval) { Encoder.SetKeyframeInterval(KeyframeInterval); }
+
+	/** The number of frames and packets sent, and the number of packets the socket failed to send. */
+	int64 GetFramesSent() const { return FramesSent; }
+	int64 GetPacketsSent() const { return PacketsSent; }
+	int64 GetSendFailures() const { return SendFailures; }
+
+private:
+	FSocket* Socket = nullptr;
+	TSharedRef<FInternetAddr> Destination;
+	FAugmentaClusterEncoder Encoder;
+
+	int64 FramesSent = 0;
+	int64 PacketsSent = 0;
+	int64 SendFailures = 0;
+};
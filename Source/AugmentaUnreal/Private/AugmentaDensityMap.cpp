@@ -0,0 +1,139 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaDensityMap.h"
+#include "AugmentaObjectStore.h"
+
+namespace AugmentaDensityMap
+{
+	/** The smallest radius of a footprint, in cells, so that small objects still cover a cell whatever the resolution. */
+	constexpr float MinRadius = 1.f;
+	/** Below this value the whole map is cleared instead of decayed. */
+	constexpr float MinValue = 1e-4f;
+}
+
+void FAugmentaDensityMap::SetResolution(int32 InWidth, int32 InHeight)
+{
+	InWidth = FMath::Max(InWidth, 0);
+	InHeight = FMath::Max(InHeight, 0);
+	if (InWidth == Width && InHeight == Height)
+	{
+		return;
+	}
+
+	Width = InWidth;
+	Height = InHeight;
+	Values.Empty(Width * Height);
+	Values.SetNumZeroed(Width * Height);
+	PeakBound = 0.f;
+}
+
+void FAugmentaDensityMap::Reset()
+{
+	FMemory::Memzero(Values.GetData(), Values.Num() * sizeof(float));
+	PeakBound = 0.f;
+}
+
+void FAugmentaDensityMap::Update(const FAugmentaObjectsSoA& Objects, float DeltaTime, float DecayTime)
+{
+	using namespace AugmentaDensityMap;
+
+	const float Decay = DecayTime > 0.f ? FMath::Exp(-DeltaTime / DecayTime) : 0.f;
+	if (PeakBound * Decay < MinValue)
+	{
+		// Nothing left to decay, e.g. once the scene is empty
+		if (PeakBound > 0.f)
+		{
+			Reset();
+		}
+	}
+	else if (Decay < 1.f)
+	{
+		const VectorRegister4Float VectorDecay = VectorSetFloat1(Decay);
+
+		const int32 Num = Values.Num();
+		const int32 NumVectorized = Num & ~3;
+		int32 Index = 0;
+		for (; Index < NumVectorized; Index += 4)
+		{
+			VectorStore(VectorMultiply(VectorLoad(&Values[Index]), VectorDecay), &Values[Index]);
+		}
+		for (; Index < Num; ++Index)
+		{
+			Values[Index] *= Decay;
+		}
+		PeakBound *= Decay;
+	}
+
+	// The objects fade in at the rate the cells decay, a still object converges to 1
+	const float Weight = 1.f - Decay;
+	if (Values.Num() == 0 || Objects.Num() == 0 || Weight <= 0.f)
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < Objects.Num(); ++Index)
+	{
+		AddFootprint(Objects.CentroidX[Index] * Width, Objects.CentroidY[Index] * Height,
+			FMath::Max(0.5f * Objects.BoundingRectSizeX[Index] * Width, MinRadius),
+			FMath::Max(0.5f * Objects.BoundingRectSizeY[Index] * Height, MinRadius),
+			Weight);
+	}
+	PeakBound += Weight * Objects.Num();
+}
+
+float FAugmentaDensityMap::GetValueAt(const FVector2D& Position) const
+{
+	const int32 X = FMath::FloorToInt32(Position.X * Width);
+	const int32 Y = FMath::FloorToInt32(Position.Y * Height);
+	if (X < 0 || X >= Width || Y < 0 || Y >= Height)
+	{
+		return 0.f;
+	}
+	return Values[Y * Width + X];
+}
+
+void FAugmentaDensityMap::AddFootprint(float CenterX, float CenterY, float RadiusX, float RadiusY, float Weight)
+{
+	// The cells whose center is within the radius, the others have a zero weight
+	const int32 MinX = FMath::Max(FMath::CeilToInt32(CenterX - RadiusX - 0.5f), 0);
+	const int32 MaxX = FMath::Min(FMath::FloorToInt32(CenterX + RadiusX - 0.5f), Width - 1);
+	const int32 MinY = FMath::Max(FMath::CeilToInt32(CenterY - RadiusY - 0.5f), 0);
+	const int32 MaxY = FMath::Min(FMath::FloorToInt32(CenterY + RadiusY - 0.5f), Height - 1);
+	if (MinX > MaxX || MinY > MaxY)
+	{
+		return;
+	}
+
+	// The kernel is separable, 1 - d^2 along each axis : the weights of the columns are computed once for every row
+	const int32 NumColumns = MaxX - MinX + 1;
+	const int32 NumVectorized = NumColumns & ~3;
+	ColumnWeights.SetNumUninitialized(Align(NumColumns, 4), false);
+
+	const float InvRadiusX = 1.f / RadiusX;
+	const VectorRegister4Float VectorInvRadiusX = VectorSetFloat1(InvRadiusX);
+	const VectorRegister4Float Lanes = MakeVectorRegisterFloat(0.f, 1.f, 2.f, 3.f);
+	for (int32 Column = 0; Column < ColumnWeights.Num(); Column += 4)
+	{
+		const VectorRegister4Float Distance = VectorMultiply(VectorAdd(VectorSetFloat1(MinX + Column + 0.5f - CenterX), Lanes), VectorInvRadiusX);
+		VectorStore(VectorMax(VectorSubtract(VectorOneFloat(), VectorMultiply(Distance, Distance)), VectorZeroFloat()), &ColumnWeights[Column]);
+	}
+
+	const float InvRadiusY = 1.f / RadiusY;
+	for (int32 Y = MinY; Y <= MaxY; ++Y)
+	{
+		const float DistanceY = (Y + 0.5f - CenterY) * InvRadiusY;
+		const float RowWeight = Weight * FMath::Max(1.f - DistanceY * DistanceY, 0.f);
+		const VectorRegister4Float VectorRowWeight = VectorSetFloat1(RowWeight);
+
+		float* Row = &Values[Y * Width + MinX];
+		int32 Column = 0;
+		for (; Column < NumVectorized; Column += 4)
+		{
+			VectorStore(VectorMultiplyAdd(VectorLoad(&ColumnWeights[Column]), VectorRowWeight, VectorLoad(Row + Column)), Row + Column);
+		}
+		for (; Column < NumColumns; ++Column)
+		{
+			Row[Column] += ColumnWeights[Column] * RowWeight;
+		}
+	}
+}
@@ -0,0 +1,244 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaEventCoalescer.h"
+
+namespace AugmentaEventCoalescer
+{
+	/** Removes the dropped elements of an array, keeping the order of the others, and maps every old index to its new index. */
+	template <typename ElementType>
+	void CompactArray(TArray<ElementType>& Array, const TBitArray<>& Dropped, TArray<int32>& OutRemap)
+	{
+		OutRemap.SetNumUninitialized(Array.Num(), false);
+
+		int32 NewNum = 0;
+		for (int32 Index = 0; Index < Array.Num(); ++Index)
+		{
+			if (Dropped[Index])
+			{
+				OutRemap[Index] = INDEX_NONE;
+				continue;
+			}
+
+			if (NewNum != Index)
+			{
+				Array[NewNum] = MoveTemp(Array[Index]);
+			}
+			OutRemap[Index] = NewNum++;
+		}
+		Array.SetNum(NewNum, false);
+	}
+}
+
+void FAugmentaEventCoalescer::Add(const FAugmentaFrameEvents& InEvents)
+{
+	for (const FAugmentaEventRecord& Event : InEvents.Sequence)
+	{
+		switch (Event.Type)
+		{
+		case EAugmentaEventType::SceneUpdated:
+			if (SceneRecord != INDEX_NONE)
+			{
+				Events.Scenes[Events.Sequence[SceneRecord].Index] = InEvents.Scenes[Event.Index];
+				++CoalescedEvents;
+			}
+			else
+			{
+				SceneRecord = Events.Sequence.Add({ Event.Type, Events.Scenes.Add(InEvents.Scenes[Event.Index]) });
+			}
+			break;
+		case EAugmentaEventType::VideoOutputUpdated:
+			if (VideoOutputRecord != INDEX_NONE)
+			{
+				Events.VideoOutputs[Events.Sequence[VideoOutputRecord].Index] = InEvents.VideoOutputs[Event.Index];
+				++CoalescedEvents;
+			}
+			else
+			{
+				VideoOutputRecord = Events.Sequence.Add({ Event.Type, Events.VideoOutputs.Add(InEvents.VideoOutputs[Event.Index]) });
+			}
+			break;
+		case EAugmentaEventType::ObjectEntered:
+			AddObject(Event.Type, InEvents.EnteredObjects[Event.Index]);
+			break;
+		case EAugmentaEventType::ObjectUpdated:
+			AddObject(Event.Type, InEvents.UpdatedObjects[Event.Index]);
+			break;
+		case EAugmentaEventType::ObjectLeft:
+			AddObject(Event.Type, InEvents.LeftObjects[Event.Index]);
+			break;
+		case EAugmentaEventType::ExtraDataEntered:
+			AddExtra(Event.Type, InEvents.EnteredExtras[Event.Index]);
+			break;
+		case EAugmentaEventType::ExtraDataUpdated:
+			AddExtra(Event.Type, InEvents.UpdatedExtras[Event.Index]);
+			break;
+		case EAugmentaEventType::ExtraDataLeft:
+			AddExtra(Event.Type, InEvents.LeftExtras[Event.Index]);
+			break;
+		}
+	}
+}
+
+void FAugmentaEventCoalescer::Flush(FAugmentaFrameEvents& OutEvents)
+{
+	if (NumDropped > 0)
+	{
+		Compact();
+	}
+
+	Swap(OutEvents, Events);
+	Reset();
+}
+
+void FAugmentaEventCoalescer::Reset()
+{
+	Events.Reset();
+	ObjectRecords.Reset();
+	ExtraRecords.Reset();
+	SceneRecord = INDEX_NONE;
+	VideoOutputRecord = INDEX_NONE;
+	DroppedObjectUpdates.Reset();
+	DroppedExtraUpdates.Reset();
+	NumDropped = 0;
+}
+
+SIZE_T FAugmentaEventCoalescer::GetAllocatedSize() const
+{
+	return Events.GetAllocatedSize() + ObjectRecords.GetAllocatedSize() + ExtraRecords.GetAllocatedSize()
+		+ DroppedObjectUpdates.GetAllocatedSize() + DroppedExtraUpdates.GetAllocatedSize() + ObjectRemap.GetAllocatedSize() + ExtraRemap.GetAllocatedSize();
+}
+
+void FAugmentaEventCoalescer::AddObject(EAugmentaEventType Type, const FAugmentaPerson& Object)
+{
+	const int32 Record = ObjectRecords.Find(Object.Pid);
+
+	if (Type == EAugmentaEventType::ObjectUpdated && Record != INDEX_NONE)
+	{
+		// Fire the pending enter or update event with the newest state
+		const FAugmentaEventRecord& Pending = Events.Sequence[Record];
+		TArray<FAugmentaPerson>& PendingObjects = Pending.Type == EAugmentaEventType::ObjectEntered ? Events.EnteredObjects : Events.UpdatedObjects;
+		PendingObjects[Pending.Index] = Object;
+		++CoalescedEvents;
+		return;
+	}
+
+	if (Type == EAugmentaEventType::ObjectLeft)
+	{
+		// The leave event holds the last state, the pending update is superseded by it
+		if (Record != INDEX_NONE)
+		{
+			const FAugmentaEventRecord& Pending = Events.Sequence[Record];
+			if (Pending.Type == EAugmentaEventType::ObjectUpdated)
+			{
+				DroppedObjectUpdates[Pending.Index] = true;
+				++NumDropped;
+				++CoalescedEvents;
+			}
+			ObjectRecords.Remove(Object.Pid);
+		}
+		Events.Sequence.Add({ Type, Events.LeftObjects.Add(Object) });
+		return;
+	}
+
+	int32 NewRecord;
+	if (Type == EAugmentaEventType::ObjectEntered)
+	{
+		NewRecord = Events.Sequence.Add({ Type, Events.EnteredObjects.Add(Object) });
+	}
+	else
+	{
+		NewRecord = Events.Sequence.Add({ Type, Events.UpdatedObjects.Add(Object) });
+		DroppedObjectUpdates.Add(false);
+	}
+
+	// An object entering again without having left keeps its previous event, only the new one is coalesced from now on
+	if (Record != INDEX_NONE)
+	{
+		ObjectRecords.Update(Object.Pid, NewRecord);
+	}
+	else
+	{
+		ObjectRecords.Add(Object.Pid, NewRecord);
+	}
+}
+
+void FAugmentaEventCoalescer::AddExtra(EAugmentaEventType Type, const FAugmentaObjectExtra& Extra)
+{
+	const int32 Record = ExtraRecords.Find(Extra.Id);
+
+	if (Type == EAugmentaEventType::ExtraDataUpdated && Record != INDEX_NONE)
+	{
+		const FAugmentaEventRecord& Pending = Events.Sequence[Record];
+		TArray<FAugmentaObjectExtra>& PendingExtras = Pending.Type == EAugmentaEventType::ExtraDataEntered ? Events.EnteredExtras : Events.UpdatedExtras;
+		PendingExtras[Pending.Index] = Extra;
+		++CoalescedEvents;
+		return;
+	}
+
+	if (Type == EAugmentaEventType::ExtraDataLeft)
+	{
+		if (Record != INDEX_NONE)
+		{
+			const FAugmentaEventRecord& Pending = Events.Sequence[Record];
+			if (Pending.Type == EAugmentaEventType::ExtraDataUpdated)
+			{
+				DroppedExtraUpdates[Pending.Index] = true;
+				++NumDropped;
+				++CoalescedEvents;
+			}
+			ExtraRecords.Remove(Extra.Id);
+		}
+		Events.Sequence.Add({ Type, Events.LeftExtras.Add(Extra) });
+		return;
+	}
+
+	int32 NewRecord;
+	if (Type == EAugmentaEventType::ExtraDataEntered)
+	{
+		NewRecord = Events.Sequence.Add({ Type, Events.EnteredExtras.Add(Extra) });
+	}
+	else
+	{
+		NewRecord = Events.Sequence.Add({ Type, Events.UpdatedExtras.Add(Extra) });
+		DroppedExtraUpdates.Add(false);
+	}
+
+	if (Record != INDEX_NONE)
+	{
+		ExtraRecords.Update(Extra.Id, NewRecord);
+	}
+	else
+	{
+		ExtraRecords.Add(Extra.Id, NewRecord);
+	}
+}
+
+void FAugmentaEventCoalescer::Compact()
+{
+	using namespace AugmentaEventCoalescer;
+
+	// Compact the updated arrays first, then the sequence, remapping the indices of the remaining update events
+	CompactArray(Events.UpdatedObjects, DroppedObjectUpdates, ObjectRemap);
+	CompactArray(Events.UpdatedExtras, DroppedExtraUpdates, ExtraRemap);
+
+	int32 NewNum = 0;
+	for (int32 Index = 0; Index < Events.Sequence.Num(); ++Index)
+	{
+		FAugmentaEventRecord Event = Events.Sequence[Index];
+		if (Event.Type == EAugmentaEventType::ObjectUpdated)
+		{
+			Event.Index = ObjectRemap[Event.Index];
+		}
+		else if (Event.Type == EAugmentaEventType::ExtraDataUpdated)
+		{
+			Event.Index = ExtraRemap[Event.Index];
+		}
+
+		if (Event.Index != INDEX_NONE)
+		{
+			Events.Sequence[NewNum++] = Event;
+		}
+	}
+	Events.Sequence.SetNum(NewNum, false);
+	NumDropped = 0;
+}
@@ -0,0 +1,365 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaFusion.h"
+
+namespace AugmentaFusion
+{
+	/** Whether a source scene is known, its objects cannot be placed in the shared space before. */
+	bool HasSceneSize(const FAugmentaFrameSnapshot& Snapshot)
+	{
+		return Snapshot.Scene.SceneSize.X > 0.0 && Snapshot.Scene.SceneSize.Y > 0.0;
+	}
+}
+
+void FAugmentaFusion::Reset()
+{
+	Snapshot.Reset();
+	Events.Reset();
+	NextPid = 0;
+	FusedPids.Reset();
+	NextFusedPids.Reset();
+}
+
+void FAugmentaFusion::Fuse(TConstArrayView<FSource> Sources, double Now)
+{
+	check(Sources.Num() <= MaxSources);
+
+	Events.Reset();
+	++Snapshot.Frame;
+
+	// The shared space either has a fixed size or covers every source scene
+	FVector2D FusedSceneSize = SceneSize;
+	if (FusedSceneSize.X <= 0.0 || FusedSceneSize.Y <= 0.0)
+	{
+		FusedSceneSize = FVector2D::ZeroVector;
+		for (const FSource& Source : Sources)
+		{
+			if (Source.Snapshot && AugmentaFusion::HasSceneSize(*Source.Snapshot))
+			{
+				FusedSceneSize = FVector2D::Max(FusedSceneSize, Source.Offset + Source.Snapshot->Scene.SceneSize);
+			}
+		}
+	}
+
+	if (FusedSceneSize.X > 0.0 && FusedSceneSize.Y > 0.0)
+	{
+		GatherCandidates(Sources, FusedSceneSize);
+		AssociateCandidates(FusedSceneSize);
+	}
+	else
+	{
+		ClusterPids.Reset();
+	}
+	AssignPids(Sources.Num());
+
+	FAugmentaScene& Scene = Snapshot.Scene;
+	Scene.CurrentTime = Snapshot.Frame;
+	Scene.NumPeople = ClusterPids.Num();
+	Scene.SceneSize = FusedSceneSize;
+	Events.Sequence.Add({ EAugmentaEventType::SceneUpdated, Events.Scenes.Add(Scene) });
+
+	UpdateObjects(Sources, FusedSceneSize, Now);
+}
+
+void FAugmentaFusion::GatherCandidates(TConstArrayView<FSource> Sources, const FVector2D& FusedSceneSize)
+{
+	CandidateX.Reset();
+	CandidateY.Reset();
+	CandidateSources.Reset();
+	CandidateSlots.Reset();
+	CandidatePids.Reset();
+
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); ++SourceIndex)
+	{
+		const FSource& Source = Sources[SourceIndex];
+		if (!Source.Snapshot || !AugmentaFusion::HasSceneSize(*Source.Snapshot))
+		{
+			continue;
+		}
+
+		// Normalized in the source scene, then in the shared space : X * Scale + Bias
+		const FVector2f Scale(Source.Snapshot->Scene.SceneSize / FusedSceneSize);
+		const FVector2f Bias(Source.Offset / FusedSceneSize);
+
+		const FAugmentaObjectsSoA Objects = Source.Snapshot->Objects.GetSoA();
+		for (int32 Slot = 0; Slot < Objects.Num(); ++Slot)
+		{
+			CandidateX.Add(Objects.CentroidX[Slot] * Scale.X + Bias.X);
+			CandidateY.Add(Objects.CentroidY[Slot] * Scale.Y + Bias.Y);
+			CandidateSources.Add(SourceIndex);
+			CandidateSlots.Add(Slot);
+			CandidatePids.Add(Source.Snapshot->Objects.GetObjects()[Slot].Pid);
+		}
+	}
+}
+
+void FAugmentaFusion::AssociateCandidates(const FVector2D& FusedSceneSize)
+{
+	const int32 NumCandidates = CandidateX.Num();
+
+	// Only the candidates of neighbouring cells are compared
+	Grid.Reset();
+	for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+	{
+		Grid.Add(Candidate, CandidateX[Candidate], CandidateY[Candidate]);
+	}
+	Pairs.Reset();
+	if (MergeDistance > 0.f)
+	{
+		Grid.FindPairs(CandidateX, CandidateY, MergeDistance, FVector2f(FusedSceneSize), Pairs);
+	}
+
+	// A source never sees the same object twice
+	Pairs.RemoveAllSwap([this](const FAugmentaSlotPair& Pair)
+	{
+		return CandidateSources[Pair.SlotA] == CandidateSources[Pair.SlotB];
+	}, false);
+	Pairs.Sort([](const FAugmentaSlotPair& A, const FAugmentaSlotPair& B)
+	{
+		return A.Distance < B.Distance;
+	});
+
+	// Merge the closest pairs first, as long as the merged cluster holds at most one candidate per source
+	Parents.SetNumUninitialized(NumCandidates);
+	SourceMasks.SetNumUninitialized(NumCandidates);
+	for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+	{
+		Parents[Candidate] = Candidate;
+		SourceMasks[Candidate] = 1u << CandidateSources[Candidate];
+	}
+	for (const FAugmentaSlotPair& Pair : Pairs)
+	{
+		const int32 RootA = FindRoot(Pair.SlotA);
+		const int32 RootB = FindRoot(Pair.SlotB);
+		if (RootA != RootB && (SourceMasks[RootA] & SourceMasks[RootB]) == 0)
+		{
+			Parents[RootB] = RootA;
+			SourceMasks[RootA] |= SourceMasks[RootB];
+		}
+	}
+
+	// Number the clusters in the order of their first candidate, then group the candidates by cluster with a counting sort
+	RootClusters.Init(INDEX_NONE, NumCandidates);
+	CandidateClusters.SetNumUninitialized(NumCandidates);
+	ClusterFirst.Reset();
+	for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+	{
+		const int32 Root = FindRoot(Candidate);
+		if (RootClusters[Root] == INDEX_NONE)
+		{
+			RootClusters[Root] = ClusterFirst.Add(0);
+		}
+		CandidateClusters[Candidate] = RootClusters[Root];
+		++ClusterFirst[RootClusters[Root]];
+	}
+
+	const int32 NumClusters = ClusterFirst.Num();
+	int32 First = 0;
+	for (int32& ClusterStart : ClusterFirst)
+	{
+		const int32 Count = ClusterStart;
+		ClusterStart = First;
+		First += Count;
+	}
+	ClusterFirst.Add(First);
+
+	// Every cluster start is used as a cursor, which ends at the start of the next cluster
+	ClusterMembers.SetNumUninitialized(NumCandidates);
+	for (int32 Candidate = 0; Candidate < NumCandidates; ++Candidate)
+	{
+		ClusterMembers[ClusterFirst[CandidateClusters[Candidate]]++] = Candidate;
+	}
+	for (int32 Cluster = NumClusters - 1; Cluster > 0; --Cluster)
+	{
+		ClusterFirst[Cluster] = ClusterFirst[Cluster - 1];
+	}
+	if (NumClusters > 0)
+	{
+		ClusterFirst[0] = 0;
+	}
+
+	ClusterPids.SetNumUninitialized(NumClusters);
+}
+
+int32 FAugmentaFusion::FindRoot(int32 Candidate)
+{
+	int32 Root = Candidate;
+	while (Parents[Root] != Root)
+	{
+		Root = Parents[Root];
+	}
+	while (Parents[Candidate] != Root)
+	{
+		const int32 Next = Parents[Candidate];
+		Parents[Candidate] = Root;
+		Candidate = Next;
+	}
+	return Root;
+}
+
+void FAugmentaFusion::AssignPids(int32 NumSources)
+{
+	FusedPids.SetNum(NumSources);
+	NextFusedPids.SetNum(NumSources);
+	for (FAugmentaIdIndex& Index : NextFusedPids)
+	{
+		Index.Reset();
+	}
+	ClaimedPids.Reset();
+
+	const int32 NumClusters = ClusterPids.Num();
+	for (int32 Cluster = 0; Cluster < NumClusters; ++Cluster)
+	{
+		// Continue the oldest fused object one of the members belonged to, unless another cluster already does
+		int32 Pid = INDEX_NONE;
+		for (int32 Member = ClusterFirst[Cluster]; Member < ClusterFirst[Cluster + 1]; ++Member)
+		{
+			const int32 Candidate = ClusterMembers[Member];
+			const int32 PreviousPid = FusedPids[CandidateSources[Candidate]].Find(CandidatePids[Candidate]);
+			if (PreviousPid != INDEX_NONE && ClaimedPids.Find(PreviousPid) == INDEX_NONE && (Pid == INDEX_NONE || PreviousPid < Pid))
+			{
+				Pid = PreviousPid;
+			}
+		}
+		if (Pid == INDEX_NONE)
+		{
+			Pid = NextPid++;
+		}
+
+		ClusterPids[Cluster] = Pid;
+		ClaimedPids.Add(Pid, Cluster);
+		for (int32 Member = ClusterFirst[Cluster]; Member < ClusterFirst[Cluster + 1]; ++Member)
+		{
+			const int32 Candidate = ClusterMembers[Member];
+			NextFusedPids[CandidateSources[Candidate]].Add(CandidatePids[Candidate], Pid);
+		}
+	}
+
+	Swap(FusedPids, NextFusedPids);
+}
+
+void FAugmentaFusion::UpdateObjects(TConstArrayView<FSource> Sources, const FVector2D& FusedSceneSize, double Now)
+{
+	// Number the fused objects like the Augmenta Oid, the oldest fused objects having the lowest Pids
+	const int32 NumClusters = ClusterPids.Num();
+	ClusterOrder.SetNumUninitialized(NumClusters);
+	for (int32 Cluster = 0; Cluster < NumClusters; ++Cluster)
+	{
+		ClusterOrder[Cluster] = Cluster;
+	}
+	ClusterOrder.Sort([this](int32 A, int32 B)
+	{
+		return ClusterPids[A] < ClusterPids[B];
+	});
+
+	for (int32 Oid = 0; Oid < NumClusters; ++Oid)
+	{
+		const int32 Cluster = ClusterOrder[Oid];
+		const int32 NumMembers = ClusterFirst[Cluster + 1] - ClusterFirst[Cluster];
+
+		// The positions are averaged and the bounding rectangles merged, the other values come from the oldest member
+		FVector2D Centroid = FVector2D::ZeroVector;
+		FVector2D Velocity = FVector2D::ZeroVector;
+		FVector2D RectMin(TNumericLimits<double>::Max());
+		FVector2D RectMax(TNumericLimits<double>::Lowest());
+		float Height = 0.f;
+		const FAugmentaPerson* Oldest = nullptr;
+		int32 OldestCandidate = INDEX_NONE;
+		for (int32 Member = ClusterFirst[Cluster]; Member < ClusterFirst[Cluster + 1]; ++Member)
+		{
+			const int32 Candidate = ClusterMembers[Member];
+			const FSource& Source = Sources[CandidateSources[Candidate]];
+			const FAugmentaPerson& Object = Source.Snapshot->Objects.GetObjects()[CandidateSlots[Candidate]];
+			const FVector2D Scale = Source.Snapshot->Scene.SceneSize / FusedSceneSize;
+			const FVector2D Bias = Source.Offset / FusedSceneSize;
+
+			Centroid += Object.Centroid * Scale + Bias;
+			Velocity += Object.Velocity * Scale;
+			const FVector2D RectCenter = Object.BoundingRectPos * Scale + Bias;
+			const FVector2D RectExtent = Object.BoundingRectSize * Scale * 0.5;
+			RectMin = FVector2D::Min(RectMin, RectCenter - RectExtent);
+			RectMax = FVector2D::Max(RectMax, RectCenter + RectExtent);
+			Height = FMath::Max(Height, Object.Height);
+			if (!Oldest || Object.Age > Oldest->Age)
+			{
+				Oldest = &Object;
+				OldestCandidate = Candidate;
+			}
+		}
+		Centroid /= NumMembers;
+		Velocity /= NumMembers;
+
+		FAugmentaObjectMessage Message;
+		Message.Frame = Snapshot.Frame;
+		Message.Pid = ClusterPids[Cluster];
+		Message.Oid = Oid;
+		Message.Age = Oldest->Age;
+		Message.CentroidX = static_cast<float>(Centroid.X);
+		Message.CentroidY = static_cast<float>(Centroid.Y);
+		Message.VelocityX = static_cast<float>(Velocity.X);
+		Message.VelocityY = static_cast<float>(Velocity.Y);
+		Message.Orientation = Oldest->Orientation;
+		Message.BoundingRectPosX = static_cast<float>((RectMin.X + RectMax.X) * 0.5);
+		Message.BoundingRectPosY = static_cast<float>((RectMin.Y + RectMax.Y) * 0.5);
+		Message.BoundingRectSizeX = static_cast<float>(RectMax.X - RectMin.X);
+		Message.BoundingRectSizeY = static_cast<float>(RectMax.Y - RectMin.Y);
+		Message.BoundingRectRotation = Oldest->BoundingRectRotation;
+		Message.Height = Height;
+
+		bool bAdded;
+		const FAugmentaPerson& Person = Snapshot.Objects.Update(Message, Now, bAdded);
+		if (bAdded)
+		{
+			Events.Sequence.Add({ EAugmentaEventType::ObjectEntered, Events.EnteredObjects.Add(Person) });
+		}
+		else
+		{
+			Events.Sequence.Add({ EAugmentaEventType::ObjectUpdated, Events.UpdatedObjects.Add(Person) });
+		}
+
+		// The extra data of the oldest member, if its source sends it
+		const FSource& OldestSource = Sources[CandidateSources[OldestCandidate]];
+		if (const FAugmentaObjectExtra* SourceExtra = OldestSource.Snapshot->ObjectExtras.Find(Oldest->Pid))
+		{
+			const FVector2D Highest = SourceExtra->Highest * (OldestSource.Snapshot->Scene.SceneSize / FusedSceneSize) + OldestSource.Offset / FusedSceneSize;
+
+			FAugmentaObjectExtraMessage ExtraMessage;
+			ExtraMessage.Frame = Snapshot.Frame;
+			ExtraMessage.Id = Message.Pid;
+			ExtraMessage.Oid = Oid;
+			ExtraMessage.HighestX = static_cast<float>(Highest.X);
+			ExtraMessage.HighestY = static_cast<float>(Highest.Y);
+			ExtraMessage.Distance = SourceExtra->Distance;
+			ExtraMessage.Reflectivity = SourceExtra->Reflectivity;
+
+			const FAugmentaObjectExtra& Extra = Snapshot.ObjectExtras.Update(ExtraMessage, Now, bAdded);
+			if (bAdded)
+			{
+				Events.Sequence.Add({ EAugmentaEventType::ExtraDataEntered, Events.EnteredExtras.Add(Extra) });
+			}
+			else
+			{
+				Events.Sequence.Add({ EAugmentaEventType::ExtraDataUpdated, Events.UpdatedExtras.Add(Extra) });
+			}
+		}
+	}
+
+	// The fused objects that are not continued were last updated at least one frame before the others
+	FAugmentaExpiry NotContinued;
+	NotContinued.TimeoutFrames = 1;
+	const int32 NextFrame = Snapshot.Frame + 1;
+
+	int32 Id;
+	while (Snapshot.Objects.FindExpired(NextFrame, Now, NotContinued, Id))
+	{
+		FAugmentaPerson OldPerson;
+		Snapshot.Objects.Remove(Id, OldPerson);
+		Events.Sequence.Add({ EAugmentaEventType::ObjectLeft, Events.LeftObjects.Add(OldPerson) });
+	}
+	while (Snapshot.ObjectExtras.FindExpired(NextFrame, Now, NotContinued, Id))
+	{
+		FAugmentaObjectExtra OldExtra;
+		Snapshot.ObjectExtras.Remove(Id, OldExtra);
+		Events.Sequence.Add({ EAugmentaEventType::ExtraDataLeft, Events.LeftExtras.Add(OldExtra) });
+	}
+}
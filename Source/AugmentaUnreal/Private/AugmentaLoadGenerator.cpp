@@ -0,0 +1,465 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaLoadGenerator.h"
+#include "AugmentaBinaryProtocol.h"
+#include "AugmentaOSCEncoder.h"
+#include "AugmentaReceiver.h"
+#include "AugmentaUnreal.h"
+#include "Common/UdpSocketBuilder.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace AugmentaLoadGenerator
+{
+	/** The smallest datagram holding a bundle with the largest Augmenta message. */
+	constexpr int32 MinDatagramSize = 128;
+	/** The size of the buffer of a datagram holding a single message. */
+	constexpr int32 SingleMessageDatagramSize = 512;
+	/** The size of the socket send buffer, large enough to send a frame of a dense scene at once. */
+	constexpr int32 SocketSendBufferSize = 2 * 1024 * 1024;
+	/** The longest sleep between two checks for a stop request, in seconds. */
+	constexpr double MaxSleepTime = 0.05;
+	/** How long a load test keeps ticking the receiver once the generator is stopped, for the datagrams in flight. */
+	constexpr double DrainTime = 0.25;
+
+	/** The maximum speed of an object, in m/s. */
+	constexpr float MaxSpeed = 1.5f;
+	/** The size of the bounding rect of an object, in m. */
+	constexpr float ObjectSize = 0.5f;
+
+	/** Closes the bundle of an OSC datagram, a binary packet needs no closing. */
+	void EndDatagram(FAugmentaOSCEncoder& Encoder)
+	{
+		Encoder.EndBundle();
+	}
+
+	void EndDatagram(FAugmentaBinaryEncoder&)
+	{
+	}
+
+	/** Sleeps until the given time, waking up regularly to check the stop request. */
+	void SleepUntil(double Time, const std::atomic<bool>& bStopping)
+	{
+		double RemainingTime = Time - FPlatformTime::Seconds();
+		while (RemainingTime > 0.0 && !bStopping)
+		{
+			FPlatformProcess::Sleep(static_cast<float>(FMath::Min(RemainingTime, MaxSleepTime)));
+			RemainingTime = Time - FPlatformTime::Seconds();
+		}
+	}
+}
+
+FString FAugmentaLoadReport::ToString() const
+{
+	return FString::Printf(
+		TEXT("Frames sent: %lld, received: %lld\n")
+		TEXT("Messages sent: %lld, lost on purpose: %lld, received: %lld, dropped: %lld, dropped leaves: %lld\n")
+		TEXT("Latency (ms): average %.3f, p99 %.3f, max %.3f\n")
+		TEXT("Game thread (ms): average tick %.3f, max tick %.3f, per frame %.3f"),
+		FramesSent, FramesReceived,
+		MessagesSent, MessagesLost, MessagesReceived, MessagesDropped, DroppedLeaves,
+		AverageLatency, P99Latency, MaxLatency,
+		AverageTickTime, MaxTickTime, TickTimePerFrame);
+}
+
+FAugmentaLoadGenerator::FAugmentaLoadGenerator(const FAugmentaLoadSettings& InSettings)
+	: Settings(InSettings)
+	, Random(InSettings.Seed)
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	bool bIsValid = false;
+	Destination = SocketSubsystem->CreateInternetAddr();
+	Destination->SetIp(*Settings.Address, bIsValid);
+	Destination->SetPort(Settings.Port);
+	if (!bIsValid)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Invalid load generator ip address '%s'."), *Settings.Address);
+		return;
+	}
+
+	Socket = FUdpSocketBuilder(TEXT("AugmentaLoadGenerator"))
+		.AsBlocking()
+		.WithSendBufferSize(AugmentaLoadGenerator::SocketSendBufferSize)
+		.Build();
+	if (!Socket)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to open the load generator socket."));
+		return;
+	}
+
+	const int32 DatagramSize = Settings.MaxDatagramSize > 0
+		? FMath::Max(Settings.MaxDatagramSize, AugmentaLoadGenerator::MinDatagramSize)
+		: AugmentaLoadGenerator::SingleMessageDatagramSize;
+	DatagramBuffer.SetNumUninitialized(DatagramSize);
+
+	Objects.Reserve(Settings.ObjectCount);
+	for (int32 Index = 0; Index < Settings.ObjectCount; ++Index)
+	{
+		AddObject();
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("AugmentaLoadGenerator"), 0, TPri_AboveNormal);
+}
+
+FAugmentaLoadGenerator::~FAugmentaLoadGenerator()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+double FAugmentaLoadGenerator::GetFrameSendTime(int32 Frame) const
+{
+	if (Frame < 0)
+	{
+		return -1.0;
+	}
+
+	const FSendTime& SendTime = SendTimes[Frame % SendTimeHistorySize];
+	if (SendTime.Frame.load(std::memory_order_acquire) != Frame)
+	{
+		return -1.0;
+	}
+	return SendTime.Time.load(std::memory_order_relaxed);
+}
+
+uint32 FAugmentaLoadGenerator::Run()
+{
+	const double FrameInterval = 1.0 / FMath::Max(Settings.FrameRate, 1.f);
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 Frame = 0; !bStopping; ++Frame)
+	{
+		SendFrame(Frame, static_cast<float>(FrameInterval));
+
+		// Pace the frames from the start time, so that a late frame does not delay the next ones
+		AugmentaLoadGenerator::SleepUntil(StartTime + (Frame + 1) * FrameInterval, bStopping);
+	}
+	return 0;
+}
+
+void FAugmentaLoadGenerator::Stop()
+{
+	bStopping = true;
+}
+
+FAugmentaLoadReport FAugmentaLoadGenerator::RunLoadTest(const FAugmentaLoadSettings& Settings)
+{
+	FAugmentaLoadReport Report;
+
+	UAugmentaReceiver* Receiver = NewObject<UAugmentaReceiver>();
+	// Keep the receiver alive while it is ticked outside of the engine loop, e.g. in a commandlet
+	Receiver->AddToRoot();
+	Receiver->bFrameAssembly = Settings.bFrameAssembly;
+	Receiver->bDecodeOnReceiveThread = Settings.bDecodeOnReceiveThread;
+	// Expire the objects whose leave message was lost after a second without update
+	Receiver->ObjectTimeoutFrames = FMath::CeilToInt(Settings.FrameRate);
+	Receiver->Connect(FString(), Settings.Port);
+	if (!Receiver->IsConnected())
+	{
+		Receiver->RemoveFromRoot();
+		return Report;
+	}
+
+	// Send to the port the receiver is bound to, which the system picked if the settings asked for port 0
+	FAugmentaLoadSettings GeneratorSettings = Settings;
+	GeneratorSettings.Port = Receiver->GetPort();
+	TUniquePtr<FAugmentaLoadGenerator> Generator = MakeUnique<FAugmentaLoadGenerator>(GeneratorSettings);
+	if (!Generator->IsRunning())
+	{
+		Receiver->Stop();
+		Receiver->RemoveFromRoot();
+		return Report;
+	}
+
+	// Measure the latency of every frame once, when its events are first fired
+	TArray<double> Latencies;
+	int32 LastFrame = INDEX_NONE;
+	const FDelegateHandle FrameHandle = Receiver->OnFrameNative.AddLambda([&](const FAugmentaFrameSnapshot& Snapshot, const FAugmentaFrameEvents&)
+	{
+		if (Snapshot.Frame == LastFrame)
+		{
+			return;
+		}
+		LastFrame = Snapshot.Frame;
+		++Report.FramesReceived;
+
+		const double SendTime = Generator->GetFrameSendTime(Snapshot.Frame);
+		if (SendTime >= 0.0)
+		{
+			Latencies.Add(FPlatformTime::Seconds() - SendTime);
+		}
+	});
+
+	// Tick the receiver at the game frame rate, measuring the game thread time it takes
+	const double TickInterval = 1.0 / FMath::Max(Settings.TickRate, 1.f);
+	const double StartTime = FPlatformTime::Seconds();
+	double LastTickTime = StartTime;
+	double TotalTickTime = 0.0;
+	double MaxTickTime = 0.0;
+	int64 NumTicks = 0;
+	std::atomic<bool> bNeverStopping{ false };
+
+	const auto TickUntil = [&](double EndTime)
+	{
+		for (double NextTickTime = LastTickTime + TickInterval; NextTickTime < EndTime; NextTickTime += TickInterval)
+		{
+			AugmentaLoadGenerator::SleepUntil(NextTickTime, bNeverStopping);
+
+			const double TickStartTime = FPlatformTime::Seconds();
+			Receiver->Tick(static_cast<float>(TickStartTime - LastTickTime));
+			const double TickTime = FPlatformTime::Seconds() - TickStartTime;
+			LastTickTime = TickStartTime;
+
+			TotalTickTime += TickTime;
+			MaxTickTime = FMath::Max(MaxTickTime, TickTime);
+			++NumTicks;
+		}
+	};
+
+	TickUntil(StartTime + Settings.Duration);
+
+	// Stop sending and receive the datagrams still in flight
+	Generator->Stop();
+	TickUntil(FPlatformTime::Seconds() + AugmentaLoadGenerator::DrainTime);
+
+	Report.FramesSent = Generator->GetFramesSent();
+	Report.MessagesSent = Generator->GetMessagesSent();
+	Report.MessagesLost = Generator->GetMessagesLost();
+
+	const FAugmentaDispatchStats Stats = Receiver->GetDispatchStats();
+	Report.MessagesReceived = Stats.MessagesDecoded;
+	Report.MessagesDropped = FMath::Max<int64>(Report.MessagesSent - Report.MessagesLost - Report.MessagesReceived, 0);
+	Report.DroppedLeaves = Stats.DroppedLeaves;
+
+	if (Latencies.Num() > 0)
+	{
+		Latencies.Sort();
+		double TotalLatency = 0.0;
+		for (const double Latency : Latencies)
+		{
+			TotalLatency += Latency;
+		}
+		Report.AverageLatency = static_cast<float>(TotalLatency / Latencies.Num() * 1000.0);
+		Report.P99Latency = static_cast<float>(Latencies[FMath::Min(Latencies.Num() * 99 / 100, Latencies.Num() - 1)] * 1000.0);
+		Report.MaxLatency = static_cast<float>(Latencies.Last() * 1000.0);
+	}
+	if (NumTicks > 0)
+	{
+		Report.AverageTickTime = static_cast<float>(TotalTickTime / NumTicks * 1000.0);
+		Report.MaxTickTime = static_cast<float>(MaxTickTime * 1000.0);
+	}
+	if (Report.FramesReceived > 0)
+	{
+		Report.TickTimePerFrame = static_cast<float>(TotalTickTime / Report.FramesReceived * 1000.0);
+	}
+
+	Receiver->OnFrameNative.Remove(FrameHandle);
+	Generator.Reset();
+	Receiver->Stop();
+	Receiver->RemoveFromRoot();
+	return Report;
+}
+
+void FAugmentaLoadGenerator::AddObject()
+{
+	using namespace AugmentaLoadGenerator;
+
+	const FVector2f SceneSize(FMath::Max(Settings.SceneSize.X, 1.0), FMath::Max(Settings.SceneSize.Y, 1.0));
+	const float Speed = Random.FRandRange(0.f, MaxSpeed);
+	const float Direction = Random.FRandRange(0.f, 2.f * PI);
+
+	FObject& Object = Objects.AddDefaulted_GetRef();
+	Object.Velocity = FVector2f(FMath::Cos(Direction), FMath::Sin(Direction)) * Speed / SceneSize;
+	Object.bEntered = false;
+
+	FAugmentaObjectMessage& Message = Object.Message;
+	Message.Pid = NextPid++;
+	Message.CentroidX = Random.FRand();
+	Message.CentroidY = Random.FRand();
+	Message.BoundingRectSizeX = ObjectSize / SceneSize.X;
+	Message.BoundingRectSizeY = ObjectSize / SceneSize.Y;
+	Message.Height = Random.FRandRange(1.f, 2.f);
+	Message.Orientation = FMath::RadiansToDegrees(Direction);
+}
+
+void FAugmentaLoadGenerator::BeginDatagram(FAugmentaOSCEncoder& Encoder)
+{
+	Encoder.Reset();
+	if (Settings.MaxDatagramSize > 0)
+	{
+		Encoder.BeginBundle(FAugmentaOSCEncoder::SecondsToTimeTag(FPlatformTime::Seconds()));
+	}
+}
+
+void FAugmentaLoadGenerator::BeginDatagram(FAugmentaBinaryEncoder& Encoder)
+{
+	Encoder.Reset();
+}
+
+template <typename EncoderType>
+void FAugmentaLoadGenerator::SendDatagram(EncoderType& Encoder)
+{
+	const int32 NumMessages = Encoder.GetNumMessages();
+	if (NumMessages == 0)
+	{
+		return;
+	}
+	AugmentaLoadGenerator::EndDatagram(Encoder);
+
+	if (Random.FRand() < Settings.PacketLoss)
+	{
+		MessagesLost.Increment(NumMessages);
+	}
+	else
+	{
+		int32 BytesSent = 0;
+		Socket->SendTo(Encoder.GetData(), static_cast<int32>(Encoder.GetSize()), BytesSent, *Destination);
+	}
+	MessagesSent.Increment(NumMessages);
+	Encoder.Reset();
+}
+
+template <typename EncoderType, typename WriteFuncType>
+void FAugmentaLoadGenerator::WriteMessage(EncoderType& Encoder, WriteFuncType&& WriteFunc)
+{
+	if (!WriteFunc(Encoder))
+	{
+		SendDatagram(Encoder);
+		BeginDatagram(Encoder);
+		verify(WriteFunc(Encoder));
+	}
+}
+
+template <typename EncoderType>
+void FAugmentaLoadGenerator::WriteObject(EncoderType& Encoder, EAugmentaMessageType Type, EAugmentaMessageType ExtraType, const FAugmentaObjectMessage& Message)
+{
+	WriteMessage(Encoder, [Type, &Message](EncoderType& Target) { return Target.WriteObject(Type, Message); });
+
+	if (Settings.bSendExtraData)
+	{
+		FAugmentaObjectExtraMessage Extra;
+		Extra.Frame = Message.Frame;
+		Extra.Id = Message.Pid;
+		Extra.Oid = Message.Oid;
+		Extra.HighestX = Message.CentroidX;
+		Extra.HighestY = Message.CentroidY;
+		Extra.Distance = Message.Height;
+		Extra.Reflectivity = 0.5f;
+		WriteMessage(Encoder, [ExtraType, &Extra](EncoderType& Target) { return Target.WriteObjectExtra(ExtraType, Extra); });
+	}
+}
+
+template <typename EncoderType>
+void FAugmentaLoadGenerator::EncodeFrame(EncoderType& Encoder, int32 Frame)
+{
+	BeginDatagram(Encoder);
+
+	FAugmentaSceneMessage Scene;
+	Scene.Frame = Frame;
+	Scene.ObjectCount = Objects.Num();
+	Scene.SizeX = Settings.SceneSize.X;
+	Scene.SizeY = Settings.SceneSize.Y;
+	WriteMessage(Encoder, [&Scene](EncoderType& Target) { return Target.WriteScene(Scene); });
+
+	FAugmentaVideoOutputMessage VideoOutput;
+	VideoOutput.SizeX = Settings.SceneSize.X;
+	VideoOutput.SizeY = Settings.SceneSize.Y;
+	VideoOutput.ResolutionX = FMath::RoundToInt(Settings.SceneSize.X * 100.f);
+	VideoOutput.ResolutionY = FMath::RoundToInt(Settings.SceneSize.Y * 100.f);
+	WriteMessage(Encoder, [&VideoOutput](EncoderType& Target) { return Target.WriteVideoOutput(VideoOutput); });
+
+	for (FAugmentaObjectMessage& Leaving : LeavingObjects)
+	{
+		Leaving.Frame = Frame;
+		WriteObject(Encoder, EAugmentaMessageType::ObjectLeave, EAugmentaMessageType::ObjectExtraLeave, Leaving);
+	}
+
+	for (FObject& Object : Objects)
+	{
+		const bool bEntering = !Object.bEntered;
+		Object.bEntered = true;
+		WriteObject(Encoder,
+			bEntering ? EAugmentaMessageType::ObjectEnter : EAugmentaMessageType::ObjectUpdate,
+			bEntering ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectExtraUpdate,
+			Object.Message);
+	}
+
+	SendDatagram(Encoder);
+}
+
+void FAugmentaLoadGenerator::SendFrame(int32 Frame, float DeltaTime)
+{
+	// Replace the objects leaving the scene
+	PendingChurn += Settings.ChurnPerSecond * DeltaTime;
+	LeavingObjects.Reset();
+	while (PendingChurn >= 1.f && Objects.Num() > 0)
+	{
+		const int32 Index = Random.RandHelper(Objects.Num());
+		if (Objects[Index].bEntered)
+		{
+			LeavingObjects.Add(Objects[Index].Message);
+		}
+		Objects.RemoveAtSwap(Index, 1, false);
+		AddObject();
+		PendingChurn -= 1.f;
+	}
+
+	// Move the objects, bouncing on the borders of the scene
+	for (int32 Index = 0; Index < Objects.Num(); ++Index)
+	{
+		FObject& Object = Objects[Index];
+		FAugmentaObjectMessage& Message = Object.Message;
+		Message.CentroidX += Object.Velocity.X * DeltaTime;
+		Message.CentroidY += Object.Velocity.Y * DeltaTime;
+		if (Message.CentroidX < 0.f || Message.CentroidX > 1.f)
+		{
+			Object.Velocity.X = -Object.Velocity.X;
+			Message.CentroidX = FMath::Clamp(Message.CentroidX, 0.f, 1.f);
+		}
+		if (Message.CentroidY < 0.f || Message.CentroidY > 1.f)
+		{
+			Object.Velocity.Y = -Object.Velocity.Y;
+			Message.CentroidY = FMath::Clamp(Message.CentroidY, 0.f, 1.f);
+		}
+
+		Message.Frame = Frame;
+		Message.Oid = Index;
+		Message.Age += DeltaTime;
+		Message.VelocityX = Object.Velocity.X;
+		Message.VelocityY = Object.Velocity.Y;
+		Message.BoundingRectPosX = Message.CentroidX;
+		Message.BoundingRectPosY = Message.CentroidY;
+	}
+
+	// The latency of the frame is measured from its first datagram
+	FSendTime& SendTime = SendTimes[Frame % SendTimeHistorySize];
+	SendTime.Time.store(FPlatformTime::Seconds(), std::memory_order_relaxed);
+	SendTime.Frame.store(Frame, std::memory_order_release);
+
+	if (Settings.bBinaryProtocol)
+	{
+		FAugmentaBinaryEncoder Encoder(DatagramBuffer.GetData(), DatagramBuffer.Num());
+		EncodeFrame(Encoder, Frame);
+	}
+	else
+	{
+		FAugmentaOSCEncoder Encoder(DatagramBuffer.GetData(), DatagramBuffer.Num());
+		EncodeFrame(Encoder, Frame);
+	}
+	FramesSent.Increment();
+}
@@ -0,0 +1,51 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaLoadTestCommandlet.h"
+#include "AugmentaLoadGenerator.h"
+#include "AugmentaUnreal.h"
+
+UAugmentaLoadTestCommandlet::UAugmentaLoadTestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Stress-tests an Augmenta receiver with a synthetic crowd sent over the loopback.");
+}
+
+int32 UAugmentaLoadTestCommandlet::Main(const FString& Params)
+{
+	FAugmentaLoadSettings Settings;
+	FParse::Value(*Params, TEXT("Objects="), Settings.ObjectCount);
+	FParse::Value(*Params, TEXT("FrameRate="), Settings.FrameRate);
+	FParse::Value(*Params, TEXT("Churn="), Settings.ChurnPerSecond);
+	FParse::Value(*Params, TEXT("Loss="), Settings.PacketLoss);
+	FParse::Value(*Params, TEXT("Duration="), Settings.Duration);
+	FParse::Value(*Params, TEXT("TickRate="), Settings.TickRate);
+	FParse::Value(*Params, TEXT("Port="), Settings.Port);
+	FParse::Value(*Params, TEXT("DatagramSize="), Settings.MaxDatagramSize);
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	Settings.bSendExtraData = !FParse::Param(*Params, TEXT("NoExtra"));
+	Settings.bFrameAssembly = !FParse::Param(*Params, TEXT("NoFrameAssembly"));
+	Settings.bDecodeOnReceiveThread = FParse::Param(*Params, TEXT("DecodeOnReceiveThread"));
+	Settings.bBinaryProtocol = FParse::Param(*Params, TEXT("Binary"));
+
+	UE_LOG(LogAugmenta, Display, TEXT("Sending %d objects at %.1f fps for %.1f s, churn %.1f/s, loss %.1f%%."),
+		Settings.ObjectCount, Settings.FrameRate, Settings.Duration, Settings.ChurnPerSecond, Settings.PacketLoss * 100.f);
+
+	const FAugmentaLoadReport Report = FAugmentaLoadGenerator::RunLoadTest(Settings);
+
+	TArray<FString> Lines;
+	Report.ToString().ParseIntoArrayLines(Lines);
+	for (const FString& Line : Lines)
+	{
+		UE_LOG(LogAugmenta, Display, TEXT("%s"), *Line);
+	}
+
+	if (Report.FramesReceived == 0)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("The receiver did not receive any frame."));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AugmentaLoadTestCommandlet.generated.h"
+
+/**
+ * Runs a load test against a receiver listening on the loopback and logs its report (see FAugmentaLoadGenerator::RunLoadTest).
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=AugmentaLoadTest [-Objects=100] [-FrameRate=60] [-Churn=1] [-Loss=0] [-Duration=10]
+ *     [-TickRate=60] [-Port=12000] [-DatagramSize=1400] [-Seed=0] [-NoExtra] [-NoFrameAssembly] [-DecodeOnReceiveThread]
+ *     [-Binary]
+ */
+UCLASS()
+class UAugmentaLoadTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaLoadTestCommandlet();
+
+	//~ Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet interface
+};
@@ -0,0 +1,513 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaOSCDecoder.h"
+
+#include <cstring>
+
+namespace AugmentaOSC
+{
+	/** The maximum number of arguments read from a single message. Augmenta messages have at most 15. */
+	constexpr int32_t MaxArguments = 32;
+	/** The maximum depth of nested bundles. */
+	constexpr int32_t MaxBundleDepth = 8;
+	/** The OSC bundle identifier, including its null terminator. */
+	constexpr char BundleTag[8] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0' };
+
+	inline uint32_t ReadUInt32(const uint8_t* Data)
+	{
+		return (uint32_t(Data[0]) << 24) | (uint32_t(Data[1]) << 16) | (uint32_t(Data[2]) << 8) | uint32_t(Data[3]);
+	}
+
+	inline uint64_t ReadUInt64(const uint8_t* Data)
+	{
+		return (uint64_t(ReadUInt32(Data)) << 32) | uint64_t(ReadUInt32(Data + 4));
+	}
+
+	/** Returns the size of the padded OSC string starting at Data, or 0 if it is not null terminated. */
+	inline size_t PaddedStringSize(const uint8_t* Data, size_t Size)
+	{
+		const void* Terminator = memchr(Data, 0, Size);
+		if (!Terminator)
+		{
+			return 0;
+		}
+		const size_t Length = static_cast<const uint8_t*>(Terminator) - Data;
+		const size_t Padded = (Length + 4) & ~size_t(3);
+		return Padded <= Size ? Padded : 0;
+	}
+
+	/** Scans the null terminated string starting at Data, computing its length and its FNV-1a hash in a single pass. */
+	inline bool HashString(const uint8_t* Data, size_t Size, uint32_t& OutLength, uint32_t& OutHash)
+	{
+		uint32_t Hash = 2166136261u;
+		for (size_t Index = 0; Index < Size; ++Index)
+		{
+			if (Data[Index] == 0)
+			{
+				OutLength = static_cast<uint32_t>(Index);
+				OutHash = Hash;
+				return true;
+			}
+			Hash = (Hash ^ Data[Index]) * 16777619u;
+		}
+		return false;
+	}
+
+	/** The addresses sent by the Augmenta Fusion and the Augmenta Node(s). */
+	struct FAddressDefinition
+	{
+		const char* Address;
+		EAugmentaMessageType Type;
+	};
+
+	constexpr FAddressDefinition Addresses[] =
+	{
+		{ "/scene", EAugmentaMessageType::Scene },
+		{ "/fusion", EAugmentaMessageType::VideoOutput },
+		{ "/object/enter", EAugmentaMessageType::ObjectEnter },
+		{ "/object/update", EAugmentaMessageType::ObjectUpdate },
+		{ "/object/leave", EAugmentaMessageType::ObjectLeave },
+		{ "/object/enter/extra", EAugmentaMessageType::ObjectExtraEnter },
+		{ "/object/update/extra", EAugmentaMessageType::ObjectExtraUpdate },
+		{ "/object/leave/extra", EAugmentaMessageType::ObjectExtraLeave },
+	};
+
+	inline bool SegmentEquals(const char* Segment, size_t Length, const char* Literal)
+	{
+		return strlen(Literal) == Length && memcmp(Segment, Literal, Length) == 0;
+	}
+
+	/** Gives typed access to the arguments of an OSC message without copying them. */
+	class FArgumentReader
+	{
+	public:
+		/** Parses the type tag string and computes the offset of every argument. */
+		bool Parse(const char* TypeTags, size_t NumTags, const uint8_t* InData, size_t InSize)
+		{
+			Data = InData;
+			NumArguments = 0;
+
+			size_t Offset = 0;
+			for (size_t TagIndex = 0; TagIndex < NumTags && NumArguments < MaxArguments; ++TagIndex)
+			{
+				const char Tag = TypeTags[TagIndex];
+				size_t ArgumentSize = 0;
+				switch (Tag)
+				{
+				case 'i': case 'f': case 'c': case 'r': case 'm':
+					ArgumentSize = 4;
+					break;
+				case 'h': case 't': case 'd':
+					ArgumentSize = 8;
+					break;
+				case 's': case 'S':
+					ArgumentSize = Offset < InSize ? PaddedStringSize(Data + Offset, InSize - Offset) : 0;
+					if (ArgumentSize == 0)
+					{
+						return false;
+					}
+					break;
+				case 'b':
+					if (Offset + 4 > InSize)
+					{
+						return false;
+					}
+					ArgumentSize = 4 + ((size_t(ReadUInt32(Data + Offset)) + 3) & ~size_t(3));
+					break;
+				case 'T': case 'F': case 'N': case 'I': case '[': case ']':
+					ArgumentSize = 0;
+					break;
+				default:
+					return false;
+				}
+
+				if (Offset + ArgumentSize > InSize)
+				{
+					return false;
+				}
+
+				Tags[NumArguments] = Tag;
+				Offsets[NumArguments] = static_cast<uint32_t>(Offset);
+				++NumArguments;
+				Offset += ArgumentSize;
+			}
+			return true;
+		}
+
+		/** Reads a numeric argument as an int32, leaving Value untouched if it is missing or not numeric. */
+		bool GetInt32(int32_t Index, int32_t& Value) const
+		{
+			if (Index >= NumArguments)
+			{
+				return false;
+			}
+			const uint8_t* Argument = Data + Offsets[Index];
+			switch (Tags[Index])
+			{
+			case 'i':
+				Value = static_cast<int32_t>(ReadUInt32(Argument));
+				return true;
+			case 'h':
+				Value = static_cast<int32_t>(static_cast<int64_t>(ReadUInt64(Argument)));
+				return true;
+			case 'f':
+				Value = static_cast<int32_t>(ReadFloat(Argument));
+				return true;
+			case 'd':
+				Value = static_cast<int32_t>(ReadDouble(Argument));
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/** Reads a numeric argument as a float, leaving Value untouched if it is missing or not numeric. */
+		bool GetFloat(int32_t Index, float& Value) const
+		{
+			if (Index >= NumArguments)
+			{
+				return false;
+			}
+			const uint8_t* Argument = Data + Offsets[Index];
+			switch (Tags[Index])
+			{
+			case 'f':
+				Value = ReadFloat(Argument);
+				return true;
+			case 'd':
+				Value = static_cast<float>(ReadDouble(Argument));
+				return true;
+			case 'i':
+				Value = static_cast<float>(static_cast<int32_t>(ReadUInt32(Argument)));
+				return true;
+			case 'h':
+				Value = static_cast<float>(static_cast<int64_t>(ReadUInt64(Argument)));
+				return true;
+			default:
+				return false;
+			}
+		}
+
+	private:
+		static float ReadFloat(const uint8_t* Argument)
+		{
+			const uint32_t Bits = ReadUInt32(Argument);
+			float Value;
+			memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		static double ReadDouble(const uint8_t* Argument)
+		{
+			const uint64_t Bits = ReadUInt64(Argument);
+			double Value;
+			memcpy(&Value, &Bits, sizeof(Value));
+			return Value;
+		}
+
+		const uint8_t* Data = nullptr;
+		int32_t NumArguments = 0;
+		char Tags[MaxArguments];
+		uint32_t Offsets[MaxArguments];
+	};
+}
+
+void FAugmentaOSCDecoder::BuildDispatchTable()
+{
+	using namespace AugmentaOSC;
+
+	for (FDispatchEntry& Entry : DispatchTable)
+	{
+		Entry = FDispatchEntry();
+	}
+
+	for (const FAddressDefinition& Definition : Addresses)
+	{
+		FDispatchEntry Entry;
+		Entry.Address = Definition.Address;
+		Entry.Type = Definition.Type;
+		HashString(reinterpret_cast<const uint8_t*>(Definition.Address), strlen(Definition.Address) + 1, Entry.Length, Entry.Hash);
+
+		// Linear probing, the table is sized so that it never fills up.
+		uint32_t Index = Entry.Hash & (DispatchTableSize - 1);
+		while (DispatchTable[Index].Address)
+		{
+			Index = (Index + 1) & (DispatchTableSize - 1);
+		}
+		DispatchTable[Index] = Entry;
+	}
+
+	bHasDispatchTable = true;
+}
+
+bool FAugmentaOSCDecoder::Decode(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener)
+{
+	if (!DecodePacket(Data, Size, 0, Listener))
+	{
+		MalformedPackets.Increment();
+		return false;
+	}
+	return true;
+}
+
+EAugmentaMessageType FAugmentaOSCDecoder::ClassifyAddress(const char* Address, size_t Length)
+{
+	using namespace AugmentaOSC;
+
+	// Split the address into its containers and its method, the same way FOSCAddress does.
+	constexpr int32_t MaxSegments = 3;
+	const char* Segments[MaxSegments + 1];
+	size_t SegmentLengths[MaxSegments + 1];
+	int32_t NumSegments = 0;
+
+	const char* Method = nullptr;
+	size_t MethodLength = 0;
+
+	size_t Start = 1;
+	for (size_t Index = 1; Index <= Length; ++Index)
+	{
+		if (Index == Length || Address[Index] == '/')
+		{
+			Method = Address + Start;
+			MethodLength = Index - Start;
+			if (Index < Length && NumSegments < MaxSegments)
+			{
+				Segments[NumSegments] = Method;
+				SegmentLengths[NumSegments] = MethodLength;
+				++NumSegments;
+			}
+			Start = Index + 1;
+		}
+	}
+
+	if (!Method)
+	{
+		return EAugmentaMessageType::Unknown;
+	}
+
+	// Ensure it is an Augmenta object message
+	if (NumSegments > 0 && SegmentEquals(Segments[0], SegmentLengths[0], "object"))
+	{
+		const char* Action = Method;
+		size_t ActionLength = MethodLength;
+		bool bIsExtra = false;
+
+		if (NumSegments > 1)
+		{
+			if (!SegmentEquals(Method, MethodLength, "extra"))
+			{
+				return EAugmentaMessageType::Unknown;
+			}
+			Action = Segments[1];
+			ActionLength = SegmentLengths[1];
+			bIsExtra = true;
+		}
+
+		if (SegmentEquals(Action, ActionLength, "enter"))
+		{
+			return bIsExtra ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectEnter;
+		}
+		if (SegmentEquals(Action, ActionLength, "update"))
+		{
+			return bIsExtra ? EAugmentaMessageType::ObjectExtraUpdate : EAugmentaMessageType::ObjectUpdate;
+		}
+		if (SegmentEquals(Action, ActionLength, "leave"))
+		{
+			return bIsExtra ? EAugmentaMessageType::ObjectExtraLeave : EAugmentaMessageType::ObjectLeave;
+		}
+		return EAugmentaMessageType::Unknown;
+	}
+
+	if (SegmentEquals(Method, MethodLength, "scene"))
+	{
+		return EAugmentaMessageType::Scene;
+	}
+	if (SegmentEquals(Method, MethodLength, "fusion"))
+	{
+		return EAugmentaMessageType::VideoOutput;
+	}
+	return EAugmentaMessageType::Unknown;
+}
+
+void FAugmentaOSCDecoder::ResetCounters()
+{
+	MessagesDecoded.Reset();
+	MessagesIgnored.Reset();
+	MalformedPackets.Reset();
+	DispatchTableHits.Reset();
+	DispatchTableMisses.Reset();
+}
+
+EAugmentaMessageType FAugmentaOSCDecoder::Dispatch(const char* Address, uint32_t Length, uint32_t Hash)
+{
+	if (bHasDispatchTable)
+	{
+		for (uint32_t Index = Hash & (DispatchTableSize - 1); DispatchTable[Index].Address; Index = (Index + 1) & (DispatchTableSize - 1))
+		{
+			const FDispatchEntry& Entry = DispatchTable[Index];
+			if (Entry.Hash == Hash && Entry.Length == Length && memcmp(Entry.Address, Address, Length) == 0)
+			{
+				DispatchTableHits.Increment();
+				return Entry.Type;
+			}
+		}
+	}
+
+	DispatchTableMisses.Increment();
+	return ClassifyAddress(Address, Length);
+}
+
+bool FAugmentaOSCDecoder::DecodePacket(const uint8_t* Data, size_t Size, int32_t Depth, IAugmentaDecoderListener& Listener)
+{
+	using namespace AugmentaOSC;
+
+	if (Size < 4 || (Size & 3) != 0)
+	{
+		return false;
+	}
+
+	if (Data[0] == '/')
+	{
+		return DecodeMessage(Data, Size, Listener);
+	}
+
+	if (Size < 16 || memcmp(Data, BundleTag, sizeof(BundleTag)) != 0 || Depth >= MaxBundleDepth)
+	{
+		return false;
+	}
+
+	// Skip the bundle tag and the time tag, then decode every element of the bundle.
+	size_t Offset = 16;
+	while (Offset < Size)
+	{
+		if (Offset + 4 > Size)
+		{
+			return false;
+		}
+		const size_t ElementSize = ReadUInt32(Data + Offset);
+		Offset += 4;
+		if (ElementSize > Size - Offset || !DecodePacket(Data + Offset, ElementSize, Depth + 1, Listener))
+		{
+			return false;
+		}
+		Offset += ElementSize;
+	}
+	return true;
+}
+
+bool FAugmentaOSCDecoder::DecodeMessage(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener)
+{
+	using namespace AugmentaOSC;
+
+	uint32_t AddressLength = 0;
+	uint32_t AddressHash = 0;
+	if (!HashString(Data, Size, AddressLength, AddressHash))
+	{
+		return false;
+	}
+	const char* Address = reinterpret_cast<const char*>(Data);
+	const size_t AddressSize = (size_t(AddressLength) + 4) & ~size_t(3);
+	if (AddressSize > Size)
+	{
+		return false;
+	}
+
+	// Messages without a type tag string have no arguments.
+	const char* TypeTags = "";
+	size_t NumTags = 0;
+	size_t Offset = AddressSize;
+	if (Offset < Size && Data[Offset] == ',')
+	{
+		const size_t TypeTagSize = PaddedStringSize(Data + Offset, Size - Offset);
+		if (TypeTagSize == 0)
+		{
+			return false;
+		}
+		TypeTags = reinterpret_cast<const char*>(Data + Offset + 1);
+		NumTags = strlen(TypeTags);
+		Offset += TypeTagSize;
+	}
+
+	const EAugmentaMessageType Type = Dispatch(Address, AddressLength, AddressHash);
+	if (Type == EAugmentaMessageType::Unknown)
+	{
+		MessagesIgnored.Increment();
+		return true;
+	}
+
+	FArgumentReader Arguments;
+	if (!Arguments.Parse(TypeTags, NumTags, Data + Offset, Size - Offset))
+	{
+		return false;
+	}
+
+	MessagesDecoded.Increment();
+
+	switch (Type)
+	{
+	case EAugmentaMessageType::Scene:
+	{
+		FAugmentaSceneMessage Scene;
+		Arguments.GetInt32(0, Scene.Frame);
+		Arguments.GetInt32(1, Scene.ObjectCount);
+		Arguments.GetFloat(2, Scene.SizeX);
+		Arguments.GetFloat(3, Scene.SizeY);
+		Listener.OnSceneDecoded(Scene);
+		break;
+	}
+	case EAugmentaMessageType::VideoOutput:
+	{
+		FAugmentaVideoOutputMessage VideoOutput;
+		Arguments.GetFloat(0, VideoOutput.OffsetX);
+		Arguments.GetFloat(1, VideoOutput.OffsetY);
+		Arguments.GetFloat(2, VideoOutput.SizeX);
+		Arguments.GetFloat(3, VideoOutput.SizeY);
+		Arguments.GetInt32(4, VideoOutput.ResolutionX);
+		Arguments.GetInt32(5, VideoOutput.ResolutionY);
+		Listener.OnVideoOutputDecoded(VideoOutput);
+		break;
+	}
+	case EAugmentaMessageType::ObjectEnter:
+	case EAugmentaMessageType::ObjectUpdate:
+	case EAugmentaMessageType::ObjectLeave:
+	{
+		FAugmentaObjectMessage Object;
+		Arguments.GetInt32(0, Object.Frame);
+		Arguments.GetInt32(1, Object.Pid);
+		Arguments.GetInt32(2, Object.Oid);
+		Arguments.GetFloat(3, Object.Age);
+		Arguments.GetFloat(4, Object.CentroidX);
+		Arguments.GetFloat(5, Object.CentroidY);
+		Arguments.GetFloat(6, Object.VelocityX);
+		Arguments.GetFloat(7, Object.VelocityY);
+		Arguments.GetFloat(8, Object.Orientation);
+		Arguments.GetFloat(9, Object.BoundingRectPosX);
+		Arguments.GetFloat(10, Object.BoundingRectPosY);
+		Arguments.GetFloat(11, Object.BoundingRectSizeX);
+		Arguments.GetFloat(12, Object.BoundingRectSizeY);
+		Arguments.GetFloat(13, Object.BoundingRectRotation);
+		Arguments.GetFloat(14, Object.Height);
+		Listener.OnObjectDecoded(Type, Object);
+		break;
+	}
+	case EAugmentaMessageType::ObjectExtraEnter:
+	case EAugmentaMessageType::ObjectExtraUpdate:
+	case EAugmentaMessageType::ObjectExtraLeave:
+	{
+		FAugmentaObjectExtraMessage Extra;
+		Arguments.GetInt32(0, Extra.Frame);
+		Arguments.GetInt32(1, Extra.Id);
+		Arguments.GetInt32(2, Extra.Oid);
+		Arguments.GetFloat(3, Extra.HighestX);
+		Arguments.GetFloat(4, Extra.HighestY);
+		Arguments.GetFloat(5, Extra.Distance);
+		Arguments.GetFloat(6, Extra.Reflectivity);
+		Listener.OnObjectExtraDecoded(Type, Extra);
+		break;
+	}
+	default:
+		break;
+	}
+
+	return true;
+}
@@ -0,0 +1,260 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaOSCEncoder.h"
+
+#include <cstring>
+
+namespace AugmentaOSCEncoder
+{
+	/** The bundle identifier followed by the time tag. */
+	constexpr size_t BundleHeaderSize = 16;
+	constexpr char BundleTag[8] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0' };
+
+	/** Returns the size of an OSC string once null terminated and padded to 4 bytes. */
+	inline size_t PaddedStringSize(size_t Length)
+	{
+		return (Length + 4) & ~size_t(3);
+	}
+
+	inline uint32_t Int32Bits(int32_t Value)
+	{
+		return static_cast<uint32_t>(Value);
+	}
+
+	inline uint32_t FloatBits(float Value)
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+}
+
+FAugmentaOSCEncoder::FAugmentaOSCEncoder(uint8_t* InBuffer, size_t InCapacity)
+	: Buffer(InBuffer)
+	, Capacity(InCapacity)
+{
+}
+
+void FAugmentaOSCEncoder::Reset()
+{
+	Size = 0;
+	NumMessages = 0;
+	BundleDepth = 0;
+}
+
+bool FAugmentaOSCEncoder::BeginBundle(uint64_t TimeTag)
+{
+	using namespace AugmentaOSCEncoder;
+
+	if (BundleDepth >= MaxBundleDepth)
+	{
+		return false;
+	}
+
+	// Only the nested bundles are prefixed by their size
+	const bool bNested = BundleDepth > 0;
+	if (!BeginElement(BundleHeaderSize))
+	{
+		return false;
+	}
+	BundleSizeOffsets[BundleDepth++] = bNested ? Size - 4 : 0;
+
+	WriteString(BundleTag, sizeof(BundleTag) - 1);
+	WriteUInt32(static_cast<uint32_t>(TimeTag >> 32));
+	WriteUInt32(static_cast<uint32_t>(TimeTag));
+	return true;
+}
+
+void FAugmentaOSCEncoder::EndBundle()
+{
+	if (BundleDepth == 0)
+	{
+		return;
+	}
+
+	--BundleDepth;
+	if (BundleDepth > 0)
+	{
+		// Patch the size prefix now that the content of the nested bundle is known
+		const size_t SizeOffset = BundleSizeOffsets[BundleDepth];
+		const uint32_t ElementSize = static_cast<uint32_t>(Size - SizeOffset - 4);
+		const size_t End = Size;
+		Size = SizeOffset;
+		WriteUInt32(ElementSize);
+		Size = End;
+	}
+}
+
+bool FAugmentaOSCEncoder::WriteScene(const FAugmentaSceneMessage& Scene)
+{
+	using namespace AugmentaOSCEncoder;
+
+	const uint32_t Arguments[] =
+	{
+		Int32Bits(Scene.Frame),
+		Int32Bits(Scene.ObjectCount),
+		FloatBits(Scene.SizeX),
+		FloatBits(Scene.SizeY),
+	};
+	return WriteMessage("/scene", ",iiff", Arguments, 4);
+}
+
+bool FAugmentaOSCEncoder::WriteVideoOutput(const FAugmentaVideoOutputMessage& VideoOutput)
+{
+	using namespace AugmentaOSCEncoder;
+
+	const uint32_t Arguments[] =
+	{
+		FloatBits(VideoOutput.OffsetX),
+		FloatBits(VideoOutput.OffsetY),
+		FloatBits(VideoOutput.SizeX),
+		FloatBits(VideoOutput.SizeY),
+		Int32Bits(VideoOutput.ResolutionX),
+		Int32Bits(VideoOutput.ResolutionY),
+	};
+	return WriteMessage("/fusion", ",ffffii", Arguments, 6);
+}
+
+bool FAugmentaOSCEncoder::WriteObject(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object)
+{
+	using namespace AugmentaOSCEncoder;
+
+	if (Type != EAugmentaMessageType::ObjectEnter && Type != EAugmentaMessageType::ObjectUpdate && Type != EAugmentaMessageType::ObjectLeave)
+	{
+		return false;
+	}
+
+	const uint32_t Arguments[] =
+	{
+		Int32Bits(Object.Frame),
+		Int32Bits(Object.Pid),
+		Int32Bits(Object.Oid),
+		FloatBits(Object.Age),
+		FloatBits(Object.CentroidX),
+		FloatBits(Object.CentroidY),
+		FloatBits(Object.VelocityX),
+		FloatBits(Object.VelocityY),
+		FloatBits(Object.Orientation),
+		FloatBits(Object.BoundingRectPosX),
+		FloatBits(Object.BoundingRectPosY),
+		FloatBits(Object.BoundingRectSizeX),
+		FloatBits(Object.BoundingRectSizeY),
+		FloatBits(Object.BoundingRectRotation),
+		FloatBits(Object.Height),
+	};
+	return WriteMessage(GetAddress(Type), ",iiiffffffffffff", Arguments, 15);
+}
+
+bool FAugmentaOSCEncoder::WriteObjectExtra(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra)
+{
+	using namespace AugmentaOSCEncoder;
+
+	if (Type != EAugmentaMessageType::ObjectExtraEnter && Type != EAugmentaMessageType::ObjectExtraUpdate && Type != EAugmentaMessageType::ObjectExtraLeave)
+	{
+		return false;
+	}
+
+	const uint32_t Arguments[] =
+	{
+		Int32Bits(Extra.Frame),
+		Int32Bits(Extra.Id),
+		Int32Bits(Extra.Oid),
+		FloatBits(Extra.HighestX),
+		FloatBits(Extra.HighestY),
+		FloatBits(Extra.Distance),
+		FloatBits(Extra.Reflectivity),
+	};
+	return WriteMessage(GetAddress(Type), ",iiiffff", Arguments, 7);
+}
+
+const char* FAugmentaOSCEncoder::GetAddress(EAugmentaMessageType Type)
+{
+	switch (Type)
+	{
+	case EAugmentaMessageType::Scene: return "/scene";
+	case EAugmentaMessageType::VideoOutput: return "/fusion";
+	case EAugmentaMessageType::ObjectEnter: return "/object/enter";
+	case EAugmentaMessageType::ObjectUpdate: return "/object/update";
+	case EAugmentaMessageType::ObjectLeave: return "/object/leave";
+	case EAugmentaMessageType::ObjectExtraEnter: return "/object/enter/extra";
+	case EAugmentaMessageType::ObjectExtraUpdate: return "/object/update/extra";
+	case EAugmentaMessageType::ObjectExtraLeave: return "/object/leave/extra";
+	default: return nullptr;
+	}
+}
+
+uint64_t FAugmentaOSCEncoder::SecondsToTimeTag(double Seconds)
+{
+	if (Seconds <= 0.0)
+	{
+		return 0;
+	}
+	const double WholeSeconds = static_cast<double>(static_cast<uint64_t>(Seconds));
+	const uint64_t Fraction = static_cast<uint64_t>((Seconds - WholeSeconds) * 4294967296.0);
+	return (static_cast<uint64_t>(WholeSeconds) << 32) | (Fraction & 0xFFFFFFFFull);
+}
+
+double FAugmentaOSCEncoder::TimeTagToSeconds(uint64_t TimeTag)
+{
+	return static_cast<double>(TimeTag >> 32) + static_cast<double>(TimeTag & 0xFFFFFFFFull) / 4294967296.0;
+}
+
+bool FAugmentaOSCEncoder::WriteMessage(const char* Address, const char* TypeTags, const uint32_t* Arguments, size_t NumArguments)
+{
+	using namespace AugmentaOSCEncoder;
+
+	const size_t AddressLength = strlen(Address);
+	const size_t TypeTagsLength = strlen(TypeTags);
+	const size_t MessageSize = PaddedStringSize(AddressLength) + PaddedStringSize(TypeTagsLength) + NumArguments * 4;
+	if (!BeginElement(MessageSize))
+	{
+		return false;
+	}
+
+	WriteString(Address, AddressLength);
+	WriteString(TypeTags, TypeTagsLength);
+	for (size_t Index = 0; Index < NumArguments; ++Index)
+	{
+		WriteUInt32(Arguments[Index]);
+	}
+
+	++NumMessages;
+	return true;
+}
+
+bool FAugmentaOSCEncoder::BeginElement(size_t ElementSize)
+{
+	const size_t PrefixSize = BundleDepth > 0 ? 4 : 0;
+	if (Size + PrefixSize + ElementSize > Capacity)
+	{
+		return false;
+	}
+
+	// Outside of a bundle, a datagram holds a single packet
+	if (BundleDepth == 0 && Size > 0)
+	{
+		return false;
+	}
+
+	if (PrefixSize > 0)
+	{
+		WriteUInt32(static_cast<uint32_t>(ElementSize));
+	}
+	return true;
+}
+
+void FAugmentaOSCEncoder::WriteUInt32(uint32_t Value)
+{
+	Buffer[Size++] = static_cast<uint8_t>(Value >> 24);
+	Buffer[Size++] = static_cast<uint8_t>(Value >> 16);
+	Buffer[Size++] = static_cast<uint8_t>(Value >> 8);
+	Buffer[Size++] = static_cast<uint8_t>(Value);
+}
+
+void FAugmentaOSCEncoder::WriteString(const char* String, size_t Length)
+{
+	const size_t PaddedSize = AugmentaOSCEncoder::PaddedStringSize(Length);
+	memcpy(Buffer + Size, String, Length);
+	memset(Buffer + Size + Length, 0, PaddedSize - Length);
+	Size += PaddedSize;
+}
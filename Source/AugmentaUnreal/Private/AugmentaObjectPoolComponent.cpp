@@ -0,0 +1,349 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaObjectPoolComponent.h"
+#include "AugmentaReceiver.h"
+#include "AugmentaStats.h"
+#include "AugmentaUnreal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+namespace AugmentaObjectPoolComponent
+{
+	/** The transform of a free instance, scaled to zero so that it is not drawn. */
+	const FTransform HiddenInstanceTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+
+	/** Turns an actor taken from or returned to the pool on or off. */
+	void SetActorActive(AActor* Actor, bool bActive)
+	{
+		if (IsValid(Actor))
+		{
+			Actor->SetActorHiddenInGame(!bActive);
+			Actor->SetActorEnableCollision(bActive);
+			Actor->SetActorTickEnabled(bActive);
+		}
+	}
+}
+
+UAugmentaObjectPoolComponent::UAugmentaObjectPoolComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// The receiver ticks with the tickable objects, after TG_PostUpdateWork : tick after it to show its latest frame
+	PrimaryComponentTick.TickGroup = TG_LastDemotable;
+}
+
+void UAugmentaObjectPoolComponent::SetReceiver(UAugmentaReceiver* InReceiver)
+{
+	if (InReceiver != Receiver)
+	{
+		ReleaseAll();
+		Receiver = InReceiver;
+	}
+}
+
+AActor* UAugmentaObjectPoolComponent::GetObjectActor(int32 Id) const
+{
+	const int32 ActiveSlot = ActiveIndex.Find(Id);
+	return ActiveSlot != INDEX_NONE && Mode == EAugmentaPoolMode::Actors ? PooledActors[ActiveEntries[ActiveSlot]].Get() : nullptr;
+}
+
+int32 UAugmentaObjectPoolComponent::GetObjectInstance(int32 Id) const
+{
+	const int32 ActiveSlot = ActiveIndex.Find(Id);
+	return ActiveSlot != INDEX_NONE && Mode == EAugmentaPoolMode::Instances ? ActiveEntries[ActiveSlot] : INDEX_NONE;
+}
+
+void UAugmentaObjectPoolComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (Mode == EAugmentaPoolMode::Actors && !ActorClass)
+	{
+		UE_LOG(LogAugmenta, Warning, TEXT("The Augmenta object pool of %s has no actor class, the objects will not be represented."), *GetNameSafe(GetOwner()));
+		return;
+	}
+
+	if (Mode == EAugmentaPoolMode::Instances)
+	{
+		InstancedMesh = NewObject<UInstancedStaticMeshComponent>(GetOwner(), NAME_None, RF_Transient);
+		InstancedMesh->SetStaticMesh(InstanceMesh);
+		InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		InstancedMesh->SetupAttachment(this);
+		InstancedMesh->RegisterComponent();
+	}
+
+	GrowPool(PoolSize);
+}
+
+void UAugmentaObjectPoolComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyPool();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UAugmentaObjectPoolComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaUpdateObjectPool);
+
+	++UpdateStamp;
+
+	if (Receiver && NumEntries > 0)
+	{
+		const FAugmentaFrameSnapshot& Snapshot = Receiver->GetFrameSnapshot();
+		const FAugmentaSmoother& Smoother = Receiver->GetSmoother();
+		const bool bSmoothed = bUseSmoothedPositions && Receiver->bSmoothObjects;
+
+		// The smoothed centroids are in the order of the smoother, the other ones in the order of the store
+		const FAugmentaObjectsSoA SoA = Snapshot.Objects.GetSoA();
+		const TConstArrayView<float> X = bSmoothed ? Smoother.GetSmoothedX() : SoA.CentroidX;
+		const TConstArrayView<float> Y = bSmoothed ? Smoother.GetSmoothedY() : SoA.CentroidY;
+		const int32 Num = X.Num();
+
+		// The instances are placed in the space of the instanced mesh component, attached to this one
+		const FTransform MetersToComponent(FQuat::Identity, FVector::ZeroVector, FVector(MetersToUnits));
+		const FTransform SceneToWorld = Mode == EAugmentaPoolMode::Instances ? MetersToComponent : MetersToComponent * GetComponentTransform();
+
+		WorldCoordinates.SetNumUninitialized(Num * 3, false);
+		const TArrayView<float> WorldX(WorldCoordinates.GetData(), Num);
+		const TArrayView<float> WorldY(WorldCoordinates.GetData() + Num, Num);
+		const TArrayView<float> WorldZ(WorldCoordinates.GetData() + Num * 2, Num);
+		FAugmentaBulkTransforms::NormalizedToWorld(X, Y, Snapshot.Scene.SceneSize, SceneToWorld, WorldX, WorldY, WorldZ);
+
+		const TConstArrayView<FAugmentaPerson> Objects = Snapshot.Objects.GetObjects();
+		const TConstArrayView<int32> SmoothedPids = Smoother.GetPids();
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			const FAugmentaPerson* Object = bSmoothed ? Snapshot.Objects.Find(SmoothedPids[Index]) : &Objects[Index];
+			if (!Object)
+			{
+				continue;
+			}
+
+			int32 ActiveSlot = ActiveIndex.Find(Object->Pid);
+			if (ActiveSlot == INDEX_NONE)
+			{
+				ActiveSlot = Acquire(*Object);
+				if (ActiveSlot == INDEX_NONE)
+				{
+					continue;
+				}
+			}
+
+			ActiveStamps[ActiveSlot] = UpdateStamp;
+			ActiveObjects[ActiveSlot] = *Object;
+
+			const FVector Location(WorldX[Index], WorldY[Index], WorldZ[Index]);
+			const int32 Entry = ActiveEntries[ActiveSlot];
+			if (Mode == EAugmentaPoolMode::Instances)
+			{
+				InstanceTransforms[Entry] = GetEntryTransform(*Object, Location);
+				bInstancesDirty = true;
+			}
+			else
+			{
+				AActor* Actor = PooledActors[Entry];
+				if (!IsValid(Actor))
+				{
+					continue;
+				}
+
+				if (bApplyOrientation)
+				{
+					const FQuat Rotation = GetComponentQuat() * GetEntryTransform(*Object, Location).GetRotation();
+					Actor->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+				}
+				else
+				{
+					Actor->SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+				}
+			}
+		}
+	}
+
+	// The objects not seen by this update are gone, iterating backwards as releasing moves the last slot
+	for (int32 ActiveSlot = ActivePids.Num() - 1; ActiveSlot >= 0; --ActiveSlot)
+	{
+		if (ActiveStamps[ActiveSlot] != UpdateStamp)
+		{
+			Release(ActiveSlot);
+		}
+	}
+
+	if (bInstancesDirty && InstancedMesh)
+	{
+		InstancedMesh->BatchUpdateInstancesTransforms(0, InstanceTransforms, false, true, true);
+		bInstancesDirty = false;
+	}
+}
+
+void UAugmentaObjectPoolComponent::GrowPool(int32 NumNewEntries)
+{
+	const int32 FirstEntry = NumEntries;
+
+	if (Mode == EAugmentaPoolMode::Actors)
+	{
+		UWorld* World = GetWorld();
+		if (!World || !ActorClass)
+		{
+			return;
+		}
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.Owner = GetOwner();
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		PooledActors.Reserve(NumEntries + NumNewEntries);
+		for (int32 Index = 0; Index < NumNewEntries; ++Index)
+		{
+			AActor* Actor = World->SpawnActor<AActor>(ActorClass, GetComponentTransform(), SpawnParameters);
+			AugmentaObjectPoolComponent::SetActorActive(Actor, false);
+			PooledActors.Add(Actor);
+		}
+	}
+	else
+	{
+		if (!InstancedMesh)
+		{
+			return;
+		}
+
+		InstanceTransforms.Reserve(NumEntries + NumNewEntries);
+		for (int32 Index = 0; Index < NumNewEntries; ++Index)
+		{
+			InstanceTransforms.Add(AugmentaObjectPoolComponent::HiddenInstanceTransform);
+		}
+		InstancedMesh->AddInstances(TArray<FTransform>(InstanceTransforms.GetData() + FirstEntry, NumNewEntries), false);
+	}
+
+	NumEntries += NumNewEntries;
+
+	// The free entries are taken from the end, push them backwards so that the first ones are used first
+	FreeEntries.Reserve(NumEntries);
+	for (int32 Entry = NumEntries - 1; Entry >= FirstEntry; --Entry)
+	{
+		FreeEntries.Add(Entry);
+	}
+
+	ActivePids.Reserve(NumEntries);
+	ActiveEntries.Reserve(NumEntries);
+	ActiveStamps.Reserve(NumEntries);
+	ActiveObjects.Reserve(NumEntries);
+}
+
+void UAugmentaObjectPoolComponent::DestroyPool()
+{
+	for (AActor* Actor : PooledActors)
+	{
+		if (IsValid(Actor))
+		{
+			Actor->Destroy();
+		}
+	}
+	PooledActors.Reset();
+
+	if (InstancedMesh)
+	{
+		InstancedMesh->DestroyComponent();
+		InstancedMesh = nullptr;
+	}
+
+	NumEntries = 0;
+	FreeEntries.Reset();
+	ActiveIndex.Reset();
+	ActivePids.Reset();
+	ActiveEntries.Reset();
+	ActiveStamps.Reset();
+	ActiveObjects.Reset();
+	InstanceTransforms.Reset();
+	bInstancesDirty = false;
+}
+
+int32 UAugmentaObjectPoolComponent::Acquire(const FAugmentaPerson& Object)
+{
+	if (FreeEntries.Num() == 0)
+	{
+		if (!bAllowPoolGrowth)
+		{
+			return INDEX_NONE;
+		}
+
+		UE_LOG(LogAugmenta, Log, TEXT("The Augmenta object pool of %s is full, growing it to %d entries."), *GetNameSafe(GetOwner()), NumEntries + PoolSize);
+		GrowPool(PoolSize);
+		if (FreeEntries.Num() == 0)
+		{
+			return INDEX_NONE;
+		}
+	}
+
+	const int32 Entry = FreeEntries.Pop(false);
+	const int32 ActiveSlot = ActivePids.Add(Object.Pid);
+	ActiveEntries.Add(Entry);
+	ActiveStamps.Add(UpdateStamp);
+	ActiveObjects.Add(Object);
+	ActiveIndex.Add(Object.Pid, ActiveSlot);
+
+	AActor* Actor = nullptr;
+	if (Mode == EAugmentaPoolMode::Actors)
+	{
+		Actor = PooledActors[Entry];
+		AugmentaObjectPoolComponent::SetActorActive(Actor, true);
+	}
+
+	OnObjectAcquired.Broadcast(Object, Actor, Actor ? INDEX_NONE : Entry);
+	return ActiveSlot;
+}
+
+void UAugmentaObjectPoolComponent::Release(int32 ActiveSlot)
+{
+	const int32 Entry = ActiveEntries[ActiveSlot];
+	const FAugmentaPerson Object = ActiveObjects[ActiveSlot];
+
+	ActiveIndex.Remove(Object.Pid);
+	const int32 LastSlot = ActivePids.Num() - 1;
+	if (ActiveSlot != LastSlot)
+	{
+		ActiveIndex.Update(ActivePids[LastSlot], ActiveSlot);
+	}
+	ActivePids.RemoveAtSwap(ActiveSlot, 1, false);
+	ActiveEntries.RemoveAtSwap(ActiveSlot, 1, false);
+	ActiveStamps.RemoveAtSwap(ActiveSlot, 1, false);
+	ActiveObjects.RemoveAtSwap(ActiveSlot, 1, false);
+
+	FreeEntries.Add(Entry);
+	HideEntry(Entry);
+
+	AActor* Actor = Mode == EAugmentaPoolMode::Actors ? PooledActors[Entry].Get() : nullptr;
+	OnObjectReleased.Broadcast(Object, Actor, Actor ? INDEX_NONE : Entry);
+}
+
+void UAugmentaObjectPoolComponent::ReleaseAll()
+{
+	for (int32 ActiveSlot = ActivePids.Num() - 1; ActiveSlot >= 0; --ActiveSlot)
+	{
+		Release(ActiveSlot);
+	}
+}
+
+void UAugmentaObjectPoolComponent::HideEntry(int32 Entry)
+{
+	if (Mode == EAugmentaPoolMode::Actors)
+	{
+		AugmentaObjectPoolComponent::SetActorActive(PooledActors[Entry], false);
+	}
+	else
+	{
+		InstanceTransforms[Entry] = AugmentaObjectPoolComponent::HiddenInstanceTransform;
+		bInstancesDirty = true;
+	}
+}
+
+FTransform UAugmentaObjectPoolComponent::GetEntryTransform(const FAugmentaPerson& Object, const FVector& Location) const
+{
+	// The Augmenta orientation is counter-clockwise as seen from above
+	const FQuat Rotation = bApplyOrientation ? FQuat(FVector::UpVector, FMath::DegreesToRadians(-Object.Orientation)) : FQuat::Identity;
+	return FTransform(Rotation, Location);
+}
@@ -0,0 +1,638 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaObjectStore.h"
+
+namespace AugmentaObjectStore
+{
+	/** The number of entries of an index when the first id is added. */
+	constexpr int32 InitialIndexSize = 64;
+}
+
+uint32 FAugmentaIdIndex::GetHomeIndex(int32 Id) const
+{
+	// Murmur3 finalizer, spreads the consecutive Augmenta ids over the whole table
+	uint32 Hash = static_cast<uint32>(Id);
+	Hash ^= Hash >> 16;
+	Hash *= 0x85ebca6b;
+	Hash ^= Hash >> 13;
+	Hash *= 0xc2b2ae35;
+	Hash ^= Hash >> 16;
+	return Hash & Mask;
+}
+
+int32 FAugmentaIdIndex::Find(int32 Id) const
+{
+	if (NumIds == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	for (uint32 EntryIndex = GetHomeIndex(Id); Entries[EntryIndex].Slot != INDEX_NONE; EntryIndex = (EntryIndex + 1) & Mask)
+	{
+		if (Entries[EntryIndex].Id == Id)
+		{
+			return Entries[EntryIndex].Slot;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void FAugmentaIdIndex::Add(int32 Id, int32 Slot)
+{
+	if ((NumIds + 1) * 2 > Entries.Num())
+	{
+		Grow();
+	}
+
+	uint32 EntryIndex = GetHomeIndex(Id);
+	while (Entries[EntryIndex].Slot != INDEX_NONE)
+	{
+		EntryIndex = (EntryIndex + 1) & Mask;
+	}
+	Entries[EntryIndex] = { Id, Slot };
+	++NumIds;
+}
+
+void FAugmentaIdIndex::Update(int32 Id, int32 Slot)
+{
+	for (uint32 EntryIndex = GetHomeIndex(Id); Entries[EntryIndex].Slot != INDEX_NONE; EntryIndex = (EntryIndex + 1) & Mask)
+	{
+		if (Entries[EntryIndex].Id == Id)
+		{
+			Entries[EntryIndex].Slot = Slot;
+			return;
+		}
+	}
+}
+
+bool FAugmentaIdIndex::Remove(int32 Id)
+{
+	if (NumIds == 0)
+	{
+		return false;
+	}
+
+	uint32 Hole = GetHomeIndex(Id);
+	while (Entries[Hole].Id != Id || Entries[Hole].Slot == INDEX_NONE)
+	{
+		if (Entries[Hole].Slot == INDEX_NONE)
+		{
+			return false;
+		}
+		Hole = (Hole + 1) & Mask;
+	}
+
+	// Backward shift deletion : move back the following entries that would not be found anymore across the hole.
+	for (uint32 EntryIndex = (Hole + 1) & Mask; Entries[EntryIndex].Slot != INDEX_NONE; EntryIndex = (EntryIndex + 1) & Mask)
+	{
+		const uint32 Home = GetHomeIndex(Entries[EntryIndex].Id);
+		const uint32 DistanceToHole = (Hole - Home) & Mask;
+		const uint32 DistanceToEntry = (EntryIndex - Home) & Mask;
+		if (DistanceToHole < DistanceToEntry)
+		{
+			Entries[Hole] = Entries[EntryIndex];
+			Hole = EntryIndex;
+		}
+	}
+
+	Entries[Hole].Slot = INDEX_NONE;
+	--NumIds;
+	return true;
+}
+
+void FAugmentaIdIndex::Reset()
+{
+	for (FEntry& Entry : Entries)
+	{
+		Entry.Slot = INDEX_NONE;
+	}
+	NumIds = 0;
+}
+
+void FAugmentaIdIndex::CopyFrom(const FAugmentaIdIndex& Other)
+{
+	Entries.Reset();
+	Entries.Append(Other.Entries);
+	NumIds = Other.NumIds;
+	Mask = Other.Mask;
+}
+
+void FAugmentaIdIndex::Grow()
+{
+	TArray<FEntry> OldEntries = MoveTemp(Entries);
+
+	const int32 NewSize = FMath::Max(AugmentaObjectStore::InitialIndexSize, OldEntries.Num() * 2);
+	Entries.Init({ 0, INDEX_NONE }, NewSize);
+	Mask = static_cast<uint32>(NewSize - 1);
+	NumIds = 0;
+
+	for (const FEntry& Entry : OldEntries)
+	{
+		if (Entry.Slot != INDEX_NONE)
+		{
+			Add(Entry.Id, Entry.Slot);
+		}
+	}
+}
+
+void FAugmentaSlotList::AddTail(int32 Slot)
+{
+	check(Slot == Links.Num());
+	Links.AddUninitialized();
+	LinkTail(Slot);
+}
+
+void FAugmentaSlotList::AddAfter(int32 Slot, int32 PrevSlot)
+{
+	check(Slot == Links.Num());
+	Links.AddUninitialized();
+
+	const int32 NextSlot = PrevSlot != INDEX_NONE ? Links[PrevSlot].Next : Head;
+	Links[Slot] = { PrevSlot, NextSlot };
+	if (PrevSlot != INDEX_NONE)
+	{
+		Links[PrevSlot].Next = Slot;
+	}
+	else
+	{
+		Head = Slot;
+	}
+	if (NextSlot != INDEX_NONE)
+	{
+		Links[NextSlot].Prev = Slot;
+	}
+	else
+	{
+		Tail = Slot;
+	}
+}
+
+void FAugmentaSlotList::MoveToTail(int32 Slot)
+{
+	if (Slot != Tail)
+	{
+		Unlink(Slot);
+		LinkTail(Slot);
+	}
+}
+
+void FAugmentaSlotList::RemoveSwap(int32 Slot, int32 LastSlot)
+{
+	Unlink(Slot);
+
+	if (Slot != LastSlot)
+	{
+		// Point the neighbours of the last slot to its new place
+		const FLink Moved = Links[LastSlot];
+		Links[Slot] = Moved;
+		if (Moved.Prev != INDEX_NONE)
+		{
+			Links[Moved.Prev].Next = Slot;
+		}
+		else
+		{
+			Head = Slot;
+		}
+		if (Moved.Next != INDEX_NONE)
+		{
+			Links[Moved.Next].Prev = Slot;
+		}
+		else
+		{
+			Tail = Slot;
+		}
+	}
+	Links.RemoveAt(LastSlot, 1, false);
+}
+
+void FAugmentaSlotList::Reset()
+{
+	Links.Reset();
+	Head = INDEX_NONE;
+	Tail = INDEX_NONE;
+}
+
+void FAugmentaSlotList::CopyFrom(const FAugmentaSlotList& Other)
+{
+	Links.Reset();
+	Links.Append(Other.Links);
+	Head = Other.Head;
+	Tail = Other.Tail;
+}
+
+void FAugmentaSlotList::Unlink(int32 Slot)
+{
+	const FLink Link = Links[Slot];
+	if (Link.Prev != INDEX_NONE)
+	{
+		Links[Link.Prev].Next = Link.Next;
+	}
+	else
+	{
+		Head = Link.Next;
+	}
+	if (Link.Next != INDEX_NONE)
+	{
+		Links[Link.Next].Prev = Link.Prev;
+	}
+	else
+	{
+		Tail = Link.Prev;
+	}
+}
+
+void FAugmentaSlotList::LinkTail(int32 Slot)
+{
+	Links[Slot] = { Tail, INDEX_NONE };
+	if (Tail != INDEX_NONE)
+	{
+		Links[Tail].Next = Slot;
+	}
+	else
+	{
+		Head = Slot;
+	}
+	Tail = Slot;
+}
+
+void FAugmentaUpdateOrder::Touch(int32 Slot, bool bAdded, int32 Frame, double Time)
+{
+	if (bAdded)
+	{
+		List.AddTail(Slot);
+		Frames.Add(Frame);
+		Times.Add(Time);
+	}
+	else
+	{
+		List.MoveToTail(Slot);
+		Frames[Slot] = Frame;
+		Times[Slot] = Time;
+	}
+}
+
+void FAugmentaUpdateOrder::RemoveSwap(int32 Slot, int32 LastSlot)
+{
+	List.RemoveSwap(Slot, LastSlot);
+	Frames.RemoveAtSwap(Slot, 1, false);
+	Times.RemoveAtSwap(Slot, 1, false);
+}
+
+int32 FAugmentaUpdateOrder::FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry) const
+{
+	// Only the least recently updated slot needs to be checked, the others were updated after it.
+	const int32 Slot = List.GetHead();
+	if (Slot == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	const bool bFramesExpired = Expiry.TimeoutFrames > 0 && CurrentFrame - Frames[Slot] > Expiry.TimeoutFrames;
+	const bool bSecondsExpired = Expiry.TimeoutSeconds > 0.0 && Now - Times[Slot] > Expiry.TimeoutSeconds;
+	return bFramesExpired || bSecondsExpired ? Slot : INDEX_NONE;
+}
+
+void FAugmentaUpdateOrder::RebaseFrames(int32 Frame)
+{
+	for (int32& SlotFrame : Frames)
+	{
+		SlotFrame = Frame;
+	}
+}
+
+void FAugmentaUpdateOrder::Reset()
+{
+	List.Reset();
+	Frames.Reset();
+	Times.Reset();
+}
+
+void FAugmentaUpdateOrder::CopyFrom(const FAugmentaUpdateOrder& Other)
+{
+	List.CopyFrom(Other.List);
+	Frames.Reset();
+	Frames.Append(Other.Frames);
+	Times.Reset();
+	Times.Append(Other.Times);
+}
+
+SIZE_T FAugmentaUpdateOrder::GetAllocatedSize() const
+{
+	return List.GetAllocatedSize() + Frames.GetAllocatedSize() + Times.GetAllocatedSize();
+}
+
+const FAugmentaPerson& FAugmentaObjectStore::Update(const FAugmentaObjectMessage& Message, double Time, bool& bOutAdded)
+{
+	const int32 Slot = Objects.FindOrAddSlot(Message.Pid, bOutAdded);
+	if (bOutAdded)
+	{
+		for (TArray<float>& Channel : Channels)
+		{
+			Channel.AddUninitialized();
+		}
+	}
+
+	FAugmentaPerson& Person = Objects.GetValue(Slot);
+	Person.Frame = Message.Frame;
+	Person.Pid = Message.Pid;
+	Person.Oid = Message.Oid;
+	Person.Age = Message.Age;
+	Person.Centroid.X = Message.CentroidX;
+	Person.Centroid.Y = Message.CentroidY;
+	Person.Velocity.X = Message.VelocityX;
+	Person.Velocity.Y = Message.VelocityY;
+	Person.Orientation = Message.Orientation;
+	Person.BoundingRectPos.X = Message.BoundingRectPosX;
+	Person.BoundingRectPos.Y = Message.BoundingRectPosY;
+	Person.BoundingRectSize.X = Message.BoundingRectSizeX;
+	Person.BoundingRectSize.Y = Message.BoundingRectSizeY;
+	Person.BoundingRectRotation = Message.BoundingRectRotation;
+	Person.Height = Message.Height;
+
+	// The channels keep the float values as received, without the round trip through the double precision vectors.
+	Channels[static_cast<int32>(EAugmentaObjectChannel::CentroidX)][Slot] = Message.CentroidX;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::CentroidY)][Slot] = Message.CentroidY;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::VelocityX)][Slot] = Message.VelocityX;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::VelocityY)][Slot] = Message.VelocityY;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::BoundingRectPosX)][Slot] = Message.BoundingRectPosX;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::BoundingRectPosY)][Slot] = Message.BoundingRectPosY;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::BoundingRectSizeX)][Slot] = Message.BoundingRectSizeX;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::BoundingRectSizeY)][Slot] = Message.BoundingRectSizeY;
+	Channels[static_cast<int32>(EAugmentaObjectChannel::Height)][Slot] = Message.Height;
+
+	UpdateOrder.Touch(Slot, bOutAdded, Message.Frame, Time);
+	if (bOutAdded)
+	{
+		AddToAgeOrder(Slot);
+		SpatialGrid.Add(Slot, Message.CentroidX, Message.CentroidY);
+	}
+	else
+	{
+		SpatialGrid.Move(Slot, Message.CentroidX, Message.CentroidY);
+	}
+
+	return Person;
+}
+
+bool FAugmentaObjectStore::Remove(int32 Pid, FAugmentaPerson& OutObject)
+{
+	int32 Slot;
+	if (!Objects.Remove(Pid, OutObject, Slot))
+	{
+		return false;
+	}
+
+	// Mirror the swap remove of the slot map
+	for (TArray<float>& Channel : Channels)
+	{
+		Channel.RemoveAtSwap(Slot, 1, false);
+	}
+	UpdateOrder.RemoveSwap(Slot, Objects.Num());
+	AgeOrder.RemoveSwap(Slot, Objects.Num());
+	SpatialGrid.RemoveSwap(Slot, Objects.Num());
+	return true;
+}
+
+void FAugmentaObjectStore::AddToAgeOrder(int32 Slot)
+{
+	// Every object ages at the same rate, so the order set when an object enters stays valid.
+	// A new object is usually the newest one and is linked at the tail right away.
+	const float Age = Objects.GetValue(Slot).Age;
+	int32 PrevSlot = AgeOrder.GetTail();
+	while (PrevSlot != INDEX_NONE && Objects.GetValue(PrevSlot).Age < Age)
+	{
+		PrevSlot = AgeOrder.GetPrev(PrevSlot);
+	}
+	AgeOrder.AddAfter(Slot, PrevSlot);
+}
+
+void FAugmentaObjectStore::Reset()
+{
+	Objects.Reset();
+	for (TArray<float>& Channel : Channels)
+	{
+		Channel.Reset();
+	}
+	UpdateOrder.Reset();
+	AgeOrder.Reset();
+	SpatialGrid.Reset();
+}
+
+void FAugmentaObjectStore::CopyFrom(const FAugmentaObjectStore& Other)
+{
+	Objects.CopyFrom(Other.Objects);
+	for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+	{
+		Channels[ChannelIndex].Reset();
+		Channels[ChannelIndex].Append(Other.Channels[ChannelIndex]);
+	}
+	UpdateOrder.CopyFrom(Other.UpdateOrder);
+	AgeOrder.CopyFrom(Other.AgeOrder);
+	SpatialGrid.CopyFrom(Other.SpatialGrid);
+}
+
+FAugmentaObjectsSoA FAugmentaObjectStore::GetSoA() const
+{
+	FAugmentaObjectsSoA SoA;
+	SoA.CentroidX = GetChannel(EAugmentaObjectChannel::CentroidX);
+	SoA.CentroidY = GetChannel(EAugmentaObjectChannel::CentroidY);
+	SoA.VelocityX = GetChannel(EAugmentaObjectChannel::VelocityX);
+	SoA.VelocityY = GetChannel(EAugmentaObjectChannel::VelocityY);
+	SoA.BoundingRectPosX = GetChannel(EAugmentaObjectChannel::BoundingRectPosX);
+	SoA.BoundingRectPosY = GetChannel(EAugmentaObjectChannel::BoundingRectPosY);
+	SoA.BoundingRectSizeX = GetChannel(EAugmentaObjectChannel::BoundingRectSizeX);
+	SoA.BoundingRectSizeY = GetChannel(EAugmentaObjectChannel::BoundingRectSizeY);
+	SoA.Height = GetChannel(EAugmentaObjectChannel::Height);
+	return SoA;
+}
+
+bool FAugmentaObjectStore::FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry, int32& OutPid) const
+{
+	const int32 Slot = UpdateOrder.FindExpired(CurrentFrame, Now, Expiry);
+	if (Slot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutPid = Objects.GetIds()[Slot];
+	return true;
+}
+
+const FAugmentaPerson* FAugmentaObjectStore::GetOldest() const
+{
+	const int32 Slot = AgeOrder.GetHead();
+	return Slot != INDEX_NONE ? &Objects.GetValue(Slot) : nullptr;
+}
+
+const FAugmentaPerson* FAugmentaObjectStore::GetNewest() const
+{
+	const int32 Slot = AgeOrder.GetTail();
+	return Slot != INDEX_NONE ? &Objects.GetValue(Slot) : nullptr;
+}
+
+void FAugmentaObjectStore::GetNOldest(int32 Count, TArray<FAugmentaPerson>& OutObjects) const
+{
+	OutObjects.Reserve(OutObjects.Num() + FMath::Clamp(Count, 0, Num()));
+	for (int32 Slot = AgeOrder.GetHead(); Slot != INDEX_NONE && Count > 0; Slot = AgeOrder.GetNext(Slot), --Count)
+	{
+		OutObjects.Add(Objects.GetValue(Slot));
+	}
+}
+
+void FAugmentaObjectStore::GetNNewest(int32 Count, TArray<FAugmentaPerson>& OutObjects) const
+{
+	OutObjects.Reserve(OutObjects.Num() + FMath::Clamp(Count, 0, Num()));
+	for (int32 Slot = AgeOrder.GetTail(); Slot != INDEX_NONE && Count > 0; Slot = AgeOrder.GetPrev(Slot), --Count)
+	{
+		OutObjects.Add(Objects.GetValue(Slot));
+	}
+}
+
+void FAugmentaObjectStore::FindInRect(const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots) const
+{
+	SpatialGrid.FindInRect(GetChannel(EAugmentaObjectChannel::CentroidX), GetChannel(EAugmentaObjectChannel::CentroidY), Min, Max, OutSlots);
+}
+
+void FAugmentaObjectStore::FindInRadius(const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots) const
+{
+	SpatialGrid.FindInRadius(GetChannel(EAugmentaObjectChannel::CentroidX), GetChannel(EAugmentaObjectChannel::CentroidY), Center, Radius, Scale, OutSlots);
+}
+
+void FAugmentaObjectStore::FindNearest(const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots) const
+{
+	SpatialGrid.FindNearest(GetChannel(EAugmentaObjectChannel::CentroidX), GetChannel(EAugmentaObjectChannel::CentroidY), Center, Count, Scale, OutSlots);
+}
+
+void FAugmentaObjectStore::FindPairs(float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs) const
+{
+	SpatialGrid.FindPairs(GetChannel(EAugmentaObjectChannel::CentroidX), GetChannel(EAugmentaObjectChannel::CentroidY), MaxDistance, Scale, OutPairs);
+}
+
+SIZE_T FAugmentaObjectStore::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = Objects.GetAllocatedSize() + UpdateOrder.GetAllocatedSize() + AgeOrder.GetAllocatedSize() + SpatialGrid.GetAllocatedSize();
+	for (const TArray<float>& Channel : Channels)
+	{
+		AllocatedSize += Channel.GetAllocatedSize();
+	}
+	return AllocatedSize;
+}
+
+const FAugmentaObjectExtra& FAugmentaObjectExtraStore::Update(const FAugmentaObjectExtraMessage& Message, double Time, bool& bOutAdded)
+{
+	const int32 Slot = Extras.FindOrAddSlot(Message.Id, bOutAdded);
+
+	FAugmentaObjectExtra& Extra = Extras.GetValue(Slot);
+	Extra.Frame = Message.Frame;
+	Extra.Id = Message.Id;
+	Extra.Oid = Message.Oid;
+	Extra.Highest.X = Message.HighestX;
+	Extra.Highest.Y = Message.HighestY;
+	Extra.Distance = Message.Distance;
+	Extra.Reflectivity = Message.Reflectivity;
+
+	UpdateOrder.Touch(Slot, bOutAdded, Message.Frame, Time);
+
+	return Extra;
+}
+
+bool FAugmentaObjectExtraStore::Remove(int32 Id, FAugmentaObjectExtra& OutExtra)
+{
+	int32 Slot;
+	if (!Extras.Remove(Id, OutExtra, Slot))
+	{
+		return false;
+	}
+
+	UpdateOrder.RemoveSwap(Slot, Extras.Num());
+	return true;
+}
+
+void FAugmentaObjectExtraStore::Reset()
+{
+	Extras.Reset();
+	UpdateOrder.Reset();
+}
+
+void FAugmentaObjectExtraStore::CopyFrom(const FAugmentaObjectExtraStore& Other)
+{
+	Extras.CopyFrom(Other.Extras);
+	UpdateOrder.CopyFrom(Other.UpdateOrder);
+}
+
+bool FAugmentaObjectExtraStore::FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry, int32& OutId) const
+{
+	const int32 Slot = UpdateOrder.FindExpired(CurrentFrame, Now, Expiry);
+	if (Slot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutId = Extras.GetIds()[Slot];
+	return true;
+}
+
+void FAugmentaBulkTransforms::NormalizedToMeters(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2D& SceneSize, TArrayView<float> OutX, TArrayView<float> OutY)
+{
+	check(Y.Num() == X.Num() && OutX.Num() >= X.Num() && OutY.Num() >= X.Num());
+
+	const float ScaleX = static_cast<float>(SceneSize.X);
+	const float ScaleY = static_cast<float>(SceneSize.Y);
+	const VectorRegister4Float VectorScaleX = VectorSetFloat1(ScaleX);
+	const VectorRegister4Float VectorScaleY = VectorSetFloat1(ScaleY);
+
+	const int32 Num = X.Num();
+	const int32 NumVectorized = Num & ~3;
+	int32 Index = 0;
+	for (; Index < NumVectorized; Index += 4)
+	{
+		VectorStore(VectorMultiply(VectorLoad(&X[Index]), VectorScaleX), &OutX[Index]);
+		VectorStore(VectorMultiply(VectorLoad(&Y[Index]), VectorScaleY), &OutY[Index]);
+	}
+	for (; Index < Num; ++Index)
+	{
+		OutX[Index] = X[Index] * ScaleX;
+		OutY[Index] = Y[Index] * ScaleY;
+	}
+}
+
+void FAugmentaBulkTransforms::NormalizedToWorld(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2D& SceneSize, const FTransform& SceneToWorld,
+	TArrayView<float> OutX, TArrayView<float> OutY, TArrayView<float> OutZ)
+{
+	check(Y.Num() == X.Num() && OutX.Num() >= X.Num() && OutY.Num() >= X.Num() && OutZ.Num() >= X.Num());
+
+	// The scene lies in the XY plane, so a world position is X * AxisX + Y * AxisY + Origin,
+	// with the scene size folded into the transformed axes.
+	const FMatrix SceneToWorldMatrix = SceneToWorld.ToMatrixWithScale();
+	const FVector3f AxisX = FVector3f(SceneToWorldMatrix.GetScaledAxis(EAxis::X) * SceneSize.X);
+	const FVector3f AxisY = FVector3f(SceneToWorldMatrix.GetScaledAxis(EAxis::Y) * SceneSize.Y);
+	const FVector3f Origin = FVector3f(SceneToWorldMatrix.GetOrigin());
+
+	const VectorRegister4Float AxisXX = VectorSetFloat1(AxisX.X);
+	const VectorRegister4Float AxisXY = VectorSetFloat1(AxisX.Y);
+	const VectorRegister4Float AxisXZ = VectorSetFloat1(AxisX.Z);
+	const VectorRegister4Float AxisYX = VectorSetFloat1(AxisY.X);
+	const VectorRegister4Float AxisYY = VectorSetFloat1(AxisY.Y);
+	const VectorRegister4Float AxisYZ = VectorSetFloat1(AxisY.Z);
+	const VectorRegister4Float OriginX = VectorSetFloat1(Origin.X);
+	const VectorRegister4Float OriginY = VectorSetFloat1(Origin.Y);
+	const VectorRegister4Float OriginZ = VectorSetFloat1(Origin.Z);
+
+	const int32 Num = X.Num();
+	const int32 NumVectorized = Num & ~3;
+	int32 Index = 0;
+	for (; Index < NumVectorized; Index += 4)
+	{
+		const VectorRegister4Float VectorX = VectorLoad(&X[Index]);
+		const VectorRegister4Float VectorY = VectorLoad(&Y[Index]);
+		VectorStore(VectorMultiplyAdd(VectorY, AxisYX, VectorMultiplyAdd(VectorX, AxisXX, OriginX)), &OutX[Index]);
+		VectorStore(VectorMultiplyAdd(VectorY, AxisYY, VectorMultiplyAdd(VectorX, AxisXY, OriginY)), &OutY[Index]);
+		VectorStore(VectorMultiplyAdd(VectorY, AxisYZ, VectorMultiplyAdd(VectorX, AxisXZ, OriginZ)), &OutZ[Index]);
+	}
+	for (; Index < Num; ++Index)
+	{
+		OutX[Index] = X[Index] * AxisX.X + Y[Index] * AxisY.X + Origin.X;
+		OutY[Index] = X[Index] * AxisX.Y + Y[Index] * AxisY.Y + Origin.Y;
+		OutZ[Index] = X[Index] * AxisX.Z + Y[Index] * AxisY.Z + Origin.Z;
+	}
+}
@@ -0,0 +1,176 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaObjectStoreBenchmarkCommandlet.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaUnreal.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace AugmentaObjectStoreBenchmarkCommandlet
+{
+	/** The update messages of every frame, all the objects first, then all their extra data. */
+	struct FUpdateStream
+	{
+		TArray<FAugmentaObjectMessage> Objects;
+		TArray<FAugmentaObjectExtraMessage> Extras;
+	};
+
+	FUpdateStream MakeStream(int32 NumObjects, int32 NumFrames, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		TArray<FAugmentaObjectMessage> Crowd;
+		for (int32 Index = 0; Index < NumObjects; ++Index)
+		{
+			FAugmentaObjectMessage& Object = Crowd.AddDefaulted_GetRef();
+			// Sparse ids, like the ones of a server that has been running for a while
+			Object.Pid = Index * 7 + Random.RandRange(0, 6);
+			Object.Oid = Index;
+			Object.CentroidX = Random.FRand();
+			Object.CentroidY = Random.FRand();
+			Object.VelocityX = Random.FRandRange(-0.01f, 0.01f);
+			Object.VelocityY = Random.FRandRange(-0.01f, 0.01f);
+			Object.BoundingRectSizeX = 0.05f;
+			Object.BoundingRectSizeY = 0.05f;
+			Object.Height = Random.FRandRange(1.f, 2.f);
+		}
+
+		FUpdateStream Stream;
+		Stream.Objects.Reserve(NumObjects * NumFrames);
+		Stream.Extras.Reserve(NumObjects * NumFrames);
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			for (FAugmentaObjectMessage& Object : Crowd)
+			{
+				Object.Frame = Frame;
+				Object.Age += 1.f / 60.f;
+				Object.CentroidX = FMath::Frac(Object.CentroidX + Object.VelocityX + 1.f);
+				Object.CentroidY = FMath::Frac(Object.CentroidY + Object.VelocityY + 1.f);
+				Object.BoundingRectPosX = Object.CentroidX;
+				Object.BoundingRectPosY = Object.CentroidY;
+				Stream.Objects.Add(Object);
+
+				FAugmentaObjectExtraMessage& Extra = Stream.Extras.AddDefaulted_GetRef();
+				Extra.Frame = Frame;
+				Extra.Id = Object.Pid;
+				Extra.Oid = Object.Oid;
+				Extra.HighestX = Object.CentroidX;
+				Extra.HighestY = Object.CentroidY;
+				Extra.Distance = Object.Height;
+				Extra.Reflectivity = 0.5f;
+			}
+		}
+		return Stream;
+	}
+
+	/** Applies the messages the way UAugmentaReceiver did before the object store : two lookups and two copies per message. */
+	double ApplyToMaps(const FUpdateStream& Stream, double& OutChecksum)
+	{
+		TMap<int32, FAugmentaPerson> ActiveObjects;
+		TMap<int32, FAugmentaObjectExtra> ActiveObjectsExtraData;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FAugmentaObjectMessage& Message : Stream.Objects)
+		{
+			FAugmentaPerson Person = ActiveObjects.FindOrAdd(Message.Pid);
+			Person.Pid = Message.Pid;
+			Person.Frame = Message.Frame;
+			Person.Oid = Message.Oid;
+			Person.Age = Message.Age;
+			Person.Centroid.X = Message.CentroidX;
+			Person.Centroid.Y = Message.CentroidY;
+			Person.Velocity.X = Message.VelocityX;
+			Person.Velocity.Y = Message.VelocityY;
+			Person.Orientation = Message.Orientation;
+			Person.BoundingRectPos.X = Message.BoundingRectPosX;
+			Person.BoundingRectPos.Y = Message.BoundingRectPosY;
+			Person.BoundingRectSize.X = Message.BoundingRectSizeX;
+			Person.BoundingRectSize.Y = Message.BoundingRectSizeY;
+			Person.BoundingRectRotation = Message.BoundingRectRotation;
+			Person.Height = Message.Height;
+			ActiveObjects[Message.Pid] = Person;
+			OutChecksum += Person.Height;
+		}
+		for (const FAugmentaObjectExtraMessage& Message : Stream.Extras)
+		{
+			FAugmentaObjectExtra Extra = ActiveObjectsExtraData.FindOrAdd(Message.Id);
+			Extra.Id = Message.Id;
+			Extra.Frame = Message.Frame;
+			Extra.Oid = Message.Oid;
+			Extra.Highest.X = Message.HighestX;
+			Extra.Highest.Y = Message.HighestY;
+			Extra.Distance = Message.Distance;
+			Extra.Reflectivity = Message.Reflectivity;
+			ActiveObjectsExtraData[Message.Id] = Extra;
+			OutChecksum += Extra.Distance;
+		}
+		return FPlatformTime::Seconds() - StartTime;
+	}
+
+	/** Applies the messages to the object stores, updated in place. */
+	double ApplyToStores(const FUpdateStream& Stream, double& OutChecksum)
+	{
+		FAugmentaObjectStore Objects;
+		FAugmentaObjectExtraStore ObjectExtras;
+		bool bAdded;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (const FAugmentaObjectMessage& Message : Stream.Objects)
+		{
+			OutChecksum += Objects.Update(Message, StartTime, bAdded).Height;
+		}
+		for (const FAugmentaObjectExtraMessage& Message : Stream.Extras)
+		{
+			OutChecksum += ObjectExtras.Update(Message, StartTime, bAdded).Distance;
+		}
+		return FPlatformTime::Seconds() - StartTime;
+	}
+}
+
+UAugmentaObjectStoreBenchmarkCommandlet::UAugmentaObjectStoreBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Compares the cost of an object update with a TMap and with the Augmenta object store.");
+}
+
+int32 UAugmentaObjectStoreBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace AugmentaObjectStoreBenchmarkCommandlet;
+
+	FString ObjectCountsParam = TEXT("50,200,1000");
+	int32 NumFrames = 2000;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Objects="), ObjectCountsParam, false);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	NumFrames = FMath::Max(NumFrames, 1);
+
+	TArray<FString> ObjectCounts;
+	ObjectCountsParam.ParseIntoArray(ObjectCounts, TEXT(","));
+
+	double Checksum = 0.0;
+	for (const FString& ObjectCount : ObjectCounts)
+	{
+		const int32 NumObjects = FMath::Max(FCString::Atoi(*ObjectCount), 1);
+		const FUpdateStream Stream = MakeStream(NumObjects, NumFrames, Seed);
+		const double NumMessages = Stream.Objects.Num() + Stream.Extras.Num();
+
+		// The first pass warms up the caches and the allocator
+		double MapSeconds = 0.0;
+		double StoreSeconds = 0.0;
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			MapSeconds = ApplyToMaps(Stream, Checksum);
+			StoreSeconds = ApplyToStores(Stream, Checksum);
+		}
+
+		UE_LOG(LogAugmenta, Display, TEXT("%5d objects : before %6.1f ns/message, after %6.1f ns/message, %.2fx faster"),
+			NumObjects, MapSeconds / NumMessages * 1e9, StoreSeconds / NumMessages * 1e9, MapSeconds / FMath::Max(StoreSeconds, UE_DOUBLE_SMALL_NUMBER));
+	}
+
+	// Logged so that the updates are not optimized away
+	UE_LOG(LogAugmenta, Verbose, TEXT("Checksum %f"), Checksum);
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AugmentaObjectStoreBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the cost of applying an object and extra data update message to the tracking state, for several crowd sizes :
+ * before, with the TMap of FAugmentaPerson copied out with FindOrAdd and written back, and after, with the dense slot arrays
+ * of FAugmentaObjectStore and FAugmentaObjectExtraStore updated in place.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=AugmentaObjectStoreBenchmark [-Objects=50,200,1000] [-Frames=2000] [-Seed=0]
+ */
+UCLASS()
+class UAugmentaObjectStoreBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaObjectStoreBenchmarkCommandlet();
+
+	//~ Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet interface
+};
@@ -0,0 +1,243 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaProtocolBenchmarkCommandlet.h"
+#include "AugmentaBinaryProtocol.h"
+#include "AugmentaOSCEncoder.h"
+#include "AugmentaTracker.h"
+#include "AugmentaUnreal.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace AugmentaProtocolBenchmarkCommandlet
+{
+	/** The datagrams are stored at this alignment, like in a receive buffer. */
+	constexpr int32 DatagramAlignment = 16;
+
+	/** The datagrams of an encoded stream, stored back to back. */
+	struct FEncodedStream
+	{
+		TArray<uint8> Bytes;
+		/** The offset and size of every datagram. */
+		TArray<TPair<int32, int32>> Datagrams;
+		/** The size of the datagrams, without the alignment padding. */
+		int64 NumBytes = 0;
+		int64 NumMessages = 0;
+	};
+
+	/** Decoding results of a stream. */
+	struct FDecodeResult
+	{
+		double Seconds = 0.0;
+		int64 MessagesDecoded = 0;
+	};
+
+	void BeginDatagram(FAugmentaOSCEncoder& Encoder)
+	{
+		Encoder.Reset();
+		Encoder.BeginBundle();
+	}
+
+	void BeginDatagram(FAugmentaBinaryEncoder& Encoder)
+	{
+		Encoder.Reset();
+	}
+
+	void EndDatagram(FAugmentaOSCEncoder& Encoder)
+	{
+		Encoder.EndBundle();
+	}
+
+	void EndDatagram(FAugmentaBinaryEncoder& Encoder)
+	{
+	}
+
+	/** Appends the current datagram to the stream and opens a new one. */
+	template <typename EncoderType>
+	void FlushDatagram(EncoderType& Encoder, FEncodedStream& Stream)
+	{
+		if (Encoder.GetNumMessages() == 0)
+		{
+			return;
+		}
+		EndDatagram(Encoder);
+
+		const int32 Offset = Align(Stream.Bytes.Num(), DatagramAlignment);
+		const int32 Size = static_cast<int32>(Encoder.GetSize());
+		Stream.Bytes.SetNumUninitialized(Offset + Size, false);
+		FMemory::Memcpy(Stream.Bytes.GetData() + Offset, Encoder.GetData(), Size);
+		Stream.Datagrams.Emplace(Offset, Size);
+		Stream.NumBytes += Size;
+		Stream.NumMessages += Encoder.GetNumMessages();
+
+		BeginDatagram(Encoder);
+	}
+
+	/** Writes a message, flushing the current datagram first when it is full. */
+	template <typename EncoderType, typename WriteFuncType>
+	void WriteMessage(EncoderType& Encoder, FEncodedStream& Stream, WriteFuncType&& WriteFunc)
+	{
+		if (!WriteFunc(Encoder))
+		{
+			FlushDatagram(Encoder, Stream);
+			verify(WriteFunc(Encoder));
+		}
+	}
+
+	/** Encodes the frames of a crowd wandering in the scene, all the objects first, then all their extra data. */
+	template <typename EncoderType>
+	void EncodeFrames(int32 NumObjects, int32 NumFrames, int32 DatagramSize, int32 Seed, bool bSendExtraData, FEncodedStream& OutStream)
+	{
+		FRandomStream Random(Seed);
+		TArray<FAugmentaObjectMessage> Objects;
+		TArray<FVector2f> Velocities;
+		for (int32 Index = 0; Index < NumObjects; ++Index)
+		{
+			FAugmentaObjectMessage& Object = Objects.AddDefaulted_GetRef();
+			Object.Pid = Index;
+			Object.Oid = Index;
+			Object.CentroidX = Random.FRand();
+			Object.CentroidY = Random.FRand();
+			Object.BoundingRectSizeX = 0.05f;
+			Object.BoundingRectSizeY = 0.05f;
+			Object.Height = Random.FRandRange(1.f, 2.f);
+			Velocities.Emplace(Random.FRandRange(-0.01f, 0.01f), Random.FRandRange(-0.01f, 0.01f));
+		}
+
+		TArray<uint8> DatagramBuffer;
+		DatagramBuffer.SetNumUninitialized(DatagramSize);
+		EncoderType Encoder(DatagramBuffer.GetData(), DatagramBuffer.Num());
+		BeginDatagram(Encoder);
+
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			FAugmentaSceneMessage Scene;
+			Scene.Frame = Frame;
+			Scene.ObjectCount = NumObjects;
+			Scene.SizeX = 20.f;
+			Scene.SizeY = 10.f;
+			WriteMessage(Encoder, OutStream, [&Scene](EncoderType& Target) { return Target.WriteScene(Scene); });
+
+			const EAugmentaMessageType Type = Frame == 0 ? EAugmentaMessageType::ObjectEnter : EAugmentaMessageType::ObjectUpdate;
+			for (int32 Index = 0; Index < NumObjects; ++Index)
+			{
+				FAugmentaObjectMessage& Object = Objects[Index];
+				Object.Frame = Frame;
+				Object.Age += 1.f / 60.f;
+				Object.CentroidX = FMath::Frac(Object.CentroidX + Velocities[Index].X + 1.f);
+				Object.CentroidY = FMath::Frac(Object.CentroidY + Velocities[Index].Y + 1.f);
+				Object.VelocityX = Velocities[Index].X;
+				Object.VelocityY = Velocities[Index].Y;
+				Object.BoundingRectPosX = Object.CentroidX;
+				Object.BoundingRectPosY = Object.CentroidY;
+				WriteMessage(Encoder, OutStream, [Type, &Object](EncoderType& Target) { return Target.WriteObject(Type, Object); });
+			}
+
+			if (bSendExtraData)
+			{
+				const EAugmentaMessageType ExtraType = Frame == 0 ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectExtraUpdate;
+				for (const FAugmentaObjectMessage& Object : Objects)
+				{
+					FAugmentaObjectExtraMessage Extra;
+					Extra.Frame = Frame;
+					Extra.Id = Object.Pid;
+					Extra.Oid = Object.Oid;
+					Extra.HighestX = Object.CentroidX;
+					Extra.HighestY = Object.CentroidY;
+					Extra.Distance = Object.Height;
+					Extra.Reflectivity = 0.5f;
+					WriteMessage(Encoder, OutStream, [ExtraType, &Extra](EncoderType& Target) { return Target.WriteObjectExtra(ExtraType, Extra); });
+				}
+			}
+
+			// Every frame starts a new datagram, like the Augmenta servers do
+			FlushDatagram(Encoder, OutStream);
+		}
+	}
+
+	/** Decodes a stream into a new tracker, once to warm up and once measured. */
+	FDecodeResult DecodeStream(const FEncodedStream& Stream)
+	{
+		FDecodeResult Result;
+		FAugmentaTracker Tracker;
+
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			Tracker.Reset(false);
+
+			const double StartTime = FPlatformTime::Seconds();
+			for (const TPair<int32, int32>& Datagram : Stream.Datagrams)
+			{
+				Tracker.ProcessDatagram(Stream.Bytes.GetData() + Datagram.Key, Datagram.Value);
+				Tracker.GetPendingEvents().Reset();
+			}
+			Result.Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+
+		Result.MessagesDecoded = Tracker.GetDecoder().GetMessagesDecoded() + Tracker.GetBinaryDecoder().GetMessagesDecoded();
+		return Result;
+	}
+
+	void LogResult(const TCHAR* Name, const FEncodedStream& Stream, const FDecodeResult& Result, int32 NumObjects, int32 NumFrames)
+	{
+		UE_LOG(LogAugmenta, Display, TEXT("%-6s : %8.1f bytes/frame, %5.1f datagrams/frame, %8.2f us/frame, %6.1f ns/object, %lld/%lld messages decoded"),
+			Name,
+			static_cast<double>(Stream.NumBytes) / NumFrames,
+			static_cast<double>(Stream.Datagrams.Num()) / NumFrames,
+			Result.Seconds / NumFrames * 1e6,
+			Result.Seconds / (static_cast<double>(NumFrames) * FMath::Max(NumObjects, 1)) * 1e9,
+			Result.MessagesDecoded, Stream.NumMessages);
+	}
+}
+
+UAugmentaProtocolBenchmarkCommandlet::UAugmentaProtocolBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Compares the decoding cost of the OSC and binary Augmenta protocols.");
+}
+
+int32 UAugmentaProtocolBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace AugmentaProtocolBenchmarkCommandlet;
+
+	int32 NumObjects = 500;
+	int32 NumFrames = 1000;
+	int32 DatagramSize = 1400;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Objects="), NumObjects);
+	FParse::Value(*Params, TEXT("Frames="), NumFrames);
+	FParse::Value(*Params, TEXT("DatagramSize="), DatagramSize);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	const bool bSendExtraData = !FParse::Param(*Params, TEXT("NoExtra"));
+
+	NumObjects = FMath::Max(NumObjects, 0);
+	NumFrames = FMath::Max(NumFrames, 1);
+	// The largest record or message must fit in a datagram
+	DatagramSize = FMath::Clamp(DatagramSize, 128, 65507);
+
+	UE_LOG(LogAugmenta, Display, TEXT("Decoding %d frames of %d objects%s, in datagrams of %d bytes."),
+		NumFrames, NumObjects, bSendExtraData ? TEXT(" with extra data") : TEXT(""), DatagramSize);
+
+	FEncodedStream OSCStream;
+	EncodeFrames<FAugmentaOSCEncoder>(NumObjects, NumFrames, DatagramSize, Seed, bSendExtraData, OSCStream);
+	FEncodedStream BinaryStream;
+	EncodeFrames<FAugmentaBinaryEncoder>(NumObjects, NumFrames, DatagramSize, Seed, bSendExtraData, BinaryStream);
+
+	const FDecodeResult OSCResult = DecodeStream(OSCStream);
+	const FDecodeResult BinaryResult = DecodeStream(BinaryStream);
+
+	LogResult(TEXT("OSC"), OSCStream, OSCResult, NumObjects, NumFrames);
+	LogResult(TEXT("Binary"), BinaryStream, BinaryResult, NumObjects, NumFrames);
+	UE_LOG(LogAugmenta, Display, TEXT("Binary is %.2fx faster to decode and %.2fx smaller."),
+		OSCResult.Seconds / FMath::Max(BinaryResult.Seconds, UE_DOUBLE_SMALL_NUMBER),
+		static_cast<double>(OSCStream.NumBytes) / FMath::Max<int64>(BinaryStream.NumBytes, 1));
+
+	if (OSCResult.MessagesDecoded != OSCStream.NumMessages || BinaryResult.MessagesDecoded != BinaryStream.NumMessages)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Some messages were not decoded."));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AugmentaProtocolBenchmarkCommandlet.generated.h"
+
+/**
+ * Encodes the same synthetic frames as OSC and as binary packets (see AugmentaBinaryProtocol), decodes both streams into a tracker
+ * on the calling thread and logs their size and decoding time.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=AugmentaProtocolBenchmark [-Objects=500] [-Frames=1000] [-DatagramSize=1400] [-Seed=0] [-NoExtra]
+ */
+UCLASS()
+class UAugmentaProtocolBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaProtocolBenchmarkCommandlet();
+
+	//~ Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet interface
+};
@@ -0,0 +1,69 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaReceiveWorker.h"
+#include "AugmentaRecording.h"
+#include "AugmentaTracker.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace AugmentaReceiveWorker
+{
+	/** The largest payload of a UDP datagram. */
+	constexpr int32 MaxDatagramSize = 65507;
+	/** How long the thread waits for a datagram before checking if it should stop. */
+	const FTimespan WaitTime = FTimespan::FromMilliseconds(50);
+}
+
+FAugmentaReceiveWorker::FAugmentaReceiveWorker(FSocket& InSocket, FAugmentaTracker& InTracker, FAugmentaRecorder& InRecorder, const TCHAR* ThreadName)
+	: Socket(InSocket)
+	, Tracker(InTracker)
+	, Recorder(InRecorder)
+{
+	SenderAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	ReceiveBuffer.SetNumUninitialized(AugmentaReceiveWorker::MaxDatagramSize);
+
+	Thread = FRunnableThread::Create(this, ThreadName, 0, TPri_AboveNormal);
+}
+
+FAugmentaReceiveWorker::~FAugmentaReceiveWorker()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+uint32 FAugmentaReceiveWorker::Run()
+{
+	while (!bStopping)
+	{
+		if (!Socket.Wait(ESocketWaitConditions::WaitForRead, AugmentaReceiveWorker::WaitTime))
+		{
+			// Commit the frame deferred while the game thread was not dequeuing, now that it may have caught up
+			Tracker.FlushDeferredCommit();
+
+			// Expire the lost objects even when nothing is received anymore
+			const double Now = FPlatformTime::Seconds();
+			Tracker.ExpireStaleObjects(Now);
+			Tracker.CommitIdleFrame(Now);
+			continue;
+		}
+
+		int32 BytesRead = 0;
+		while (!bStopping && Socket.RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *SenderAddress))
+		{
+			Recorder.Record(ReceiveBuffer.GetData(), BytesRead);
+			Tracker.ProcessDatagram(ReceiveBuffer.GetData(), BytesRead);
+		}
+	}
+	return 0;
+}
+
+void FAugmentaReceiveWorker::Stop()
+{
+	bStopping = true;
+}
@@ -0,0 +1,53 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+/** Forward Declarations */
+class FAugmentaRecorder;
+class FAugmentaTracker;
+class FInternetAddr;
+class FRunnableThread;
+class FSocket;
+
+/**
+ * A thread receiving the datagrams of a socket and feeding them to a tracker, so that decoding and the
+ * tracking state updates happen off the game thread. The committed frames are handed over to the game
+ * thread through the lock-free single producer single consumer queue of the tracker.
+ */
+class FAugmentaReceiveWorker : public FRunnable
+{
+public:
+	/**
+	 * Starts the thread. The socket, the tracker and the recorder must outlive the worker.
+	 *
+	 * @param InSocket The socket to receive the datagrams from.
+	 * @param InTracker The tracker the datagrams are applied to, in frame assembly mode.
+	 * @param InRecorder The recorder the datagrams are recorded with, while it is recording.
+	 * @param ThreadName The name of the thread.
+	 */
+	FAugmentaReceiveWorker(FSocket& InSocket, FAugmentaTracker& InTracker, FAugmentaRecorder& InRecorder, const TCHAR* ThreadName);
+	/** Stops the thread and waits for it to exit. */
+	virtual ~FAugmentaReceiveWorker();
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable interface
+
+private:
+	FSocket& Socket;
+	FAugmentaTracker& Tracker;
+	FAugmentaRecorder& Recorder;
+
+	/** The address of the sender of the last received datagram. */
+	TSharedPtr<FInternetAddr> SenderAddress;
+	/** The buffer the datagrams are received into, reused for every datagram. */
+	TArray<uint8> ReceiveBuffer;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+};
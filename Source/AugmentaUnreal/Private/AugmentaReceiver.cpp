@@ -1,40 +1,323 @@
 // Copyright Augmenta, All Rights Reserved.
 
 #include "AugmentaReceiver.h"
-#include "OSCManager.h"
-#include "OSCServer.h"
+#include "AugmentaAnalyticsWriter.h"
+#include "AugmentaClusterPublisher.h"
+#include "AugmentaReceiveWorker.h"
+#include "AugmentaReplayWorker.h"
+#include "AugmentaSharedEndpoint.h"
+#include "AugmentaSubsystem.h"
+#include "AugmentaUnreal.h"
+#include "AugmentaZoneManager.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+#include "UObject/UObjectIterator.h"
 
+namespace AugmentaReceiver
+{
+	/** The largest payload of a UDP datagram. */
+	constexpr int32 MaxDatagramSize = 65507;
 
-UAugmentaReceiver::UAugmentaReceiver()
+	TArray<FAugmentaPerson> GetObjectsAtSlots(const FAugmentaObjectStore& Objects, TConstArrayView<int32> Slots)
+	{
+		TArray<FAugmentaPerson> Result;
+		Result.Reserve(Slots.Num());
+		for (const int32 Slot : Slots)
+		{
+			Result.Add(Objects.GetObjects()[Slot]);
+		}
+		return Result;
+	}
+
+	/** Converts normalized centroids into world space, see FAugmentaBulkTransforms::NormalizedToWorld. */
+	void NormalizedToWorldCentroids(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2D& SceneSize, const FTransform& SceneToWorld, TArray<FVector>& Centroids)
+	{
+		const int32 Num = X.Num();
+
+		TArray<float> WorldCoordinates;
+		WorldCoordinates.SetNumUninitialized(Num * 3);
+		const TArrayView<float> WorldX(WorldCoordinates.GetData(), Num);
+		const TArrayView<float> WorldY(WorldCoordinates.GetData() + Num, Num);
+		const TArrayView<float> WorldZ(WorldCoordinates.GetData() + Num * 2, Num);
+		FAugmentaBulkTransforms::NormalizedToWorld(X, Y, SceneSize, SceneToWorld, WorldX, WorldY, WorldZ);
+
+		Centroids.SetNumUninitialized(Num);
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			Centroids[Index] = FVector(WorldX[Index], WorldY[Index], WorldZ[Index]);
+		}
+	}
+
+	/** Moves an object to its smoothed centroid, along with its bounding rect. Leaves the objects unknown to the smoother in place. */
+	void MoveToSmoothedCentroid(const FAugmentaSmoother& Smoother, FAugmentaPerson& Object)
+	{
+		FVector2D Centroid;
+		if (Smoother.FindSmoothedCentroid(Object.Pid, Centroid))
+		{
+			Object.BoundingRectPos += Centroid - Object.Centroid;
+			Object.Centroid = Centroid;
+		}
+	}
+
+	/** How often the rates and latencies of the counters are refreshed, in seconds. */
+	constexpr double CountersInterval = 1.0;
+
+	static FAutoConsoleCommand PrintCountersCommand(
+		TEXT("Augmenta.PrintCounters"),
+		TEXT("Logs the runtime counters of every Augmenta receiver."),
+		FConsoleCommandDelegate::CreateLambda([]()
+		{
+			for (TObjectIterator<UAugmentaReceiver> It; It; ++It)
+			{
+				TArray<FString> Lines;
+				It->GetCounters().ToString().ParseIntoArrayLines(Lines);
+				UE_LOG(LogAugmenta, Display, TEXT("%s :"), *It->GetName());
+				for (const FString& Line : Lines)
+				{
+					UE_LOG(LogAugmenta, Display, TEXT("  %s"), *Line);
+				}
+			}
+		}));
+}
+
+/** An Augmenta node or port merged by UAugmentaReceiver::ConnectSources, received and decoded on its own thread. */
+struct FAugmentaSource
 {
+	FAugmentaSourceSettings Settings;
+	FSocket* Socket = nullptr;
+	FAugmentaTracker Tracker;
+	/** Never opened, the sources are not recorded. */
+	FAugmentaRecorder Recorder;
+	TSharedPtr<FAugmentaReceiveWorker> ReceiveWorker;
+	/** The last committed frame of the source. */
+	FAugmentaCommittedFrameRef FrontFrame;
+
+	~FAugmentaSource()
+	{
+		// Stop the worker before closing the socket it reads from
+		ReceiveWorker.Reset();
+		if (Socket)
+		{
+			Socket->Close();
+			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		}
+	}
+};
+
+template<typename GetterType>
+int64 UAugmentaReceiver::SumTrackerCounters(GetterType&& Getter) const
+{
+	int64 Sum = Getter(Tracker);
+	if (SharedEndpoint)
+	{
+		Sum += Getter(SharedEndpoint->GetTracker());
+	}
+	for (const TSharedPtr<FAugmentaSource>& Source : Sources)
+	{
+		Sum += Getter(Source->Tracker);
+	}
+	return Sum;
+}
 
+UAugmentaReceiver::UAugmentaReceiver()
+{
+	ZoneManager = CreateDefaultSubobject<UAugmentaZoneManager>(TEXT("ZoneManager"));
 }
 
 UAugmentaReceiver::~UAugmentaReceiver()
 {
 	Stop();
-
-	ActiveObjects.Empty();
-	ActiveObjectsExtraData.Empty();
 }
 
 void UAugmentaReceiver::Connect(FString ReceiveIPAddress, int32 Port)
 {
-	if (OSCServer) return;
+	if (Socket) return;
+
+	// The socket takes over from the replay
+	Stop();
+
+	Socket = FAugmentaSharedEndpoint::OpenSocket(ReceiveIPAddress, Port);
+	if (!Socket)
+	{
+		return;
+	}
 
-	OSCServer = UOSCManager::CreateOSCServer(ReceiveIPAddress, Port, false, true, "AugmentaOSCServer");
+	SenderAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+	ReceiveBuffer.SetNumUninitialized(AugmentaReceiver::MaxDatagramSize);
 
-	OSCServer->OnOscMessageReceived.AddDynamic(this, &UAugmentaReceiver::OnMessageReceived);
+	FAugmentaExpiry Expiry;
+	Expiry.TimeoutFrames = ObjectTimeoutFrames;
+	Expiry.TimeoutSeconds = ObjectTimeoutSeconds;
+	Tracker.SetExpiry(Expiry);
+	ResetTrackingState(bFrameAssembly || bDecodeOnReceiveThread);
+
+	if (bDecodeOnReceiveThread)
+	{
+		ReceiveWorker = MakeShared<FAugmentaReceiveWorker>(*Socket, Tracker, Recorder, TEXT("AugmentaReceiveWorker"));
+	}
 }
 
 void UAugmentaReceiver::Stop()
 {
-	if (OSCServer && OSCServer->IsValidLowLevel())
+	// Stop the workers before closing the socket they read from and resetting the tracker they feed.
+	ReceiveWorker.Reset();
+	ReplayWorker.Reset();
+	Sources.Reset();
+	// Closes the endpoint if no other receiver is attached to it
+	SharedEndpoint.Reset();
+
+	if (Socket)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+
+	// The objects of the stream are not read anymore, nor updated
+	ResetTrackingState(bFrameAssembly || bDecodeOnReceiveThread);
+}
+
+void UAugmentaReceiver::ResetTrackingState(bool bInFrameAssembly)
+{
+	Tracker.Reset(bInFrameAssembly);
+	ResetCounters();
+	FrontFrame.Reset();
+	Smoother.Reset();
+	Coalescer.Reset();
+	BroadcastAllocations = 0;
+	DensityMap.Reset();
+	ResetAnalytics();
+	Subscriptions.ResetObjects();
+	bSnapshotChanged = true;
+}
+
+void UAugmentaReceiver::ConnectSources(const TArray<FAugmentaSourceSettings>& SourceSettings)
+{
+	// The sources take over from the socket or the replay
+	Stop();
+
+	if (SourceSettings.Num() > FAugmentaFusion::MaxSources)
+	{
+		UE_LOG(LogAugmenta, Warning, TEXT("Only the first %d of the %d sources are merged."), FAugmentaFusion::MaxSources, SourceSettings.Num());
+	}
+
+	FAugmentaExpiry Expiry;
+	Expiry.TimeoutFrames = ObjectTimeoutFrames;
+	Expiry.TimeoutSeconds = ObjectTimeoutSeconds;
+
+	const int32 NumSources = FMath::Min(SourceSettings.Num(), FAugmentaFusion::MaxSources);
+	for (int32 SourceIndex = 0; SourceIndex < NumSources; ++SourceIndex)
+	{
+		const FAugmentaSourceSettings& Settings = SourceSettings[SourceIndex];
+		TSharedPtr<FAugmentaSource> Source = MakeShared<FAugmentaSource>();
+		Source->Settings = Settings;
+		Source->Socket = FAugmentaSharedEndpoint::OpenSocket(Settings.ReceiveIPAddress, Settings.Port);
+		if (!Source->Socket)
+		{
+			// Keep the other sources, and the place of this one so that the offsets still match
+			Sources.Add(Source);
+			continue;
+		}
+
+		Source->Tracker.SetExpiry(Expiry);
+		Source->Tracker.Reset(true);
+		const FString ThreadName = FString::Printf(TEXT("AugmentaSourceWorker%d"), SourceIndex);
+		Source->ReceiveWorker = MakeShared<FAugmentaReceiveWorker>(*Source->Socket, Source->Tracker, Source->Recorder, *ThreadName);
+		Sources.Add(Source);
+	}
+
+	// The tracker is unused, but still read by the counters
+	ResetTrackingState(true);
+	Fusion.Reset();
+	Fusion.SetMergeDistance(SourceMergeDistance);
+	Fusion.SetSceneSize(FusedSceneSize);
+}
+
+void UAugmentaReceiver::ConnectShared(FString ReceiveIPAddress, int32 Port)
+{
+	// The endpoint takes over from the socket, the sources or the replay
+	Stop();
+
+	UAugmentaSubsystem* Subsystem = GEngine ? GEngine->GetEngineSubsystem<UAugmentaSubsystem>() : nullptr;
+	if (!Subsystem)
+	{
+		return;
+	}
+
+	FAugmentaExpiry Expiry;
+	Expiry.TimeoutFrames = ObjectTimeoutFrames;
+	Expiry.TimeoutSeconds = ObjectTimeoutSeconds;
+	SharedEndpoint = Subsystem->AcquireEndpoint(ReceiveIPAddress, Port, Expiry);
+	if (!SharedEndpoint)
+	{
+		return;
+	}
+
+	// The tracker is unused, but still read by the counters
+	ResetTrackingState(true);
+
+	// Start from the last frame of the endpoint, its objects enter on the next tick
+	SharedEndpoint->Pump();
+	SharedFrameCursor = SharedEndpoint->GetNextSequence();
+	FrontFrame = SharedEndpoint->GetLatestFrame();
+	bPublishSharedSnapshot = FrontFrame.IsValid();
+}
+
+bool UAugmentaReceiver::StartRecording(FString Filename)
+{
+	return Recorder.Open(*Filename);
+}
+
+void UAugmentaReceiver::StopRecording()
+{
+	Recorder.Close();
+}
+
+bool UAugmentaReceiver::IsRecording() const
+{
+	return Recorder.IsRecording();
+}
+
+bool UAugmentaReceiver::StartReplay(FString Filename, float PlaybackRate, bool bLoop)
+{
+	Stop();
+
+	TUniquePtr<FAugmentaReplay> Replay = MakeUnique<FAugmentaReplay>();
+	if (!Replay->Open(*Filename))
 	{
-		OSCServer->Stop(); //This is called by its destruction, calling it here to be safe.
-		OSCServer->ConditionalBeginDestroy();
-		OSCServer = nullptr;
+		return false;
 	}
+
+	FAugmentaExpiry Expiry;
+	Expiry.TimeoutFrames = ObjectTimeoutFrames;
+	Tracker.SetExpiry(Expiry);
+	ResetTrackingState(true);
+
+	ReplayWorker = MakeShared<FAugmentaReplayWorker>(MoveTemp(Replay), Tracker, PlaybackRate, bLoop, TEXT("AugmentaReplayWorker"));
+	return true;
+}
+
+void UAugmentaReceiver::SeekReplay(float Time)
+{
+	if (ReplayWorker)
+	{
+		ReplayWorker->Seek(Time);
+	}
+}
+
+bool UAugmentaReceiver::IsReplaying() const
+{
+	return ReplayWorker && !ReplayWorker->IsFinished();
+}
+
+float UAugmentaReceiver::GetReplayTime() const
+{
+	return ReplayWorker ? static_cast<float>(ReplayWorker->GetTime()) : 0.f;
 }
 
 UAugmentaReceiver* UAugmentaReceiver::CreateAugmentaReceiver(FString ReceiveIPAddress, int32 Port)
@@ -44,53 +327,62 @@ UAugmentaReceiver* UAugmentaReceiver::CreateAugmentaReceiver(FString ReceiveIPAd
 	return Receiver;
 }
 
+UAugmentaReceiver* UAugmentaReceiver::CreateSharedAugmentaReceiver(FString ReceiveIPAddress, int32 Port)
+{
+	UAugmentaReceiver* Receiver = NewObject<UAugmentaReceiver>();
+	Receiver->ConnectShared(ReceiveIPAddress, Port);
+	return Receiver;
+}
+
 bool UAugmentaReceiver::IsConnected() const
 {
-	return (OSCServer && OSCServer->IsValidLowLevel() && OSCServer->IsActive());
+	return Socket != nullptr || Sources.Num() > 0 || SharedEndpoint.IsValid();
+}
+
+int32 UAugmentaReceiver::GetPort() const
+{
+	return Socket ? Socket->GetPortNo() : 0;
 }
 
 FAugmentaScene UAugmentaReceiver::GetScene() const
 {
-	return Scene;
+	return GetFrameSnapshot().Scene;
 }
 
 TArray<FAugmentaPerson> UAugmentaReceiver::GetPersonsArray() const
 {
-	TArray<FAugmentaPerson> OutArray;
-	ActiveObjects.GenerateValueArray(OutArray);
-	return OutArray;
+	return TArray<FAugmentaPerson>(GetFrameSnapshot().Objects.GetObjects());
 }
 
 FAugmentaPerson UAugmentaReceiver::GetNewestPerson() const
 {
-	FAugmentaPerson Youngest;
-	Youngest.Age = FLT_MAX;
-	for (auto& Pair : ActiveObjects)
-	{
-		if (Pair.Value.Age < Youngest.Age)
-		{
-			Youngest = Pair.Value;
-		}
-	}
-	return Youngest;
+	const FAugmentaPerson* Newest = GetFrameSnapshot().Objects.GetNewest();
+	return Newest != nullptr ? *Newest : FAugmentaPerson();
 }
 
 FAugmentaPerson UAugmentaReceiver::GetOldestPerson() const
 {
-	FAugmentaPerson Oldest;
-	for (auto& Pair : ActiveObjects)
-	{
-		if (Pair.Value.Age > Oldest.Age)
-		{
-			Oldest = Pair.Value;
-		}
-	}
+	const FAugmentaPerson* Oldest = GetFrameSnapshot().Objects.GetOldest();
+	return Oldest != nullptr ? *Oldest : FAugmentaPerson();
+}
+
+TArray<FAugmentaPerson> UAugmentaReceiver::GetNOldestObjects(int32 Count) const
+{
+	TArray<FAugmentaPerson> Oldest;
+	GetFrameSnapshot().Objects.GetNOldest(Count, Oldest);
 	return Oldest;
 }
 
+TArray<FAugmentaPerson> UAugmentaReceiver::GetNNewestObjects(int32 Count) const
+{
+	TArray<FAugmentaPerson> Newest;
+	GetFrameSnapshot().Objects.GetNNewest(Count, Newest);
+	return Newest;
+}
+
 bool UAugmentaReceiver::GetObject(const int32 Id, FAugmentaPerson& Object) const
 {
-	const FAugmentaPerson* Obj = ActiveObjects.Find(Id);
+	const FAugmentaPerson* Obj = GetFrameSnapshot().Objects.Find(Id);
 	if (Obj != nullptr)
 	{
 		Object = *Obj;
@@ -102,19 +394,17 @@ bool UAugmentaReceiver::GetObject(const int32 Id, FAugmentaPerson& Object) const
 
 FAugmentaVideoOutput UAugmentaReceiver::GetVideoOutput() const
 {
-	return VideoOutput;
+	return GetFrameSnapshot().VideoOutput;
 }
 
 TArray<FAugmentaObjectExtra> UAugmentaReceiver::GetObjectExtrasArray() const
 {
-	TArray<FAugmentaObjectExtra> OutArray;
-	ActiveObjectsExtraData.GenerateValueArray(OutArray);
-	return OutArray;
+	return TArray<FAugmentaObjectExtra>(GetFrameSnapshot().ObjectExtras.GetExtras());
 }
 
 bool UAugmentaReceiver::GetObjectExtra(const int32 Id, FAugmentaObjectExtra& Extra) const
 {
-	const FAugmentaObjectExtra* Ex = ActiveObjectsExtraData.Find(Id);
+	const FAugmentaObjectExtra* Ex = GetFrameSnapshot().ObjectExtras.Find(Id);
 	if (Ex != nullptr)
 	{
 		Extra = *Ex;
@@ -124,190 +414,652 @@ bool UAugmentaReceiver::GetObjectExtra(const int32 Id, FAugmentaObjectExtra& Ext
 	return false;
 }
 
-void UAugmentaReceiver::OnMessageReceived(const FOSCMessage& Message, const FString& IPAddress, int32 Port)
+TArray<FAugmentaPerson> UAugmentaReceiver::GetObjectsInRadius(FVector2D Center, float Radius) const
+{
+	const FAugmentaFrameSnapshot& Snapshot = GetFrameSnapshot();
+	TArray<int32> Slots;
+	Snapshot.Objects.FindInRadius(FVector2f(Center), Radius, FAugmentaObjectStore::GetDistanceScale(Snapshot.Scene), Slots);
+	return AugmentaReceiver::GetObjectsAtSlots(Snapshot.Objects, Slots);
+}
+
+TArray<FAugmentaPerson> UAugmentaReceiver::GetObjectsInRect(FVector2D Min, FVector2D Max) const
+{
+	const FAugmentaFrameSnapshot& Snapshot = GetFrameSnapshot();
+	TArray<int32> Slots;
+	Snapshot.Objects.FindInRect(FVector2f(Min), FVector2f(Max), Slots);
+	return AugmentaReceiver::GetObjectsAtSlots(Snapshot.Objects, Slots);
+}
+
+TArray<FAugmentaPerson> UAugmentaReceiver::GetNearestObjects(FVector2D Point, int32 Count) const
+{
+	const FAugmentaFrameSnapshot& Snapshot = GetFrameSnapshot();
+	TArray<int32> Slots;
+	Snapshot.Objects.FindNearest(FVector2f(Point), Count, FAugmentaObjectStore::GetDistanceScale(Snapshot.Scene), Slots);
+	return AugmentaReceiver::GetObjectsAtSlots(Snapshot.Objects, Slots);
+}
+
+TArray<FAugmentaObjectPair> UAugmentaReceiver::GetObjectPairsWithinDistance(float Distance) const
+{
+	const FAugmentaFrameSnapshot& Snapshot = GetFrameSnapshot();
+	TArray<FAugmentaSlotPair> SlotPairs;
+	Snapshot.Objects.FindPairs(Distance, FAugmentaObjectStore::GetDistanceScale(Snapshot.Scene), SlotPairs);
+
+	const TConstArrayView<FAugmentaPerson> Objects = Snapshot.Objects.GetObjects();
+	TArray<FAugmentaObjectPair> Pairs;
+	Pairs.Reserve(SlotPairs.Num());
+	for (const FAugmentaSlotPair& SlotPair : SlotPairs)
+	{
+		FAugmentaObjectPair& Pair = Pairs.AddDefaulted_GetRef();
+		Pair.IdA = Objects[SlotPair.SlotA].Pid;
+		Pair.IdB = Objects[SlotPair.SlotB].Pid;
+		Pair.Distance = SlotPair.Distance;
+	}
+	return Pairs;
+}
+
+void UAugmentaReceiver::GetObjectsWorldCentroids(const FTransform& SceneToWorld, TArray<FVector>& Centroids) const
+{
+	const FAugmentaFrameSnapshot& Snapshot = GetFrameSnapshot();
+	const FAugmentaObjectsSoA Objects = Snapshot.Objects.GetSoA();
+	AugmentaReceiver::NormalizedToWorldCentroids(Objects.CentroidX, Objects.CentroidY, Snapshot.Scene.SceneSize, SceneToWorld, Centroids);
+}
+
+TArray<FAugmentaPerson> UAugmentaReceiver::GetSmoothedObjectsArray() const
+{
+	TArray<FAugmentaPerson> Objects(GetFrameSnapshot().Objects.GetObjects());
+	for (FAugmentaPerson& Object : Objects)
+	{
+		AugmentaReceiver::MoveToSmoothedCentroid(Smoother, Object);
+	}
+	return Objects;
+}
+
+bool UAugmentaReceiver::GetSmoothedObject(const int32 Id, FAugmentaPerson& Object) const
+{
+	if (!GetObject(Id, Object))
+	{
+		return false;
+	}
+
+	AugmentaReceiver::MoveToSmoothedCentroid(Smoother, Object);
+	return true;
+}
+
+void UAugmentaReceiver::GetSmoothedObjectsWorldCentroids(const FTransform& SceneToWorld, TArray<int32>& Ids, TArray<FVector>& Centroids) const
+{
+	Ids = TArray<int32>(Smoother.GetPids());
+	AugmentaReceiver::NormalizedToWorldCentroids(Smoother.GetSmoothedX(), Smoother.GetSmoothedY(), GetFrameSnapshot().Scene.SceneSize, SceneToWorld, Centroids);
+}
+
+int32 UAugmentaReceiver::SubscribeToObjects(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectEvent Delegate)
+{
+	return Subscriptions.Add(Filter, MoveTemp(Delegate));
+}
+
+int32 UAugmentaReceiver::SubscribeToObjectsNative(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent Delegate)
+{
+	return Subscriptions.Add(Filter, MoveTemp(Delegate));
+}
+
+bool UAugmentaReceiver::UnsubscribeFromObjects(int32 SubscriptionId)
+{
+	return Subscriptions.Remove(SubscriptionId);
+}
+
+FAugmentaAnalyticsSummary UAugmentaReceiver::GetAnalyticsSummary() const
+{
+	return Analytics.GetSummary();
+}
+
+TArray<int64> UAugmentaReceiver::GetDwellHistogram() const
+{
+	return TArray<int64>(Analytics.GetDwellHistogram());
+}
+
+bool UAugmentaReceiver::GetObjectTrajectory(const int32 Id, TArray<FVector2D>& Positions) const
 {
-	const FOSCAddress Addr = Message.GetAddress();
-	const FString Container = Addr.GetContainer(0);
-	const FString InnerContainer = Addr.GetContainer(1);
-	const FString Method = Addr.GetMethod();
-	
-	// Ensure it is an Augmenta message
-	if (Container == ContainerObject)
+	return Analytics.GetTrajectories().GetTrajectory(Id, Positions);
+}
+
+bool UAugmentaReceiver::StartAnalyticsStream(FString Filename, bool bBinary)
+{
+	StopAnalyticsStream();
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
 	{
-		if (InnerContainer.IsEmpty())
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to create the analytics stream '%s'."), *Filename);
+		return false;
+	}
+
+	AnalyticsWriter = MakeShared<FAugmentaAnalyticsWriter>(MoveTemp(Writer), bBinary);
+	return true;
+}
+
+void UAugmentaReceiver::StopAnalyticsStream()
+{
+	AnalyticsWriter.Reset();
+}
+
+bool UAugmentaReceiver::StartClusterPublisher(FString DestinationAddress, int32 Port)
+{
+	StopClusterPublisher();
+
+	ClusterPublisher = FAugmentaClusterPublisher::Create(DestinationAddress, Port, ClusterKeyframeInterval);
+	if (!ClusterPublisher)
+	{
+		return false;
+	}
+
+	// The secondaries that are already synchronized get the whole state with the first keyframe
+	ClusterPublisher->Publish(GetFrameSnapshot());
+	return true;
+}
+
+void UAugmentaReceiver::StopClusterPublisher()
+{
+	ClusterPublisher.Reset();
+}
+
+bool UAugmentaReceiver::IsPublishingCluster() const
+{
+	return ClusterPublisher.IsValid();
+}
+
+UTexture2D* UAugmentaReceiver::GetDensityTexture() const
+{
+	return DensityTexture;
+}
+
+FAugmentaDispatchStats UAugmentaReceiver::GetDispatchStats() const
+{
+	FAugmentaDispatchStats Stats;
+	Stats.MessagesDecoded = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDecoder().GetMessagesDecoded() + InTracker.GetBinaryDecoder().GetMessagesDecoded(); });
+	Stats.MessagesIgnored = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDecoder().GetMessagesIgnored(); });
+	Stats.MalformedPackets = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDecoder().GetMalformedPackets() + InTracker.GetBinaryDecoder().GetMalformedPackets() + InTracker.GetClusterDecoder().GetMalformedPackets(); });
+	Stats.DispatchTableHits = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDecoder().GetDispatchTableHits(); });
+	Stats.DispatchTableMisses = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDecoder().GetDispatchTableMisses(); });
+	Stats.DispatchAllocations = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDispatchAllocations(); }) + BroadcastAllocations;
+	Stats.DroppedLeaves = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDroppedLeaves(); });
+	return Stats;
+}
+
+FAugmentaReceiverCounters UAugmentaReceiver::GetCounters() const
+{
+	FAugmentaReceiverCounters Current = Counters;
+	Current.FramesAssembled = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetFramesAssembled(); });
+	Current.FrameGaps = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetFrameGaps(); });
+	Current.MissedFrames = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetMissedFrames(); });
+	Current.OutOfOrderPackets = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetOutOfOrderPackets(); });
+	Current.CoalescedEvents = Coalescer.GetCoalescedEvents();
+	Current.FilteredEvents = Subscriptions.GetFilteredEvents();
+	Current.ClusterFramesDropped = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetClusterDecoder().GetFramesDropped(); });
+	Current.ActiveObjects = GetFrameSnapshot().Objects.Num();
+	return Current;
+}
+
+const FAugmentaFrameSnapshot& UAugmentaReceiver::GetFrameSnapshot() const
+{
+	if (Sources.Num() > 0)
+	{
+		return Fusion.GetSnapshot();
+	}
+
+	if (!Tracker.IsFrameAssemblyEnabled())
+	{
+		return Tracker.GetLiveState();
+	}
+
+	static const FAugmentaFrameSnapshot EmptySnapshot;
+	return FrontFrame ? FrontFrame->Snapshot : EmptySnapshot;
+}
+
+FAugmentaCommittedFrameRef UAugmentaReceiver::GetCommittedFrame() const
+{
+	if (Sources.Num() > 0 || !Tracker.IsFrameAssemblyEnabled())
+	{
+		return nullptr;
+	}
+	return FrontFrame;
+}
+
+void UAugmentaReceiver::Tick(float DeltaTime)
+{
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaReceiverTick);
+
+	// The previous tick dequeued every frame, so a frame deferred while the queue was full can be committed
+	if (Socket && !ReceiveWorker)
+	{
+		Tracker.FlushDeferredCommit();
+	}
+
+	// Decode every datagram received since the last tick, unless the worker does it
+	int32 BytesRead = 0;
+	while (Socket && !ReceiveWorker && Socket->RecvFrom(ReceiveBuffer.GetData(), ReceiveBuffer.Num(), BytesRead, *SenderAddress))
+	{
+		Recorder.Record(ReceiveBuffer.GetData(), BytesRead);
+		Tracker.ProcessDatagram(ReceiveBuffer.GetData(), BytesRead);
+
+		if (!Tracker.IsFrameAssemblyEnabled())
 		{
-			const bool HasEntered = Method == MethodObjectEnter;
-			// Send it off to the proper processing function based on the method
-			if (HasEntered || Method == MethodObjectUpdate)
-			{
-				UpdateObject(Message, HasEntered);
-			}
-			else if (Method == MethodObjectLeave)
+			Swap(BroadcastingEvents, Tracker.GetPendingEvents());
+			if (!BroadcastingEvents.IsEmpty())
 			{
-				RemoveObject(Message);
+				LatencyHistogram.Add(FPlatformTime::Seconds() - Tracker.GetReceiveTime());
 			}
+			PublishEvents(BroadcastingEvents, Tracker.GetReceiveTime());
+			BroadcastingEvents.Reset();
 		}
-		else if (Method == MethodObjectExtra)
+	}
+
+	// Expire the lost objects even when nothing is received anymore
+	if (Socket && !ReceiveWorker)
+	{
+		const double Now = FPlatformTime::Seconds();
+		const bool bExpired = Tracker.ExpireStaleObjects(Now);
+		if (Tracker.IsFrameAssemblyEnabled())
 		{
-			const bool HasEntered = InnerContainer == MethodObjectEnter;
-			if (HasEntered || InnerContainer == MethodObjectUpdate)
-			{
-				UpdateObjectExtraData(Message, HasEntered);
-			}
-			else if (InnerContainer == MethodObjectLeave)
-			{
-				RemoveObjectExtraData(Message);
-			}
+			// The last datagram drained may be in the middle of a frame, whose next datagrams are still on their way
+			Tracker.CommitIdleFrame(Now);
+		}
+		else if (bExpired)
+		{
+			Swap(BroadcastingEvents, Tracker.GetPendingEvents());
+			PublishEvents(BroadcastingEvents, Now);
+			BroadcastingEvents.Reset();
 		}
 	}
-	else if (Method == MethodScene)
+
+	// Publish the complete frames, firing their events with the getters reading the frame they belong to
+	FAugmentaCommittedFrameRef Frame;
+	while ((Socket || ReplayWorker) && Tracker.DequeueCommittedFrame(Frame))
+	{
+		FrontFrame = Frame;
+		LatencyHistogram.Add(FPlatformTime::Seconds() - Frame->ReceiveTime);
+		PublishEvents(Frame->Events, Frame->ReceiveTime);
+	}
+
+	if (SharedEndpoint)
+	{
+		TickSharedEndpoint();
+	}
+
+	if (Sources.Num() > 0)
+	{
+		TickSources();
+	}
+
+	// The events merged since the last tick are fired once, with the getters reading the newest state
+	if (!Coalescer.IsEmpty())
+	{
+		const SIZE_T AllocatedSize = Coalescer.GetAllocatedSize() + BroadcastingEvents.GetAllocatedSize();
+		Coalescer.Flush(BroadcastingEvents);
+		BroadcastAllocations += Coalescer.GetAllocatedSize() + BroadcastingEvents.GetAllocatedSize() != AllocatedSize;
+		BroadcastEvents(BroadcastingEvents);
+		BroadcastingEvents.Reset();
+	}
+
+	// The secondaries receive the state the getters read, once per tick whatever the number of frames received
+	if (ClusterPublisher && bSnapshotChanged)
+	{
+		ClusterPublisher->Publish(GetFrameSnapshot());
+	}
+
+	// One pass over the zones per tick, whatever the number of messages or frames received
+	if (ZoneManager && ZoneManager->HasZones())
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaEvaluateZones);
+		ZoneManager->Evaluate(GetFrameSnapshot(), FPlatformTime::Seconds(), bSnapshotChanged);
+	}
+	bSnapshotChanged = false;
+
+	// One vectorized pass over the objects per tick, whatever the number of frames received
+	if (bSmoothObjects)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaSmoothObjects);
+		Smoother.Sample(FPlatformTime::Seconds() - SmoothingDelay, MaxExtrapolationTime);
+	}
+	else if (Smoother.Num() > 0)
+	{
+		// Its objects would be stale once enabled again
+		Smoother.Reset();
+	}
+
+	if (bComputeAnalytics)
+	{
+		Analytics.Tick(FPlatformTime::Seconds());
+	}
+
+	// One pass over the cells per tick, then one footprint per object
+	if (bComputeDensityMap)
 	{
-		UpdateScene(Message);
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaUpdateDensityMap);
+		DensityMap.SetResolution(DensityMapResolution.X, DensityMapResolution.Y);
+		DensityMap.Update(GetFrameSnapshot().Objects.GetSoA(), DeltaTime, DensityDecayTime);
+		if (bUploadDensityTexture)
+		{
+			UploadDensityTexture();
+		}
 	}
-	else if (Method == MethodVideoOutput)
+	else if (DensityMap.GetValues().Num() > 0)
 	{
-		UpdateVideoOutputData(Message);
+		DensityMap.SetResolution(0, 0);
+		DensityTexture = nullptr;
 	}
+
+	UpdateCounters(FPlatformTime::Seconds());
+
+	// The counter stats are cleared every frame, every receiver adds its own
+	const float MessagesPerSecond = Counters.SceneMessagesPerSecond + Counters.VideoOutputMessagesPerSecond + Counters.ObjectEnterMessagesPerSecond
+		+ Counters.ObjectUpdateMessagesPerSecond + Counters.ObjectLeaveMessagesPerSecond + Counters.ExtraMessagesPerSecond;
+	INC_DWORD_STAT_BY(STAT_AugmentaActiveObjects, GetFrameSnapshot().Objects.Num());
+	INC_FLOAT_STAT_BY(STAT_AugmentaMessagesPerSecond, MessagesPerSecond);
+	INC_FLOAT_STAT_BY(STAT_AugmentaKilobytesPerSecond, Counters.BytesPerSecond / 1024.f);
+	INC_FLOAT_STAT_BY(STAT_AugmentaLatencyP99, Counters.LatencyP99);
 }
 
-void UAugmentaReceiver::UpdateScene(const FOSCMessage& Message)
+bool UAugmentaReceiver::IsTickable() const
 {
-	// UE5 : FVector2D is now double instead of float
-	// Create temporary float to cast
-	float TmpFloat;
-
-	// The way it is done in UOSCManager relies on private classes, so this may be the best way for now.
-	UOSCManager::GetInt32(Message, 0, Scene.CurrentTime);
-	UOSCManager::GetInt32(Message, 1, Scene.NumPeople);
-	UOSCManager::GetFloat(Message, 2, TmpFloat);
-	Scene.SceneSize.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 3, TmpFloat);
-	Scene.SceneSize.Y = TmpFloat;
+	return Socket != nullptr || ReplayWorker.IsValid() || Sources.Num() > 0 || SharedEndpoint.IsValid();
+}
 
-	OnSceneUpdated.Broadcast(Scene);
+TStatId UAugmentaReceiver::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAugmentaReceiver, STATGROUP_Tickables);
 }
 
-void UAugmentaReceiver::UpdateObject(const FOSCMessage& Message, bool HasEntered)
+void UAugmentaReceiver::ResetAnalytics()
 {
-	// UE5 : FVector2D is now double instead of float
-	// Create temporary float to cast
-	float TmpFloat;
+	// The trajectory pool is only allocated when used
+	Analytics.Configure(bComputeAnalytics ? MaxTrajectories : 0, TrajectoryLength, DwellHistogramBinDuration, DwellHistogramNumBins);
+}
 
-	int32 Pid = -1;
-	UOSCManager::GetInt32(Message, 1, Pid);
+void UAugmentaReceiver::UploadDensityTexture()
+{
+	const int32 Width = DensityMap.GetWidth();
+	const int32 Height = DensityMap.GetHeight();
+	if (Width == 0 || Height == 0)
+	{
+		return;
+	}
 
-	// Find or add a person entry
-	FAugmentaPerson Person = ActiveObjects.FindOrAdd(Pid);
-	// Update the values
-	Person.Pid = Pid;
-	UOSCManager::GetInt32(Message, 0, Person.Frame);
-	UOSCManager::GetInt32(Message, 2, Person.Oid);
-	UOSCManager::GetFloat(Message, 3, Person.Age);
-	UOSCManager::GetFloat(Message, 4, TmpFloat);
-	Person.Centroid.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 5, TmpFloat);
-	Person.Centroid.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 6, TmpFloat);
-	Person.Velocity.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 7, TmpFloat);
-	Person.Velocity.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 8, Person.Orientation);
-	UOSCManager::GetFloat(Message, 9, TmpFloat);
-	Person.BoundingRectPos.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 10, TmpFloat);
-	Person.BoundingRectPos.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 11, TmpFloat);
-	Person.BoundingRectSize.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 12, TmpFloat);
-	Person.BoundingRectSize.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 13, Person.BoundingRectRotation);
-	UOSCManager::GetFloat(Message, 14, Person.Height);
+	if (!DensityTexture || DensityTexture->GetSizeX() != Width || DensityTexture->GetSizeY() != Height)
+	{
+		DensityTexture = UTexture2D::CreateTransient(Width, Height, PF_R32_FLOAT, TEXT("AugmentaDensity"));
+		if (!DensityTexture)
+		{
+			return;
+		}
+		DensityTexture->SRGB = false;
+		DensityTexture->Filter = TF_Bilinear;
+		DensityTexture->AddressX = TA_Clamp;
+		DensityTexture->AddressY = TA_Clamp;
+		DensityTexture->UpdateResource();
+	}
 
-	ActiveObjects[Pid] = Person;
+	// The render thread uploads a copy of the cells and frees it, the map keeps being updated on the game thread
+	const int32 NumBytes = DensityMap.GetValues().Num() * sizeof(float);
+	uint8* Data = static_cast<uint8*>(FMemory::Malloc(NumBytes));
+	FMemory::Memcpy(Data, DensityMap.GetValues().GetData(), NumBytes);
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Width, Height);
+	DensityTexture->UpdateTextureRegions(0, 1, Region, Width * sizeof(float), sizeof(float), Data,
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+		{
+			FMemory::Free(SrcData);
+			delete Regions;
+		});
+}
 
-	if (HasEntered)
+void UAugmentaReceiver::TickSources()
+{
+	// Only the last complete frame of every source is fused, the frames in between are superseded by it
+	bool bSourcesChanged = false;
+	double OldestReceiveTime = TNumericLimits<double>::Max();
+	FAugmentaCommittedFrameRef Frame;
+	for (const TSharedPtr<FAugmentaSource>& Source : Sources)
 	{
-		OnPersonEntered.Broadcast(Person);
+		while (Source->Tracker.DequeueCommittedFrame(Frame))
+		{
+			Source->FrontFrame = Frame;
+			OldestReceiveTime = FMath::Min(OldestReceiveTime, Frame->ReceiveTime);
+			bSourcesChanged = true;
+		}
 	}
-	else
+	if (!bSourcesChanged)
 	{
-		OnPersonUpdated.Broadcast(Person);
+		return;
 	}
+
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaFuseSources);
+
+		TArray<FAugmentaFusion::FSource, TInlineAllocator<FAugmentaFusion::MaxSources>> FusionSources;
+		for (const TSharedPtr<FAugmentaSource>& Source : Sources)
+		{
+			FAugmentaFusion::FSource& FusionSource = FusionSources.AddDefaulted_GetRef();
+			FusionSource.Snapshot = Source->FrontFrame ? &Source->FrontFrame->Snapshot : nullptr;
+			FusionSource.Offset = Source->Settings.Offset;
+		}
+		Fusion.Fuse(FusionSources, FPlatformTime::Seconds());
+	}
+
+	LatencyHistogram.Add(FPlatformTime::Seconds() - OldestReceiveTime);
+	Swap(BroadcastingEvents, Fusion.GetEvents());
+	PublishEvents(BroadcastingEvents, OldestReceiveTime);
+	BroadcastingEvents.Reset();
 }
 
-void UAugmentaReceiver::RemoveObject(const FOSCMessage& Message)
+void UAugmentaReceiver::TickSharedEndpoint()
 {
-	int32 Pid = -1;
-	UOSCManager::GetInt32(Message, 1, Pid);
+	// Keep the endpoint and its frames alive even if a delegate stops or reconnects the receiver
+	const TSharedPtr<FAugmentaSharedEndpoint> Endpoint = SharedEndpoint;
+
+	// The objects of an endpoint that was already receiving enter as if they had just been received
+	if (bPublishSharedSnapshot)
+	{
+		bPublishSharedSnapshot = false;
+		const FAugmentaCommittedFrameRef Frame = FrontFrame;
+		FAugmentaSharedEndpoint::GetSnapshotEvents(Frame->Snapshot, BroadcastingEvents);
+		PublishEvents(BroadcastingEvents, Frame->ReceiveTime);
+		BroadcastingEvents.Reset();
+		if (SharedEndpoint != Endpoint)
+		{
+			return;
+		}
+	}
 
-	// Remove the person entry from the map
-	FAugmentaPerson OldPerson;
-	ActiveObjects.RemoveAndCopyValue(Pid, OldPerson);
+	// The first receiver to tick dequeues the frames of the endpoint, every receiver then reads the same frames
+	Endpoint->Pump();
+	for (const FAugmentaCommittedFrameRef& Frame : Endpoint->ReadFrames(SharedFrameCursor))
+	{
+		if (SharedEndpoint != Endpoint)
+		{
+			break;
+		}
 
-	OnPersonWillLeave.Broadcast(OldPerson);
+		FrontFrame = Frame;
+		LatencyHistogram.Add(FPlatformTime::Seconds() - Frame->ReceiveTime);
+		PublishEvents(Frame->Events, Frame->ReceiveTime);
+	}
 }
 
-void UAugmentaReceiver::UpdateVideoOutputData(const FOSCMessage& Message)
+void UAugmentaReceiver::ResetCounters()
 {
-	// UE5 : FVector2D is now double instead of float
-	// Create temporary float to cast
-	float TmpFloat;
+	Counters = FAugmentaReceiverCounters();
+	CountersTime = FPlatformTime::Seconds();
+	// A shared endpoint was counting before this receiver attached to it, its rates start from its current totals
+	for (int32 TypeIndex = 0; TypeIndex < FAugmentaTracker::NumMessageTypes; ++TypeIndex)
+	{
+		const EAugmentaMessageType Type = static_cast<EAugmentaMessageType>(TypeIndex);
+		LastMessagesReceived[TypeIndex] = SumTrackerCounters([Type](const FAugmentaTracker& InTracker) { return InTracker.GetMessagesReceived(Type); });
+	}
+	LastDatagramsReceived = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDatagramsReceived(); });
+	LastBytesReceived = SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetBytesReceived(); });
+	LatencyHistogram.Reset();
+	Coalescer.ResetCounters();
+	Subscriptions.ResetCounters();
+}
 
-	UOSCManager::GetFloat(Message, 0, TmpFloat);
-	VideoOutput.Offset.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 1, TmpFloat);
-	VideoOutput.Offset.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 2, TmpFloat);
-	VideoOutput.Size.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 3, TmpFloat);
-	VideoOutput.Size.Y = TmpFloat;
-	UOSCManager::GetInt32(Message, 4, VideoOutput.Resolution.X);
-	UOSCManager::GetInt32(Message, 5, VideoOutput.Resolution.Y);
+void UAugmentaReceiver::UpdateCounters(double Now)
+{
+	const double Elapsed = Now - CountersTime;
+	if (Elapsed < AugmentaReceiver::CountersInterval)
+	{
+		return;
+	}
+	CountersTime = Now;
+
+	// Rate of a cumulated tracker counter since the last refresh
+	const auto GetRate = [Elapsed](int64 Total, int64& LastTotal)
+	{
+		const float Rate = static_cast<float>((Total - LastTotal) / Elapsed);
+		LastTotal = Total;
+		return Rate;
+	};
+	const auto GetMessageRate = [this, &GetRate](EAugmentaMessageType Type)
+	{
+		const int64 MessagesReceived = SumTrackerCounters([Type](const FAugmentaTracker& InTracker) { return InTracker.GetMessagesReceived(Type); });
+		return GetRate(MessagesReceived, LastMessagesReceived[static_cast<int32>(Type)]);
+	};
+
+	Counters.SceneMessagesPerSecond = GetMessageRate(EAugmentaMessageType::Scene);
+	Counters.VideoOutputMessagesPerSecond = GetMessageRate(EAugmentaMessageType::VideoOutput);
+	Counters.ObjectEnterMessagesPerSecond = GetMessageRate(EAugmentaMessageType::ObjectEnter);
+	Counters.ObjectUpdateMessagesPerSecond = GetMessageRate(EAugmentaMessageType::ObjectUpdate);
+	Counters.ObjectLeaveMessagesPerSecond = GetMessageRate(EAugmentaMessageType::ObjectLeave);
+	Counters.ExtraMessagesPerSecond = GetMessageRate(EAugmentaMessageType::ObjectExtraEnter)
+		+ GetMessageRate(EAugmentaMessageType::ObjectExtraUpdate)
+		+ GetMessageRate(EAugmentaMessageType::ObjectExtraLeave);
+	Counters.DatagramsPerSecond = GetRate(SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetDatagramsReceived(); }), LastDatagramsReceived);
+	Counters.BytesPerSecond = GetRate(SumTrackerCounters([](const FAugmentaTracker& InTracker) { return InTracker.GetBytesReceived(); }), LastBytesReceived);
 
-	OnVideoOutputUpdated.Broadcast(VideoOutput);
+	Counters.LatencyP50 = static_cast<float>(LatencyHistogram.GetPercentile(0.5) * 1000.0);
+	Counters.LatencyP99 = static_cast<float>(LatencyHistogram.GetPercentile(0.99) * 1000.0);
+	LatencyHistogram.Reset();
 }
 
-void UAugmentaReceiver::UpdateObjectExtraData(const FOSCMessage& Message, bool HasEntered)
+void UAugmentaReceiver::PublishEvents(const FAugmentaFrameEvents& Events, double ReceiveTime)
 {
-	// UE5 : FVector2D is now double instead of float
-	// Create temporary float to cast
-	float TmpFloat;
+	bSnapshotChanged = true;
 
-	int32 Id = -1;
-	UOSCManager::GetInt32(Message, 1, Id);
+	// The smoother and the analytics see every frame, even the ones whose events are coalesced
+	if (bSmoothObjects)
+	{
+		Smoother.ApplyEvents(Events, ReceiveTime);
+	}
 
-	FAugmentaObjectExtra Extra = ActiveObjectsExtraData.FindOrAdd(Id);
-	// Update the values
-	Extra.Id = Id;
-	UOSCManager::GetInt32(Message, 0, Extra.Frame);
-	UOSCManager::GetInt32(Message, 2, Extra.Oid);
-	UOSCManager::GetFloat(Message, 3, TmpFloat);
-	Extra.Highest.X = TmpFloat;
-	UOSCManager::GetFloat(Message, 4, TmpFloat);
-	Extra.Highest.Y = TmpFloat;
-	UOSCManager::GetFloat(Message, 5, Extra.Distance);
-	UOSCManager::GetFloat(Message, 6, Extra.Reflectivity);
+	if (bComputeAnalytics)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaUpdateAnalytics);
+		Analytics.ApplyEvents(Events, GetFrameSnapshot().Scene.SceneSize, ReceiveTime);
+		if (AnalyticsWriter)
+		{
+			for (const FAugmentaVisitorRecord& Visitor : Analytics.GetLeftVisitors())
+			{
+				AnalyticsWriter->Write(Visitor);
+			}
+		}
+	}
 
-	ActiveObjectsExtraData[Id] = Extra;
-	
-	if (HasEntered)
+	if (bCoalesceEvents)
 	{
-		OnEnteredExtraData.Broadcast(Extra);
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaCoalesceEvents);
+		const SIZE_T AllocatedSize = Coalescer.GetAllocatedSize();
+		Coalescer.Add(Events);
+		BroadcastAllocations += Coalescer.GetAllocatedSize() != AllocatedSize;
 	}
 	else
 	{
-		OnUpdatedExtraData.Broadcast(Extra);
+		BroadcastEvents(Events);
 	}
 }
 
-void UAugmentaReceiver::RemoveObjectExtraData(const FOSCMessage& Message)
+void UAugmentaReceiver::BroadcastEvents(const FAugmentaFrameEvents& Events)
 {
-	int32 Id = -1;
-	UOSCManager::GetInt32(Message, 1, Id);
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastFrame);
+		OnFrameNative.Broadcast(GetFrameSnapshot(), Events);
+	}
+
+	// Batched events, fired once with the whole array
+	if (Events.EnteredObjects.Num() > 0)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastFrameObjectsEntered);
+		OnFrameObjectsEnteredNative.Broadcast(Events.EnteredObjects);
+		OnFrameObjectsEntered.Broadcast(Events.EnteredObjects);
+	}
+	if (Events.UpdatedObjects.Num() > 0)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastFrameObjectsUpdated);
+		OnFrameObjectsUpdatedNative.Broadcast(Events.UpdatedObjects);
+		OnFrameObjectsUpdated.Broadcast(Events.UpdatedObjects);
+	}
+	if (Events.LeftObjects.Num() > 0)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastFrameObjectsLeft);
+		OnFrameObjectsLeftNative.Broadcast(Events.LeftObjects);
+		OnFrameObjectsLeft.Broadcast(Events.LeftObjects);
+	}
 
-	// Remove the entry from the map
-	FAugmentaObjectExtra ExtraDataToRemove;
-	ActiveObjectsExtraData.RemoveAndCopyValue(Id, ExtraDataToRemove);
+	// Per object events, in the order they were received
+	for (const FAugmentaEventRecord& Event : Events.Sequence)
+	{
+		switch (Event.Type)
+		{
+		case EAugmentaEventType::SceneUpdated:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastSceneUpdated);
+			OnSceneUpdated.Broadcast(Events.Scenes[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::VideoOutputUpdated:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastVideoOutputUpdated);
+			OnVideoOutputUpdated.Broadcast(Events.VideoOutputs[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ObjectEntered:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastPersonEntered);
+			OnPersonEntered.Broadcast(Events.EnteredObjects[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ObjectUpdated:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastPersonUpdated);
+			OnPersonUpdated.Broadcast(Events.UpdatedObjects[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ObjectLeft:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastPersonWillLeave);
+			OnPersonWillLeave.Broadcast(Events.LeftObjects[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ExtraDataEntered:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastEnteredExtraData);
+			OnEnteredExtraData.Broadcast(Events.EnteredExtras[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ExtraDataUpdated:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastUpdatedExtraData);
+			OnUpdatedExtraData.Broadcast(Events.UpdatedExtras[Event.Index]);
+			break;
+		}
+		case EAugmentaEventType::ExtraDataLeft:
+		{
+			AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaBroadcastLeaveExtraData);
+			OnLeaveExtraData.Broadcast(Events.LeftExtras[Event.Index]);
+			break;
+		}
+		}
+	}
 
-	OnLeaveExtraData.Broadcast(ExtraDataToRemove);
+	if (Subscriptions.Num() > 0)
+	{
+		AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaDispatchSubscriptions);
+		Subscriptions.Dispatch(Events);
+	}
 }
@@ -0,0 +1,257 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaRecording.h"
+#include "AugmentaUnreal.h"
+#include "Algo/UpperBound.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+using namespace AugmentaRecording;
+
+namespace AugmentaRecording
+{
+	/** The alignment of the records in the file. */
+	constexpr int64 RecordAlignment = 8;
+}
+
+FAugmentaRecorder::~FAugmentaRecorder()
+{
+	Close();
+}
+
+bool FAugmentaRecorder::Open(const TCHAR* Filename)
+{
+	Close();
+
+	FScopeLock ScopeLock(&Lock);
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to create the recording '%s'."), Filename);
+		return false;
+	}
+
+	FFileHeader Header = { FileMagic, AugmentaRecording::Version, 0 };
+	Writer->Serialize(&Header, sizeof(Header));
+
+	Index.Reset();
+	NumRecords = 0;
+	LastTimestampMicros = 0;
+	bRecording = true;
+	return true;
+}
+
+void FAugmentaRecorder::Close()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!Writer)
+	{
+		return;
+	}
+	bRecording = false;
+
+	FFileFooter Footer;
+	Footer.IndexOffset = Writer->Tell();
+	Footer.NumRecords = NumRecords;
+	Footer.DurationMicros = LastTimestampMicros;
+	Footer.NumIndexEntries = Index.Num();
+	Footer.Magic = FooterMagic;
+
+	Writer->Serialize(Index.GetData(), Index.Num() * sizeof(FIndexEntry));
+	Writer->Serialize(&Footer, sizeof(Footer));
+	Writer->Close();
+	Writer.Reset();
+}
+
+void FAugmentaRecorder::Record(const uint8* Data, int32 Size)
+{
+	if (!IsRecording())
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock ScopeLock(&Lock);
+
+	if (!Writer)
+	{
+		return;
+	}
+
+	if (NumRecords == 0)
+	{
+		StartTime = Now;
+	}
+
+	FRecordHeader Header;
+	Header.TimestampMicros = static_cast<uint64>(FMath::Max(Now - StartTime, 0.0) * 1e6);
+	Header.Size = static_cast<uint32>(Size);
+	Header.Reserved = 0;
+
+	if (Index.Num() == 0 || Header.TimestampMicros - Index.Last().TimestampMicros >= IndexInterval)
+	{
+		Index.Add({ Header.TimestampMicros, static_cast<uint64>(Writer->Tell()) });
+	}
+
+	static const uint8 Padding[RecordAlignment] = {};
+	Writer->Serialize(&Header, sizeof(Header));
+	Writer->Serialize(const_cast<uint8*>(Data), Size);
+	Writer->Serialize(const_cast<uint8*>(Padding), Align(Size, RecordAlignment) - Size);
+
+	++NumRecords;
+	LastTimestampMicros = Header.TimestampMicros;
+}
+
+FAugmentaReplay::~FAugmentaReplay()
+{
+	Close();
+}
+
+bool FAugmentaReplay::Open(const TCHAR* Filename)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(Filename));
+	const int64 FileSize = MappedFile ? MappedFile->GetFileSize() : 0;
+	if (FileSize < static_cast<int64>(sizeof(FFileHeader)))
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to open the recording '%s'."), Filename);
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, FileSize));
+	if (!MappedRegion)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to map the recording '%s'."), Filename);
+		Close();
+		return false;
+	}
+
+	const uint8* FileData = MappedRegion->GetMappedPtr();
+	FFileHeader Header;
+	FMemory::Memcpy(&Header, FileData, sizeof(Header));
+	if (Header.Magic != FileMagic || Header.Version != AugmentaRecording::Version)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("'%s' is not an Augmenta recording."), Filename);
+		Close();
+		return false;
+	}
+	Data = FileData;
+
+	// Use the index of a closed recording if it is consistent, scan the records otherwise
+	FFileFooter Footer = {};
+	if (FileSize >= static_cast<int64>(sizeof(FFileHeader) + sizeof(FFileFooter)))
+	{
+		FMemory::Memcpy(&Footer, Data + FileSize - sizeof(FFileFooter), sizeof(Footer));
+	}
+	const bool bHasIndex = Footer.Magic == FooterMagic
+		&& Footer.IndexOffset >= sizeof(FFileHeader)
+		&& Footer.IndexOffset + Footer.NumIndexEntries * sizeof(FIndexEntry) + sizeof(FFileFooter) == static_cast<uint64>(FileSize);
+
+	if (bHasIndex)
+	{
+		RecordsEnd = Footer.IndexOffset;
+		NumRecords = Footer.NumRecords;
+		DurationMicros = Footer.DurationMicros;
+		Index.SetNumUninitialized(Footer.NumIndexEntries);
+		FMemory::Memcpy(Index.GetData(), Data + Footer.IndexOffset, Footer.NumIndexEntries * sizeof(FIndexEntry));
+	}
+	else
+	{
+		UE_LOG(LogAugmenta, Warning, TEXT("The recording '%s' was not closed, scanning its records."), Filename);
+		RecordsEnd = FileSize;
+		ScanRecords();
+	}
+
+	ReadOffset = sizeof(FFileHeader);
+	return true;
+}
+
+void FAugmentaReplay::Close()
+{
+	Data = nullptr;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	RecordsEnd = 0;
+	ReadOffset = 0;
+	Index.Reset();
+	NumRecords = 0;
+	DurationMicros = 0;
+}
+
+bool FAugmentaReplay::ReadNext(FAugmentaRecordedDatagram& OutDatagram)
+{
+	FRecordHeader Header;
+	if (!ReadRecordHeader(ReadOffset, Header))
+	{
+		return false;
+	}
+
+	OutDatagram.Data = Data + ReadOffset + sizeof(FRecordHeader);
+	OutDatagram.Size = Header.Size;
+	OutDatagram.Time = Header.TimestampMicros / 1e6;
+
+	ReadOffset = GetNextRecordOffset(ReadOffset, Header);
+	return true;
+}
+
+void FAugmentaReplay::Seek(double Time)
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	// Start from the last index entry at or before the time, then walk the few records up to it
+	const uint64 TimestampMicros = static_cast<uint64>(FMath::Max(Time, 0.0) * 1e6);
+	const int32 EntryIndex = Algo::UpperBoundBy(Index, TimestampMicros, &FIndexEntry::TimestampMicros) - 1;
+	ReadOffset = EntryIndex >= 0 ? static_cast<int64>(Index[EntryIndex].Offset) : static_cast<int64>(sizeof(FFileHeader));
+
+	FRecordHeader Header;
+	while (ReadRecordHeader(ReadOffset, Header) && Header.TimestampMicros < TimestampMicros)
+	{
+		ReadOffset = GetNextRecordOffset(ReadOffset, Header);
+	}
+}
+
+bool FAugmentaReplay::ReadRecordHeader(int64 Offset, FRecordHeader& OutHeader) const
+{
+	if (!IsOpen() || Offset + static_cast<int64>(sizeof(FRecordHeader)) > RecordsEnd)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&OutHeader, Data + Offset, sizeof(OutHeader));
+	return Offset + static_cast<int64>(sizeof(FRecordHeader)) + OutHeader.Size <= RecordsEnd;
+}
+
+int64 FAugmentaReplay::GetNextRecordOffset(int64 Offset, const FRecordHeader& Header)
+{
+	return Offset + sizeof(FRecordHeader) + Align(static_cast<int64>(Header.Size), RecordAlignment);
+}
+
+void FAugmentaReplay::ScanRecords()
+{
+	int64 Offset = sizeof(FFileHeader);
+	FRecordHeader Header;
+	while (ReadRecordHeader(Offset, Header))
+	{
+		if (Index.Num() == 0 || Header.TimestampMicros - Index.Last().TimestampMicros >= IndexInterval)
+		{
+			Index.Add({ Header.TimestampMicros, static_cast<uint64>(Offset) });
+		}
+		++NumRecords;
+		DurationMicros = Header.TimestampMicros;
+		Offset = GetNextRecordOffset(Offset, Header);
+	}
+
+	// Ignore the truncated record, if any
+	RecordsEnd = FMath::Min(Offset, RecordsEnd);
+}
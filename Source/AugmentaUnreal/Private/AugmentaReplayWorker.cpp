@@ -0,0 +1,112 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaReplayWorker.h"
+#include "AugmentaRecording.h"
+#include "AugmentaTracker.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+
+namespace AugmentaReplayWorker
+{
+	/** The longest sleep between two checks for a stop or seek request, in seconds. */
+	constexpr double MaxSleepTime = 0.05;
+	/** The sleep between two checks for a free slot in the committed frame queue, in seconds. */
+	constexpr float QueueFullSleepTime = 0.001f;
+}
+
+FAugmentaReplayWorker::FAugmentaReplayWorker(TUniquePtr<FAugmentaReplay> InReplay, FAugmentaTracker& InTracker, float InPlaybackRate, bool bInLoop, const TCHAR* ThreadName)
+	: Replay(MoveTemp(InReplay))
+	, Tracker(InTracker)
+	, PlaybackRate(InPlaybackRate)
+	, bLoop(bInLoop)
+{
+	Thread = FRunnableThread::Create(this, ThreadName, 0, TPri_AboveNormal);
+}
+
+FAugmentaReplayWorker::~FAugmentaReplayWorker()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+void FAugmentaReplayWorker::Seek(double InTime)
+{
+	PendingSeekTime = FMath::Max(InTime, 0.0);
+}
+
+uint32 FAugmentaReplayWorker::Run()
+{
+	// The wall clock time at which the recording time TimeOrigin is replayed
+	double ClockOrigin = FPlatformTime::Seconds();
+	double TimeOrigin = 0.0;
+
+	FAugmentaRecordedDatagram Datagram;
+	while (!bStopping)
+	{
+		const double SeekTime = PendingSeekTime.exchange(-1.0);
+		if (SeekTime >= 0.0)
+		{
+			// The objects of the previous time leave, the ones of the new time enter as they are replayed
+			Tracker.RemoveAllObjects();
+			Tracker.CommitFrame();
+			Replay->Seek(SeekTime);
+			ClockOrigin = FPlatformTime::Seconds();
+			TimeOrigin = SeekTime;
+			bFinished = false;
+		}
+
+		if (!Replay->ReadNext(Datagram))
+		{
+			// Publish the last frame of the recording
+			Tracker.CommitFrame();
+			if (bLoop && Replay->GetNumDatagrams() > 0)
+			{
+				Seek(0.0);
+			}
+			else
+			{
+				bFinished = true;
+				FPlatformProcess::Sleep(AugmentaReplayWorker::MaxSleepTime);
+			}
+			continue;
+		}
+
+		// Wait until the datagram is due, unless replaying as fast as possible
+		if (PlaybackRate > 0.f)
+		{
+			const double DueTime = ClockOrigin + (Datagram.Time - TimeOrigin) / PlaybackRate;
+			double RemainingTime = DueTime - FPlatformTime::Seconds();
+			while (RemainingTime > 0.0 && !bStopping && PendingSeekTime < 0.0)
+			{
+				FPlatformProcess::Sleep(static_cast<float>(FMath::Min(RemainingTime, AugmentaReplayWorker::MaxSleepTime)));
+				RemainingTime = DueTime - FPlatformTime::Seconds();
+			}
+			if (RemainingTime > 0.0)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			// Wait until the receiver dequeues the frames rather than merging them, so that every recorded frame is published
+			while (Tracker.IsCommitQueueFull() && !bStopping && PendingSeekTime < 0.0)
+			{
+				FPlatformProcess::Sleep(AugmentaReplayWorker::QueueFullSleepTime);
+			}
+		}
+
+		Tracker.ProcessDatagram(Datagram.Data, Datagram.Size);
+		Time = Datagram.Time;
+	}
+	return 0;
+}
+
+void FAugmentaReplayWorker::Stop()
+{
+	bStopping = true;
+}
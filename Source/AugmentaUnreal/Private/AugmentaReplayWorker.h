@@ -0,0 +1,61 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+/** Forward Declarations */
+class FAugmentaReplay;
+class FAugmentaTracker;
+class FRunnableThread;
+
+/**
+ * A thread feeding the datagrams of an Augmenta recording to a tracker, in place of a socket.
+ * The datagrams go through the same decode path as the received ones, and the committed frames are handed
+ * over to the game thread through the queue of the tracker.
+ */
+class FAugmentaReplayWorker : public FRunnable
+{
+public:
+	/**
+	 * Starts the thread. The tracker must outlive the worker.
+	 *
+	 * @param InReplay The opened recording, owned by the worker.
+	 * @param InTracker The tracker the datagrams are applied to, in frame assembly mode.
+	 * @param InPlaybackRate The speed of the replay, 1 for real time. Zero or less replays as fast as the frames are dequeued.
+	 * @param bInLoop Whether the replay starts over once the end of the recording is reached.
+	 * @param ThreadName The name of the thread.
+	 */
+	FAugmentaReplayWorker(TUniquePtr<FAugmentaReplay> InReplay, FAugmentaTracker& InTracker, float InPlaybackRate, bool bInLoop, const TCHAR* ThreadName);
+	/** Stops the thread and waits for it to exit. */
+	virtual ~FAugmentaReplayWorker();
+
+	/** Requests the replay to continue from the given time, in seconds since the start of the recording. */
+	void Seek(double Time);
+
+	/** Whether the end of the recording was reached, when not looping. */
+	bool IsFinished() const { return bFinished; }
+
+	/** The time of the last replayed datagram, in seconds since the start of the recording. */
+	double GetTime() const { return Time; }
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable interface
+
+private:
+	TUniquePtr<FAugmentaReplay> Replay;
+	FAugmentaTracker& Tracker;
+	float PlaybackRate;
+	bool bLoop;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+	std::atomic<bool> bFinished{ false };
+	std::atomic<double> Time{ 0.0 };
+	/** The time requested by Seek, negative if there is none. */
+	std::atomic<double> PendingSeekTime{ -1.0 };
+};
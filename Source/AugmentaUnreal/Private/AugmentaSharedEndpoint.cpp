@@ -0,0 +1,120 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSharedEndpoint.h"
+#include "AugmentaReceiveWorker.h"
+#include "AugmentaUnreal.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "SocketSubsystem.h"
+#include "Sockets.h"
+
+namespace AugmentaSharedEndpoint
+{
+	/** The size of the socket receive buffer, large enough to absorb a few frames of a dense scene. */
+	constexpr int32 SocketReceiveBufferSize = 2 * 1024 * 1024;
+}
+
+FAugmentaSharedEndpoint::FAugmentaSharedEndpoint(FSocket* InSocket, const FAugmentaExpiry& Expiry, const TCHAR* ThreadName)
+	: Socket(InSocket)
+{
+	Tracker.SetExpiry(Expiry);
+	Tracker.Reset(true);
+	ReceiveWorker = MakeShared<FAugmentaReceiveWorker>(*Socket, Tracker, Recorder, ThreadName);
+}
+
+FAugmentaSharedEndpoint::~FAugmentaSharedEndpoint()
+{
+	// Stop the worker before closing the socket it reads from
+	ReceiveWorker.Reset();
+	Socket->Close();
+	ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+}
+
+FSocket* FAugmentaSharedEndpoint::OpenSocket(const FString& ReceiveIPAddress, int32 Port)
+{
+	FIPv4Address Address = FIPv4Address::Any;
+	if (!ReceiveIPAddress.IsEmpty() && !FIPv4Address::Parse(ReceiveIPAddress, Address))
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Invalid receive ip address '%s'."), *ReceiveIPAddress);
+		return nullptr;
+	}
+
+	FUdpSocketBuilder Builder(TEXT("AugmentaReceiver"));
+	Builder.AsNonBlocking()
+		.AsReusable()
+		.WithReceiveBufferSize(AugmentaSharedEndpoint::SocketReceiveBufferSize);
+
+	// Same behavior as the OSC server : multicast addresses are joined, any other address is bound to.
+	if (Address.IsMulticastAddress())
+	{
+		Builder.BoundToAddress(FIPv4Address::Any).BoundToPort(Port).JoinedToGroup(Address);
+	}
+	else
+	{
+		Builder.BoundToEndpoint(FIPv4Endpoint(Address, Port));
+	}
+
+	FSocket* NewSocket = Builder.Build();
+	if (!NewSocket)
+	{
+		UE_LOG(LogAugmenta, Error, TEXT("Failed to open the socket on %s:%d."), *Address.ToString(), Port);
+	}
+	return NewSocket;
+}
+
+FString FAugmentaSharedEndpoint::GetKey(const FString& ReceiveIPAddress, int32 Port)
+{
+	// An empty address and 0.0.0.0 are the same endpoint, an invalid address keeps its own key and fails to open
+	FIPv4Address Address = FIPv4Address::Any;
+	if (!ReceiveIPAddress.IsEmpty() && !FIPv4Address::Parse(ReceiveIPAddress, Address))
+	{
+		return FString::Printf(TEXT("%s:%d"), *ReceiveIPAddress, Port);
+	}
+	return FIPv4Endpoint(Address, Port).ToString();
+}
+
+void FAugmentaSharedEndpoint::GetSnapshotEvents(const FAugmentaFrameSnapshot& Snapshot, FAugmentaFrameEvents& OutEvents)
+{
+	OutEvents.Sequence.Add({ EAugmentaEventType::SceneUpdated, OutEvents.Scenes.Add(Snapshot.Scene) });
+	OutEvents.Sequence.Add({ EAugmentaEventType::VideoOutputUpdated, OutEvents.VideoOutputs.Add(Snapshot.VideoOutput) });
+	for (const FAugmentaPerson& Object : Snapshot.Objects.GetObjects())
+	{
+		OutEvents.Sequence.Add({ EAugmentaEventType::ObjectEntered, OutEvents.EnteredObjects.Add(Object) });
+	}
+	for (const FAugmentaObjectExtra& Extra : Snapshot.ObjectExtras.GetExtras())
+	{
+		OutEvents.Sequence.Add({ EAugmentaEventType::ExtraDataEntered, OutEvents.EnteredExtras.Add(Extra) });
+	}
+}
+
+void FAugmentaSharedEndpoint::Pump()
+{
+	if (PumpFrameCounter == GFrameCounter)
+	{
+		return;
+	}
+	PumpFrameCounter = GFrameCounter;
+
+	// Every receiver ticks once per engine frame, so they all read the frames of the last pump before the next one
+	FirstPumpedSequence = GetNextSequence();
+	PumpedFrames.Reset();
+
+	FAugmentaCommittedFrameRef Frame;
+	while (Tracker.DequeueCommittedFrame(Frame))
+	{
+		LatestFrame = Frame;
+		PumpedFrames.Add(MoveTemp(Frame));
+	}
+}
+
+TConstArrayView<FAugmentaCommittedFrameRef> FAugmentaSharedEndpoint::ReadFrames(uint64& Cursor) const
+{
+	// A receiver that missed a pump continues from the frames of the last one
+	const uint64 First = FMath::Max(Cursor, FirstPumpedSequence);
+	Cursor = FMath::Max(Cursor, GetNextSequence());
+	if (First >= Cursor)
+	{
+		return TConstArrayView<FAugmentaCommittedFrameRef>();
+	}
+	return TConstArrayView<FAugmentaCommittedFrameRef>(PumpedFrames).Slice(static_cast<int32>(First - FirstPumpedSequence), static_cast<int32>(Cursor - First));
+}
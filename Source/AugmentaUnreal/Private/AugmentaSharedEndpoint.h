@@ -0,0 +1,79 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaRecording.h"
+#include "AugmentaTracker.h"
+
+/** Forward Declarations */
+class FAugmentaReceiveWorker;
+class FSocket;
+
+/**
+ * A socket received and decoded on its own thread, whose committed frames are read by every receiver attached to it,
+ * see UAugmentaReceiver::ConnectShared. The frames are read only and reference counted, so the receivers read the
+ * same frames without copying them : the decode cost is paid once whatever the number of receivers.
+ *
+ * The endpoint is owned by the receivers attached to it, and closed once the last one releases it.
+ */
+class FAugmentaSharedEndpoint
+{
+public:
+	/**
+	 * Starts receiving on the socket, in frame assembly mode.
+	 *
+	 * @param InSocket The socket to receive the datagrams from, closed with the endpoint.
+	 * @param Expiry When the objects that are not updated anymore are considered lost.
+	 * @param ThreadName The name of the receive thread.
+	 */
+	FAugmentaSharedEndpoint(FSocket* InSocket, const FAugmentaExpiry& Expiry, const TCHAR* ThreadName);
+	/** Stops the receive thread and closes the socket. */
+	~FAugmentaSharedEndpoint();
+
+	/** Opens a non blocking UDP socket receiving on the given ip address and port, joining the multicast addresses. */
+	static FSocket* OpenSocket(const FString& ReceiveIPAddress, int32 Port);
+
+	/** Returns the key of the endpoint receiving on the given ip address and port, the same for every spelling of the address. */
+	static FString GetKey(const FString& ReceiveIPAddress, int32 Port);
+
+	/** Records a snapshot as the events of a receiver seeing it for the first time : the scene, then every object entering. */
+	static void GetSnapshotEvents(const FAugmentaFrameSnapshot& Snapshot, FAugmentaFrameEvents& OutEvents);
+
+	/**
+	 * Dequeues the frames committed since the last engine frame. Only the first call of an engine frame dequeues, so that
+	 * every receiver reads the same frames during an engine frame, whatever the order they tick in.
+	 */
+	void Pump();
+
+	/**
+	 * Returns the frames of the last pump after a cursor, and moves the cursor past them.
+	 * The frames are only valid until the next pump.
+	 *
+	 * @param Cursor The sequence number of the next frame to read, see GetNextSequence.
+	 */
+	TConstArrayView<FAugmentaCommittedFrameRef> ReadFrames(uint64& Cursor) const;
+
+	/** The sequence number of the next frame to be pumped. */
+	uint64 GetNextSequence() const { return FirstPumpedSequence + PumpedFrames.Num(); }
+
+	/** The last frame pumped, null before the first one. */
+	const FAugmentaCommittedFrameRef& GetLatestFrame() const { return LatestFrame; }
+
+	/** The tracker fed by the receive thread, for its counters. */
+	const FAugmentaTracker& GetTracker() const { return Tracker; }
+
+private:
+	FSocket* Socket = nullptr;
+	FAugmentaTracker Tracker;
+	/** Never opened, the shared endpoints are not recorded. */
+	FAugmentaRecorder Recorder;
+	TSharedPtr<FAugmentaReceiveWorker> ReceiveWorker;
+
+	/** The frames dequeued by the last pump, and the sequence number of the first one. */
+	TArray<FAugmentaCommittedFrameRef> PumpedFrames;
+	uint64 FirstPumpedSequence = 0;
+	FAugmentaCommittedFrameRef LatestFrame;
+	/** The engine frame of the last pump. */
+	uint64 PumpFrameCounter = MAX_uint64;
+};
@@ -0,0 +1,325 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSmoother.h"
+#include "AugmentaTracker.h"
+
+namespace AugmentaSmoother
+{
+	/** The share of the arrival time error corrected in the frame time, and in the frame period. */
+	constexpr double TimeGain = 0.1;
+	constexpr double PeriodGain = 0.01;
+	/** A frame this far from the last one, or arriving this far from its expected time, restarts the clock. */
+	constexpr int32 MaxFrameJump = 256;
+	constexpr double MaxTimeError = 0.5;
+
+	/** How far the times can get from their origin before it is moved, in seconds. Floats keep a 0.1 ms precision up to there. */
+	constexpr double RebaseInterval = 1024.0;
+	/** The shortest duration between two samples, to interpolate between samples of the same time. */
+	constexpr float MinSampleDuration = 1e-6f;
+}
+
+void FAugmentaFrameClock::Reset()
+{
+	LastFrame = INDEX_NONE;
+	LastFrameTime = 0.0;
+	FramePeriod = 0.0;
+}
+
+double FAugmentaFrameClock::GetFrameTime(int32 Frame, double ArrivalTime)
+{
+	using namespace AugmentaSmoother;
+
+	const int32 Frames = Frame - LastFrame;
+	if (LastFrame == INDEX_NONE || Frames > MaxFrameJump || Frames < -MaxFrameJump)
+	{
+		// The first frame, or the server restarted
+		LastFrame = Frame;
+		LastFrameTime = ArrivalTime;
+		FramePeriod = 0.0;
+		return ArrivalTime;
+	}
+
+	if (Frames <= 0)
+	{
+		// A frame already received, or received out of order
+		return LastFrameTime + Frames * FramePeriod;
+	}
+
+	if (FramePeriod <= 0.0)
+	{
+		// The second frame gives the first estimation of the period
+		FramePeriod = FMath::Max((ArrivalTime - LastFrameTime) / Frames, 0.0);
+		LastFrame = Frame;
+		LastFrameTime = ArrivalTime;
+		return ArrivalTime;
+	}
+
+	const double ExpectedTime = LastFrameTime + Frames * FramePeriod;
+	const double Error = ArrivalTime - ExpectedTime;
+	if (FMath::Abs(Error) > MaxTimeError)
+	{
+		LastFrame = Frame;
+		LastFrameTime = ArrivalTime;
+		FramePeriod = 0.0;
+		return ArrivalTime;
+	}
+
+	LastFrame = Frame;
+	LastFrameTime = ExpectedTime + TimeGain * Error;
+	FramePeriod = FMath::Max(FramePeriod + PeriodGain * Error / Frames, 0.0);
+	return LastFrameTime;
+}
+
+FAugmentaSmoother::FAugmentaSmoother()
+{
+	Reset();
+}
+
+void FAugmentaSmoother::Reset()
+{
+	FrameClock.Reset();
+	TimeBase = 0.0;
+	Index.Reset();
+	Pids.Reset();
+	for (int32 SampleIndex = 0; SampleIndex < HistorySize; ++SampleIndex)
+	{
+		SampleTimes[SampleIndex].Reset();
+		SampleX[SampleIndex].Reset();
+		SampleY[SampleIndex].Reset();
+	}
+	VelocityX.Reset();
+	VelocityY.Reset();
+	SmoothedX.Reset();
+	SmoothedY.Reset();
+}
+
+void FAugmentaSmoother::ApplyEvents(const FAugmentaFrameEvents& Events, double ArrivalTime)
+{
+	Rebase(ArrivalTime);
+
+	for (const FAugmentaEventRecord& Event : Events.Sequence)
+	{
+		switch (Event.Type)
+		{
+		case EAugmentaEventType::ObjectEntered:
+		{
+			const FAugmentaPerson& Object = Events.EnteredObjects[Event.Index];
+			AddSample(Object.Pid, static_cast<float>(FrameClock.GetFrameTime(Object.Frame, ArrivalTime) - TimeBase), Object);
+			break;
+		}
+		case EAugmentaEventType::ObjectUpdated:
+		{
+			const FAugmentaPerson& Object = Events.UpdatedObjects[Event.Index];
+			AddSample(Object.Pid, static_cast<float>(FrameClock.GetFrameTime(Object.Frame, ArrivalTime) - TimeBase), Object);
+			break;
+		}
+		case EAugmentaEventType::ObjectLeft:
+		{
+			Remove(Events.LeftObjects[Event.Index].Pid);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+}
+
+void FAugmentaSmoother::Sample(double RenderTime, float MaxExtrapolationTime)
+{
+	using namespace AugmentaSmoother;
+
+	Rebase(RenderTime);
+
+	const int32 Num = Pids.Num();
+	SmoothedX.SetNumUninitialized(Num);
+	SmoothedY.SetNumUninitialized(Num);
+
+	const float Time = static_cast<float>(RenderTime - TimeBase);
+	const VectorRegister4Float VectorTime = VectorSetFloat1(Time);
+	const VectorRegister4Float VectorMaxExtrapolationTime = VectorSetFloat1(MaxExtrapolationTime);
+	const VectorRegister4Float VectorMinSampleDuration = VectorSetFloat1(MinSampleDuration);
+
+	const int32 NumVectorized = Num & ~3;
+	int32 Slot = 0;
+	for (; Slot < NumVectorized; Slot += 4)
+	{
+		// Before the oldest sample, the oldest sample
+		VectorRegister4Float X = VectorLoad(&SampleX[HistorySize - 1][Slot]);
+		VectorRegister4Float Y = VectorLoad(&SampleY[HistorySize - 1][Slot]);
+
+		// Interpolated between the most recent pair of samples starting before the render time
+		for (int32 SampleIndex = HistorySize - 2; SampleIndex >= 0; --SampleIndex)
+		{
+			const VectorRegister4Float OlderTime = VectorLoad(&SampleTimes[SampleIndex + 1][Slot]);
+			const VectorRegister4Float NewerTime = VectorLoad(&SampleTimes[SampleIndex][Slot]);
+			const VectorRegister4Float Duration = VectorMax(VectorSubtract(NewerTime, OlderTime), VectorMinSampleDuration);
+			const VectorRegister4Float Alpha = VectorMin(VectorMax(VectorDivide(VectorSubtract(VectorTime, OlderTime), Duration), VectorZeroFloat()), VectorOneFloat());
+
+			const VectorRegister4Float OlderX = VectorLoad(&SampleX[SampleIndex + 1][Slot]);
+			const VectorRegister4Float OlderY = VectorLoad(&SampleY[SampleIndex + 1][Slot]);
+			const VectorRegister4Float InterpolatedX = VectorMultiplyAdd(VectorSubtract(VectorLoad(&SampleX[SampleIndex][Slot]), OlderX), Alpha, OlderX);
+			const VectorRegister4Float InterpolatedY = VectorMultiplyAdd(VectorSubtract(VectorLoad(&SampleY[SampleIndex][Slot]), OlderY), Alpha, OlderY);
+
+			const VectorRegister4Float StartedMask = VectorCompareGE(VectorTime, OlderTime);
+			X = VectorSelect(StartedMask, InterpolatedX, X);
+			Y = VectorSelect(StartedMask, InterpolatedY, Y);
+		}
+
+		// Past the most recent sample, extrapolated with the velocity
+		const VectorRegister4Float NewestTime = VectorLoad(&SampleTimes[0][Slot]);
+		const VectorRegister4Float Elapsed = VectorMin(VectorSubtract(VectorTime, NewestTime), VectorMaxExtrapolationTime);
+		const VectorRegister4Float ExtrapolatedX = VectorMultiplyAdd(VectorLoad(&VelocityX[Slot]), Elapsed, VectorLoad(&SampleX[0][Slot]));
+		const VectorRegister4Float ExtrapolatedY = VectorMultiplyAdd(VectorLoad(&VelocityY[Slot]), Elapsed, VectorLoad(&SampleY[0][Slot]));
+
+		const VectorRegister4Float EndedMask = VectorCompareGE(VectorTime, NewestTime);
+		VectorStore(VectorSelect(EndedMask, ExtrapolatedX, X), &SmoothedX[Slot]);
+		VectorStore(VectorSelect(EndedMask, ExtrapolatedY, Y), &SmoothedY[Slot]);
+	}
+	for (; Slot < Num; ++Slot)
+	{
+		float X = SampleX[HistorySize - 1][Slot];
+		float Y = SampleY[HistorySize - 1][Slot];
+		for (int32 SampleIndex = HistorySize - 2; SampleIndex >= 0; --SampleIndex)
+		{
+			const float OlderTime = SampleTimes[SampleIndex + 1][Slot];
+			if (Time >= OlderTime)
+			{
+				const float Duration = FMath::Max(SampleTimes[SampleIndex][Slot] - OlderTime, MinSampleDuration);
+				const float Alpha = FMath::Clamp((Time - OlderTime) / Duration, 0.f, 1.f);
+				X = FMath::Lerp(SampleX[SampleIndex + 1][Slot], SampleX[SampleIndex][Slot], Alpha);
+				Y = FMath::Lerp(SampleY[SampleIndex + 1][Slot], SampleY[SampleIndex][Slot], Alpha);
+			}
+		}
+
+		const float NewestTime = SampleTimes[0][Slot];
+		if (Time >= NewestTime)
+		{
+			const float Elapsed = FMath::Min(Time - NewestTime, MaxExtrapolationTime);
+			X = SampleX[0][Slot] + VelocityX[Slot] * Elapsed;
+			Y = SampleY[0][Slot] + VelocityY[Slot] * Elapsed;
+		}
+
+		SmoothedX[Slot] = X;
+		SmoothedY[Slot] = Y;
+	}
+}
+
+bool FAugmentaSmoother::FindSmoothedCentroid(int32 Pid, FVector2D& OutCentroid) const
+{
+	const int32 Slot = Index.Find(Pid);
+	if (Slot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutCentroid = FVector2D(SmoothedX[Slot], SmoothedY[Slot]);
+	return true;
+}
+
+void FAugmentaSmoother::AddSample(int32 Pid, float Time, const FAugmentaPerson& Object)
+{
+	const float X = static_cast<float>(Object.Centroid.X);
+	const float Y = static_cast<float>(Object.Centroid.Y);
+
+	int32 Slot = Index.Find(Pid);
+	if (Slot == INDEX_NONE)
+	{
+		Slot = Pids.Add(Pid);
+		Index.Add(Pid, Slot);
+		for (int32 SampleIndex = 0; SampleIndex < HistorySize; ++SampleIndex)
+		{
+			SampleTimes[SampleIndex].Add(Time);
+			SampleX[SampleIndex].Add(X);
+			SampleY[SampleIndex].Add(Y);
+		}
+		VelocityX.Add(static_cast<float>(Object.Velocity.X));
+		VelocityY.Add(static_cast<float>(Object.Velocity.Y));
+		// Sampled at the next tick, until then the object stays where it entered
+		SmoothedX.Add(X);
+		SmoothedY.Add(Y);
+		return;
+	}
+
+	const float NewestTime = SampleTimes[0][Slot];
+	if (Time > NewestTime)
+	{
+		for (int32 SampleIndex = HistorySize - 1; SampleIndex > 0; --SampleIndex)
+		{
+			SampleTimes[SampleIndex][Slot] = SampleTimes[SampleIndex - 1][Slot];
+			SampleX[SampleIndex][Slot] = SampleX[SampleIndex - 1][Slot];
+			SampleY[SampleIndex][Slot] = SampleY[SampleIndex - 1][Slot];
+		}
+	}
+	else if (Time < NewestTime)
+	{
+		// The clock restarted, the history does not match the new times anymore
+		for (int32 SampleIndex = 1; SampleIndex < HistorySize; ++SampleIndex)
+		{
+			SampleTimes[SampleIndex][Slot] = Time;
+			SampleX[SampleIndex][Slot] = X;
+			SampleY[SampleIndex][Slot] = Y;
+		}
+	}
+	// Otherwise another update of the same frame replaces the most recent sample
+	SampleTimes[0][Slot] = Time;
+	SampleX[0][Slot] = X;
+	SampleY[0][Slot] = Y;
+	VelocityX[Slot] = static_cast<float>(Object.Velocity.X);
+	VelocityY[Slot] = static_cast<float>(Object.Velocity.Y);
+}
+
+void FAugmentaSmoother::Remove(int32 Pid)
+{
+	const int32 Slot = Index.Find(Pid);
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	Index.Remove(Pid);
+	const int32 LastSlot = Pids.Num() - 1;
+	if (Slot != LastSlot)
+	{
+		Index.Update(Pids[LastSlot], Slot);
+	}
+
+	const auto RemoveSwap = [Slot](auto& Array)
+	{
+		Array.RemoveAtSwap(Slot, 1, false);
+	};
+	RemoveSwap(Pids);
+	for (int32 SampleIndex = 0; SampleIndex < HistorySize; ++SampleIndex)
+	{
+		RemoveSwap(SampleTimes[SampleIndex]);
+		RemoveSwap(SampleX[SampleIndex]);
+		RemoveSwap(SampleY[SampleIndex]);
+	}
+	RemoveSwap(VelocityX);
+	RemoveSwap(VelocityY);
+	RemoveSwap(SmoothedX);
+	RemoveSwap(SmoothedY);
+}
+
+void FAugmentaSmoother::Rebase(double Time)
+{
+	if (TimeBase == 0.0)
+	{
+		TimeBase = Time;
+		return;
+	}
+
+	if (Time - TimeBase < AugmentaSmoother::RebaseInterval)
+	{
+		return;
+	}
+
+	const float Offset = static_cast<float>(Time - TimeBase);
+	TimeBase = Time;
+	for (TArray<float>& Times : SampleTimes)
+	{
+		for (float& SampleTime : Times)
+		{
+			SampleTime -= Offset;
+		}
+	}
+}
@@ -0,0 +1,85 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSpatialBruteForce.h"
+
+namespace AugmentaSpatialBruteForce
+{
+	/** A slot considered by FindNearest. */
+	struct FCandidate
+	{
+		float DistanceSquared;
+		int32 Slot;
+	};
+
+	void FindInRect(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots)
+	{
+		for (int32 Slot = 0; Slot < X.Num(); ++Slot)
+		{
+			if (X[Slot] >= Min.X && X[Slot] <= Max.X && Y[Slot] >= Min.Y && Y[Slot] <= Max.Y)
+			{
+				OutSlots.Add(Slot);
+			}
+		}
+	}
+
+	void FindInRadius(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots)
+	{
+		const float RadiusSquared = Radius * Radius;
+		for (int32 Slot = 0; Slot < X.Num(); ++Slot)
+		{
+			if (FAugmentaSpatialGrid::GetDistanceSquared(X[Slot], Y[Slot], Center, Scale) <= RadiusSquared)
+			{
+				OutSlots.Add(Slot);
+			}
+		}
+	}
+
+	void FindNearest(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots)
+	{
+		if (Count <= 0)
+		{
+			return;
+		}
+
+		// Keep the nearest candidates in a max heap rather than sorting every slot, the farthest one on top
+		TArray<FCandidate, TInlineAllocator<64>> Nearest;
+		const auto FarthestFirst = [](const FCandidate& A, const FCandidate& B) { return A.DistanceSquared > B.DistanceSquared; };
+		for (int32 Slot = 0; Slot < X.Num(); ++Slot)
+		{
+			const float DistanceSquared = FAugmentaSpatialGrid::GetDistanceSquared(X[Slot], Y[Slot], Center, Scale);
+			if (Nearest.Num() < Count)
+			{
+				Nearest.HeapPush({ DistanceSquared, Slot }, FarthestFirst);
+			}
+			else if (DistanceSquared < Nearest.HeapTop().DistanceSquared)
+			{
+				Nearest.HeapPopDiscard(FarthestFirst, false);
+				Nearest.HeapPush({ DistanceSquared, Slot }, FarthestFirst);
+			}
+		}
+
+		Nearest.Sort([](const FCandidate& A, const FCandidate& B) { return A.DistanceSquared < B.DistanceSquared; });
+		OutSlots.Reserve(OutSlots.Num() + Nearest.Num());
+		for (const FCandidate& Candidate : Nearest)
+		{
+			OutSlots.Add(Candidate.Slot);
+		}
+	}
+
+	void FindPairs(TConstArrayView<float> X, TConstArrayView<float> Y, float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs)
+	{
+		const float MaxDistanceSquared = MaxDistance * MaxDistance;
+		for (int32 SlotA = 0; SlotA < X.Num(); ++SlotA)
+		{
+			const FVector2f PositionA(X[SlotA], Y[SlotA]);
+			for (int32 SlotB = SlotA + 1; SlotB < X.Num(); ++SlotB)
+			{
+				const float DistanceSquared = FAugmentaSpatialGrid::GetDistanceSquared(X[SlotB], Y[SlotB], PositionA, Scale);
+				if (DistanceSquared <= MaxDistanceSquared)
+				{
+					OutPairs.Add({ SlotA, SlotB, FMath::Sqrt(DistanceSquared) });
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,29 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaSpatialGrid.h"
+
+/**
+ * The spatial queries of FAugmentaSpatialGrid, scanning every slot instead of the cells. They are the reference the grid is
+ * tested against and compared with by the spatial query benchmark, and measure the same distances (see
+ * FAugmentaSpatialGrid::GetDistanceSquared) so that the slots on the edge of a radius are found by both.
+ */
+namespace AugmentaSpatialBruteForce
+{
+	/** The scale measuring the distances in meters, in the 20 x 10 m scene the queries are tested and benchmarked in. */
+	inline const FVector2f SceneScale(20.f, 10.f);
+
+	/** Finds the slots inside a rectangle. See FAugmentaSpatialGrid::FindInRect. */
+	void FindInRect(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots);
+
+	/** Finds the slots within a distance of a point. See FAugmentaSpatialGrid::FindInRadius. */
+	void FindInRadius(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots);
+
+	/** Finds the slots nearest to a point, from the nearest to the farthest. See FAugmentaSpatialGrid::FindNearest. */
+	void FindNearest(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots);
+
+	/** Finds every pair of slots within a distance of each other. See FAugmentaSpatialGrid::FindPairs. */
+	void FindPairs(TConstArrayView<float> X, TConstArrayView<float> Y, float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs);
+}
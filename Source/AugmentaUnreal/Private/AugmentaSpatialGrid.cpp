@@ -0,0 +1,259 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSpatialGrid.h"
+
+namespace AugmentaSpatialGrid
+{
+	/** The size of a cell, in normalized scene coordinates. */
+	constexpr float CellSize = 1.f / FAugmentaSpatialGrid::Resolution;
+
+	/** A slot considered by FindNearest. */
+	struct FCandidate
+	{
+		float DistanceSquared;
+		int32 Slot;
+	};
+}
+
+FAugmentaSpatialGrid::FAugmentaSpatialGrid()
+{
+	CellHeads.Init(INDEX_NONE, Resolution * Resolution);
+}
+
+void FAugmentaSpatialGrid::Add(int32 Slot, float X, float Y)
+{
+	check(Slot == Links.Num());
+	Links.AddUninitialized();
+	Link(Slot, GetCell(X, Y));
+}
+
+void FAugmentaSpatialGrid::Move(int32 Slot, float X, float Y)
+{
+	const int32 Cell = GetCell(X, Y);
+	if (Cell != Links[Slot].Cell)
+	{
+		Unlink(Slot);
+		Link(Slot, Cell);
+	}
+}
+
+void FAugmentaSpatialGrid::RemoveSwap(int32 Slot, int32 LastSlot)
+{
+	Unlink(Slot);
+
+	if (Slot != LastSlot)
+	{
+		// Point the neighbours of the last slot to its new place
+		const FLink Moved = Links[LastSlot];
+		Links[Slot] = Moved;
+		if (Moved.Prev != INDEX_NONE)
+		{
+			Links[Moved.Prev].Next = Slot;
+		}
+		else
+		{
+			CellHeads[Moved.Cell] = Slot;
+		}
+		if (Moved.Next != INDEX_NONE)
+		{
+			Links[Moved.Next].Prev = Slot;
+		}
+	}
+	Links.RemoveAt(LastSlot, 1, false);
+}
+
+void FAugmentaSpatialGrid::Reset()
+{
+	Links.Reset();
+	for (int32& Head : CellHeads)
+	{
+		Head = INDEX_NONE;
+	}
+}
+
+void FAugmentaSpatialGrid::CopyFrom(const FAugmentaSpatialGrid& Other)
+{
+	Links.Reset();
+	Links.Append(Other.Links);
+	FMemory::Memcpy(CellHeads.GetData(), Other.CellHeads.GetData(), CellHeads.Num() * sizeof(int32));
+}
+
+void FAugmentaSpatialGrid::FindInRect(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots) const
+{
+	ForEachSlotInRect(Min, Max, [&](int32 Slot)
+	{
+		if (X[Slot] >= Min.X && X[Slot] <= Max.X && Y[Slot] >= Min.Y && Y[Slot] <= Max.Y)
+		{
+			OutSlots.Add(Slot);
+		}
+	});
+}
+
+void FAugmentaSpatialGrid::FindInRadius(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots) const
+{
+	const FVector2f Extent(Radius / Scale.X, Radius / Scale.Y);
+	const float RadiusSquared = Radius * Radius;
+	ForEachSlotInRect(Center - Extent, Center + Extent, [&](int32 Slot)
+	{
+		if (GetDistanceSquared(X[Slot], Y[Slot], Center, Scale) <= RadiusSquared)
+		{
+			OutSlots.Add(Slot);
+		}
+	});
+}
+
+void FAugmentaSpatialGrid::FindNearest(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots) const
+{
+	using AugmentaSpatialGrid::FCandidate;
+
+	if (Count <= 0 || Links.Num() == 0)
+	{
+		return;
+	}
+
+	// Max heap of the nearest candidates found so far, the farthest one on top
+	TArray<FCandidate, TInlineAllocator<64>> Nearest;
+	const auto FarthestFirst = [](const FCandidate& A, const FCandidate& B) { return A.DistanceSquared > B.DistanceSquared; };
+
+	const int32 CenterCellX = GetCellCoordinate(Center.X);
+	const int32 CenterCellY = GetCellCoordinate(Center.Y);
+	for (int32 Ring = 0; ; ++Ring)
+	{
+		const int32 MinCellX = CenterCellX - Ring;
+		const int32 MaxCellX = CenterCellX + Ring;
+		const int32 MinCellY = CenterCellY - Ring;
+		const int32 MaxCellY = CenterCellY + Ring;
+
+		// Visit the cells on the border of the ring only, the inner ones were visited by the previous rings
+		for (int32 CellY = FMath::Max(MinCellY, 0); CellY <= FMath::Min(MaxCellY, Resolution - 1); ++CellY)
+		{
+			const bool bFullRow = CellY == MinCellY || CellY == MaxCellY;
+			const int32 Step = bFullRow ? 1 : MaxCellX - MinCellX;
+			for (int32 CellX = MinCellX; CellX <= MaxCellX; CellX += Step)
+			{
+				if (CellX < 0 || CellX >= Resolution)
+				{
+					continue;
+				}
+
+				for (int32 Slot = CellHeads[CellY * Resolution + CellX]; Slot != INDEX_NONE; Slot = Links[Slot].Next)
+				{
+					const float DistanceSquared = GetDistanceSquared(X[Slot], Y[Slot], Center, Scale);
+					if (Nearest.Num() < Count)
+					{
+						Nearest.HeapPush({ DistanceSquared, Slot }, FarthestFirst);
+					}
+					else if (DistanceSquared < Nearest.HeapTop().DistanceSquared)
+					{
+						Nearest.HeapPopDiscard(FarthestFirst, false);
+						Nearest.HeapPush({ DistanceSquared, Slot }, FarthestFirst);
+					}
+				}
+			}
+		}
+
+		if (MinCellX <= 0 && MinCellY <= 0 && MaxCellX >= Resolution - 1 && MaxCellY >= Resolution - 1)
+		{
+			break;
+		}
+
+		// Stop once the slots outside of the visited cells cannot be nearer than the farthest candidate
+		if (Nearest.Num() == Count)
+		{
+			float Bound = MAX_flt;
+			if (MinCellX > 0)
+			{
+				Bound = FMath::Min(Bound, (Center.X - MinCellX * AugmentaSpatialGrid::CellSize) * Scale.X);
+			}
+			if (MaxCellX < Resolution - 1)
+			{
+				Bound = FMath::Min(Bound, ((MaxCellX + 1) * AugmentaSpatialGrid::CellSize - Center.X) * Scale.X);
+			}
+			if (MinCellY > 0)
+			{
+				Bound = FMath::Min(Bound, (Center.Y - MinCellY * AugmentaSpatialGrid::CellSize) * Scale.Y);
+			}
+			if (MaxCellY < Resolution - 1)
+			{
+				Bound = FMath::Min(Bound, ((MaxCellY + 1) * AugmentaSpatialGrid::CellSize - Center.Y) * Scale.Y);
+			}
+			if (Bound * Bound >= Nearest.HeapTop().DistanceSquared)
+			{
+				break;
+			}
+		}
+	}
+
+	Nearest.Sort([](const FCandidate& A, const FCandidate& B) { return A.DistanceSquared < B.DistanceSquared; });
+	OutSlots.Reserve(OutSlots.Num() + Nearest.Num());
+	for (const FCandidate& Candidate : Nearest)
+	{
+		OutSlots.Add(Candidate.Slot);
+	}
+}
+
+void FAugmentaSpatialGrid::FindPairs(TConstArrayView<float> X, TConstArrayView<float> Y, float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs) const
+{
+	// The number of neighbouring cells that can hold a slot within the distance, along each axis
+	const int32 RangeX = FMath::Min(FMath::CeilToInt(MaxDistance / (Scale.X * AugmentaSpatialGrid::CellSize)), Resolution);
+	const int32 RangeY = FMath::Min(FMath::CeilToInt(MaxDistance / (Scale.Y * AugmentaSpatialGrid::CellSize)), Resolution);
+	const float MaxDistanceSquared = MaxDistance * MaxDistance;
+
+	for (int32 Cell = 0; Cell < CellHeads.Num(); ++Cell)
+	{
+		const int32 CellX = Cell % Resolution;
+		const int32 CellY = Cell / Resolution;
+		for (int32 SlotA = CellHeads[Cell]; SlotA != INDEX_NONE; SlotA = Links[SlotA].Next)
+		{
+			const FVector2f PositionA(X[SlotA], Y[SlotA]);
+			for (int32 OtherY = FMath::Max(CellY - RangeY, 0); OtherY <= FMath::Min(CellY + RangeY, Resolution - 1); ++OtherY)
+			{
+				for (int32 OtherX = FMath::Max(CellX - RangeX, 0); OtherX <= FMath::Min(CellX + RangeX, Resolution - 1); ++OtherX)
+				{
+					for (int32 SlotB = CellHeads[OtherY * Resolution + OtherX]; SlotB != INDEX_NONE; SlotB = Links[SlotB].Next)
+					{
+						// Every pair is seen from both of its slots, only keep one
+						if (SlotB <= SlotA)
+						{
+							continue;
+						}
+
+						const float DistanceSquared = GetDistanceSquared(X[SlotB], Y[SlotB], PositionA, Scale);
+						if (DistanceSquared <= MaxDistanceSquared)
+						{
+							OutPairs.Add({ SlotA, SlotB, FMath::Sqrt(DistanceSquared) });
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void FAugmentaSpatialGrid::Link(int32 Slot, int32 Cell)
+{
+	const int32 Head = CellHeads[Cell];
+	Links[Slot] = { INDEX_NONE, Head, Cell };
+	if (Head != INDEX_NONE)
+	{
+		Links[Head].Prev = Slot;
+	}
+	CellHeads[Cell] = Slot;
+}
+
+void FAugmentaSpatialGrid::Unlink(int32 Slot)
+{
+	const FLink SlotLink = Links[Slot];
+	if (SlotLink.Prev != INDEX_NONE)
+	{
+		Links[SlotLink.Prev].Next = SlotLink.Next;
+	}
+	else
+	{
+		CellHeads[SlotLink.Cell] = SlotLink.Next;
+	}
+	if (SlotLink.Next != INDEX_NONE)
+	{
+		Links[SlotLink.Next].Prev = SlotLink.Prev;
+	}
+}
@@ -0,0 +1,167 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSpatialQueryBenchmarkCommandlet.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaSpatialBruteForce.h"
+#include "AugmentaUnreal.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace AugmentaSpatialQueryBenchmarkCommandlet
+{
+	/** The half size of the rectangles, the radius and the pair distance, in meters, e.g. an interactive zone. */
+	constexpr float QuerySize = 1.f;
+	constexpr int32 NearestCount = 5;
+
+	/** The time of a query, with the grid and with a brute force scan, in nanoseconds. */
+	struct FQueryTimes
+	{
+		double Grid = 0.0;
+		double BruteForce = 0.0;
+	};
+
+	/** Runs a query with the grid then with the brute force, once per center, and returns their average time. */
+	template <typename GridFuncType, typename BruteForceFuncType>
+	FQueryTimes TimeQuery(TConstArrayView<FVector2f> Centers, GridFuncType&& GridFunc, BruteForceFuncType&& BruteForceFunc)
+	{
+		FQueryTimes Times;
+		double StartTime = FPlatformTime::Seconds();
+		for (const FVector2f& Center : Centers)
+		{
+			GridFunc(Center);
+		}
+		Times.Grid = (FPlatformTime::Seconds() - StartTime) / Centers.Num() * 1e9;
+
+		StartTime = FPlatformTime::Seconds();
+		for (const FVector2f& Center : Centers)
+		{
+			BruteForceFunc(Center);
+		}
+		Times.BruteForce = (FPlatformTime::Seconds() - StartTime) / Centers.Num() * 1e9;
+		return Times;
+	}
+
+	void LogTimes(const TCHAR* Name, const FQueryTimes& Times)
+	{
+		UE_LOG(LogAugmenta, Display, TEXT("  %-8s : grid %10.0f ns, brute force %10.0f ns, %6.1fx faster"),
+			Name, Times.Grid, Times.BruteForce, Times.BruteForce / FMath::Max(Times.Grid, UE_DOUBLE_SMALL_NUMBER));
+	}
+}
+
+UAugmentaSpatialQueryBenchmarkCommandlet::UAugmentaSpatialQueryBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	HelpDescription = TEXT("Compares the spatial queries of the Augmenta object store with a brute force scan.");
+}
+
+int32 UAugmentaSpatialQueryBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace AugmentaSpatialQueryBenchmarkCommandlet;
+	const FVector2f& Scale = AugmentaSpatialBruteForce::SceneScale;
+
+	FString ObjectCountsParam = TEXT("100,250,500,1000,2000");
+	int32 NumQueries = 1000;
+	int32 Seed = 0;
+	FParse::Value(*Params, TEXT("Objects="), ObjectCountsParam, false);
+	FParse::Value(*Params, TEXT("Queries="), NumQueries);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	NumQueries = FMath::Max(NumQueries, 1);
+
+	TArray<FString> ObjectCounts;
+	ObjectCountsParam.ParseIntoArray(ObjectCounts, TEXT(","));
+
+	FRandomStream Random(Seed);
+	TArray<FVector2f> Centers;
+	for (int32 Query = 0; Query < NumQueries; ++Query)
+	{
+		Centers.Emplace(Random.FRand(), Random.FRand());
+	}
+
+	int64 NumFound = 0;
+	TArray<int32> Slots;
+	TArray<FAugmentaSlotPair> Pairs;
+	for (const FString& ObjectCount : ObjectCounts)
+	{
+		const int32 NumObjects = FMath::Max(FCString::Atoi(*ObjectCount), 1);
+
+		FAugmentaObjectStore Store;
+		FAugmentaObjectMessage Message;
+		bool bAdded;
+		for (int32 Pid = 0; Pid < NumObjects; ++Pid)
+		{
+			Message.Pid = Pid;
+			Message.CentroidX = Random.FRand();
+			Message.CentroidY = Random.FRand();
+			Store.Update(Message, 0.0, bAdded);
+		}
+		const FAugmentaObjectsSoA SoA = Store.GetSoA();
+		const FVector2f Extent(QuerySize / Scale.X, QuerySize / Scale.Y);
+
+		UE_LOG(LogAugmenta, Display, TEXT("%d objects, %d queries :"), NumObjects, NumQueries);
+
+		LogTimes(TEXT("Rect"), TimeQuery(Centers,
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				Store.FindInRect(Center - Extent, Center + Extent, Slots);
+				NumFound += Slots.Num();
+			},
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				AugmentaSpatialBruteForce::FindInRect(SoA.CentroidX, SoA.CentroidY, Center - Extent, Center + Extent, Slots);
+				NumFound += Slots.Num();
+			}));
+
+		LogTimes(TEXT("Radius"), TimeQuery(Centers,
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				Store.FindInRadius(Center, QuerySize, Scale, Slots);
+				NumFound += Slots.Num();
+			},
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				AugmentaSpatialBruteForce::FindInRadius(SoA.CentroidX, SoA.CentroidY, Center, QuerySize, Scale, Slots);
+				NumFound += Slots.Num();
+			}));
+
+		LogTimes(TEXT("Nearest"), TimeQuery(Centers,
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				Store.FindNearest(Center, NearestCount, Scale, Slots);
+				NumFound += Slots.Num();
+			},
+			[&](const FVector2f& Center)
+			{
+				Slots.Reset();
+				AugmentaSpatialBruteForce::FindNearest(SoA.CentroidX, SoA.CentroidY, Center, NearestCount, Scale, Slots);
+				NumFound += Slots.Num();
+			}));
+
+		// The pairs are searched once per frame rather than once per point, so fewer runs are timed
+		const TConstArrayView<FVector2f> PairRuns = TConstArrayView<FVector2f>(Centers).Left(FMath::Max(NumQueries / 100, 1));
+		LogTimes(TEXT("Pairs"), TimeQuery(PairRuns,
+			[&](const FVector2f&)
+			{
+				Pairs.Reset();
+				Store.FindPairs(QuerySize, Scale, Pairs);
+				NumFound += Pairs.Num();
+			},
+			[&](const FVector2f&)
+			{
+				Pairs.Reset();
+				AugmentaSpatialBruteForce::FindPairs(SoA.CentroidX, SoA.CentroidY, QuerySize, Scale, Pairs);
+				NumFound += Pairs.Num();
+			}));
+	}
+
+	// Logged so that the queries are not optimized away
+	UE_LOG(LogAugmenta, Verbose, TEXT("%lld objects found"), NumFound);
+	return 0;
+}
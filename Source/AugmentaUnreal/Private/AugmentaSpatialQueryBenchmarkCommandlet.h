@@ -0,0 +1,26 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "AugmentaSpatialQueryBenchmarkCommandlet.generated.h"
+
+/**
+ * Measures the spatial queries of FAugmentaObjectStore (rectangle, radius, k nearest and proximity pairs) against a brute force
+ * scan of every object, for several crowd sizes in a 20 x 10 m scene.
+ *
+ * UnrealEditor-Cmd.exe <Project> -run=AugmentaSpatialQueryBenchmark [-Objects=100,250,500,1000,2000] [-Queries=1000] [-Seed=0]
+ */
+UCLASS()
+class UAugmentaSpatialQueryBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaSpatialQueryBenchmarkCommandlet();
+
+	//~ Begin UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet interface
+};
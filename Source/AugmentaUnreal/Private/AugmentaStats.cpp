@@ -0,0 +1,84 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaStats.h"
+#include "AugmentaData.h"
+
+DEFINE_STAT(STAT_AugmentaReceiverTick);
+DEFINE_STAT(STAT_AugmentaDecode);
+DEFINE_STAT(STAT_AugmentaUpdateObjects);
+DEFINE_STAT(STAT_AugmentaCommitFrame);
+DEFINE_STAT(STAT_AugmentaEvaluateZones);
+DEFINE_STAT(STAT_AugmentaFuseSources);
+DEFINE_STAT(STAT_AugmentaSmoothObjects);
+DEFINE_STAT(STAT_AugmentaUpdateDensityMap);
+DEFINE_STAT(STAT_AugmentaUpdateAnalytics);
+DEFINE_STAT(STAT_AugmentaUpdateObjectPool);
+
+DEFINE_STAT(STAT_AugmentaBroadcastFrame);
+DEFINE_STAT(STAT_AugmentaCoalesceEvents);
+DEFINE_STAT(STAT_AugmentaDispatchSubscriptions);
+DEFINE_STAT(STAT_AugmentaPublishCluster);
+DEFINE_STAT(STAT_AugmentaBroadcastFrameObjectsEntered);
+DEFINE_STAT(STAT_AugmentaBroadcastFrameObjectsUpdated);
+DEFINE_STAT(STAT_AugmentaBroadcastFrameObjectsLeft);
+DEFINE_STAT(STAT_AugmentaBroadcastSceneUpdated);
+DEFINE_STAT(STAT_AugmentaBroadcastVideoOutputUpdated);
+DEFINE_STAT(STAT_AugmentaBroadcastPersonEntered);
+DEFINE_STAT(STAT_AugmentaBroadcastPersonUpdated);
+DEFINE_STAT(STAT_AugmentaBroadcastPersonWillLeave);
+DEFINE_STAT(STAT_AugmentaBroadcastEnteredExtraData);
+DEFINE_STAT(STAT_AugmentaBroadcastUpdatedExtraData);
+DEFINE_STAT(STAT_AugmentaBroadcastLeaveExtraData);
+
+DEFINE_STAT(STAT_AugmentaActiveObjects);
+DEFINE_STAT(STAT_AugmentaMessagesPerSecond);
+DEFINE_STAT(STAT_AugmentaKilobytesPerSecond);
+DEFINE_STAT(STAT_AugmentaLatencyP99);
+
+void FAugmentaLatencyHistogram::Add(double Latency)
+{
+	// The bucket whose upper bound is the smallest one above the latency
+	const double Octaves = FMath::Log2(FMath::Max(Latency, MinLatency) / MinLatency);
+	const int32 Bucket = FMath::Min(FMath::CeilToInt(Octaves * BucketsPerOctave), NumBuckets - 1);
+	++Buckets[Bucket];
+	++Count;
+}
+
+double FAugmentaLatencyHistogram::GetPercentile(double Fraction) const
+{
+	if (Count == 0)
+	{
+		return 0.0;
+	}
+
+	const int64 Rank = FMath::Max<int64>(FMath::CeilToInt64(FMath::Clamp(Fraction, 0.0, 1.0) * Count), 1);
+	int64 Cumulated = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Cumulated += Buckets[Bucket];
+		if (Cumulated >= Rank)
+		{
+			return MinLatency * FMath::Pow(2.0, static_cast<double>(Bucket) / BucketsPerOctave);
+		}
+	}
+	return MinLatency * FMath::Pow(2.0, static_cast<double>(NumBuckets - 1) / BucketsPerOctave);
+}
+
+void FAugmentaLatencyHistogram::Reset()
+{
+	FMemory::Memzero(Buckets);
+	Count = 0;
+}
+
+FString FAugmentaReceiverCounters::ToString() const
+{
+	return FString::Printf(
+		TEXT("Messages/s: scene %.1f, fusion %.1f, enter %.1f, update %.1f, leave %.1f, extra %.1f\n")
+		TEXT("Datagrams/s: %.1f, bytes/s: %.0f\n")
+		TEXT("Frames: %lld, gaps: %lld, missed: %lld, out of order datagrams: %lld, coalesced events: %lld, filtered events: %lld, dropped cluster frames: %lld\n")
+		TEXT("Objects: %d, latency (ms): p50 %.3f, p99 %.3f"),
+		SceneMessagesPerSecond, VideoOutputMessagesPerSecond, ObjectEnterMessagesPerSecond, ObjectUpdateMessagesPerSecond, ObjectLeaveMessagesPerSecond, ExtraMessagesPerSecond,
+		DatagramsPerSecond, BytesPerSecond,
+		FramesAssembled, FrameGaps, MissedFrames, OutOfOrderPackets, CoalescedEvents, FilteredEvents, ClusterFramesDropped,
+		ActiveObjects, LatencyP50, LatencyP99);
+}
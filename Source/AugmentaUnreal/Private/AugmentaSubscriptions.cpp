@@ -0,0 +1,171 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSubscriptions.h"
+#include "AugmentaTracker.h"
+
+int32 FAugmentaSubscriptions::Add(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent Delegate)
+{
+	return AddSubscription(Filter, MoveTemp(Delegate), FAugmentaFilteredObjectEvent());
+}
+
+int32 FAugmentaSubscriptions::Add(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectEvent Delegate)
+{
+	return AddSubscription(Filter, FAugmentaFilteredObjectNativeEvent(), MoveTemp(Delegate));
+}
+
+int32 FAugmentaSubscriptions::AddSubscription(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent NativeDelegate, FAugmentaFilteredObjectEvent Delegate)
+{
+	TSharedRef<FSubscription> Subscription = MakeShared<FSubscription>();
+	Subscription->Id = NextId++;
+	Subscription->Filter = Filter;
+	Subscription->Changes = static_cast<EAugmentaObjectChange>(Filter.Changes);
+	Subscription->NativeDelegate = MoveTemp(NativeDelegate);
+	Subscription->Delegate = MoveTemp(Delegate);
+	Subscriptions.Add(Subscription);
+	return Subscription->Id;
+}
+
+bool FAugmentaSubscriptions::Remove(int32 SubscriptionId)
+{
+	const int32 Index = Subscriptions.IndexOfByPredicate([SubscriptionId](const TSharedRef<FSubscription>& Subscription)
+	{
+		return Subscription->Id == SubscriptionId && !Subscription->bRemoved;
+	});
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Keep the indices of the dispatch loop valid, the flagged subscriptions are removed once it is done
+	Subscriptions[Index]->bRemoved = true;
+	if (!bDispatching)
+	{
+		Subscriptions.RemoveAt(Index);
+	}
+	return true;
+}
+
+void FAugmentaSubscriptions::ResetObjects()
+{
+	for (const TSharedRef<FSubscription>& Subscription : Subscriptions)
+	{
+		Subscription->Objects.Reset();
+	}
+}
+
+void FAugmentaSubscriptions::Dispatch(const FAugmentaFrameEvents& Events)
+{
+	bDispatching = true;
+
+	// The subscriptions added by a delegate are notified from the next frame
+	const int32 NumSubscriptions = Subscriptions.Num();
+	for (int32 SubscriptionIndex = 0; SubscriptionIndex < NumSubscriptions; ++SubscriptionIndex)
+	{
+		// Keep the subscription alive while its delegate runs, even if it removes it
+		const TSharedRef<FSubscription> Subscription = Subscriptions[SubscriptionIndex];
+		for (const FAugmentaEventRecord& Event : Events.Sequence)
+		{
+			if (Subscription->bRemoved)
+			{
+				break;
+			}
+
+			switch (Event.Type)
+			{
+			case EAugmentaEventType::ObjectEntered:
+				Evaluate(*Subscription, Events.EnteredObjects[Event.Index], false);
+				break;
+			case EAugmentaEventType::ObjectUpdated:
+				Evaluate(*Subscription, Events.UpdatedObjects[Event.Index], false);
+				break;
+			case EAugmentaEventType::ObjectLeft:
+				Evaluate(*Subscription, Events.LeftObjects[Event.Index], true);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	bDispatching = false;
+	Subscriptions.RemoveAll([](const TSharedRef<FSubscription>& Subscription) { return Subscription->bRemoved; });
+}
+
+void FAugmentaSubscriptions::Evaluate(FSubscription& Subscription, const FAugmentaPerson& Object, bool bLeft)
+{
+	const FAugmentaEventFilter& Filter = Subscription.Filter;
+	EAugmentaObjectChange Changes = EAugmentaObjectChange::None;
+
+	const int32 Slot = Subscription.Objects.FindSlot(Object.Pid);
+	if (bLeft || !Matches(Filter, Object))
+	{
+		// Only the objects the subscription follows can leave it
+		if (Slot != INDEX_NONE)
+		{
+			FReportedState Removed;
+			int32 RemovedSlot;
+			Subscription.Objects.Remove(Object.Pid, Removed, RemovedSlot);
+			Changes = EAugmentaObjectChange::Left;
+		}
+	}
+	else if (Slot == INDEX_NONE)
+	{
+		bool bAdded;
+		FReportedState& Reported = Subscription.Objects.FindOrAdd(Object.Pid, bAdded);
+		Reported.Centroid = Object.Centroid;
+		Reported.Height = Object.Height;
+		Reported.Orientation = Object.Orientation;
+		Changes = EAugmentaObjectChange::Entered;
+	}
+	else
+	{
+		// The change mask of the object against the values last reported to the subscription
+		FReportedState& Reported = Subscription.Objects.GetValue(Slot);
+		if (FVector2D::DistSquared(Object.Centroid, Reported.Centroid) > FMath::Square(Filter.CentroidDeadBand))
+		{
+			Changes |= EAugmentaObjectChange::Centroid;
+		}
+		if (FMath::Abs(Object.Height - Reported.Height) > Filter.HeightDeadBand)
+		{
+			Changes |= EAugmentaObjectChange::Height;
+		}
+		if (FMath::Abs(FMath::FindDeltaAngleDegrees(Reported.Orientation, Object.Orientation)) > Filter.OrientationDeadBand)
+		{
+			Changes |= EAugmentaObjectChange::Orientation;
+		}
+		Changes &= Subscription.Changes;
+
+		// Only the reported fields move their reference, the others keep accumulating their change
+		if (EnumHasAnyFlags(Changes, EAugmentaObjectChange::Centroid))
+		{
+			Reported.Centroid = Object.Centroid;
+		}
+		if (EnumHasAnyFlags(Changes, EAugmentaObjectChange::Height))
+		{
+			Reported.Height = Object.Height;
+		}
+		if (EnumHasAnyFlags(Changes, EAugmentaObjectChange::Orientation))
+		{
+			Reported.Orientation = Object.Orientation;
+		}
+	}
+
+	Changes &= Subscription.Changes;
+	if (Changes == EAugmentaObjectChange::None)
+	{
+		++FilteredEvents;
+		return;
+	}
+
+	Subscription.NativeDelegate.ExecuteIfBound(Object, Changes);
+	Subscription.Delegate.ExecuteIfBound(Object, static_cast<int32>(Changes));
+}
+
+bool FAugmentaSubscriptions::Matches(const FAugmentaEventFilter& Filter, const FAugmentaPerson& Object)
+{
+	if (Object.Oid < Filter.MinOid || (Filter.MaxOid >= 0 && Object.Oid > Filter.MaxOid))
+	{
+		return false;
+	}
+	return !Filter.bFilterRegion || Filter.Region.IsInsideOrOn(Object.Centroid);
+}
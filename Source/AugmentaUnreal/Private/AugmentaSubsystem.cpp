@@ -0,0 +1,51 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaSubsystem.h"
+#include "AugmentaSharedEndpoint.h"
+
+TSharedPtr<FAugmentaSharedEndpoint> UAugmentaSubsystem::AcquireEndpoint(const FString& ReceiveIPAddress, int32 Port, const FAugmentaExpiry& Expiry)
+{
+	// Forget the endpoints closed since the last call
+	for (auto It = Endpoints.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const FString Key = FAugmentaSharedEndpoint::GetKey(ReceiveIPAddress, Port);
+	if (const TWeakPtr<FAugmentaSharedEndpoint>* Existing = Endpoints.Find(Key))
+	{
+		return Existing->Pin();
+	}
+
+	FSocket* Socket = FAugmentaSharedEndpoint::OpenSocket(ReceiveIPAddress, Port);
+	if (!Socket)
+	{
+		return nullptr;
+	}
+
+	const FString ThreadName = FString::Printf(TEXT("AugmentaSharedWorker %s"), *Key);
+	TSharedPtr<FAugmentaSharedEndpoint> Endpoint = MakeShared<FAugmentaSharedEndpoint>(Socket, Expiry, *ThreadName);
+	Endpoints.Add(Key, Endpoint);
+	return Endpoint;
+}
+
+int32 UAugmentaSubsystem::GetNumEndpoints() const
+{
+	int32 NumEndpoints = 0;
+	for (const TPair<FString, TWeakPtr<FAugmentaSharedEndpoint>>& Endpoint : Endpoints)
+	{
+		NumEndpoints += Endpoint.Value.IsValid() ? 1 : 0;
+	}
+	return NumEndpoints;
+}
+
+void UAugmentaSubsystem::Deinitialize()
+{
+	// The receivers still attached keep their endpoint until they stop
+	Endpoints.Empty();
+
+	Super::Deinitialize();
+}
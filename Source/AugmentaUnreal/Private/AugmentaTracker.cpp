@@ -0,0 +1,453 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaTracker.h"
+#include "AugmentaStats.h"
+#include "HAL/PlatformTime.h"
+
+namespace AugmentaTracker
+{
+	/** The number of committed frames that can wait to be dequeued. */
+	constexpr uint32 CommittedFrameCapacity = 16;
+	/** How long nothing must be received before the frame being assembled is considered complete, in seconds. */
+	constexpr double IdleCommitTime = 0.05;
+	/** A frame further back than this is considered a restart of the server rather than an out of order datagram. */
+	constexpr int32 MaxOutOfOrderFrames = 64;
+}
+
+void FAugmentaFrameEvents::Reset()
+{
+	Sequence.Reset();
+	Scenes.Reset();
+	VideoOutputs.Reset();
+	EnteredObjects.Reset();
+	UpdatedObjects.Reset();
+	LeftObjects.Reset();
+	EnteredExtras.Reset();
+	UpdatedExtras.Reset();
+	LeftExtras.Reset();
+}
+
+SIZE_T FAugmentaFrameEvents::GetAllocatedSize() const
+{
+	return Sequence.GetAllocatedSize() + Scenes.GetAllocatedSize() + VideoOutputs.GetAllocatedSize()
+		+ EnteredObjects.GetAllocatedSize() + UpdatedObjects.GetAllocatedSize() + LeftObjects.GetAllocatedSize()
+		+ EnteredExtras.GetAllocatedSize() + UpdatedExtras.GetAllocatedSize() + LeftExtras.GetAllocatedSize();
+}
+
+void FAugmentaFrameSnapshot::Reset()
+{
+	Frame = 0;
+	Scene = FAugmentaScene();
+	VideoOutput = FAugmentaVideoOutput();
+	Objects.Reset();
+	ObjectExtras.Reset();
+}
+
+void FAugmentaFrameSnapshot::CopyFrom(const FAugmentaFrameSnapshot& Other)
+{
+	Frame = Other.Frame;
+	Scene = Other.Scene;
+	VideoOutput = Other.VideoOutput;
+	Objects.CopyFrom(Other.Objects);
+	ObjectExtras.CopyFrom(Other.ObjectExtras);
+}
+
+FAugmentaTracker::FAugmentaTracker()
+	: CommittedFrames(AugmentaTracker::CommittedFrameCapacity + 1)
+{
+	Decoder.BuildDispatchTable();
+}
+
+void FAugmentaTracker::Reset(bool bInFrameAssembly)
+{
+	bFrameAssembly = bInFrameAssembly;
+	bHasUncommittedChanges = false;
+	bCommitDeferred = false;
+	bClusterStream = false;
+
+	LiveState.Reset();
+	PendingEvents.Reset();
+
+	FAugmentaCommittedFrameRef Frame;
+	while (CommittedFrames.Dequeue(Frame))
+	{
+	}
+
+	Decoder.BuildDispatchTable();
+	Decoder.ResetCounters();
+	BinaryDecoder.ResetCounters();
+	ClusterDecoder.Reset();
+	ClusterDecoder.ResetCounters();
+	DispatchAllocations.Reset();
+	DroppedFrames.Reset();
+	DroppedLeaves.Reset();
+
+	for (FAugmentaCounter& Counter : MessagesReceived)
+	{
+		Counter.Reset();
+	}
+	DatagramsReceived.Reset();
+	BytesReceived.Reset();
+	FramesAssembled.Reset();
+	FrameGaps.Reset();
+	MissedFrames.Reset();
+	OutOfOrderPackets.Reset();
+	LatestFrame = INDEX_NONE;
+}
+
+void FAugmentaTracker::ProcessDatagram(const uint8* Data, int32 Size)
+{
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaDecode);
+
+	ReceiveTime = FPlatformTime::Seconds();
+	DatagramsReceived.Increment();
+	BytesReceived.Increment(Size);
+
+	bDatagramOutOfOrder = false;
+	bDecodingClusterFrame = false;
+	if (FAugmentaBinaryDecoder::IsBinaryPacket(Data, Size))
+	{
+		BinaryDecoder.Decode(Data, Size, *this);
+	}
+	else if (FAugmentaClusterDecoder::IsClusterPacket(Data, Size))
+	{
+		// A cluster frame is whole once applied, there is no next message to commit it
+		bDecodingClusterFrame = true;
+		bClusterStream = true;
+		if (ClusterDecoder.Decode(Data, Size, *this) && bFrameAssembly)
+		{
+			CommitFrame();
+		}
+	}
+	else
+	{
+		Decoder.Decode(Data, Size, *this);
+	}
+	OutOfOrderPackets.Increment(bDatagramOutOfOrder);
+}
+
+bool FAugmentaTracker::ExpireStaleObjects(double Now)
+{
+	// The objects that do not change are not sent by a primary, they must not time out
+	if (!Expiry.IsEnabled() || bClusterStream)
+	{
+		return false;
+	}
+
+	// The least recently updated entries are at the head of the update order, so this stops at the first live one.
+	bool bExpired = false;
+	int32 Id;
+	while (LiveState.Objects.FindExpired(LiveState.Frame, Now, Expiry, Id))
+	{
+		RemoveObject(Id);
+		DroppedLeaves.Increment();
+		bExpired = true;
+
+		// The extra data of a lost object is lost with it
+		if (LiveState.ObjectExtras.Find(Id))
+		{
+			RemoveObjectExtraData(Id);
+			DroppedLeaves.Increment();
+		}
+	}
+	while (LiveState.ObjectExtras.FindExpired(LiveState.Frame, Now, Expiry, Id))
+	{
+		RemoveObjectExtraData(Id);
+		DroppedLeaves.Increment();
+		bExpired = true;
+	}
+
+	bHasUncommittedChanges |= bExpired;
+	return bExpired;
+}
+
+void FAugmentaTracker::RemoveAllObjects()
+{
+	LatestFrame = INDEX_NONE;
+	if (LiveState.Objects.Num() == 0 && LiveState.ObjectExtras.Num() == 0)
+	{
+		return;
+	}
+
+	// Remove from the last slot, so that the swap-remove never moves the remaining entries
+	while (LiveState.Objects.Num() > 0)
+	{
+		RemoveObject(LiveState.Objects.GetObjects().Last().Pid);
+	}
+	while (LiveState.ObjectExtras.Num() > 0)
+	{
+		RemoveObjectExtraData(LiveState.ObjectExtras.GetExtras().Last().Id);
+	}
+
+	bHasUncommittedChanges = true;
+}
+
+void FAugmentaTracker::CommitFrame()
+{
+	if (!bHasUncommittedChanges)
+	{
+		return;
+	}
+
+	// Keep the events pending rather than dropping the frame, they are committed with the next frame
+	if (CommittedFrames.IsFull())
+	{
+		bCommitDeferred = true;
+		return;
+	}
+	bHasUncommittedChanges = false;
+	bCommitDeferred = false;
+
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaCommitFrame);
+
+	FAugmentaCommittedFrameRef Frame = AcquireFrame();
+	const SIZE_T AllocatedSize = Frame->Snapshot.GetAllocatedSize();
+	Frame->Snapshot.CopyFrom(LiveState);
+	DispatchAllocations.Increment(Frame->Snapshot.GetAllocatedSize() != AllocatedSize);
+	Frame->ReceiveTime = FrameReceiveTime;
+	// Hand over the pending events, and reuse the allocations of the recycled frame for the next ones.
+	Swap(Frame->Events, PendingEvents);
+	PendingEvents.Reset();
+
+	// Only this thread enqueues, so the queue cannot have filled up since it was checked
+	CommittedFrames.Enqueue(MoveTemp(Frame));
+}
+
+void FAugmentaTracker::FlushDeferredCommit()
+{
+	if (bCommitDeferred)
+	{
+		CommitFrame();
+	}
+}
+
+void FAugmentaTracker::CommitIdleFrame(double Now)
+{
+	// The frame is only complete once its sender paused, the next datagram could still belong to it
+	if (Now - ReceiveTime >= AugmentaTracker::IdleCommitTime)
+	{
+		CommitFrame();
+	}
+}
+
+bool FAugmentaTracker::DequeueCommittedFrame(FAugmentaCommittedFrameRef& OutFrame)
+{
+	return CommittedFrames.Dequeue(OutFrame);
+}
+
+FAugmentaCommittedFrameRef FAugmentaTracker::AcquireFrame()
+{
+	// A frame only referenced by the pool has been released by every reader.
+	for (const FAugmentaCommittedFrameRef& Frame : FramePool)
+	{
+		if (Frame.GetSharedReferenceCount() == 1)
+		{
+			return Frame;
+		}
+	}
+
+	// The frame, and the pool if it has to grow
+	DispatchAllocations.Increment(1 + (FramePool.Num() == FramePool.Max()));
+	return FramePool.Add_GetRef(MakeShared<FAugmentaCommittedFrame, ESPMode::ThreadSafe>());
+}
+
+template <typename EventType>
+void FAugmentaTracker::AddPendingEvent(EAugmentaEventType Type, TArray<EventType>& Events, const EventType& Event)
+{
+	DispatchAllocations.Increment((Events.Num() == Events.Max()) + (PendingEvents.Sequence.Num() == PendingEvents.Sequence.Max()));
+	PendingEvents.Sequence.Add({ Type, Events.Add(Event) });
+}
+
+void FAugmentaTracker::BeginMessage(int32 Frame)
+{
+	if (Frame == LiveState.Frame)
+	{
+		bHasUncommittedChanges = true;
+		DroppedFrames.Increment(bCommitDeferred);
+		bCommitDeferred = false;
+		return;
+	}
+
+	// Compare with the latest frame rather than the current one, so that an out of order datagram is not also seen as a gap
+	const bool bOlderFrame = LatestFrame != INDEX_NONE && Frame < LatestFrame;
+	const bool bSenderRestarted = bOlderFrame && LatestFrame - Frame > AugmentaTracker::MaxOutOfOrderFrames;
+	if (bOlderFrame && !bSenderRestarted)
+	{
+		// A late datagram would move the objects back to where they were, keep the newer state
+		bDatagramOutOfOrder = true;
+		if (!bDecodingClusterFrame)
+		{
+			return;
+		}
+	}
+
+	if (bFrameAssembly && bHasUncommittedChanges)
+	{
+		CommitFrame();
+	}
+
+	if (!bOlderFrame || bSenderRestarted)
+	{
+		if (LatestFrame != INDEX_NONE && Frame > LatestFrame + 1)
+		{
+			FrameGaps.Increment();
+			MissedFrames.Increment(Frame - LatestFrame - 1);
+		}
+		else if (bSenderRestarted)
+		{
+			// The sender restarted, count the frame timeout of the objects it does not send anymore from now on
+			LiveState.Objects.RebaseFrames(Frame);
+			LiveState.ObjectExtras.RebaseFrames(Frame);
+		}
+		LatestFrame = Frame;
+	}
+
+	// A deferred frame is merged into this one, which supersedes its snapshot
+	DroppedFrames.Increment(bCommitDeferred);
+	bCommitDeferred = false;
+	LiveState.Frame = Frame;
+	FrameReceiveTime = ReceiveTime;
+	FramesAssembled.Increment();
+	bHasUncommittedChanges = true;
+
+	// The leave events of the lost objects belong to the frame that detected them
+	ExpireStaleObjects(ReceiveTime);
+}
+
+void FAugmentaTracker::OnSceneDecoded(const FAugmentaSceneMessage& Message)
+{
+	MessagesReceived[static_cast<int32>(EAugmentaMessageType::Scene)].Increment();
+	BeginMessage(Message.Frame);
+	if (IsDroppingDatagram())
+	{
+		return;
+	}
+
+	FAugmentaScene& Scene = LiveState.Scene;
+	Scene.CurrentTime = Message.Frame;
+	Scene.NumPeople = Message.ObjectCount;
+	Scene.SceneSize.X = Message.SizeX;
+	Scene.SceneSize.Y = Message.SizeY;
+
+	AddPendingEvent(EAugmentaEventType::SceneUpdated, PendingEvents.Scenes, Scene);
+}
+
+void FAugmentaTracker::OnVideoOutputDecoded(const FAugmentaVideoOutputMessage& Message)
+{
+	MessagesReceived[static_cast<int32>(EAugmentaMessageType::VideoOutput)].Increment();
+	if (IsDroppingDatagram())
+	{
+		return;
+	}
+
+	// The video output message has no frame number, it belongs to the frame being assembled.
+	bHasUncommittedChanges = true;
+	DroppedFrames.Increment(bCommitDeferred);
+	bCommitDeferred = false;
+
+	FAugmentaVideoOutput& VideoOutput = LiveState.VideoOutput;
+	VideoOutput.Offset.X = Message.OffsetX;
+	VideoOutput.Offset.Y = Message.OffsetY;
+	VideoOutput.Size.X = Message.SizeX;
+	VideoOutput.Size.Y = Message.SizeY;
+	VideoOutput.Resolution.X = Message.ResolutionX;
+	VideoOutput.Resolution.Y = Message.ResolutionY;
+
+	AddPendingEvent(EAugmentaEventType::VideoOutputUpdated, PendingEvents.VideoOutputs, VideoOutput);
+}
+
+void FAugmentaTracker::OnObjectDecoded(EAugmentaMessageType Type, const FAugmentaObjectMessage& Message)
+{
+	MessagesReceived[static_cast<int32>(Type)].Increment();
+	BeginMessage(Message.Frame);
+	if (IsDroppingDatagram())
+	{
+		return;
+	}
+
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaUpdateObjects);
+
+	// Send it off to the proper processing function based on the method
+	if (Type == EAugmentaMessageType::ObjectLeave)
+	{
+		RemoveObject(Message.Pid);
+	}
+	else
+	{
+		UpdateObject(Message, Type == EAugmentaMessageType::ObjectEnter);
+	}
+}
+
+void FAugmentaTracker::OnObjectExtraDecoded(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Message)
+{
+	MessagesReceived[static_cast<int32>(Type)].Increment();
+	BeginMessage(Message.Frame);
+	if (IsDroppingDatagram())
+	{
+		return;
+	}
+
+	AUGMENTA_SCOPE_CYCLE_COUNTER(STAT_AugmentaUpdateObjects);
+
+	if (Type == EAugmentaMessageType::ObjectExtraLeave)
+	{
+		RemoveObjectExtraData(Message.Id);
+	}
+	else
+	{
+		UpdateObjectExtraData(Message, Type == EAugmentaMessageType::ObjectExtraEnter);
+	}
+}
+
+void FAugmentaTracker::UpdateObject(const FAugmentaObjectMessage& Message, bool HasEntered)
+{
+	// Find or add a person entry, updated in place
+	const SIZE_T AllocatedSize = LiveState.Objects.GetAllocatedSize();
+	bool bAdded;
+	const FAugmentaPerson& Person = LiveState.Objects.Update(Message, ReceiveTime, bAdded);
+	DispatchAllocations.Increment(LiveState.Objects.GetAllocatedSize() != AllocatedSize);
+
+	if (HasEntered)
+	{
+		AddPendingEvent(EAugmentaEventType::ObjectEntered, PendingEvents.EnteredObjects, Person);
+	}
+	else
+	{
+		AddPendingEvent(EAugmentaEventType::ObjectUpdated, PendingEvents.UpdatedObjects, Person);
+	}
+}
+
+void FAugmentaTracker::RemoveObject(int32 Pid)
+{
+	// Remove the person entry from the store
+	FAugmentaPerson OldPerson;
+	LiveState.Objects.Remove(Pid, OldPerson);
+
+	AddPendingEvent(EAugmentaEventType::ObjectLeft, PendingEvents.LeftObjects, OldPerson);
+}
+
+void FAugmentaTracker::UpdateObjectExtraData(const FAugmentaObjectExtraMessage& Message, bool HasEntered)
+{
+	const SIZE_T AllocatedSize = LiveState.ObjectExtras.GetAllocatedSize();
+	bool bAdded;
+	const FAugmentaObjectExtra& Extra = LiveState.ObjectExtras.Update(Message, ReceiveTime, bAdded);
+	DispatchAllocations.Increment(LiveState.ObjectExtras.GetAllocatedSize() != AllocatedSize);
+
+	if (HasEntered)
+	{
+		AddPendingEvent(EAugmentaEventType::ExtraDataEntered, PendingEvents.EnteredExtras, Extra);
+	}
+	else
+	{
+		AddPendingEvent(EAugmentaEventType::ExtraDataUpdated, PendingEvents.UpdatedExtras, Extra);
+	}
+}
+
+void FAugmentaTracker::RemoveObjectExtraData(int32 Id)
+{
+	// Remove the entry from the store
+	FAugmentaObjectExtra ExtraDataToRemove;
+	LiveState.ObjectExtras.Remove(Id, ExtraDataToRemove);
+
+	AddPendingEvent(EAugmentaEventType::ExtraDataLeft, PendingEvents.LeftExtras, ExtraDataToRemove);
+}
@@ -0,0 +1,237 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaZoneManager.h"
+#include "AugmentaTracker.h"
+#include "AugmentaUnreal.h"
+
+void UAugmentaZoneManager::AddRectZone(FName Name, FVector2D Min, FVector2D Max, float DwellTime)
+{
+	FZone& Zone = FindOrAddZone(Name);
+	Zone.Shape = EAugmentaZoneShape::Rect;
+	Zone.Min = FVector2f(FVector2D::Min(Min, Max));
+	Zone.Max = FVector2f(FVector2D::Max(Min, Max));
+	Zone.DwellTime = DwellTime;
+}
+
+void UAugmentaZoneManager::AddCircleZone(FName Name, FVector2D Center, float Radius, float DwellTime)
+{
+	FZone& Zone = FindOrAddZone(Name);
+	Zone.Shape = EAugmentaZoneShape::Circle;
+	Zone.Center = FVector2f(Center);
+	Zone.Radius = FMath::Abs(Radius);
+	Zone.DwellTime = DwellTime;
+}
+
+void UAugmentaZoneManager::AddPolygonZone(FName Name, const TArray<FVector2D>& Points, float DwellTime)
+{
+	if (Points.Num() < 3)
+	{
+		UE_LOG(LogAugmenta, Warning, TEXT("The polygon zone '%s' needs at least three points."), *Name.ToString());
+		return;
+	}
+
+	FZone& Zone = FindOrAddZone(Name);
+	Zone.Shape = EAugmentaZoneShape::Polygon;
+	Zone.Points.Reset();
+	Zone.Min = FVector2f(MAX_flt, MAX_flt);
+	Zone.Max = FVector2f(-MAX_flt, -MAX_flt);
+	for (const FVector2D& Point : Points)
+	{
+		const FVector2f& Vertex = Zone.Points.Add_GetRef(FVector2f(Point));
+		Zone.Min = FVector2f::Min(Zone.Min, Vertex);
+		Zone.Max = FVector2f::Max(Zone.Max, Vertex);
+	}
+	Zone.DwellTime = DwellTime;
+}
+
+bool UAugmentaZoneManager::RemoveZone(FName Name)
+{
+	return Zones.RemoveAll([Name](const FZone& Zone) { return Zone.Name == Name; }) > 0;
+}
+
+void UAugmentaZoneManager::RemoveAllZones()
+{
+	Zones.Reset();
+}
+
+int32 UAugmentaZoneManager::GetZoneOccupancy(FName Name) const
+{
+	const FZone* Zone = Zones.FindByPredicate([Name](const FZone& Other) { return Other.Name == Name; });
+	return Zone != nullptr ? Zone->Members.Num() : 0;
+}
+
+TArray<FAugmentaPerson> UAugmentaZoneManager::GetObjectsInZone(FName Name) const
+{
+	TArray<FAugmentaPerson> Objects;
+	if (const FZone* Zone = Zones.FindByPredicate([Name](const FZone& Other) { return Other.Name == Name; }))
+	{
+		Objects.Reserve(Zone->Members.Num());
+		for (const FZoneMember& Member : Zone->Members)
+		{
+			Objects.Add(Member.Object);
+		}
+	}
+	return Objects;
+}
+
+void UAugmentaZoneManager::Evaluate(const FAugmentaFrameSnapshot& Snapshot, double Now, bool bSnapshotChanged)
+{
+	if (Zones.Num() == 0)
+	{
+		return;
+	}
+
+	const FVector2f Scale = FAugmentaObjectStore::GetDistanceScale(Snapshot.Scene);
+	for (FZone& Zone : Zones)
+	{
+		const int32 Occupancy = Zone.Members.Num();
+		if (bSnapshotChanged || bZonesChanged)
+		{
+			UpdateMembers(Zone, Snapshot, Scale, Now);
+		}
+
+		if (Zone.DwellTime > 0.f)
+		{
+			for (FZoneMember& Member : Zone.Members)
+			{
+				const double DwellTime = Now - Member.EnterTime;
+				if (!Member.bDwelled && DwellTime >= Zone.DwellTime)
+				{
+					Member.bDwelled = true;
+					PendingEvents.Add({ FPendingEvent::EType::Dwelled, Zone.Name, Member.Object, static_cast<float>(DwellTime) });
+				}
+			}
+		}
+
+		if (Zone.Members.Num() != Occupancy)
+		{
+			PendingEvents.Add({ FPendingEvent::EType::OccupancyChanged, Zone.Name, FAugmentaPerson(), static_cast<float>(Zone.Members.Num()) });
+		}
+	}
+	bZonesChanged = false;
+
+	// Fire the events once the zones are up to date, so that the handlers can query or modify them
+	TArray<FPendingEvent> Events = MoveTemp(PendingEvents);
+	for (const FPendingEvent& Event : Events)
+	{
+		switch (Event.Type)
+		{
+		case FPendingEvent::EType::Entered:
+			OnObjectEntered.Broadcast(Event.ZoneName, Event.Object);
+			break;
+		case FPendingEvent::EType::Left:
+			OnObjectLeft.Broadcast(Event.ZoneName, Event.Object);
+			break;
+		case FPendingEvent::EType::Dwelled:
+			OnObjectDwelled.Broadcast(Event.ZoneName, Event.Object, Event.Value);
+			break;
+		case FPendingEvent::EType::OccupancyChanged:
+			OnOccupancyChanged.Broadcast(Event.ZoneName, static_cast<int32>(Event.Value));
+			break;
+		}
+	}
+	// Give the allocation back for the next evaluation
+	Events.Reset();
+	PendingEvents = MoveTemp(Events);
+}
+
+UAugmentaZoneManager::FZone& UAugmentaZoneManager::FindOrAddZone(FName Name)
+{
+	bZonesChanged = true;
+
+	if (FZone* Zone = Zones.FindByPredicate([Name](const FZone& Other) { return Other.Name == Name; }))
+	{
+		return *Zone;
+	}
+
+	FZone& Zone = Zones.AddDefaulted_GetRef();
+	Zone.Name = Name;
+	return Zone;
+}
+
+bool UAugmentaZoneManager::Contains(const FZone& Zone, const FVector2f& Position, const FVector2f& Scale)
+{
+	switch (Zone.Shape)
+	{
+	case EAugmentaZoneShape::Rect:
+		return Position.X >= Zone.Min.X && Position.X <= Zone.Max.X && Position.Y >= Zone.Min.Y && Position.Y <= Zone.Max.Y;
+
+	case EAugmentaZoneShape::Circle:
+		return ((Position - Zone.Center) * Scale).SizeSquared() <= Zone.Radius * Zone.Radius;
+
+	case EAugmentaZoneShape::Polygon:
+	{
+		// Even-odd rule : count the edges crossed by a horizontal ray starting at the position
+		bool bInside = false;
+		const int32 NumPoints = Zone.Points.Num();
+		for (int32 Index = 0, PrevIndex = NumPoints - 1; Index < NumPoints; PrevIndex = Index++)
+		{
+			const FVector2f& A = Zone.Points[Index];
+			const FVector2f& B = Zone.Points[PrevIndex];
+			if ((A.Y > Position.Y) != (B.Y > Position.Y)
+				&& Position.X < (B.X - A.X) * (Position.Y - A.Y) / (B.Y - A.Y) + A.X)
+			{
+				bInside = !bInside;
+			}
+		}
+		return bInside;
+	}
+	}
+	return false;
+}
+
+void UAugmentaZoneManager::UpdateMembers(FZone& Zone, const FAugmentaFrameSnapshot& Snapshot, const FVector2f& Scale, double Now)
+{
+	const TConstArrayView<FAugmentaPerson> Objects = Snapshot.Objects.GetObjects();
+	const TConstArrayView<float> X = Snapshot.Objects.GetChannel(EAugmentaObjectChannel::CentroidX);
+	const TConstArrayView<float> Y = Snapshot.Objects.GetChannel(EAugmentaObjectChannel::CentroidY);
+
+	// Only test the objects of the grid cells overlapping the zone
+	FVector2f Min = Zone.Min;
+	FVector2f Max = Zone.Max;
+	if (Zone.Shape == EAugmentaZoneShape::Circle)
+	{
+		const FVector2f Extent(Zone.Radius / Scale.X, Zone.Radius / Scale.Y);
+		Min = Zone.Center - Extent;
+		Max = Zone.Center + Extent;
+	}
+
+	InsideSlots.Reset();
+	Snapshot.Objects.GetSpatialGrid().ForEachSlotInRect(Min, Max, [&](int32 Slot)
+	{
+		if (Contains(Zone, FVector2f(X[Slot], Y[Slot]), Scale))
+		{
+			InsideSlots.Add(Slot);
+		}
+	});
+	InsideSlots.Sort([&Objects](int32 A, int32 B) { return Objects[A].Pid < Objects[B].Pid; });
+
+	// Merge the objects inside with the previous members, both sorted by Pid
+	NewMembers.Reset();
+	int32 MemberIndex = 0;
+	for (const int32 Slot : InsideSlots)
+	{
+		const FAugmentaPerson& Object = Objects[Slot];
+		while (MemberIndex < Zone.Members.Num() && Zone.Members[MemberIndex].Object.Pid < Object.Pid)
+		{
+			PendingEvents.Add({ FPendingEvent::EType::Left, Zone.Name, Zone.Members[MemberIndex++].Object, 0.f });
+		}
+
+		if (MemberIndex < Zone.Members.Num() && Zone.Members[MemberIndex].Object.Pid == Object.Pid)
+		{
+			FZoneMember& Member = NewMembers.Add_GetRef(Zone.Members[MemberIndex++]);
+			Member.Object = Object;
+		}
+		else
+		{
+			NewMembers.Add({ Object, Now, false });
+			PendingEvents.Add({ FPendingEvent::EType::Entered, Zone.Name, Object, 0.f });
+		}
+	}
+	while (MemberIndex < Zone.Members.Num())
+	{
+		PendingEvents.Add({ FPendingEvent::EType::Left, Zone.Name, Zone.Members[MemberIndex++].Object, 0.f });
+	}
+
+	Swap(Zone.Members, NewMembers);
+}
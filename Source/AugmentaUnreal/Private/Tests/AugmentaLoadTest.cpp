@@ -0,0 +1,33 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaLoadGenerator.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAugmentaLoopbackLoadTest, "Augmenta.LoadTest.Loopback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAugmentaLoopbackLoadTest::RunTest(const FString& Parameters)
+{
+	// A short load, without packet loss, so that nearly every message sent must be decoded
+	FAugmentaLoadSettings Settings;
+	// Any free port, so that the test does not depend on the ports used on the machine
+	Settings.Port = 0;
+	Settings.ObjectCount = 50;
+	Settings.FrameRate = 30.f;
+	Settings.PacketLoss = 0.f;
+	Settings.Duration = 2.f;
+
+	const FAugmentaLoadReport Report = FAugmentaLoadGenerator::RunLoadTest(Settings);
+	AddInfo(Report.ToString());
+
+	TestTrue(TEXT("Frames were received"), Report.FramesReceived > 0);
+	TestEqual(TEXT("Messages lost by the generator"), Report.MessagesLost, 0ll);
+	// The loopback may still drop a few datagrams under a loaded machine
+	constexpr double MaxDropRate = 0.01;
+	TestTrue(FString::Printf(TEXT("At most %.0f%% of the messages are dropped between the generator and the receiver"), MaxDropRate * 100.0),
+		static_cast<double>(Report.MessagesDropped) <= static_cast<double>(Report.MessagesSent) * MaxDropRate);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
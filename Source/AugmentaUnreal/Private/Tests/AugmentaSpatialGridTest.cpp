@@ -0,0 +1,131 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaObjectStore.h"
+#include "AugmentaSpatialBruteForce.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AugmentaSpatialGridTest
+{
+	FVector2f RandomPosition(FRandomStream& Random)
+	{
+		// Some positions are outside of the scene, the grid keeps them in its border cells
+		return FVector2f(Random.FRandRange(-0.1f, 1.1f), Random.FRandRange(-0.1f, 1.1f));
+	}
+
+	/** Adds the objects, then moves and removes some of them, so that the grid is updated the way a stream updates it. */
+	void FillStore(FAugmentaObjectStore& Store, FRandomStream& Random, int32 NumObjects)
+	{
+		FAugmentaObjectMessage Message;
+		bool bAdded;
+		for (int32 Pid = 0; Pid < NumObjects; ++Pid)
+		{
+			// Half of the crowd gathers in a corner, to fill some cells much more than the others
+			const FVector2f Position = Pid % 2 ? RandomPosition(Random) : FVector2f(Random.FRandRange(0.f, 0.1f), Random.FRandRange(0.f, 0.1f));
+			Message.Pid = Pid;
+			Message.CentroidX = Position.X;
+			Message.CentroidY = Position.Y;
+			Store.Update(Message, 0.0, bAdded);
+		}
+
+		for (int32 Move = 0; Move < NumObjects; ++Move)
+		{
+			const FVector2f Position = RandomPosition(Random);
+			Message.Pid = Random.RandHelper(NumObjects);
+			Message.CentroidX = Position.X;
+			Message.CentroidY = Position.Y;
+			Store.Update(Message, 0.0, bAdded);
+		}
+
+		FAugmentaPerson Removed;
+		for (int32 Pid = 0; Pid < NumObjects; Pid += 7)
+		{
+			Store.Remove(Pid, Removed);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAugmentaSpatialGridBruteForceTest, "Augmenta.SpatialGrid.BruteForce", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAugmentaSpatialGridBruteForceTest::RunTest(const FString& Parameters)
+{
+	using namespace AugmentaSpatialGridTest;
+	const FVector2f& Scale = AugmentaSpatialBruteForce::SceneScale;
+
+	constexpr int32 NumQueries = 50;
+	constexpr int32 NearestCount = 5;
+	constexpr float PairDistance = 0.75f;
+
+	FRandomStream Random(0);
+	for (const int32 NumObjects : { 0, 1, 100, 500, 2000 })
+	{
+		FAugmentaObjectStore Store;
+		FillStore(Store, Random, NumObjects);
+
+		const FAugmentaObjectsSoA SoA = Store.GetSoA();
+		TArray<int32> Slots;
+		TArray<int32> Expected;
+
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			const FVector2f Center = RandomPosition(Random);
+
+			const FVector2f Extent(Random.FRandRange(0.f, 0.3f), Random.FRandRange(0.f, 0.3f));
+			const FVector2f Min = Center - Extent;
+			const FVector2f Max = Center + Extent;
+			Slots.Reset();
+			Store.FindInRect(Min, Max, Slots);
+			Expected.Reset();
+			AugmentaSpatialBruteForce::FindInRect(SoA.CentroidX, SoA.CentroidY, Min, Max, Expected);
+			Slots.Sort();
+			TestTrue(FString::Printf(TEXT("%d objects : FindInRect matches the brute force"), NumObjects), Slots == Expected);
+
+			const float Radius = Random.FRandRange(0.f, 3.f);
+			Slots.Reset();
+			Store.FindInRadius(Center, Radius, Scale, Slots);
+			Expected.Reset();
+			AugmentaSpatialBruteForce::FindInRadius(SoA.CentroidX, SoA.CentroidY, Center, Radius, Scale, Expected);
+			Slots.Sort();
+			TestTrue(FString::Printf(TEXT("%d objects : FindInRadius matches the brute force"), NumObjects), Slots == Expected);
+
+			// Several objects can be at the same distance, so the distances are compared rather than the slots
+			Slots.Reset();
+			Store.FindNearest(Center, NearestCount, Scale, Slots);
+			Expected.Reset();
+			AugmentaSpatialBruteForce::FindNearest(SoA.CentroidX, SoA.CentroidY, Center, NearestCount, Scale, Expected);
+			TArray<float> Distances;
+			for (const int32 Slot : Slots)
+			{
+				Distances.Add(FAugmentaSpatialGrid::GetDistanceSquared(SoA.CentroidX[Slot], SoA.CentroidY[Slot], Center, Scale));
+			}
+			TArray<float> ExpectedDistances;
+			for (const int32 Slot : Expected)
+			{
+				ExpectedDistances.Add(FAugmentaSpatialGrid::GetDistanceSquared(SoA.CentroidX[Slot], SoA.CentroidY[Slot], Center, Scale));
+			}
+			TestTrue(FString::Printf(TEXT("%d objects : FindNearest matches the brute force"), NumObjects), Distances == ExpectedDistances);
+		}
+
+		TArray<FAugmentaSlotPair> Pairs;
+		Store.FindPairs(PairDistance, Scale, Pairs);
+		TArray<TPair<int32, int32>> FoundPairs;
+		for (const FAugmentaSlotPair& Pair : Pairs)
+		{
+			FoundPairs.Emplace(Pair.SlotA, Pair.SlotB);
+		}
+		FoundPairs.Sort();
+		Pairs.Reset();
+		AugmentaSpatialBruteForce::FindPairs(SoA.CentroidX, SoA.CentroidY, PairDistance, Scale, Pairs);
+		TArray<TPair<int32, int32>> ExpectedPairs;
+		for (const FAugmentaSlotPair& Pair : Pairs)
+		{
+			ExpectedPairs.Emplace(Pair.SlotA, Pair.SlotB);
+		}
+		TestTrue(FString::Printf(TEXT("%d objects : FindPairs matches the brute force"), NumObjects), FoundPairs == ExpectedPairs);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
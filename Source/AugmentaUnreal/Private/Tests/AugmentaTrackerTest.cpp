@@ -0,0 +1,95 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaTracker.h"
+#include "AugmentaOSCEncoder.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AugmentaTrackerTest
+{
+	/** Sends the tracker a datagram of a frame updating the given objects, at the given position. */
+	void SendFrame(FAugmentaTracker& Tracker, int32 Frame, std::initializer_list<int32> Pids, float CentroidX = 0.5f)
+	{
+		uint8 Buffer[1024];
+		FAugmentaOSCEncoder Encoder(Buffer, sizeof(Buffer));
+		Encoder.BeginBundle();
+
+		FAugmentaSceneMessage Scene;
+		Scene.Frame = Frame;
+		Scene.ObjectCount = static_cast<int32>(Pids.size());
+		Encoder.WriteScene(Scene);
+
+		FAugmentaObjectMessage Message;
+		Message.Frame = Frame;
+		Message.CentroidX = CentroidX;
+		for (const int32 Pid : Pids)
+		{
+			Message.Pid = Pid;
+			Encoder.WriteObject(EAugmentaMessageType::ObjectUpdate, Message);
+		}
+
+		Encoder.EndBundle();
+		Tracker.ProcessDatagram(Encoder.GetData(), static_cast<int32>(Encoder.GetSize()));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAugmentaTrackerSenderRestartTest, "Augmenta.Tracker.SenderRestart", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAugmentaTrackerSenderRestartTest::RunTest(const FString& Parameters)
+{
+	using namespace AugmentaTrackerTest;
+
+	constexpr int32 TimeoutFrames = 10;
+
+	FAugmentaTracker Tracker;
+	FAugmentaExpiry Expiry;
+	Expiry.TimeoutFrames = TimeoutFrames;
+	Tracker.SetExpiry(Expiry);
+	Tracker.Reset(true);
+
+	for (int32 Frame = 1000; Frame < 1010; ++Frame)
+	{
+		SendFrame(Tracker, Frame, { 1, 2 });
+	}
+
+	// The sender restarts its frame numbers and only sends the second object, its leave message for the first one was lost
+	for (int32 Frame = 0; Frame <= TimeoutFrames; ++Frame)
+	{
+		SendFrame(Tracker, Frame, { 2 });
+	}
+	TestNotNull(TEXT("The object not sent anymore is kept until the timeout"), Tracker.GetLiveState().Objects.Find(1));
+
+	SendFrame(Tracker, TimeoutFrames + 1, { 2 });
+	TestNull(TEXT("The object not sent since the restart expired"), Tracker.GetLiveState().Objects.Find(1));
+	TestNotNull(TEXT("The object still sent is kept"), Tracker.GetLiveState().Objects.Find(2));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAugmentaTrackerOutOfOrderTest, "Augmenta.Tracker.OutOfOrder", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAugmentaTrackerOutOfOrderTest::RunTest(const FString& Parameters)
+{
+	using namespace AugmentaTrackerTest;
+
+	FAugmentaTracker Tracker;
+	Tracker.Reset(true);
+
+	SendFrame(Tracker, 10, { 1 }, 0.1f);
+	SendFrame(Tracker, 12, { 1 }, 0.3f);
+	// The datagram of frame 11 arrives late, the object must not move back
+	SendFrame(Tracker, 11, { 1, 2 }, 0.2f);
+
+	const FAugmentaPerson* Person = Tracker.GetLiveState().Objects.Find(1);
+	TestEqual(TEXT("The late datagram is counted"), Tracker.GetOutOfOrderPackets(), 1ll);
+	TestTrue(TEXT("The late update is dropped"), Person && FMath::IsNearlyEqual(Person->Centroid.X, 0.3, 1e-6));
+	TestNull(TEXT("The object of the late datagram does not enter"), Tracker.GetLiveState().Objects.Find(2));
+	TestEqual(TEXT("The frame being received is kept"), Tracker.GetLiveState().Frame, 12);
+
+	SendFrame(Tracker, 13, { 1 }, 0.4f);
+	Person = Tracker.GetLiveState().Objects.Find(1);
+	TestTrue(TEXT("The next frame is applied"), Person && FMath::IsNearlyEqual(Person->Centroid.X, 0.4, 1e-6));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
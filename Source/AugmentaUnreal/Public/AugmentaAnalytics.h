@@ -0,0 +1,194 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaData.h"
+#include "AugmentaObjectStore.h"
+
+/** Forward Declarations */
+struct FAugmentaFrameEvents;
+
+/** A trajectory sample, quantized to 16 bits per axis over the normalized scene. */
+struct FAugmentaTrajectorySample
+{
+	uint16 X;
+	uint16 Y;
+	/** The time since the object entered, in milliseconds. */
+	uint32 TimeMillis;
+};
+
+/**
+ * The last positions of every object, in fixed memory.
+ *
+ * The samples live in a single pool allocated once, cut into one block per object used as a ring buffer : an object keeps
+ * its last SamplesPerObject positions, and its block goes back to a free list when it leaves. Objects entering while every
+ * block is used have no trajectory, see GetDroppedTrajectories.
+ */
+class AUGMENTAUNREAL_API FAugmentaTrajectoryStore
+{
+public:
+	/** Allocates the pool, removing every trajectory. Zero frees the pool. */
+	void SetCapacity(int32 MaxObjects, int32 InSamplesPerObject);
+
+	/** Removes every trajectory, keeping the pool. */
+	void Reset();
+
+	/**
+	 * Appends a position to the trajectory of an object, overwriting its oldest position once its block is full.
+	 *
+	 * @param Pid The object.
+	 * @param Position The normalized position, clamped to the scene.
+	 * @param TimeMillis The time since the object entered, in milliseconds.
+	 *
+	 * @return false if the object has no trajectory because the pool is exhausted.
+	 */
+	bool AddSample(int32 Pid, const FVector2D& Position, uint32 TimeMillis);
+
+	/** Removes the trajectory of an object, giving its block back to the pool. */
+	void Remove(int32 Pid);
+
+	/** Returns the positions of an object from the oldest to the newest, normalized, or false if it has no trajectory. */
+	bool GetTrajectory(int32 Pid, TArray<FVector2D>& OutPositions) const;
+
+	/** Returns the samples of an object, in ring buffer order, and the index of the oldest one. */
+	bool GetSamples(int32 Pid, TConstArrayView<FAugmentaTrajectorySample>& OutSamples, int32& OutOldest) const;
+
+	int32 Num() const { return Trajectories.Num(); }
+
+	/** The number of objects that had no trajectory because the pool was exhausted, since the last Reset. */
+	int64 GetDroppedTrajectories() const { return DroppedTrajectories; }
+
+	SIZE_T GetAllocatedSize() const { return Samples.GetAllocatedSize() + FreeBlocks.GetAllocatedSize() + Trajectories.GetAllocatedSize(); }
+
+private:
+	struct FTrajectory
+	{
+		/** The first sample of the block in the pool. */
+		int32 Block = 0;
+		/** The index of the next sample to write in the block. */
+		int32 Head = 0;
+		int32 Num = 0;
+	};
+
+	TAugmentaSlotMap<FTrajectory> Trajectories;
+	TArray<FAugmentaTrajectorySample> Samples;
+	TArray<int32> FreeBlocks;
+	int32 SamplesPerObject = 0;
+	int64 DroppedTrajectories = 0;
+};
+
+/** The summary of a visitor, i.e. an object from its enter to its leave, as streamed by FAugmentaAnalyticsWriter. */
+struct FAugmentaVisitorRecord
+{
+	/** When the object left, in seconds since the analytics were reset. */
+	double LeaveTime;
+	int32 Pid;
+	/** How long the object stayed in the scene, in seconds. */
+	float DwellTime;
+	/** The distance walked, in meters. */
+	float PathLength;
+	/** The path length over the dwell time, in meters per second. */
+	float AverageSpeed;
+	/** Where the object entered and left the scene, in meters. */
+	float EnterX;
+	float EnterY;
+	float LeaveX;
+	float LeaveY;
+};
+
+/**
+ * Streaming analytics of the Augmenta Objects : visitor counts, entries and exits over the last minute, dwell time histogram,
+ * average speed and flow direction, plus the trajectory of every object (see FAugmentaTrajectoryStore).
+ *
+ * Every aggregate is maintained incrementally from the events, so that the queries are constant time whatever the crowd.
+ */
+class AUGMENTAUNREAL_API FAugmentaAnalytics
+{
+public:
+	/** The duration of the window of the entries and exits per minute, in seconds. */
+	static constexpr int32 WindowSeconds = 60;
+
+	FAugmentaAnalytics();
+
+	/**
+	 * Sets the trajectory pool and the dwell time histogram, and resets the analytics.
+	 *
+	 * @param MaxTrajectories The number of objects whose trajectory is kept, zero to keep none.
+	 * @param TrajectoryLength The number of positions kept per object.
+	 * @param DwellBinDuration The duration covered by every bin of the dwell time histogram, in seconds.
+	 * @param NumDwellBins The number of bins, the last one counting every longer dwell time.
+	 */
+	void Configure(int32 MaxTrajectories, int32 TrajectoryLength, float DwellBinDuration, int32 NumDwellBins);
+
+	/** Forgets every object and clears the aggregates. */
+	void Reset();
+
+	/**
+	 * Updates the visitors, the aggregates and the trajectories from the events of a frame.
+	 *
+	 * @param Events The changes applied to the tracking state.
+	 * @param SceneSize The size of the scene in meters (see FAugmentaScene::SceneSize).
+	 * @param Time When the events were received, in seconds.
+	 */
+	void ApplyEvents(const FAugmentaFrameEvents& Events, const FVector2D& SceneSize, double Time);
+
+	/** Moves the window of the entries and exits per minute to the given time, in seconds. */
+	void Tick(double Time);
+
+	/** Returns the aggregates. */
+	FAugmentaAnalyticsSummary GetSummary() const;
+
+	/** The number of visitors per dwell time bin, see Configure. */
+	TConstArrayView<int64> GetDwellHistogram() const { return DwellHistogram; }
+
+	/** The visitors that left in the last call to ApplyEvents. */
+	TConstArrayView<FAugmentaVisitorRecord> GetLeftVisitors() const { return LeftVisitors; }
+
+	const FAugmentaTrajectoryStore& GetTrajectories() const { return Trajectories; }
+
+private:
+	struct FVisitor
+	{
+		double EnterTime = 0.0;
+		double LastTime = 0.0;
+		/** The positions in meters. */
+		FVector2f EnterPosition = FVector2f::ZeroVector;
+		FVector2f LastPosition = FVector2f::ZeroVector;
+		/** The velocity between the last two updates, in meters per second. */
+		FVector2f Velocity = FVector2f::ZeroVector;
+		float PathLength = 0.f;
+	};
+
+	void AddVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time);
+	void UpdateVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time);
+	void RemoveVisitor(const FAugmentaPerson& Object, const FVector2D& SceneSize, double Time);
+
+	/** Records the position of an object in its trajectory. */
+	void AddTrajectorySample(const FAugmentaPerson& Object, const FVisitor& Visitor, double Time);
+
+	TAugmentaSlotMap<FVisitor> Visitors;
+	FAugmentaTrajectoryStore Trajectories;
+
+	/** The time of the first event since the analytics were reset, negative until then. */
+	double StartTime = -1.0;
+
+	/** The entries and exits of every second of the window, indexed by the second modulo WindowSeconds. */
+	int32 WindowEntries[WindowSeconds] = {};
+	int32 WindowExits[WindowSeconds] = {};
+	int64 WindowSecond = INDEX_NONE;
+	int32 EntriesInWindow = 0;
+	int32 ExitsInWindow = 0;
+
+	TArray<int64> DwellHistogram;
+	float DwellBinDuration = 10.f;
+
+	int64 TotalVisitors = 0;
+	int64 TotalLeft = 0;
+	double TotalDwellTime = 0.0;
+	double TotalPathLength = 0.0;
+	/** The sum of the velocities of the visitors, in meters per second. */
+	FVector2D VelocitySum = FVector2D::ZeroVector;
+
+	TArray<FAugmentaVisitorRecord> LeftVisitors;
+};
@@ -0,0 +1,122 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+// Like the OSC decoder, the binary protocol only depends on the C++ standard library. Do not include any engine header here.
+#include "AugmentaOSCDecoder.h"
+
+/**
+ * A compact binary transport for the Augmenta data, an alternative to OSC for large scenes.
+ *
+ * A packet is an 8 byte header followed by blocks of fixed size records, every block holding consecutive records of one type :
+ *
+ *   Header : char Magic[4] = "AUGB", uint16 Version, uint16 HeaderSize
+ *   Block  : uint8 Type (EAugmentaMessageType), uint8 RecordSize, uint16 NumRecords, then NumRecords records of RecordSize bytes
+ *
+ * The records have the exact layout of the decoded messages (FAugmentaSceneMessage, FAugmentaVideoOutputMessage,
+ * FAugmentaObjectMessage and FAugmentaObjectExtraMessage) : every field is 4 bytes, little endian. On a little endian host
+ * the decoder hands the records over in place, without parsing nor copying any field. A frame is usually a single packet,
+ * a frame too large for a datagram is split into several packets, every record holding its frame number.
+ *
+ * Newer versions may grow the header and the records, the decoder skips the bytes it does not know and the blocks of unknown
+ * types. The first byte of a packet is never '/' nor '#', so binary packets and OSC packets can share a port.
+ */
+namespace AugmentaBinaryProtocol
+{
+	constexpr char Magic[4] = { 'A', 'U', 'G', 'B' };
+	constexpr uint16_t Version = 1;
+	constexpr size_t HeaderSize = 8;
+	constexpr size_t BlockHeaderSize = 4;
+	/** The maximum number of records of a block. */
+	constexpr size_t MaxRecordsPerBlock = 0xFFFF;
+}
+
+/**
+ * Encodes Augmenta data into binary packets (see AugmentaBinaryProtocol), with the same interface as FAugmentaOSCEncoder.
+ * Records are written into a caller provided buffer and encoding never allocates memory. A record that does not fit in the
+ * buffer is not written, so a full packet can be sent and the encoder reset.
+ */
+class AUGMENTAUNREAL_API FAugmentaBinaryEncoder
+{
+public:
+	/**
+	 * @param InBuffer The buffer the packet is written into, preferably 4 byte aligned.
+	 * @param InCapacity The size of the buffer, i.e. the maximum size of the packet.
+	 */
+	FAugmentaBinaryEncoder(uint8_t* InBuffer, size_t InCapacity);
+
+	/** Discards the packet written so far. */
+	void Reset();
+
+	/** Writes a scene record. Returns false if it does not fit. */
+	bool WriteScene(const FAugmentaSceneMessage& Scene);
+	/** Writes a video output record. Returns false if it does not fit. */
+	bool WriteVideoOutput(const FAugmentaVideoOutputMessage& VideoOutput);
+	/** Writes an object enter, update or leave record. Returns false if it does not fit or if the type is not an object type. */
+	bool WriteObject(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object);
+	/** Writes an object extra data enter, update or leave record. Returns false if it does not fit or if the type is not an extra data type. */
+	bool WriteObjectExtra(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra);
+
+	const uint8_t* GetData() const { return Buffer; }
+	/** The size of the packet written so far. */
+	size_t GetSize() const { return Size; }
+	/** The number of records written since the last reset. */
+	int32_t GetNumMessages() const { return NumMessages; }
+
+private:
+	/** Appends a record to the current block, opening a new block if the record is of another type. */
+	bool WriteRecord(EAugmentaMessageType Type, const void* Record, size_t RecordSize);
+
+	uint8_t* Buffer;
+	size_t Capacity;
+	size_t Size = 0;
+	int32_t NumMessages = 0;
+
+	/** The offset of the header of the current block, and its type and number of records. */
+	size_t BlockOffset = 0;
+	EAugmentaMessageType BlockType = EAugmentaMessageType::Unknown;
+	uint16_t BlockRecords = 0;
+};
+
+/**
+ * Decodes binary packets (see AugmentaBinaryProtocol) and forwards their records to a listener, like FAugmentaOSCDecoder.
+ * A packet is validated as a whole before any record is forwarded, so a malformed packet is never partially applied.
+ */
+class AUGMENTAUNREAL_API FAugmentaBinaryDecoder
+{
+public:
+	/** Returns whether a datagram starts like a binary packet. */
+	static bool IsBinaryPacket(const uint8_t* Data, size_t Size);
+
+	/**
+	 * Decodes a packet and forwards every record it contains to the listener.
+	 *
+	 * @param Data The packet bytes.
+	 * @param Size The size of the packet in bytes.
+	 * @param Listener The listener receiving the decoded records.
+	 *
+	 * @return true if the packet is well formed, false otherwise.
+	 */
+	bool Decode(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener);
+
+	/** Resets the decoding counters. The counters can be read from any thread. */
+	void ResetCounters();
+
+	/** The number of packets decoded. */
+	uint64_t GetPacketsDecoded() const { return PacketsDecoded.Get(); }
+	/** The number of records decoded, i.e. the number of Augmenta messages. */
+	uint64_t GetMessagesDecoded() const { return MessagesDecoded.Get(); }
+	/** The number of records forwarded in place, without being copied. */
+	uint64_t GetRecordsInPlace() const { return RecordsInPlace.Get(); }
+	/** The number of packets that could not be parsed. */
+	uint64_t GetMalformedPackets() const { return MalformedPackets.Get(); }
+
+private:
+	/** Forwards the records of a block to the listener. */
+	void DecodeBlock(EAugmentaMessageType Type, const uint8_t* Records, size_t RecordSize, size_t NumRecords, IAugmentaDecoderListener& Listener);
+
+	FAugmentaCounter PacketsDecoded;
+	FAugmentaCounter MessagesDecoded;
+	FAugmentaCounter RecordsInPlace;
+	FAugmentaCounter MalformedPackets;
+};
@@ -0,0 +1,215 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaOSCDecoder.h"
+#include "AugmentaObjectStore.h"
+
+/** Forward Declarations */
+struct FAugmentaFrameSnapshot;
+
+/**
+ * The stream a primary receiver re-publishes its tracking state with, to the secondary receivers of a render cluster
+ * (see UAugmentaReceiver::StartClusterPublisher). Every published state is a frame of one or more packets :
+ *
+ *   Header : char Magic[4] = "AUGC", uint16 Version, uint8 Flags, uint8 Reserved, uint32 Sequence, uint32 BaseSequence,
+ *            int32 Frame, uint16 PacketIndex, uint16 NumPackets
+ *   Record : uint8 Type (EAugmentaMessageType), then the fields of the type
+ *
+ * A keyframe holds the whole state. Any other frame only holds the changes since the frame BaseSequence : the objects that
+ * entered or left, and the fields of the updated objects that changed once quantized, selected by a mask. The positions and
+ * sizes are quantized to 1/16000 of the scene, the angles to 1/65536 of a turn and the heights and distances to the mm.
+ * The secondaries apply a frame once all of its packets are received and only on top of its base frame, otherwise they wait
+ * for the next keyframe : every secondary ends up with the same state for the same Frame, whatever the packets they lost.
+ * The first frame of a primary that started or was reset is flagged as a restart, so that the secondaries take its sequence
+ * for the new one rather than for a late packet.
+ *
+ * Every value is little endian, the ids and the integers are zigzag varints.
+ */
+namespace AugmentaClusterProtocol
+{
+	constexpr uint8 Magic[4] = { 'A', 'U', 'G', 'C' };
+	constexpr uint16 Version = 1;
+	constexpr int32 HeaderSize = 24;
+	/** The default maximum size of a packet, below the usual MTU. */
+	constexpr int32 DefaultPacketSize = 1400;
+
+	/** The header flag of the keyframes. */
+	constexpr uint8 KeyframeFlag = 1 << 0;
+	/** The header flag of the first frame of a primary that started or was reset, always a keyframe. */
+	constexpr uint8 RestartFlag = 1 << 1;
+
+	/** The fields of an object record, in the order they are written. */
+	enum class EObjectField : uint8
+	{
+		Oid,
+		Age,
+		CentroidX,
+		CentroidY,
+		VelocityX,
+		VelocityY,
+		Orientation,
+		BoundingRectPosX,
+		BoundingRectPosY,
+		BoundingRectSizeX,
+		BoundingRectSizeY,
+		BoundingRectRotation,
+		Height,
+		Num
+	};
+	constexpr int32 NumObjectFields = static_cast<int32>(EObjectField::Num);
+
+	/** The fields of an extra data record, in the order they are written. */
+	enum class EExtraField : uint8
+	{
+		Oid,
+		HighestX,
+		HighestY,
+		Distance,
+		Reflectivity,
+		Num
+	};
+	constexpr int32 NumExtraFields = static_cast<int32>(EExtraField::Num);
+
+	/** An object as published : its quantized fields. */
+	struct FObjectState
+	{
+		int32 Fields[NumObjectFields];
+		/** The sequence of the last frame holding the object. */
+		uint32 Sequence;
+	};
+
+	/** An extra data as published : its quantized fields. */
+	struct FExtraState
+	{
+		int32 Fields[NumExtraFields];
+		/** The sequence of the last frame holding the extra data. */
+		uint32 Sequence;
+	};
+
+	/** Returns a hash of the published state of a snapshot, the same on the primary and on every synchronized secondary. */
+	AUGMENTAUNREAL_API uint32 HashSnapshot(const FAugmentaFrameSnapshot& Snapshot);
+}
+
+/**
+ * Encodes the successive tracking states of a primary receiver into cluster frames (see AugmentaClusterProtocol).
+ * The packets of a frame are written into a buffer owned by the encoder, reused from one frame to the next.
+ */
+class AUGMENTAUNREAL_API FAugmentaClusterEncoder
+{
+public:
+	/**
+	 * @param InMaxPacketSize The maximum size of a packet.
+	 * @param InKeyframeInterval The number of frames between two keyframes, at least 1.
+	 */
+	explicit FAugmentaClusterEncoder(int32 InMaxPacketSize = AugmentaClusterProtocol::DefaultPacketSize, int32 InKeyframeInterval = 60);
+
+	/** Forgets the published state, the next frame is a keyframe. */
+	void Reset();
+
+	void SetKeyframeInterval(int32 InKeyframeInterval) { KeyframeInterval = FMath::Max(InKeyframeInterval, 1); }
+
+	/** Encodes the changes of a snapshot since the last encoded one, see GetPacket. */
+	void Encode(const FAugmentaFrameSnapshot& Snapshot);
+
+	/** The packets of the last encoded frame. */
+	int32 GetNumPackets() const { return PacketOffsets.Num(); }
+	TConstArrayView<uint8> GetPacket(int32 Index) const;
+
+	/** The sequence of the last encoded frame. */
+	uint32 GetSequence() const { return Sequence; }
+
+private:
+	/** Appends the record being written to the current packet, starting a new packet if it does not fit. */
+	void CommitRecord();
+
+	int32 MaxPacketSize;
+	int32 KeyframeInterval;
+	int32 FramesSinceKeyframe = 0;
+
+	/** The state of the secondaries once they applied the last frame. */
+	TAugmentaSlotMap<AugmentaClusterProtocol::FObjectState> Objects;
+	TAugmentaSlotMap<AugmentaClusterProtocol::FExtraState> Extras;
+	FAugmentaVideoOutputMessage VideoOutput;
+	bool bHasState = false;
+	uint32 Sequence = 0;
+
+	/** The packets of the last frame, one after the other, and the offset of each of them. */
+	TArray<uint8> PacketData;
+	TArray<int32> PacketOffsets;
+	/** The record being written. */
+	TArray<uint8> Record;
+	/** The ids of the objects or extra data that left, reused for every frame. */
+	TArray<int32> LeftIds;
+};
+
+/**
+ * Applies the cluster frames of a primary receiver (see AugmentaClusterProtocol), forwarding their changes to a listener as
+ * Augmenta messages, like FAugmentaOSCDecoder. The packets are buffered until the whole frame is received and validated, so
+ * a frame is either applied as a whole or not at all.
+ */
+class AUGMENTAUNREAL_API FAugmentaClusterDecoder
+{
+public:
+	/** Returns whether a datagram starts like a cluster packet. */
+	static bool IsClusterPacket(const uint8* Data, int32 Size);
+
+	/** Forgets the state of the primary, waiting for its next keyframe. */
+	void Reset();
+
+	/**
+	 * Buffers a packet, and applies its frame once all of its packets are received.
+	 *
+	 * @param Data The packet bytes.
+	 * @param Size The size of the packet in bytes.
+	 * @param Listener The listener receiving the changes of the frame.
+	 *
+	 * @return true if a frame was applied.
+	 */
+	bool Decode(const uint8* Data, int32 Size, IAugmentaDecoderListener& Listener);
+
+	/** Resets the decoding counters. The counters can be read from any thread. */
+	void ResetCounters();
+
+	/** The number of frames applied. */
+	uint64 GetFramesApplied() const { return FramesApplied.Get(); }
+	/** The number of frames not applied, because a packet was lost or their base frame was not applied. */
+	uint64 GetFramesDropped() const { return FramesDropped.Get(); }
+	/** The number of packets that could not be parsed. */
+	uint64 GetMalformedPackets() const { return MalformedPackets.Get(); }
+
+private:
+	/**
+	 * Parses the records of the frame once all of its packets are received. Returns false if they are malformed.
+	 *
+	 * @param Listener The listener the changes are applied and forwarded to, null to only validate the records.
+	 */
+	bool ReadFrame(IAugmentaDecoderListener* Listener);
+
+	/** Removes an object or an extra data, forwarding its leave message. */
+	void RemoveObject(int32 Pid, IAugmentaDecoderListener& Listener);
+	void RemoveExtra(int32 Id, IAugmentaDecoderListener& Listener);
+
+	/** Whether a frame is being assembled, and its header. */
+	bool bAssembling = false;
+	uint32 AssemblingSequence = 0;
+	uint32 AssemblingBaseSequence = 0;
+	int32 AssemblingFrame = 0;
+	bool bAssemblingKeyframe = false;
+	/** The records of every packet of the frame being assembled, empty until received. */
+	TArray<TArray<uint8>> Packets;
+	TBitArray<> ReceivedPackets;
+	int32 NumReceivedPackets = 0;
+
+	/** Whether the state matches the state of the primary after the frame AppliedSequence. */
+	bool bSynchronized = false;
+	uint32 AppliedSequence = 0;
+	TAugmentaSlotMap<AugmentaClusterProtocol::FObjectState> Objects;
+	TAugmentaSlotMap<AugmentaClusterProtocol::FExtraState> Extras;
+	TArray<int32> LeftIds;
+
+	FAugmentaCounter FramesApplied;
+	FAugmentaCounter FramesDropped;
+	FAugmentaCounter MalformedPackets;
+};
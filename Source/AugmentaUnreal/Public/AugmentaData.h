@@ -137,3 +137,185 @@ struct FAugmentaObjectExtra
 	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Object|Extra")
 	float Reflectivity;
 };
+
+/** 
+ * A structure to hold two Augmenta Objects close to each other.
+ */
+USTRUCT(BlueprintType, Category = "Augmenta|Data")
+struct FAugmentaObjectPair
+{
+	GENERATED_BODY()
+
+	/** The Id of the first object. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Pair")
+	int32 IdA = 0;
+
+	/** The Id of the second object. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Pair")
+	int32 IdB = 0;
+
+	/** The distance between the centroids of the objects (in m). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Pair")
+	float Distance = 0.f;
+};
+
+/** 
+ * A structure to hold the aggregates of the Augmenta analytics.
+ */
+USTRUCT(BlueprintType, Category = "Augmenta|Data")
+struct FAugmentaAnalyticsSummary
+{
+	GENERATED_BODY()
+
+	/** The number of objects that entered since the analytics were reset. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	int64 TotalVisitors = 0;
+
+	/** The number of objects in the scene. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	int32 CurrentVisitors = 0;
+
+	/** The number of objects that entered during the last minute. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	int32 EntriesPerMinute = 0;
+
+	/** The number of objects that left during the last minute. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	int32 ExitsPerMinute = 0;
+
+	/** The average time the objects that left stayed in the scene (in s). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	float AverageDwellTime = 0.f;
+
+	/** The average speed of the objects that left, their total path length over their total dwell time (in m/s). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	float AverageSpeed = 0.f;
+
+	/** The average velocity of the objects in the scene (in m/s), whose direction is the main direction of the flow. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Analytics")
+	FVector2D FlowVelocity = FVector2D::ZeroVector;
+};
+
+/** 
+ * A structure to hold the counters of the Augmenta message dispatch.
+ */
+USTRUCT(BlueprintType, Category = "Augmenta|Data")
+struct FAugmentaDispatchStats
+{
+	GENERATED_BODY()
+
+	/** The number of Augmenta messages decoded, OSC messages or binary records. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 MessagesDecoded = 0;
+
+	/** The number of OSC messages that are not Augmenta messages. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 MessagesIgnored = 0;
+
+	/** The number of datagrams that could not be parsed. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 MalformedPackets = 0;
+
+	/** The number of messages dispatched with a single lookup in the precompiled address table. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 DispatchTableHits = 0;
+
+	/** The number of messages whose address was not in the precompiled address table. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 DispatchTableMisses = 0;
+
+	/**
+	 * The number of heap allocations made while dispatching messages, i.e. the number of times the tracked object containers,
+	 * the pending events, the committed frames and their pool, or the events being coalesced and broadcast had to grow.
+	 * Stays constant once the largest crowd has been seen.
+	 */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 DispatchAllocations = 0;
+
+	/** The number of objects and extra data removed because they were not updated within the timeout, i.e. whose leave message was lost. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 DroppedLeaves = 0;
+};
+
+/** 
+ * A structure to hold the runtime counters of an Augmenta receiver, for dashboards.
+ * The rates and latencies are measured over the last second.
+ */
+USTRUCT(BlueprintType, Category = "Augmenta|Data")
+struct AUGMENTAUNREAL_API FAugmentaReceiverCounters
+{
+	GENERATED_BODY()
+
+	/** The number of /scene messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float SceneMessagesPerSecond = 0.f;
+
+	/** The number of /fusion messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float VideoOutputMessagesPerSecond = 0.f;
+
+	/** The number of /object/enter messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float ObjectEnterMessagesPerSecond = 0.f;
+
+	/** The number of /object/update messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float ObjectUpdateMessagesPerSecond = 0.f;
+
+	/** The number of /object/leave messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float ObjectLeaveMessagesPerSecond = 0.f;
+
+	/** The number of /object/enter/extra, /object/update/extra and /object/leave/extra messages received per second. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float ExtraMessagesPerSecond = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float DatagramsPerSecond = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float BytesPerSecond = 0.f;
+
+	/** The number of frames received since the receiver was connected. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 FramesAssembled = 0;
+
+	/** The number of times the Frame field skipped frames, i.e. frames whose every message was lost. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 FrameGaps = 0;
+
+	/** The total number of frames skipped by the frame gaps. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 MissedFrames = 0;
+
+	/** The number of datagrams holding a frame older than the frame being received, whose messages were dropped. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 OutOfOrderPackets = 0;
+
+	/** The number of events dropped or merged into a newer event of the same object, see UAugmentaReceiver::bCoalesceEvents. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 CoalescedEvents = 0;
+
+	/** The number of object events not fired to the filtered subscriptions, see UAugmentaReceiver::SubscribeToObjects. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 FilteredEvents = 0;
+
+	/** The number of cluster frames not applied by a secondary receiver, because a packet was lost (see UAugmentaReceiver::StartClusterPublisher). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int64 ClusterFramesDropped = 0;
+
+	/** The number of objects in the scene. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	int32 ActiveObjects = 0;
+
+	/** The median time from the first datagram of a frame being read from the socket to the events of the frame being fired (in ms). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float LatencyP50 = 0.f;
+
+	/** The 99th percentile of the time from the first datagram of a frame being read from the socket to the events of the frame being fired (in ms). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Stats")
+	float LatencyP99 = 0.f;
+
+	/** Returns the counters as a multi-line text, for logs and the console. */
+	FString ToString() const;
+};
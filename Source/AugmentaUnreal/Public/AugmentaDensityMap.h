@@ -0,0 +1,58 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Forward Declarations */
+struct FAugmentaObjectsSoA;
+
+/**
+ * A grid of the occupancy of the Augmenta scene, covering the whole scene whatever its size in meters.
+ *
+ * The map is updated incrementally once per tick : every cell decays exponentially towards zero, then every object adds its
+ * footprint, a separable kernel as large as its bounding rectangle. Both passes process four cells per SIMD instruction, so
+ * that the cost is dominated by the decay of the whole grid. A cell under a still object converges to 1, and to the number
+ * of overlapping objects where they overlap. A zero decay time gives the instantaneous occupancy instead.
+ */
+class AUGMENTAUNREAL_API FAugmentaDensityMap
+{
+public:
+	/** Sets the number of cells of the map, clearing it if it changed. Zero frees the map. */
+	void SetResolution(int32 InWidth, int32 InHeight);
+
+	/** Clears every cell. */
+	void Reset();
+
+	/**
+	 * Decays the map, then adds the objects to it.
+	 *
+	 * @param Objects The objects, with their normalized centroids and bounding rectangles.
+	 * @param DeltaTime The time since the last update, in seconds.
+	 * @param DecayTime The time for a cell to decay to 37% of its value, in seconds. Zero only keeps the objects of this update.
+	 */
+	void Update(const FAugmentaObjectsSoA& Objects, float DeltaTime, float DecayTime);
+
+	int32 GetWidth() const { return Width; }
+	int32 GetHeight() const { return Height; }
+
+	/** The cells, row by row from the top of the scene, as contiguous floats. */
+	TConstArrayView<float> GetValues() const { return Values; }
+
+	/** Returns the value of the cell at a normalized position of the scene, or zero outside of the scene. */
+	float GetValueAt(const FVector2D& Position) const;
+
+private:
+	/** Adds the footprint of an object, in cells, scaled by Weight. */
+	void AddFootprint(float CenterX, float CenterY, float RadiusX, float RadiusY, float Weight);
+
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<float> Values;
+
+	/** An upper bound of the values, so that an empty map is not decayed forever. */
+	float PeakBound = 0.f;
+
+	/** The kernel weights of the columns covered by the current footprint, reused by every object. */
+	TArray<float> ColumnWeights;
+};
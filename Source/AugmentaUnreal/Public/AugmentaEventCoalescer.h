@@ -0,0 +1,67 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaTracker.h"
+
+/**
+ * Merges the events of several datagrams or frames into a single group, so that an object changing several times between
+ * two ticks is fired once with its newest state.
+ *
+ * An update of an object that already has an enter or update event in the group overwrites that event in place, an update
+ * followed by the leave of the object is dropped, and the scene and video output keep their newest state only. Enter and leave
+ * events are never dropped, so every object still fires matching enter and leave events. The events keep the position of
+ * their first occurrence in the group.
+ */
+class AUGMENTAUNREAL_API FAugmentaEventCoalescer
+{
+public:
+	/** Adds the events of a datagram or frame to the group, coalescing them with the events already in it. */
+	void Add(const FAugmentaFrameEvents& InEvents);
+
+	bool IsEmpty() const { return Events.IsEmpty(); }
+
+	/** Hands the coalesced events over and starts a new group. The previous content of OutEvents is reused by the next group. */
+	void Flush(FAugmentaFrameEvents& OutEvents);
+
+	/** Drops the events of the group. */
+	void Reset();
+
+	SIZE_T GetAllocatedSize() const;
+
+	/** The number of events dropped or overwritten by a newer event of the same object since the last call to ResetCounters. */
+	int64 GetCoalescedEvents() const { return CoalescedEvents; }
+
+	void ResetCounters() { CoalescedEvents = 0; }
+
+private:
+	/** Adds an object event, coalescing it with the pending event of the same object. */
+	void AddObject(EAugmentaEventType Type, const FAugmentaPerson& Object);
+
+	/** Adds an extra data event, coalescing it with the pending event of the same extra data. */
+	void AddExtra(EAugmentaEventType Type, const FAugmentaObjectExtra& Extra);
+
+	/** Removes the dropped update events, keeping the order of the others. */
+	void Compact();
+
+	FAugmentaFrameEvents Events;
+
+	/** The pending enter or update event of every object and extra data, as an index into Events.Sequence. */
+	FAugmentaIdIndex ObjectRecords;
+	FAugmentaIdIndex ExtraRecords;
+	int32 SceneRecord = INDEX_NONE;
+	int32 VideoOutputRecord = INDEX_NONE;
+
+	/** The update events superseded by a leave event, indexed like Events.UpdatedObjects and Events.UpdatedExtras. */
+	TBitArray<> DroppedObjectUpdates;
+	TBitArray<> DroppedExtraUpdates;
+	int32 NumDropped = 0;
+
+	/** Scratch arrays reused by every compaction. */
+	TArray<int32> ObjectRemap;
+	TArray<int32> ExtraRemap;
+
+	int64 CoalescedEvents = 0;
+};
@@ -0,0 +1,135 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaSpatialGrid.h"
+#include "AugmentaTracker.h"
+#include "AugmentaFusion.generated.h"
+
+/** An Augmenta node or port merged by UAugmentaReceiver::ConnectSources, and where its scene is placed in the shared space. */
+USTRUCT(BlueprintType)
+struct AUGMENTAUNREAL_API FAugmentaSourceSettings
+{
+	GENERATED_BODY()
+
+	/** The ip address of the device to connect to get the OSC Messages, empty to listen on every interface. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Fusion")
+	FString ReceiveIPAddress;
+
+	/** The port of the device to listen to, to get the OSC Messages. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Fusion")
+	int32 Port = 12000;
+
+	/** The position of the top left corner of the source scene in the shared space (in m). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Fusion")
+	FVector2D Offset = FVector2D::ZeroVector;
+};
+
+/**
+ * Merges the tracking states of several Augmenta sources into a single tracking state, as if a single node covered the
+ * whole floor. Every source scene is placed in a shared space by its offset, and the objects seen by several sources in
+ * the overlap regions are merged into one.
+ *
+ * The objects of all the sources are indexed in a uniform grid, so that only the objects of neighbouring cells are
+ * compared, and the pairs closer than the merge distance are associated from the closest to the farthest, each fused
+ * object holding at most one object per source. The fused objects have their own Pid space : a fused object keeps its
+ * Pid as long as one of the source objects it was made of is still tracked, so an object walking from one source to
+ * another is not seen leaving and entering again.
+ *
+ * The fused state is rebuilt from the last complete frame of every source, so it is always made of whole frames, and
+ * its events are the differences with the previous fused state. The video output of the sources is not fused.
+ */
+class AUGMENTAUNREAL_API FAugmentaFusion
+{
+public:
+	/** The maximum number of sources, the sources of a fused object are kept in a 32 bit mask. */
+	static constexpr int32 MaxSources = 32;
+
+	/** A source to fuse. */
+	struct FSource
+	{
+		/** The last complete frame of the source, nullptr until the first one is received. */
+		const FAugmentaFrameSnapshot* Snapshot = nullptr;
+		/** The position of the top left corner of the source scene in the shared space (in m). */
+		FVector2D Offset = FVector2D::ZeroVector;
+	};
+
+	/** Removes every fused object and forgets the sources. */
+	void Reset();
+
+	/** Sets the distance under which the objects of two sources are merged (in m). */
+	void SetMergeDistance(float InMergeDistance) { MergeDistance = InMergeDistance; }
+
+	/** Sets the size of the shared space (in m). Zero fits the shared space to the scenes of the sources. */
+	void SetSceneSize(const FVector2D& InSceneSize) { SceneSize = InSceneSize; }
+
+	/**
+	 * Rebuilds the fused state from the sources and records the changes as events.
+	 *
+	 * @param Sources The sources, always given in the same order. At most MaxSources.
+	 * @param Now The current time, in seconds.
+	 */
+	void Fuse(TConstArrayView<FSource> Sources, double Now);
+
+	/** The fused tracking state. Its objects are positioned in the shared space, normalized by its size. */
+	const FAugmentaFrameSnapshot& GetSnapshot() const { return Snapshot; }
+
+	/** The changes recorded by the last call to Fuse. */
+	FAugmentaFrameEvents& GetEvents() { return Events; }
+
+private:
+	/** Adds the objects of the sources to the candidates, in the shared space normalized by its size. */
+	void GatherCandidates(TConstArrayView<FSource> Sources, const FVector2D& FusedSceneSize);
+
+	/** Merges the close candidates of different sources into clusters. */
+	void AssociateCandidates(const FVector2D& FusedSceneSize);
+
+	/** Returns the root of the cluster of a candidate, compressing the path to it. */
+	int32 FindRoot(int32 Candidate);
+
+	/** Gives every cluster the Pid of the fused object it continues, or a new one. */
+	void AssignPids(int32 NumSources);
+
+	/** Applies the clusters to the fused state, removing the fused objects that are not continued. */
+	void UpdateObjects(TConstArrayView<FSource> Sources, const FVector2D& FusedSceneSize, double Now);
+
+	float MergeDistance = 0.5f;
+	FVector2D SceneSize = FVector2D::ZeroVector;
+
+	FAugmentaFrameSnapshot Snapshot;
+	FAugmentaFrameEvents Events;
+	int32 NextPid = 0;
+
+	/** The objects of every source, indexed by candidate. */
+	TArray<float> CandidateX;
+	TArray<float> CandidateY;
+	TArray<int32> CandidateSources;
+	/** The slot of the object in the store of its source. */
+	TArray<int32> CandidateSlots;
+	TArray<int32> CandidatePids;
+
+	FAugmentaSpatialGrid Grid;
+	TArray<FAugmentaSlotPair> Pairs;
+
+	/** The union-find forest of the clusters, and the sources of every root. */
+	TArray<int32> Parents;
+	TArray<uint32> SourceMasks;
+
+	/** The cluster of every root, while numbering the clusters. */
+	TArray<int32> RootClusters;
+	/** The candidates grouped by cluster : the members of a cluster are ClusterMembers[ClusterFirst[C]] to ClusterMembers[ClusterFirst[C + 1] - 1]. */
+	TArray<int32> CandidateClusters;
+	TArray<int32> ClusterFirst;
+	TArray<int32> ClusterMembers;
+	TArray<int32> ClusterPids;
+	/** The clusters sorted by Pid, i.e. by age, to number them like the Augmenta Oid. */
+	TArray<int32> ClusterOrder;
+
+	/** Per source, the fused Pid of every source Pid, as of the last call to Fuse and being built. */
+	TArray<FAugmentaIdIndex> FusedPids;
+	TArray<FAugmentaIdIndex> NextFusedPids;
+	/** The fused Pids already given to a cluster, mapped to the cluster. */
+	FAugmentaIdIndex ClaimedPids;
+};
@@ -0,0 +1,243 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Math/RandomStream.h"
+#include "AugmentaOSCDecoder.h"
+#include "AugmentaLoadGenerator.generated.h"
+
+/** Forward Declarations */
+class FInternetAddr;
+class FRunnableThread;
+class FSocket;
+class FAugmentaBinaryEncoder;
+class FAugmentaOSCEncoder;
+
+/** The synthetic crowd sent by FAugmentaLoadGenerator, and how a load test is run. */
+USTRUCT(BlueprintType)
+struct AUGMENTAUNREAL_API FAugmentaLoadSettings
+{
+	GENERATED_BODY()
+
+	/** The ip address the streams are sent to. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	FString Address = TEXT("127.0.0.1");
+
+	/** The port the streams are sent to. A load test given port 0 listens to a free port picked by the system. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	int32 Port = 12000;
+
+	/** The number of objects in the scene. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "0"))
+	int32 ObjectCount = 100;
+
+	/** The number of frames sent per second. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "1"))
+	float FrameRate = 60.f;
+
+	/** The number of objects leaving the scene per second, each replaced by a new object entering it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "0"))
+	float ChurnPerSecond = 1.f;
+
+	/** The probability of a datagram not being sent, to simulate a lossy network. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "0", ClampMax = "1"))
+	float PacketLoss = 0.f;
+
+	/** Whether the extra data of every object is sent as well. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	bool bSendExtraData = true;
+
+	/** Whether the streams are sent as binary packets (see AugmentaBinaryProtocol) rather than OSC. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	bool bBinaryProtocol = false;
+
+	/** The maximum size of a datagram. The messages are grouped in bundles or packets up to this size, zero sends every OSC message alone. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "0"))
+	int32 MaxDatagramSize = 1400;
+
+	/** The size of the scene (in m). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	FVector2D SceneSize = FVector2D(20.f, 10.f);
+
+	/** The seed of the random positions, velocities and losses, so that a load can be reproduced. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	int32 Seed = 0;
+
+	/** How long a load test sends the streams (in s). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "0"))
+	float Duration = 10.f;
+
+	/** The number of receiver ticks per second during a load test, i.e. the simulated game frame rate. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load", meta = (ClampMin = "1"))
+	float TickRate = 60.f;
+
+	/** Whether the receiver of a load test assembles the frames (see UAugmentaReceiver::bFrameAssembly). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	bool bFrameAssembly = true;
+
+	/** Whether the receiver of a load test decodes on its receive thread (see UAugmentaReceiver::bDecodeOnReceiveThread). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Load")
+	bool bDecodeOnReceiveThread = false;
+};
+
+/** The results of a load test. */
+USTRUCT(BlueprintType)
+struct AUGMENTAUNREAL_API FAugmentaLoadReport
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 FramesSent = 0;
+
+	/** The number of messages generated, including the lost ones. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 MessagesSent = 0;
+
+	/** The number of messages not sent on purpose, see FAugmentaLoadSettings::PacketLoss. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 MessagesLost = 0;
+
+	/** The number of messages decoded by the receiver. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 MessagesReceived = 0;
+
+	/** The number of messages sent but never decoded, e.g. dropped by a full socket buffer. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 MessagesDropped = 0;
+
+	/** The number of objects expired by the receiver because their leave message was lost. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 DroppedLeaves = 0;
+
+	/** The number of frames whose events were fired by the receiver. */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	int64 FramesReceived = 0;
+
+	/** The time from a frame being sent to its events being fired on the game thread (in ms). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float AverageLatency = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float P99Latency = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float MaxLatency = 0.f;
+
+	/** The time spent in the tick of the receiver (in ms). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float AverageTickTime = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float MaxTickTime = 0.f;
+
+	/** The game thread time spent per received frame (in ms). */
+	UPROPERTY(BlueprintReadOnly, Category = "Augmenta|Load")
+	float TickTimePerFrame = 0.f;
+
+	/** Returns the report as a multi-line text, for logs. */
+	FString ToString() const;
+};
+
+/**
+ * Sends a synthetic crowd as protocol-correct Augmenta streams (/scene, /fusion, /object/enter|update|leave and their extra data)
+ * from a dedicated thread, to stress-test a receiver. The streams are sent as OSC or as binary packets (see AugmentaBinaryProtocol). The objects wander around the scene, leave and are replaced at the churn rate.
+ *
+ * Every OSC datagram is a bundle whose time tag is the time it was sent (see FPlatformTime::Seconds), and the send time of every frame
+ * is kept so that the latency of a receiver in the same process can be measured (see GetFrameSendTime).
+ */
+class AUGMENTAUNREAL_API FAugmentaLoadGenerator : public FRunnable
+{
+public:
+	/** Opens the socket and starts sending. */
+	explicit FAugmentaLoadGenerator(const FAugmentaLoadSettings& InSettings);
+	/** Stops the thread, waits for it to exit and closes the socket. */
+	virtual ~FAugmentaLoadGenerator();
+
+	/** Whether the socket could be opened and the thread is sending. */
+	bool IsRunning() const { return Thread != nullptr; }
+
+	/** Returns the time the first datagram of a recent frame was sent, or a negative time if the frame is unknown. */
+	double GetFrameSendTime(int32 Frame) const;
+
+	int64 GetFramesSent() const { return static_cast<int64>(FramesSent.Get()); }
+	int64 GetMessagesSent() const { return static_cast<int64>(MessagesSent.Get()); }
+	int64 GetMessagesLost() const { return static_cast<int64>(MessagesLost.Get()); }
+
+	/**
+	 * Runs a load test against a new receiver listening on the loopback, ticking it on the calling thread like the game thread would.
+	 * Blocks for the duration of the test.
+	 */
+	static FAugmentaLoadReport RunLoadTest(const FAugmentaLoadSettings& Settings);
+
+	//~ Begin FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~ End FRunnable interface
+
+private:
+	/** An object of the synthetic crowd. */
+	struct FObject
+	{
+		FAugmentaObjectMessage Message;
+		/** The velocity, in normalized units per second. */
+		FVector2f Velocity;
+		bool bEntered;
+	};
+
+	/** Adds a new object at a random position, with a random velocity. */
+	void AddObject();
+
+	/** Moves the objects, replaces the ones leaving and sends the frame. */
+	void SendFrame(int32 Frame, float DeltaTime);
+
+	/** Writes the messages of a frame, sending the datagrams as they fill up. */
+	template <typename EncoderType>
+	void EncodeFrame(EncoderType& Encoder, int32 Frame);
+
+	/** Writes an object message and its extra data, sending the current datagram first when it is full. */
+	template <typename EncoderType>
+	void WriteObject(EncoderType& Encoder, EAugmentaMessageType Type, EAugmentaMessageType ExtraType, const FAugmentaObjectMessage& Message);
+
+	/** Writes a message with the given encoder function, sending the current datagram first when it is full. */
+	template <typename EncoderType, typename WriteFuncType>
+	void WriteMessage(EncoderType& Encoder, WriteFuncType&& WriteFunc);
+
+	/** Opens a new datagram. */
+	void BeginDatagram(FAugmentaOSCEncoder& Encoder);
+	void BeginDatagram(FAugmentaBinaryEncoder& Encoder);
+	/** Sends the current datagram, unless it is lost on purpose. */
+	template <typename EncoderType>
+	void SendDatagram(EncoderType& Encoder);
+
+	FAugmentaLoadSettings Settings;
+	FRandomStream Random;
+
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> Destination;
+	TArray<uint8> DatagramBuffer;
+
+	TArray<FObject> Objects;
+	/** The objects leaving the scene this frame. */
+	TArray<FAugmentaObjectMessage> LeavingObjects;
+	int32 NextPid = 0;
+	/** The fractional number of objects to replace, accumulated frame after frame. */
+	float PendingChurn = 0.f;
+
+	/** The send time of the recent frames, indexed by frame modulo the size of the history. */
+	static constexpr int32 SendTimeHistorySize = 1024;
+	struct FSendTime
+	{
+		std::atomic<int32> Frame{ -1 };
+		std::atomic<double> Time{ 0.0 };
+	};
+	FSendTime SendTimes[SendTimeHistorySize];
+
+	FAugmentaCounter FramesSent;
+	FAugmentaCounter MessagesSent;
+	FAugmentaCounter MessagesLost;
+
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+};
@@ -0,0 +1,185 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+// The decoder only depends on the C++ standard library so that it can be compiled, profiled
+// and tested outside of the engine. Do not include any engine header here.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef AUGMENTAUNREAL_API
+#define AUGMENTAUNREAL_API
+#endif
+
+/**
+ * A counter incremented by a single thread and readable from any thread.
+ * Increments are a plain load and store, no locked instruction is emitted.
+ */
+class FAugmentaCounter
+{
+public:
+	void Increment(uint64_t Amount = 1) { Value.store(Value.load(std::memory_order_relaxed) + Amount, std::memory_order_relaxed); }
+	void Reset() { Value.store(0, std::memory_order_relaxed); }
+	uint64_t Get() const { return Value.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> Value{ 0 };
+};
+
+/** The Augmenta OSC Messages understood by the decoder. */
+enum class EAugmentaMessageType : uint8_t
+{
+	Unknown,
+	Scene,
+	VideoOutput,
+	ObjectEnter,
+	ObjectUpdate,
+	ObjectLeave,
+	ObjectExtraEnter,
+	ObjectExtraUpdate,
+	ObjectExtraLeave,
+};
+
+/** The arguments of an /object/enter, /object/update or /object/leave OSC Message. */
+struct FAugmentaObjectMessage
+{
+	int32_t Frame = 0;
+	int32_t Pid = -1;
+	int32_t Oid = 0;
+	float Age = 0.f;
+	float CentroidX = 0.f;
+	float CentroidY = 0.f;
+	float VelocityX = 0.f;
+	float VelocityY = 0.f;
+	float Orientation = 0.f;
+	float BoundingRectPosX = 0.f;
+	float BoundingRectPosY = 0.f;
+	float BoundingRectSizeX = 0.f;
+	float BoundingRectSizeY = 0.f;
+	float BoundingRectRotation = 0.f;
+	float Height = 0.f;
+};
+
+/** The arguments of a /scene OSC Message. */
+struct FAugmentaSceneMessage
+{
+	int32_t Frame = 0;
+	int32_t ObjectCount = 0;
+	float SizeX = 0.f;
+	float SizeY = 0.f;
+};
+
+/** The arguments of a /fusion OSC Message. */
+struct FAugmentaVideoOutputMessage
+{
+	float OffsetX = 0.f;
+	float OffsetY = 0.f;
+	float SizeX = 0.f;
+	float SizeY = 0.f;
+	int32_t ResolutionX = 0;
+	int32_t ResolutionY = 0;
+};
+
+/** The arguments of an /object/enter/extra, /object/update/extra or /object/leave/extra OSC Message. */
+struct FAugmentaObjectExtraMessage
+{
+	int32_t Frame = 0;
+	int32_t Id = -1;
+	int32_t Oid = 0;
+	float HighestX = 0.f;
+	float HighestY = 0.f;
+	float Distance = 0.f;
+	float Reflectivity = 0.f;
+};
+
+/** Interface receiving the Augmenta data decoded by FAugmentaOSCDecoder. */
+class IAugmentaDecoderListener
+{
+public:
+	virtual ~IAugmentaDecoderListener() = default;
+
+	/** Called for every decoded /scene message. */
+	virtual void OnSceneDecoded(const FAugmentaSceneMessage& Scene) = 0;
+	/** Called for every decoded /fusion message. */
+	virtual void OnVideoOutputDecoded(const FAugmentaVideoOutputMessage& VideoOutput) = 0;
+	/** Called for every decoded object enter, update or leave message. */
+	virtual void OnObjectDecoded(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object) = 0;
+	/** Called for every decoded object enter, update or leave extra data message. */
+	virtual void OnObjectExtraDecoded(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra) = 0;
+};
+
+/**
+ * Decodes raw OSC datagrams (messages and bundles) sent by the Augmenta Fusion or the Augmenta Node(s)
+ * into plain structures. Decoding works in place on the datagram bytes and never allocates memory.
+ */
+class AUGMENTAUNREAL_API FAugmentaOSCDecoder
+{
+public:
+	/**
+	 * Builds the table mapping the Augmenta addresses to their message type.
+	 * Messages are dispatched with a single hash lookup once it is built, other addresses
+	 * (ex: a prefixed /scene) fall back to ClassifyAddress.
+	 */
+	void BuildDispatchTable();
+
+	/**
+	 * Decodes a datagram and forwards every Augmenta message it contains to the listener.
+	 *
+	 * @param Data The datagram bytes.
+	 * @param Size The size of the datagram in bytes.
+	 * @param Listener The listener receiving the decoded messages.
+	 *
+	 * @return true if the datagram is a well formed OSC packet, false otherwise.
+	 */
+	bool Decode(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener);
+
+	/** Returns the Augmenta message type matching the given OSC address. */
+	static EAugmentaMessageType ClassifyAddress(const char* Address, size_t Length);
+
+	/** Resets the decoding counters. The counters can be read from any thread. */
+	void ResetCounters();
+
+	/** The number of Augmenta messages decoded. */
+	uint64_t GetMessagesDecoded() const { return MessagesDecoded.Get(); }
+	/** The number of well formed OSC messages that are not Augmenta messages. */
+	uint64_t GetMessagesIgnored() const { return MessagesIgnored.Get(); }
+	/** The number of datagrams that could not be parsed. */
+	uint64_t GetMalformedPackets() const { return MalformedPackets.Get(); }
+	/** The number of messages whose address was found in the dispatch table. */
+	uint64_t GetDispatchTableHits() const { return DispatchTableHits.Get(); }
+	/** The number of messages whose address had to be classified segment by segment. */
+	uint64_t GetDispatchTableMisses() const { return DispatchTableMisses.Get(); }
+
+private:
+	/** An entry of the dispatch table. */
+	struct FDispatchEntry
+	{
+		const char* Address = nullptr;
+		uint32_t Hash = 0;
+		uint32_t Length = 0;
+		EAugmentaMessageType Type = EAugmentaMessageType::Unknown;
+	};
+
+	/** The number of entries of the dispatch table, a power of two at least twice the number of addresses. */
+	static constexpr uint32_t DispatchTableSize = 32;
+
+	/** Returns the message type of the given address, using the dispatch table when it is built. */
+	EAugmentaMessageType Dispatch(const char* Address, uint32_t Length, uint32_t Hash);
+
+	/** Decodes a bundle element, which is either a message or a nested bundle. */
+	bool DecodePacket(const uint8_t* Data, size_t Size, int32_t Depth, IAugmentaDecoderListener& Listener);
+	/** Decodes a single OSC message. */
+	bool DecodeMessage(const uint8_t* Data, size_t Size, IAugmentaDecoderListener& Listener);
+
+	FAugmentaCounter MessagesDecoded;
+	FAugmentaCounter MessagesIgnored;
+	FAugmentaCounter MalformedPackets;
+	FAugmentaCounter DispatchTableHits;
+	FAugmentaCounter DispatchTableMisses;
+
+	/** Open addressing table of the Augmenta addresses, indexed by their hash. */
+	FDispatchEntry DispatchTable[DispatchTableSize];
+	/** Whether BuildDispatchTable has been called. */
+	bool bHasDispatchTable = false;
+};
@@ -0,0 +1,78 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+// Like the decoder, the encoder only depends on the C++ standard library. Do not include any engine header here.
+#include "AugmentaOSCDecoder.h"
+
+/**
+ * Encodes Augmenta data into OSC datagrams, as sent by the Augmenta Fusion or the Augmenta Node(s).
+ * Messages are written into a caller provided buffer, optionally grouped in bundles, and encoding never allocates memory.
+ * Messages and bundles that do not fit in the buffer are not written, so a full datagram can be sent and the encoder reset.
+ */
+class AUGMENTAUNREAL_API FAugmentaOSCEncoder
+{
+public:
+	/** The maximum depth of nested bundles, the same as the decoder. */
+	static constexpr int32_t MaxBundleDepth = 8;
+	/** The OSC time tag meaning "immediately". */
+	static constexpr uint64_t ImmediateTimeTag = 1;
+
+	/**
+	 * @param InBuffer The buffer the datagram is written into.
+	 * @param InCapacity The size of the buffer, i.e. the maximum size of the datagram.
+	 */
+	FAugmentaOSCEncoder(uint8_t* InBuffer, size_t InCapacity);
+
+	/** Discards the datagram written so far, including the open bundles. */
+	void Reset();
+
+	/** Opens a bundle, nested in the current one if any. Returns false if it does not fit. */
+	bool BeginBundle(uint64_t TimeTag = ImmediateTimeTag);
+	/** Closes the current bundle. */
+	void EndBundle();
+
+	/** Writes a /scene message. Returns false if it does not fit. */
+	bool WriteScene(const FAugmentaSceneMessage& Scene);
+	/** Writes a /fusion message. Returns false if it does not fit. */
+	bool WriteVideoOutput(const FAugmentaVideoOutputMessage& VideoOutput);
+	/** Writes an /object/enter, /object/update or /object/leave message. Returns false if it does not fit. */
+	bool WriteObject(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object);
+	/** Writes an /object/enter/extra, /object/update/extra or /object/leave/extra message. Returns false if it does not fit. */
+	bool WriteObjectExtra(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra);
+
+	const uint8_t* GetData() const { return Buffer; }
+	/** The size of the datagram written so far. */
+	size_t GetSize() const { return Size; }
+	/** The number of messages written since the last reset. */
+	int32_t GetNumMessages() const { return NumMessages; }
+	/** Whether a bundle is open. */
+	bool IsInBundle() const { return BundleDepth > 0; }
+
+	/** Returns the OSC address of a message type, or nullptr for EAugmentaMessageType::Unknown. */
+	static const char* GetAddress(EAugmentaMessageType Type);
+
+	/** Converts a time in seconds into an OSC time tag, a 32.32 fixed point number of seconds. */
+	static uint64_t SecondsToTimeTag(double Seconds);
+	/** Converts an OSC time tag into a time in seconds. */
+	static double TimeTagToSeconds(uint64_t TimeTag);
+
+private:
+	/** Writes a message whose arguments are all 4 bytes long, their bits given in the order of the type tags. */
+	bool WriteMessage(const char* Address, const char* TypeTags, const uint32_t* Arguments, size_t NumArguments);
+
+	/** Reserves the size prefix of a bundle element if a bundle is open. Returns false if the element does not fit. */
+	bool BeginElement(size_t ElementSize);
+
+	void WriteUInt32(uint32_t Value);
+	void WriteString(const char* String, size_t Length);
+
+	uint8_t* Buffer;
+	size_t Capacity;
+	size_t Size = 0;
+	int32_t NumMessages = 0;
+
+	/** The offset of the size prefix of every open nested bundle, the outermost bundle has none. */
+	size_t BundleSizeOffsets[MaxBundleDepth];
+	int32_t BundleDepth = 0;
+};
@@ -0,0 +1,165 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "AugmentaData.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaObjectPoolComponent.generated.h"
+
+/** Forward Declarations */
+class UAugmentaReceiver;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+/** Delegates */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FAugmentaPooledObjectEvent, const FAugmentaPerson&, Object, AActor*, Actor, int32, InstanceIndex);
+
+/** What represents the Augmenta Objects in the world. */
+UENUM(BlueprintType)
+enum class EAugmentaPoolMode : uint8
+{
+	/** An actor of ActorClass per object. */
+	Actors,
+	/** An instance of InstanceMesh per object, all drawn by a single instanced static mesh component. */
+	Instances,
+};
+
+/**
+ * Represents every Augmenta Object of a receiver by a pooled actor or mesh instance, without spawning nor destroying
+ * anything while the objects enter and leave.
+ *
+ * The pool is filled when play begins : the free actors are hidden, without collision nor tick, and the free instances
+ * are scaled to zero. Once per tick, after the receiver has ticked, the objects are diffed against the entries in use :
+ * the new objects take a free entry, the entries of the objects that are gone return to the pool, and every object is
+ * moved to its world centroid, computed for all the objects in a single vectorized pass. The instances are all updated
+ * with a single batched call. Nothing is allocated on enter or leave once the pool is as large as the crowd.
+ *
+ * The Augmenta scene is placed in the world by the transform of this component, one meter being MetersToUnits units.
+ */
+UCLASS(ClassGroup = (Augmenta), meta = (BlueprintSpawnableComponent))
+class AUGMENTAUNREAL_API UAugmentaObjectPoolComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UAugmentaObjectPoolComponent();
+
+	/** The receiver whose objects are represented, see SetReceiver. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Augmenta|Pool")
+	TObjectPtr<UAugmentaReceiver> Receiver;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Augmenta|Pool")
+	EAugmentaPoolMode Mode = EAugmentaPoolMode::Actors;
+
+	/** The actor spawned for every entry of the pool, in Actors mode. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Augmenta|Pool", meta = (EditCondition = "Mode == EAugmentaPoolMode::Actors"))
+	TSubclassOf<AActor> ActorClass;
+
+	/** The mesh drawn for every object, in Instances mode. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Augmenta|Pool", meta = (EditCondition = "Mode == EAugmentaPoolMode::Instances"))
+	TObjectPtr<UStaticMesh> InstanceMesh;
+
+	/** The number of entries created when play begins. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Augmenta|Pool", meta = (ClampMin = "1"))
+	int32 PoolSize = 64;
+
+	/** Whether the pool grows by PoolSize entries when it runs out, instead of leaving the extra objects unrepresented. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Augmenta|Pool")
+	bool bAllowPoolGrowth = true;
+
+	/** The number of world units per meter of the Augmenta scene. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Pool")
+	float MetersToUnits = 100.f;
+
+	/** Whether to place the objects at their smoothed centroid, when the receiver smooths the objects (see UAugmentaReceiver::bSmoothObjects). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Pool")
+	bool bUseSmoothedPositions = true;
+
+	/** Whether to turn the entries by the orientation of the objects, around the up axis of this component. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Pool")
+	bool bApplyOrientation = false;
+
+	/** A delegate that is fired when an entry of the pool starts representing an Augmenta Object. Actor is nullptr in Instances mode, InstanceIndex is INDEX_NONE in Actors mode. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Pool")
+	FAugmentaPooledObjectEvent OnObjectAcquired;
+
+	/** A delegate that is fired when an entry of the pool returns to the pool, after its Augmenta Object left. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Pool")
+	FAugmentaPooledObjectEvent OnObjectReleased;
+
+	/** Sets the receiver whose objects are represented, returning every entry to the pool. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Pool")
+	void SetReceiver(UAugmentaReceiver* InReceiver);
+
+	/** Returns the actor representing an object, or nullptr if there is none. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Pool")
+	AActor* GetObjectActor(int32 Id) const;
+
+	/** Returns the instance representing an object, or INDEX_NONE if there is none. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Pool")
+	int32 GetObjectInstance(int32 Id) const;
+
+	/** Returns the number of entries representing an object. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Pool")
+	int32 GetNumActiveEntries() const { return ActivePids.Num(); }
+
+	/** The component drawing the instances, nullptr in Actors mode. */
+	UInstancedStaticMeshComponent* GetInstancedMeshComponent() const { return InstancedMesh; }
+
+	//~ Begin UActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	//~ End UActorComponent interface
+
+private:
+	/** Adds entries to the pool. */
+	void GrowPool(int32 NumNewEntries);
+
+	/** Destroys every entry of the pool. */
+	void DestroyPool();
+
+	/** Gives a free entry to an object. Returns the active slot of the object, or INDEX_NONE if the pool is empty. */
+	int32 Acquire(const FAugmentaPerson& Object);
+
+	/** Returns the entry of an active slot to the pool, moving the last active slot into it. */
+	void Release(int32 ActiveSlot);
+
+	/** Returns every entry to the pool. */
+	void ReleaseAll();
+
+	/** Hides a free entry. */
+	void HideEntry(int32 Entry);
+
+	/** The transform of an object at a world centroid. */
+	FTransform GetEntryTransform(const FAugmentaPerson& Object, const FVector& Location) const;
+
+	/** The pooled actors, in Actors mode. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AActor>> PooledActors;
+
+	/** The component drawing the pooled instances, in Instances mode. */
+	UPROPERTY(Transient)
+	TObjectPtr<UInstancedStaticMeshComponent> InstancedMesh;
+
+	/** The number of entries of the pool, free or in use. */
+	int32 NumEntries = 0;
+	/** The entries not representing any object. */
+	TArray<int32> FreeEntries;
+
+	/** The objects represented, by active slot : their Pid, their entry and the last update they were seen by. */
+	FAugmentaIdIndex ActiveIndex;
+	TArray<int32> ActivePids;
+	TArray<int32> ActiveEntries;
+	TArray<uint32> ActiveStamps;
+	/** The last object represented by every active slot, given to OnObjectReleased. */
+	TArray<FAugmentaPerson> ActiveObjects;
+	uint32 UpdateStamp = 0;
+
+	/** Scratch arrays reused by every tick. */
+	TArray<float> WorldCoordinates;
+	TArray<FTransform> InstanceTransforms;
+	bool bInstancesDirty = false;
+};
@@ -0,0 +1,541 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaData.h"
+#include "AugmentaOSCDecoder.h"
+#include "AugmentaSpatialGrid.h"
+
+/**
+ * An open addressing hash index mapping Augmenta ids to slots.
+ * The entries are stored in a single flat array so that copying the index is a memcpy.
+ */
+class AUGMENTAUNREAL_API FAugmentaIdIndex
+{
+public:
+	/** Returns the slot of the given id, or INDEX_NONE if the id is not in the index. */
+	int32 Find(int32 Id) const;
+
+	/** Adds an id that is not in the index yet. */
+	void Add(int32 Id, int32 Slot);
+
+	/** Changes the slot of an id already in the index. */
+	void Update(int32 Id, int32 Slot);
+
+	/** Removes an id from the index. Returns false if it was not in the index. */
+	bool Remove(int32 Id);
+
+	/** Removes every id, keeping the allocation. */
+	void Reset();
+
+	/** Copies another index, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaIdIndex& Other);
+
+	SIZE_T GetAllocatedSize() const { return Entries.GetAllocatedSize(); }
+
+private:
+	struct FEntry
+	{
+		int32 Id;
+		/** INDEX_NONE for an empty entry. */
+		int32 Slot;
+	};
+
+	/** Returns the preferred entry of the given id. */
+	uint32 GetHomeIndex(int32 Id) const;
+
+	/** Doubles the number of entries, keeping the load factor under one half. */
+	void Grow();
+
+	TArray<FEntry> Entries;
+	int32 NumIds = 0;
+	uint32 Mask = 0;
+};
+
+/**
+ * A map from Augmenta ids to values, stored densely in a single array updated in place.
+ * Removing a value moves the last value into its slot, so slots are not stable across removals.
+ */
+template<typename ValueType>
+class TAugmentaSlotMap
+{
+public:
+	/** Returns the value with the given id, or nullptr if there is none. */
+	ValueType* Find(int32 Id)
+	{
+		const int32 Slot = Index.Find(Id);
+		return Slot != INDEX_NONE ? &Values[Slot] : nullptr;
+	}
+
+	const ValueType* Find(int32 Id) const
+	{
+		const int32 Slot = Index.Find(Id);
+		return Slot != INDEX_NONE ? &Values[Slot] : nullptr;
+	}
+
+	/** Returns the slot of the value with the given id, or INDEX_NONE if there is none. */
+	int32 FindSlot(int32 Id) const
+	{
+		return Index.Find(Id);
+	}
+
+	/**
+	 * Returns the slot of the value with the given id, adding a default constructed value if there is none.
+	 *
+	 * @param Id The id of the value.
+	 * @param bOutAdded Set to whether the value was added.
+	 */
+	int32 FindOrAddSlot(int32 Id, bool& bOutAdded)
+	{
+		int32 Slot = Index.Find(Id);
+		bOutAdded = Slot == INDEX_NONE;
+		if (bOutAdded)
+		{
+			Slot = Values.AddDefaulted();
+			Ids.Add(Id);
+			Index.Add(Id, Slot);
+		}
+		return Slot;
+	}
+
+	/** Returns the value with the given id, adding a default constructed value if there is none. */
+	ValueType& FindOrAdd(int32 Id, bool& bOutAdded)
+	{
+		return Values[FindOrAddSlot(Id, bOutAdded)];
+	}
+
+	/**
+	 * Removes the value with the given id, moving the last value into its slot.
+	 *
+	 * @param Id The id of the value to remove.
+	 * @param OutValue Set to the removed value, if any.
+	 * @param OutSlot Set to the slot of the removed value, which now holds the value previously in the last slot.
+	 *
+	 * @return false if there was no value with the given id.
+	 */
+	bool Remove(int32 Id, ValueType& OutValue, int32& OutSlot)
+	{
+		const int32 Slot = Index.Find(Id);
+		if (Slot == INDEX_NONE)
+		{
+			return false;
+		}
+
+		OutValue = MoveTemp(Values[Slot]);
+		OutSlot = Slot;
+
+		Index.Remove(Id);
+		const int32 LastSlot = Values.Num() - 1;
+		if (Slot != LastSlot)
+		{
+			Values[Slot] = MoveTemp(Values[LastSlot]);
+			Ids[Slot] = Ids[LastSlot];
+			Index.Update(Ids[Slot], Slot);
+		}
+		Values.RemoveAt(LastSlot, 1, false);
+		Ids.RemoveAt(LastSlot, 1, false);
+		return true;
+	}
+
+	/** Removes every value, keeping the allocations. */
+	void Reset()
+	{
+		Values.Reset();
+		Ids.Reset();
+		Index.Reset();
+	}
+
+	/** Copies another map, only reallocating if this one is too small. */
+	void CopyFrom(const TAugmentaSlotMap& Other)
+	{
+		Values.Reset();
+		Values.Append(Other.Values);
+		Ids.Reset();
+		Ids.Append(Other.Ids);
+		Index.CopyFrom(Other.Index);
+	}
+
+	int32 Num() const { return Values.Num(); }
+
+	/** The values, densely packed. */
+	TConstArrayView<ValueType> GetValues() const { return Values; }
+	/** The ids of the values, in the same order as the values. */
+	TConstArrayView<int32> GetIds() const { return Ids; }
+
+	ValueType& GetValue(int32 Slot) { return Values[Slot]; }
+	const ValueType& GetValue(int32 Slot) const { return Values[Slot]; }
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Values.GetAllocatedSize() + Ids.GetAllocatedSize() + Index.GetAllocatedSize();
+	}
+
+private:
+	TArray<ValueType> Values;
+	TArray<int32> Ids;
+	FAugmentaIdIndex Index;
+};
+
+/**
+ * A doubly linked list threaded through the slots of a TAugmentaSlotMap, with one link per slot.
+ * Every operation is constant time, and the links are moved along with the values on swap removals.
+ */
+class AUGMENTAUNREAL_API FAugmentaSlotList
+{
+public:
+	/** Appends a link for a new slot, which must be the next slot of the map, and links it at the tail. */
+	void AddTail(int32 Slot);
+
+	/**
+	 * Appends a link for a new slot, which must be the next slot of the map, and links it after another slot.
+	 *
+	 * @param Slot The new slot.
+	 * @param PrevSlot The slot to link it after, INDEX_NONE to link it at the head.
+	 */
+	void AddAfter(int32 Slot, int32 PrevSlot);
+
+	/** Moves a linked slot to the tail of the list. */
+	void MoveToTail(int32 Slot);
+
+	/**
+	 * Unlinks a slot removed from the map, then moves the link of the last slot into it the way the map moved its value.
+	 *
+	 * @param Slot The removed slot.
+	 * @param LastSlot The last slot of the map before the removal.
+	 */
+	void RemoveSwap(int32 Slot, int32 LastSlot);
+
+	/** Removes every link, keeping the allocation. */
+	void Reset();
+
+	/** Copies another list, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaSlotList& Other);
+
+	/** The first slot of the list, INDEX_NONE if the list is empty. */
+	int32 GetHead() const { return Head; }
+	/** The last slot of the list, INDEX_NONE if the list is empty. */
+	int32 GetTail() const { return Tail; }
+	/** The slot after the given one, INDEX_NONE at the tail. */
+	int32 GetNext(int32 Slot) const { return Links[Slot].Next; }
+	/** The slot before the given one, INDEX_NONE at the head. */
+	int32 GetPrev(int32 Slot) const { return Links[Slot].Prev; }
+
+	SIZE_T GetAllocatedSize() const { return Links.GetAllocatedSize(); }
+
+private:
+	struct FLink
+	{
+		int32 Prev;
+		int32 Next;
+	};
+
+	void Unlink(int32 Slot);
+	void LinkTail(int32 Slot);
+
+	TArray<FLink> Links;
+	int32 Head = INDEX_NONE;
+	int32 Tail = INDEX_NONE;
+};
+
+/** When a tracked object that is not updated anymore is considered lost. A timeout of zero is disabled. */
+struct FAugmentaExpiry
+{
+	/** The number of Augmenta frames without an update after which an object is lost. */
+	int32 TimeoutFrames = 0;
+	/** The number of seconds without an update after which an object is lost. */
+	double TimeoutSeconds = 0.0;
+
+	bool IsEnabled() const { return TimeoutFrames > 0 || TimeoutSeconds > 0.0; }
+};
+
+/**
+ * Orders the slots of a TAugmentaSlotMap from the least to the most recently updated, with the frame and time of
+ * their last update, so that the lost objects are found at the head of the list without scanning the map.
+ */
+class AUGMENTAUNREAL_API FAugmentaUpdateOrder
+{
+public:
+	/**
+	 * Records the update of a slot.
+	 *
+	 * @param Slot The updated slot.
+	 * @param bAdded Whether the slot was just added to the map.
+	 * @param Frame The Augmenta frame number of the update.
+	 * @param Time The time of the update, in seconds.
+	 */
+	void Touch(int32 Slot, bool bAdded, int32 Frame, double Time);
+
+	/** Mirrors a swap removal of the map. */
+	void RemoveSwap(int32 Slot, int32 LastSlot);
+
+	/** Returns the least recently updated slot if it has expired, INDEX_NONE otherwise. */
+	int32 FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry) const;
+
+	/** Records every slot as updated on a frame, e.g. when the sender restarted its frame numbers. The times are kept. */
+	void RebaseFrames(int32 Frame);
+
+	/** Removes every slot, keeping the allocations. */
+	void Reset();
+
+	/** Copies another order, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaUpdateOrder& Other);
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	FAugmentaSlotList List;
+	TArray<int32> Frames;
+	TArray<double> Times;
+};
+
+/** The per object values stored as contiguous float arrays by FAugmentaObjectStore. */
+enum class EAugmentaObjectChannel : uint8
+{
+	CentroidX,
+	CentroidY,
+	VelocityX,
+	VelocityY,
+	BoundingRectPosX,
+	BoundingRectPosY,
+	BoundingRectSizeX,
+	BoundingRectSizeY,
+	Height,
+
+	Num
+};
+
+/** A structure of arrays view of the tracked objects, in the same order as FAugmentaObjectStore::GetObjects. */
+struct FAugmentaObjectsSoA
+{
+	TConstArrayView<float> CentroidX;
+	TConstArrayView<float> CentroidY;
+	TConstArrayView<float> VelocityX;
+	TConstArrayView<float> VelocityY;
+	TConstArrayView<float> BoundingRectPosX;
+	TConstArrayView<float> BoundingRectPosY;
+	TConstArrayView<float> BoundingRectSizeX;
+	TConstArrayView<float> BoundingRectSizeY;
+	TConstArrayView<float> Height;
+
+	int32 Num() const { return CentroidX.Num(); }
+};
+
+/**
+ * The Augmenta Objects being tracked, stored densely with their Pid as the unique key.
+ * Besides the FAugmentaPerson array, the positions and sizes are mirrored in contiguous float arrays
+ * (see EAugmentaObjectChannel) so that they can be processed in bulk with SIMD instructions.
+ * The objects are also kept ordered by age, from the oldest to the newest, so that the age queries are constant time,
+ * and indexed by centroid in a uniform grid for the spatial queries.
+ */
+class AUGMENTAUNREAL_API FAugmentaObjectStore
+{
+public:
+	/** Returns the object with the given Pid, or nullptr if there is none. */
+	const FAugmentaPerson* Find(int32 Pid) const { return Objects.Find(Pid); }
+
+	/** Returns the index of the object with the given Pid into GetObjects, or INDEX_NONE if there is none. */
+	int32 FindSlot(int32 Pid) const { return Objects.FindSlot(Pid); }
+
+	/**
+	 * Applies an object message, adding the object if it is not tracked yet.
+	 *
+	 * @param Message The decoded object message.
+	 * @param Time The time the message was received, in seconds.
+	 * @param bOutAdded Set to whether the object was added.
+	 *
+	 * @return The updated object.
+	 */
+	const FAugmentaPerson& Update(const FAugmentaObjectMessage& Message, double Time, bool& bOutAdded);
+
+	/**
+	 * Removes the object with the given Pid.
+	 *
+	 * @param Pid The Pid of the object to remove.
+	 * @param OutObject Set to the removed object, if any.
+	 *
+	 * @return false if there was no object with the given Pid.
+	 */
+	bool Remove(int32 Pid, FAugmentaPerson& OutObject);
+
+	/** Removes every object, keeping the allocations. */
+	void Reset();
+
+	/** Copies another store, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaObjectStore& Other);
+
+	int32 Num() const { return Objects.Num(); }
+
+	/** The objects, densely packed in no particular order. */
+	TConstArrayView<FAugmentaPerson> GetObjects() const { return Objects.GetValues(); }
+
+	/** The values of one channel for every object, in the same order as GetObjects. */
+	TConstArrayView<float> GetChannel(EAugmentaObjectChannel Channel) const { return Channels[static_cast<int32>(Channel)]; }
+
+	/** A structure of arrays view of the objects, in the same order as GetObjects. */
+	FAugmentaObjectsSoA GetSoA() const;
+
+	/**
+	 * Finds the least recently updated object if it has expired.
+	 *
+	 * @param CurrentFrame The current Augmenta frame number.
+	 * @param Now The current time, in seconds.
+	 * @param Expiry When an object is considered lost.
+	 * @param OutPid Set to the Pid of the expired object, if any.
+	 *
+	 * @return false if no object has expired.
+	 */
+	bool FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry, int32& OutPid) const;
+
+	/**
+	 * Records every object as updated on a frame, so that the frame timeout counts from it. Called when the sender
+	 * restarted its frame numbers, which would otherwise be far below the ones stored and never expire the objects.
+	 */
+	void RebaseFrames(int32 Frame) { UpdateOrder.RebaseFrames(Frame); }
+
+	/** Returns the object with the highest age, or nullptr if there is none. */
+	const FAugmentaPerson* GetOldest() const;
+
+	/** Returns the object with the lowest age, or nullptr if there is none. */
+	const FAugmentaPerson* GetNewest() const;
+
+	/**
+	 * Adds the oldest objects to an array, from the oldest to the newest.
+	 *
+	 * @param Count The maximum number of objects to add.
+	 * @param OutObjects The array the objects are added to.
+	 */
+	void GetNOldest(int32 Count, TArray<FAugmentaPerson>& OutObjects) const;
+
+	/**
+	 * Adds the newest objects to an array, from the newest to the oldest.
+	 *
+	 * @param Count The maximum number of objects to add.
+	 * @param OutObjects The array the objects are added to.
+	 */
+	void GetNNewest(int32 Count, TArray<FAugmentaPerson>& OutObjects) const;
+
+	/**
+	 * The spatial queries below use normalized positions, like FAugmentaPerson::Centroid, and measure distances after
+	 * scaling them, e.g. by the scene size to measure them in meters. Found objects are added to OutSlots as indices
+	 * into GetObjects.
+	 */
+
+	/** Finds the objects whose centroid is inside a rectangle. */
+	void FindInRect(const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots) const;
+
+	/** Finds the objects whose centroid is within a distance of a point. */
+	void FindInRadius(const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots) const;
+
+	/** Finds the objects whose centroid is nearest to a point, from the nearest to the farthest. */
+	void FindNearest(const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots) const;
+
+	/** Finds every pair of objects whose centroids are within a distance of each other. */
+	void FindPairs(float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs) const;
+
+	/** The grid indexing the objects by centroid. */
+	const FAugmentaSpatialGrid& GetSpatialGrid() const { return SpatialGrid; }
+
+	/** Returns the scale measuring the distances between normalized positions in meters, or in normalized units until the scene size is known. */
+	static FVector2f GetDistanceScale(const FAugmentaScene& Scene)
+	{
+		return Scene.SceneSize.X > 0.0 && Scene.SceneSize.Y > 0.0 ? FVector2f(Scene.SceneSize) : FVector2f(1.f, 1.f);
+	}
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static constexpr int32 NumChannels = static_cast<int32>(EAugmentaObjectChannel::Num);
+
+	/** Links a new object into the age order. */
+	void AddToAgeOrder(int32 Slot);
+
+	TAugmentaSlotMap<FAugmentaPerson> Objects;
+	TArray<float> Channels[NumChannels];
+	FAugmentaUpdateOrder UpdateOrder;
+	/** The objects from the oldest (head) to the newest (tail). */
+	FAugmentaSlotList AgeOrder;
+	FAugmentaSpatialGrid SpatialGrid;
+};
+
+/** The Augmenta Objects extra data, stored densely with their id as the unique key. */
+class AUGMENTAUNREAL_API FAugmentaObjectExtraStore
+{
+public:
+	/** Returns the extra data with the given id, or nullptr if there is none. */
+	const FAugmentaObjectExtra* Find(int32 Id) const { return Extras.Find(Id); }
+
+	/**
+	 * Applies an extra data message, adding the extra data if it is not tracked yet.
+	 *
+	 * @param Message The decoded extra data message.
+	 * @param Time The time the message was received, in seconds.
+	 * @param bOutAdded Set to whether the extra data was added.
+	 *
+	 * @return The updated extra data.
+	 */
+	const FAugmentaObjectExtra& Update(const FAugmentaObjectExtraMessage& Message, double Time, bool& bOutAdded);
+
+	/**
+	 * Removes the extra data with the given id.
+	 *
+	 * @param Id The id of the extra data to remove.
+	 * @param OutExtra Set to the removed extra data, if any.
+	 *
+	 * @return false if there was no extra data with the given id.
+	 */
+	bool Remove(int32 Id, FAugmentaObjectExtra& OutExtra);
+
+	/** Removes every extra data, keeping the allocations. */
+	void Reset();
+
+	/** Copies another store, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaObjectExtraStore& Other);
+
+	int32 Num() const { return Extras.Num(); }
+
+	/** The extra data, densely packed in no particular order. */
+	TConstArrayView<FAugmentaObjectExtra> GetExtras() const { return Extras.GetValues(); }
+
+	/** Finds the least recently updated extra data if it has expired. See FAugmentaObjectStore::FindExpired. */
+	bool FindExpired(int32 CurrentFrame, double Now, const FAugmentaExpiry& Expiry, int32& OutId) const;
+
+	/** Records every extra data as updated on a frame. See FAugmentaObjectStore::RebaseFrames. */
+	void RebaseFrames(int32 Frame) { UpdateOrder.RebaseFrames(Frame); }
+
+	SIZE_T GetAllocatedSize() const { return Extras.GetAllocatedSize() + UpdateOrder.GetAllocatedSize(); }
+
+private:
+	TAugmentaSlotMap<FAugmentaObjectExtra> Extras;
+	FAugmentaUpdateOrder UpdateOrder;
+};
+
+/** Bulk conversions of the Augmenta normalized coordinates, processing four objects per SIMD instruction. */
+struct AUGMENTAUNREAL_API FAugmentaBulkTransforms
+{
+	/**
+	 * Converts normalized scene coordinates into meters.
+	 *
+	 * @param X The normalized X coordinates.
+	 * @param Y The normalized Y coordinates.
+	 * @param SceneSize The size of the scene in meters (see FAugmentaScene::SceneSize).
+	 * @param OutX The X coordinates in meters, must be as large as X.
+	 * @param OutY The Y coordinates in meters, must be as large as Y.
+	 */
+	static void NormalizedToMeters(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2D& SceneSize, TArrayView<float> OutX, TArrayView<float> OutY);
+
+	/**
+	 * Converts normalized scene coordinates into world space. The point at (X * SceneSize.X, Y * SceneSize.Y, 0) in meters
+	 * is transformed by SceneToWorld.
+	 *
+	 * @param X The normalized X coordinates.
+	 * @param Y The normalized Y coordinates.
+	 * @param SceneSize The size of the scene in meters (see FAugmentaScene::SceneSize).
+	 * @param SceneToWorld The transform from the scene in meters to the world.
+	 * @param OutX The world X coordinates, must be as large as X.
+	 * @param OutY The world Y coordinates, must be as large as X.
+	 * @param OutZ The world Z coordinates, must be as large as X.
+	 */
+	static void NormalizedToWorld(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2D& SceneSize, const FTransform& SceneToWorld,
+		TArrayView<float> OutX, TArrayView<float> OutY, TArrayView<float> OutZ);
+};
@@ -3,28 +3,54 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "OSCMessage.h"
+#include "Tickable.h"
+#include "AugmentaAnalytics.h"
 #include "AugmentaData.h"
+#include "AugmentaDensityMap.h"
+#include "AugmentaEventCoalescer.h"
+#include "AugmentaFusion.h"
+#include "AugmentaRecording.h"
+#include "AugmentaSmoother.h"
+#include "AugmentaStats.h"
+#include "AugmentaSubscriptions.h"
+#include "AugmentaTracker.h"
 #include "AugmentaReceiver.generated.h"
 
 /** Forward Declarations */
-class UOSCServer;
+struct FAugmentaSource;
+class FAugmentaAnalyticsWriter;
+class FAugmentaClusterPublisher;
+class FAugmentaReceiveWorker;
+class FAugmentaReplayWorker;
+class FAugmentaSharedEndpoint;
+class UAugmentaZoneManager;
+class UTexture2D;
+class FInternetAddr;
+class FSocket;
 
 /** Delegates */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSceneUpdatedEvent, const FAugmentaScene, Scene);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FPersonUpdatedEvent, const FAugmentaPerson, Person);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FVideoOutputUpdatedEvent, const FAugmentaVideoOutput, VideoOutput);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FExtraDataEvent, const FAugmentaObjectExtra, ExtraData);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFrameObjectsEvent, const TArray<FAugmentaPerson>&, Objects);
+
+/** Native Delegates */
+DECLARE_MULTICAST_DELEGATE_OneParam(FAugmentaFrameObjectsNativeEvent, TConstArrayView<FAugmentaPerson>);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FAugmentaFrameNativeEvent, const FAugmentaFrameSnapshot&, const FAugmentaFrameEvents&);
 
 /**
  * A child class of UObject that is responsible for :
- * - Connecting to the OSCServer with the given Ip Address and Port.
- * - Processing the OSC Messages received from the Augmenta Fusion or the Augmenta Node(s) and for firing off the OnSceneUpdated, 
-     OnPersonEntered, OnPersonUpdated and OnPersonWillLeave events that can be used in Blueprints.
- * - Stopping/disconnecting the connection to the OSCServer.
+ * - Listening to the UDP socket with the given Ip Address and Port.
+ * - Decoding the OSC Messages received from the Augmenta Fusion or the Augmenta Node(s) with FAugmentaTracker and for firing off
+     the OnSceneUpdated, OnPersonEntered, OnPersonUpdated and OnPersonWillLeave events that can be used in Blueprints.
+ * - Merging several Augmenta nodes or ports into a single scene, see ConnectSources.
+ * - Sharing a socket with the other receivers listening to the same port, see ConnectShared.
+ * - Redistributing the tracking state to the other nodes of a render cluster, see StartClusterPublisher.
+ * - Stopping/disconnecting the UDP socket.
  */
 UCLASS(BlueprintType, Category = "Augmenta")
-class AUGMENTAUNREAL_API UAugmentaReceiver : public UObject
+class AUGMENTAUNREAL_API UAugmentaReceiver : public UObject, public FTickableGameObject
 {
 	GENERATED_BODY()
 
@@ -35,7 +61,7 @@ public:
 	~UAugmentaReceiver();
 
 	/** 
-	 * Connects to the OSCServer with the given ip address and port.
+	 * Opens the UDP socket receiving the OSC Messages with the given ip address and port.
 	 * 
 	 * @param ReceiveIPAddress The ip address of the device to connect to get the OSC Messages.
 	 * @param Port The port of the device to listen to, to get the OSC Messages.
@@ -43,12 +69,74 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Augmenta")
 	void Connect(FString ReceiveIPAddress, int32 Port);
 
-	/** Stops the connection with the OSCServer. */
+	/** Closes the UDP socket, or detaches from the shared endpoint. */
 	UFUNCTION(BlueprintCallable, Category = "Augmenta")
 	void Stop();
 
 	/**
-	 * Creates an instance of the UAugmentaReceiver and connects to the OSCServer with the given details.
+	 * Attaches to the endpoint receiving on the given ip address and port, shared by every receiver connected to it this way
+	 * (see UAugmentaSubsystem). The endpoint is received and decoded once, on its own thread and in frame assembly mode,
+	 * and its frames are read by every attached receiver without being copied. Each receiver keeps its own delegates,
+	 * smoothing, zones and analytics. The endpoint is closed once the last receiver attached to it stops.
+	 *
+	 * A receiver attaching to an endpoint that is already receiving starts from its last frame, whose objects enter on the
+	 * next tick. The object timeouts of the first receiver are used. The shared endpoints are not recorded.
+	 *
+	 * @param ReceiveIPAddress The ip address of the device to connect to get the OSC Messages.
+	 * @param Port The port of the device to listen to, to get the OSC Messages.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta")
+	void ConnectShared(FString ReceiveIPAddress, int32 Port);
+
+	/**
+	 * Listens to several Augmenta nodes or ports at once and merges them into a single scene, replacing the current
+	 * socket or replay. Every source is received and decoded on its own thread, in frame assembly mode, and their last
+	 * complete frames are fused once per tick (see FAugmentaFusion). The getters, events and zones then use the fused
+	 * scene, whose objects have their own Pids. The sources are not recorded.
+	 *
+	 * @param SourceSettings The sources and where their scene is placed in the shared space. At most 32.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Fusion")
+	void ConnectSources(const TArray<FAugmentaSourceSettings>& SourceSettings);
+
+	/**
+	 * Re-publishes the tracking state of this receiver, the primary, to the secondary receivers of a render cluster, replacing the
+	 * current publisher if any. Every tick the state changed, its objects are sent as a delta against the last published state,
+	 * quantized and keyed by the Augmenta Frame (see AugmentaClusterProtocol), with a keyframe every ClusterKeyframeInterval frames.
+	 *
+	 * The secondaries simply Connect to the destination address and port, preferably in frame assembly mode. They apply a frame
+	 * as a whole or not at all, so they all hold the same objects for the same Frame, and recover from a lost packet or a late
+	 * start at the next keyframe. Their object timeouts should be disabled, the objects that do not change are not sent.
+	 *
+	 * @param DestinationAddress The ip address of the secondaries, a multicast group to reach several of them or several processes on the same host.
+	 * @param Port The port the secondaries are listening to.
+	 *
+	 * @return true if the socket was opened.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Cluster")
+	bool StartClusterPublisher(FString DestinationAddress, int32 Port);
+
+	/** Stops re-publishing the tracking state to the secondaries. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Cluster")
+	void StopClusterPublisher();
+
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Cluster")
+	bool IsPublishingCluster() const;
+
+	/** The number of published frames between two keyframes, which the secondaries that lost a packet wait for. Must be set before StartClusterPublisher. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Cluster", meta = (ClampMin = "1"))
+	int32 ClusterKeyframeInterval = 60;
+
+	/** The distance under which the objects seen by two sources are merged (in m). Must be set before ConnectSources. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Fusion", meta = (ClampMin = "0"))
+	float SourceMergeDistance = 0.5f;
+
+	/** The size of the shared space of the sources (in m). Zero fits it to the source scenes. Must be set before ConnectSources. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Fusion")
+	FVector2D FusedSceneSize = FVector2D::ZeroVector;
+
+	/**
+	 * Creates an instance of the UAugmentaReceiver and opens the UDP socket with the given details.
 	 *
 	 * @param ReceiveIPAddress The ip address of the device to connect to get the OSC Messages.
 	 * @param Port The port of the device to listen to, to get the OSC Messages.
@@ -58,6 +146,166 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Augmenta")
 	static UAugmentaReceiver* CreateAugmentaReceiver(FString ReceiveIPAddress, int32 Port);
 
+	/**
+	 * Creates an instance of the UAugmentaReceiver attached to the endpoint shared by the receivers listening to the
+	 * same ip address and port, see ConnectShared.
+	 *
+	 * @param ReceiveIPAddress The ip address of the device to connect to get the OSC Messages.
+	 * @param Port The port of the device to listen to, to get the OSC Messages.
+	 *
+	 * @return UAugmentaReceiver* A pointer to the created instance of UAugmentaReceiver.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta")
+	static UAugmentaReceiver* CreateSharedAugmentaReceiver(FString ReceiveIPAddress, int32 Port);
+
+	/**
+	 * Starts recording the received datagrams, with their timestamp, into a file that can be replayed with StartReplay.
+	 * Replaces the current recording if any.
+	 *
+	 * @param Filename The path of the recording file.
+	 *
+	 * @return true if the file was created.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Recording")
+	bool StartRecording(FString Filename);
+
+	/** Stops recording and writes the index of the recording. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Recording")
+	void StopRecording();
+
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Recording")
+	bool IsRecording() const;
+
+	/**
+	 * Replays a recording in place of the socket, closing the socket if it is open. The recorded datagrams go through the
+	 * same decode path as the received ones, on a dedicated thread and in frame assembly mode.
+	 *
+	 * @param Filename The path of the recording file.
+	 * @param PlaybackRate The speed of the replay, 1 for real time. Zero replays as fast as the receiver ticks, without dropping any frame.
+	 * @param bLoop Whether the replay starts over once the end of the recording is reached.
+	 *
+	 * @return true if the recording was opened.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Recording")
+	bool StartReplay(FString Filename, float PlaybackRate = 1.f, bool bLoop = false);
+
+	/** Continues the replay from the given time, in seconds since the start of the recording. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Recording")
+	void SeekReplay(float Time);
+
+	/** Returns whether a recording is being replayed and has not reached its end. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Recording")
+	bool IsReplaying() const;
+
+	/** Returns the time of the last replayed datagram, in seconds since the start of the recording. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Recording")
+	float GetReplayTime() const;
+
+	/**
+	 * Whether the messages are assembled into complete frames before being exposed. Must be set before Connect.
+	 * When enabled, the getters return a read only snapshot of the last complete frame and the events of a frame
+	 * are fired once all of its messages have been received, i.e. when the first message of the next frame arrives.
+	 * When disabled, every message is applied and fired as soon as it is received.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta")
+	bool bFrameAssembly = false;
+
+	/**
+	 * Whether the datagrams are received, decoded and applied to the tracking state on a dedicated thread
+	 * instead of the game thread. Must be set before Connect. Implies frame assembly : the game thread only
+	 * publishes the complete frames and fires their events.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta")
+	bool bDecodeOnReceiveThread = false;
+
+	/**
+	 * Whether the events received within a tick are merged before being fired, so that an object updated by several datagrams
+	 * or frames since the last tick fires a single update with its newest state. Enter and leave events are always fired.
+	 * Useful when the sender runs faster than the game, see FAugmentaReceiverCounters::CoalescedEvents.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta")
+	bool bCoalesceEvents = false;
+
+	/**
+	 * The number of Augmenta frames without an update after which an object is considered lost, e.g. because its leave
+	 * message was dropped. Lost objects are removed and fire the usual leave events. Zero disables it. Must be set before Connect.
+	 * Ignored when receiving the cluster stream of a primary (see StartClusterPublisher), which carries its leaves.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta", meta = (ClampMin = "0"))
+	int32 ObjectTimeoutFrames = 0;
+
+	/**
+	 * The number of seconds without an update after which an object is considered lost, e.g. because its leave message
+	 * was dropped or the sender stopped. Lost objects are removed and fire the usual leave events. Zero disables it.
+	 * Must be set before Connect. Ignored when receiving the cluster stream of a primary, like ObjectTimeoutFrames.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta", meta = (ClampMin = "0"))
+	float ObjectTimeoutSeconds = 0.f;
+
+	/**
+	 * Whether the motion of the Augmenta Objects is smoothed between the network frames, so that actors move at the render
+	 * frame rate. The smoothed objects are sampled once per tick, see GetSmoothedObjectsArray and FAugmentaSmoother.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Smoothing")
+	bool bSmoothObjects = false;
+
+	/**
+	 * How far in the past the smoothed objects are sampled (in s), so that they are interpolated between two received frames.
+	 * Around one or two frame periods gives a continuous motion. Zero only extrapolates from the last frame.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Smoothing", meta = (ClampMin = "0"))
+	float SmoothingDelay = 0.04f;
+
+	/** How far past its last frame a smoothed object keeps moving with its velocity (in s). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Smoothing", meta = (ClampMin = "0"))
+	float MaxExtrapolationTime = 0.1f;
+
+	/**
+	 * Whether a map of the occupancy of the scene is updated once per tick from the objects, for floor-reactive visuals.
+	 * See GetDensityTexture, GetDensityAt and FAugmentaDensityMap.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Density")
+	bool bComputeDensityMap = false;
+
+	/** The number of cells of the density map, covering the whole scene. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Density", meta = (ClampMin = "1", ClampMax = "2048"))
+	FIntPoint DensityMapResolution = FIntPoint(128, 128);
+
+	/** The time for the density left by an object to decay to 37% of its value (in s). Zero only shows the current objects. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Density", meta = (ClampMin = "0"))
+	float DensityDecayTime = 1.f;
+
+	/** Whether the density map is uploaded to a float texture once per tick, see GetDensityTexture. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Density")
+	bool bUploadDensityTexture = false;
+
+	/**
+	 * Whether the visitors are analyzed : visitor counts, entries and exits per minute, dwell times, speeds and trajectories.
+	 * See GetAnalyticsSummary, GetObjectTrajectory, StartAnalyticsStream and FAugmentaAnalytics. Must be set before Connect.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Analytics")
+	bool bComputeAnalytics = false;
+
+	/** The number of objects whose trajectory is kept, allocated once on Connect. Must be set before Connect. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Analytics", meta = (ClampMin = "0"))
+	int32 MaxTrajectories = 1024;
+
+	/** The number of positions kept per trajectory, the oldest ones are overwritten. Must be set before Connect. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Analytics", meta = (ClampMin = "1"))
+	int32 TrajectoryLength = 256;
+
+	/** The duration covered by every bin of the dwell time histogram (in s). Must be set before Connect. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Analytics", meta = (ClampMin = "0.1"))
+	float DwellHistogramBinDuration = 10.f;
+
+	/** The number of bins of the dwell time histogram, the last one counting every longer dwell time. Must be set before Connect. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Analytics", meta = (ClampMin = "1"))
+	int32 DwellHistogramNumBins = 30;
+
+	/** The zones evaluated against the Augmenta Objects once per tick. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Augmenta")
+	TObjectPtr<UAugmentaZoneManager> ZoneManager;
+
 	/** A delegate that is fired when an Augmenta scene OSC Message is received. */
 	UPROPERTY(BlueprintAssignable, Category = "Augmenta")
 	FSceneUpdatedEvent OnSceneUpdated;
@@ -90,10 +338,68 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Augmenta")
 	FExtraDataEvent OnLeaveExtraData;
 
-	/** Returns if the OSCServer is active and connected. */
+	/**
+	 * A delegate that is fired once per frame with every Augmenta Object that entered during the frame.
+	 * In immediate mode, it is fired once per received datagram instead.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta")
+	FFrameObjectsEvent OnFrameObjectsEntered;
+
+	/**
+	 * A delegate that is fired once per frame with every Augmenta Object updated during the frame.
+	 * In immediate mode, it is fired once per received datagram instead.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta")
+	FFrameObjectsEvent OnFrameObjectsUpdated;
+
+	/**
+	 * A delegate that is fired once per frame with every Augmenta Object that left during the frame.
+	 * In immediate mode, it is fired once per received datagram instead.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta")
+	FFrameObjectsEvent OnFrameObjectsLeft;
+
+	/** Native equivalent of OnFrameObjectsEntered, without copying the objects. */
+	FAugmentaFrameObjectsNativeEvent OnFrameObjectsEnteredNative;
+	/** Native equivalent of OnFrameObjectsUpdated, without copying the objects. */
+	FAugmentaFrameObjectsNativeEvent OnFrameObjectsUpdatedNative;
+	/** Native equivalent of OnFrameObjectsLeft, without copying the objects. */
+	FAugmentaFrameObjectsNativeEvent OnFrameObjectsLeftNative;
+
+	/**
+	 * A native delegate that is fired once per frame, before any other delegate, with the tracking state and every
+	 * change of the frame. In immediate mode, it is fired once per received datagram with the live state instead.
+	 */
+	FAugmentaFrameNativeEvent OnFrameNative;
+
+	/**
+	 * Subscribes a delegate to the Augmenta Objects matching a filter, fired after the other delegates. The filter is
+	 * evaluated natively : the delegate is only fired when an object enters or leaves the filter, or when a field changed
+	 * by more than its dead-band since it was last fired, with the mask of the changes (see EAugmentaObjectChange).
+	 *
+	 * @param Filter The objects and the changes the delegate is fired for.
+	 * @param Delegate The delegate to fire.
+	 *
+	 * @return The id to unsubscribe with.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Filter")
+	int32 SubscribeToObjects(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectEvent Delegate);
+
+	/** Native equivalent of SubscribeToObjects. */
+	int32 SubscribeToObjectsNative(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent Delegate);
+
+	/** Removes a subscription, returns false if there is no subscription with this id. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Filter")
+	bool UnsubscribeFromObjects(int32 SubscriptionId);
+
+	/** Returns if the UDP socket is open and receiving. */
 	UFUNCTION(BlueprintPure, Category = "Augmenta")
 	bool IsConnected() const;
 
+	/** Returns the port the UDP socket is bound to, e.g. the one picked by the system when connecting to port 0, or 0 if it is not open. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	int32 GetPort() const;
+
 	/** Returns the current Augmenta Scene. */
 	UFUNCTION(BlueprintPure, Category = "Augmenta")
 	FAugmentaScene GetScene() const;
@@ -104,18 +410,34 @@ public:
 
 	/**
 	 * Returns the Augmenta Object that has the lowest age in the scene i.e., 
-	 * the object who recently entered the scene.
+	 * the object who recently entered the scene. Returns a default object if the scene is empty.
 	 */
 	UFUNCTION(BlueprintPure, DisplayName = "GetNewestObject", Category = "Augmenta")
 	FAugmentaPerson GetNewestPerson() const;
 
 	/** 
 	 * Returns the Augmenta Object that has the highest age in the scene i.e., 
-	 * the object who has been there for the longest time.
+	 * the object who has been there for the longest time. Returns a default object if the scene is empty.
 	 */
 	UFUNCTION(BlueprintPure, DisplayName = "GetOldestObject", Category = "Augmenta")
 	FAugmentaPerson GetOldestPerson() const;
 
+	/**
+	 * Returns the Augmenta Objects that have the highest age in the scene, from the oldest to the newest.
+	 *
+	 * @param Count The maximum number of objects to return.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	TArray<FAugmentaPerson> GetNOldestObjects(int32 Count) const;
+
+	/**
+	 * Returns the Augmenta Objects that have the lowest age in the scene, from the newest to the oldest.
+	 *
+	 * @param Count The maximum number of objects to return.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	TArray<FAugmentaPerson> GetNNewestObjects(int32 Count) const;
+
 	/**
 	 * Helper function to find the Object with a given Id.
 	 *
@@ -146,50 +468,269 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Augmenta")
 	bool GetObjectExtra(const int32 Id, FAugmentaObjectExtra& Extra) const;
 
+	/**
+	 * Returns the Augmenta Objects whose centroid is within a distance of a point.
+	 *
+	 * @param Center The normalized position of the point, like the object centroids.
+	 * @param Radius The distance (in m), or in normalized units until the scene size is received.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Spatial")
+	TArray<FAugmentaPerson> GetObjectsInRadius(FVector2D Center, float Radius) const;
+
+	/**
+	 * Returns the Augmenta Objects whose centroid is inside a rectangle.
+	 *
+	 * @param Min The normalized minimum corner of the rectangle.
+	 * @param Max The normalized maximum corner of the rectangle.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Spatial")
+	TArray<FAugmentaPerson> GetObjectsInRect(FVector2D Min, FVector2D Max) const;
+
+	/**
+	 * Returns the Augmenta Objects whose centroid is nearest to a point, from the nearest to the farthest.
+	 *
+	 * @param Point The normalized position of the point, like the object centroids.
+	 * @param Count The maximum number of objects to return.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Spatial")
+	TArray<FAugmentaPerson> GetNearestObjects(FVector2D Point, int32 Count) const;
+
+	/**
+	 * Returns every pair of Augmenta Objects whose centroids are within a distance of each other.
+	 *
+	 * @param Distance The distance (in m), or in normalized units until the scene size is received.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Spatial")
+	TArray<FAugmentaObjectPair> GetObjectPairsWithinDistance(float Distance) const;
+
+	/**
+	 * Converts the centroids of every Augmenta Object being tracked into world space in a single vectorized pass.
+	 * The centroids are scaled by the scene size into meters, then transformed by SceneToWorld.
+	 *
+	 * @param SceneToWorld The transform from the Augmenta scene in meters to the world.
+	 * @param Centroids The world centroids, in the same order as GetObjectsArray.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta")
+	void GetObjectsWorldCentroids(const FTransform& SceneToWorld, TArray<FVector>& Centroids) const;
+
+	/**
+	 * Returns the Augmenta Objects being tracked with their centroid and bounding rect moved to their smoothed position,
+	 * in the same order as GetObjectsArray. The objects are not moved unless bSmoothObjects is enabled.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Smoothing")
+	TArray<FAugmentaPerson> GetSmoothedObjectsArray() const;
+
+	/**
+	 * Helper function to find the smoothed Object with a given Id.
+	 *
+	 * @param Id The Id used to find the Augmenta Object.
+	 * @param Object The Augmenta Object with the given Id, at its smoothed position, if successful.
+	 *
+	 * @return true if successful, false otherwise.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Smoothing")
+	bool GetSmoothedObject(const int32 Id, FAugmentaPerson& Object) const;
+
+	/**
+	 * Converts the smoothed centroids of every Augmenta Object into world space in a single vectorized pass, like GetObjectsWorldCentroids.
+	 *
+	 * @param SceneToWorld The transform from the Augmenta scene in meters to the world.
+	 * @param Ids The Ids of the objects, in the same order as the centroids.
+	 * @param Centroids The smoothed world centroids.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Smoothing")
+	void GetSmoothedObjectsWorldCentroids(const FTransform& SceneToWorld, TArray<int32>& Ids, TArray<FVector>& Centroids) const;
+
+	/** The smoothed centroids of the last tick, as contiguous arrays. Empty unless bSmoothObjects is enabled. */
+	const FAugmentaSmoother& GetSmoother() const { return Smoother; }
+
+	/**
+	 * Returns the density map as a single channel float texture, one texel per cell, with the top left of the scene at UV (0, 0).
+	 * Null unless bComputeDensityMap and bUploadDensityTexture are enabled.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Density")
+	UTexture2D* GetDensityTexture() const;
+
+	/**
+	 * Returns the density at a position of the scene, zero unless bComputeDensityMap is enabled.
+	 *
+	 * @param Position The normalized position, like FAugmentaPerson::Centroid.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Density")
+	float GetDensityAt(const FVector2D& Position) const { return DensityMap.GetValueAt(Position); }
+
+	/** The density map of the last tick, as a contiguous float buffer. Empty unless bComputeDensityMap is enabled. */
+	const FAugmentaDensityMap& GetDensityMap() const { return DensityMap; }
+
+	/** Returns the visitor counts, dwell time, speed and flow of the Augmenta Objects, if bComputeAnalytics is enabled. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Analytics")
+	FAugmentaAnalyticsSummary GetAnalyticsSummary() const;
+
+	/** Returns the number of visitors per dwell time bin, see DwellHistogramBinDuration. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Analytics")
+	TArray<int64> GetDwellHistogram() const;
+
+	/**
+	 * Gets the last positions of an Augmenta Object, if bComputeAnalytics is enabled.
+	 *
+	 * @param Id The Id of the Augmenta Object.
+	 * @param Positions The normalized positions, from the oldest to the newest, quantized to 1/65535 of the scene.
+	 *
+	 * @return true if the object has a trajectory, false otherwise.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Analytics")
+	bool GetObjectTrajectory(const int32 Id, TArray<FVector2D>& Positions) const;
+
+	/**
+	 * Starts writing a line per visitor into a file when it leaves, from a background thread, stopping the current stream if any.
+	 *
+	 * @param Filename The file to create.
+	 * @param bBinary Whether the visitors are written as binary records (see AugmentaAnalyticsStream) instead of CSV lines.
+	 *
+	 * @return false if the file could not be created.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Analytics")
+	bool StartAnalyticsStream(FString Filename, bool bBinary = false);
+
+	/** Writes the queued visitors and closes the stream. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Analytics")
+	void StopAnalyticsStream();
+
+	/** The analytics, with the aggregates and the trajectories as native arrays. Empty unless bComputeAnalytics is enabled. */
+	const FAugmentaAnalytics& GetAnalytics() const { return Analytics; }
+
+	/** Returns the counters of the message dispatch since the last Connect. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	FAugmentaDispatchStats GetDispatchStats() const;
+
+	/**
+	 * Returns the runtime counters of the receiver : message rates, frame gaps, latency, ...
+	 * The rates and latencies are refreshed once per second. They can also be logged with the Augmenta.PrintCounters
+	 * console command, and the main ones are in the Augmenta stat group ("stat Augmenta").
+	 */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	FAugmentaReceiverCounters GetCounters() const;
+
+	/**
+	 * Returns the tracking state the getters read from, without copying it : the snapshot of the last complete
+	 * frame in frame assembly mode, the live state otherwise. Only valid until the next tick.
+	 */
+	const FAugmentaFrameSnapshot& GetFrameSnapshot() const;
+
+	/**
+	 * Returns the committed frame the getters read from in frame assembly mode. It is read only and reference counted, so it
+	 * stays valid and unchanged while it is held, e.g. by another thread. Null in immediate mode and with ConnectSources.
+	 */
+	FAugmentaCommittedFrameRef GetCommittedFrame() const;
+
+	//~ Begin FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject interface
+
 private:
 
-	/** The OSCServer that is used to connect and stop. */
-	UPROPERTY()
-	UOSCServer* OSCServer;
-
-	/** The current Augmenta scene where the Augmenta objects are being tracked. */
-	FAugmentaScene Scene;
-	/** A key value pair that stores the Augmenta Objects being tracked with the their id as the unique key. */
-	TMap<int32, FAugmentaPerson> ActiveObjects;
-	/** The current Augmenta VideoOutput data. */
-	FAugmentaVideoOutput VideoOutput;
-	/** A key value pair that stores the Augmenta Objects extra data with the their id as the unique key. */
-	TMap<int32, FAugmentaObjectExtra> ActiveObjectsExtraData;
-
-	const FString ContainerObject = "object";
-	const FString MethodScene = "scene";
-	const FString MethodObjectEnter = "enter";
-	const FString MethodObjectUpdate = "update";
-	const FString MethodObjectLeave = "leave";
-	const FString MethodVideoOutput = "fusion";
-	const FString MethodObjectExtra = "extra";
-	
+	/** The UDP socket receiving the OSC datagrams. */
+	FSocket* Socket = nullptr;
+	/** The address of the sender of the last received datagram. */
+	TSharedPtr<FInternetAddr> SenderAddress;
+	/** The buffer the datagrams are received into, reused for every datagram. */
+	TArray<uint8> ReceiveBuffer;
+	/** Applies the received datagrams to the tracking state. */
+	FAugmentaTracker Tracker;
+	/** The thread feeding the tracker when decoding on the receive thread. */
+	TSharedPtr<FAugmentaReceiveWorker> ReceiveWorker;
+	/** The thread feeding the tracker when replaying a recording. */
+	TSharedPtr<FAugmentaReplayWorker> ReplayWorker;
+	/** Records the received datagrams, from the thread receiving them. */
+	FAugmentaRecorder Recorder;
+	/** The sources merged into a single scene, see ConnectSources. */
+	TArray<TSharedPtr<FAugmentaSource>> Sources;
+	/** Merges the last complete frame of every source. */
+	FAugmentaFusion Fusion;
+	/** The endpoint shared with the other receivers, see ConnectShared. */
+	TSharedPtr<FAugmentaSharedEndpoint> SharedEndpoint;
+	/** The sequence number of the next frame of the shared endpoint to publish. */
+	uint64 SharedFrameCursor = 0;
+	/** Whether the objects of the shared endpoint are still to enter, after attaching to it. */
+	bool bPublishSharedSnapshot = false;
+	/** Sends the tracking state to the secondaries, see StartClusterPublisher. */
+	TSharedPtr<FAugmentaClusterPublisher> ClusterPublisher;
+	/** Smooths the objects between the frames, when bSmoothObjects is enabled. */
+	FAugmentaSmoother Smoother;
+	/** The filtered delegates, see SubscribeToObjects. */
+	FAugmentaSubscriptions Subscriptions;
+	/** The visitor analytics, when bComputeAnalytics is enabled. */
+	FAugmentaAnalytics Analytics;
+	/** Writes the visitors into a file as they leave. */
+	TSharedPtr<FAugmentaAnalyticsWriter> AnalyticsWriter;
+	/** The occupancy of the scene, when bComputeDensityMap is enabled. */
+	FAugmentaDensityMap DensityMap;
+	/** The density map uploaded once per tick, when bUploadDensityTexture is enabled. */
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> DensityTexture;
+	/** The last committed frame, read by the getters in frame assembly mode. */
+	FAugmentaCommittedFrameRef FrontFrame;
+	/** The events being broadcast, swapped out of the tracker so that delegates can safely reconnect. */
+	FAugmentaFrameEvents BroadcastingEvents;
+	/** Merges the events received within a tick, when bCoalesceEvents is enabled. */
+	FAugmentaEventCoalescer Coalescer;
+	/** The number of times the arrays of the events being broadcast or coalesced had to grow, see FAugmentaDispatchStats. */
+	int64 BroadcastAllocations = 0;
+	/** Whether the tracking state read by the getters changed since the zones were last evaluated. */
+	bool bSnapshotChanged = false;
+
+	/** The counters as of their last refresh. */
+	FAugmentaReceiverCounters Counters;
+	/** The time of the last refresh of the counters, in seconds. */
+	double CountersTime = 0.0;
+	/** The cumulated tracker counters at the last refresh, to compute the rates. */
+	int64 LastMessagesReceived[FAugmentaTracker::NumMessageTypes] = {};
+	int64 LastDatagramsReceived = 0;
+	int64 LastBytesReceived = 0;
+	/** The latencies of the frames broadcast since the last refresh. */
+	FAugmentaLatencyHistogram LatencyHistogram;
+
 	/**
-	 * Processes the valid Augmenta OSC Message and gets the data accordingly for the Augmenta Scene and
-	 * Augmenta Objects.
-	 * 
-	 * @param Message The OSC Message to process and get the Augmenta data.
-	 * @param IPAddress The OSC receive IP address of the device.
-	 * @param Port The port of the device where the OSC Messages are received.
-	 */
-	UFUNCTION()
-	void OnMessageReceived(const FOSCMessage& Message, const FString& IPAddress, int32 Port);
-
-	/** Processes the Augmenta Scene OSC Message. */
-	void UpdateScene(const FOSCMessage& Message);
-	/** Processes the Augmenta Object Entered and Updated OSC Message. */
-	void UpdateObject(const FOSCMessage& Message, bool HasEntered);
-	/** Processes the Augmenta Object Will Leave OSC Message. */
-	void RemoveObject(const FOSCMessage& Message);
-	/** Processes the Augmenta VideoOutput (Fusion) OSC Message. */
-	void UpdateVideoOutputData(const FOSCMessage& Message);
-	/** Processes the Augmenta Object enter and update extra data OSC Message. */
-	void UpdateObjectExtraData(const FOSCMessage& Message, bool HasEntered);
-	/** Processes the Augmenta Object leave extra data OSC Message. */
-	void RemoveObjectExtraData(const FOSCMessage& Message);
+	 * Resets the tracker and clears everything derived from its objects (counters, smoothing, coalesced events, density map,
+	 * analytics and subscriptions), when the receiver starts or stops reading a stream.
+	 *
+	 * @param bInFrameAssembly Whether the tracker assembles and commits the frames as a whole.
+	 */
+	void ResetTrackingState(bool bInFrameAssembly);
+
+	/** Allocates the trajectories and clears the analytics, when the tracker is reset. */
+	void ResetAnalytics();
+
+	/** Copies the density map into the density texture, creating it if needed. */
+	void UploadDensityTexture();
+
+	/** Fuses the sources if any of them committed a frame, and fires the events of the fused scene. */
+	void TickSources();
+
+	/** Publishes the frames of the shared endpoint committed since the last tick. */
+	void TickSharedEndpoint();
+
+	/** Sums a counter of the tracker and of the source trackers. */
+	template<typename GetterType>
+	int64 SumTrackerCounters(GetterType&& Getter) const;
+
+	/** Clears the counters, when the tracker is reset. */
+	void ResetCounters();
+	/** Refreshes the rates and the latencies once per second. */
+	void UpdateCounters(double Now);
+
+	/**
+	 * Applies the given events to the smoother, then fires them or merges them with the events of the tick.
+	 *
+	 * @param Events The events of a datagram or frame.
+	 * @param ReceiveTime When the events were received, in seconds.
+	 */
+	void PublishEvents(const FAugmentaFrameEvents& Events, double ReceiveTime);
+
+	/** Fires the delegates for the given events, in the order they were received. */
+	void BroadcastEvents(const FAugmentaFrameEvents& Events);
 };
@@ -0,0 +1,163 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include <atomic>
+
+/**
+ * The Augmenta recording format : the raw datagrams as received, with their timestamp, followed by an index for seeking.
+ * Every value is little endian and every record starts on an 8 bytes boundary, so the file can be read in place once mapped.
+ *
+ *   FFileHeader
+ *   FRecordHeader, datagram bytes, padding to 8 bytes   (repeated for every datagram)
+ *   FIndexEntry                                          (repeated, one entry every IndexInterval)
+ *   FFileFooter
+ *
+ * A recording that was not closed has no index nor footer, its records are scanned when it is opened.
+ */
+namespace AugmentaRecording
+{
+	/** "AUGR" */
+	constexpr uint32 FileMagic = 0x52475541;
+	/** "AUGI" */
+	constexpr uint32 FooterMagic = 0x49475541;
+	constexpr uint32 Version = 1;
+	/** The time between two index entries, in microseconds. */
+	constexpr uint64 IndexInterval = 500000;
+
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint64 Reserved;
+	};
+
+	struct FRecordHeader
+	{
+		/** The time the datagram was received, since the first datagram of the recording. */
+		uint64 TimestampMicros;
+		uint32 Size;
+		uint32 Reserved;
+	};
+
+	struct FIndexEntry
+	{
+		uint64 TimestampMicros;
+		/** The offset of the record in the file. */
+		uint64 Offset;
+	};
+
+	struct FFileFooter
+	{
+		uint64 IndexOffset;
+		uint64 NumRecords;
+		uint64 DurationMicros;
+		uint32 NumIndexEntries;
+		uint32 Magic;
+	};
+
+	static_assert(sizeof(FFileHeader) == 16 && sizeof(FRecordHeader) == 16 && sizeof(FIndexEntry) == 16 && sizeof(FFileFooter) == 32,
+		"The recording structures are written as is.");
+}
+
+/**
+ * Records the received datagrams into an Augmenta recording file.
+ * Recording can be started and stopped from any thread while another thread records the datagrams.
+ */
+class AUGMENTAUNREAL_API FAugmentaRecorder
+{
+public:
+	/** Closes the recording, if any. */
+	~FAugmentaRecorder();
+
+	/** Starts recording into a new file, closing the current recording if any. Returns false if the file could not be created. */
+	bool Open(const TCHAR* Filename);
+
+	/** Writes the index and closes the recording. */
+	void Close();
+
+	bool IsRecording() const { return bRecording.load(std::memory_order_relaxed); }
+
+	/** Records a datagram received now. Does nothing when not recording. */
+	void Record(const uint8* Data, int32 Size);
+
+private:
+	/** Serializes the recording, the datagrams can come from another thread than the one opening and closing it. */
+	FCriticalSection Lock;
+	TUniquePtr<FArchive> Writer;
+	TArray<AugmentaRecording::FIndexEntry> Index;
+
+	/** The time of the first datagram, in seconds. */
+	double StartTime = 0.0;
+	uint64 NumRecords = 0;
+	uint64 LastTimestampMicros = 0;
+
+	std::atomic<bool> bRecording{ false };
+};
+
+/** A datagram read from an Augmenta recording. The data points into the mapped file. */
+struct FAugmentaRecordedDatagram
+{
+	const uint8* Data = nullptr;
+	int32 Size = 0;
+	/** The time the datagram was received, in seconds since the first datagram of the recording. */
+	double Time = 0.0;
+};
+
+/**
+ * Reads an Augmenta recording. The file is memory mapped, so it is paged in as it is read whatever its size.
+ * Not thread safe : a replay must only be read from one thread.
+ */
+class AUGMENTAUNREAL_API FAugmentaReplay
+{
+public:
+	~FAugmentaReplay();
+
+	/** Opens a recording, closing the current one if any. Returns false if the file is not a valid recording. */
+	bool Open(const TCHAR* Filename);
+
+	void Close();
+
+	bool IsOpen() const { return Data != nullptr; }
+
+	/**
+	 * Reads the next datagram of the recording.
+	 *
+	 * @param OutDatagram Set to the datagram read, valid until the replay is closed.
+	 *
+	 * @return false at the end of the recording.
+	 */
+	bool ReadNext(FAugmentaRecordedDatagram& OutDatagram);
+
+	/** Moves to the first datagram received at or after the given time, in seconds since the start of the recording. */
+	void Seek(double Time);
+
+	/** The time of the last datagram, in seconds since the first one. */
+	double GetDuration() const { return DurationMicros / 1e6; }
+
+	int64 GetNumDatagrams() const { return NumRecords; }
+
+private:
+	/** Reads the record header at an offset. Returns false if there is no complete record at this offset. */
+	bool ReadRecordHeader(int64 Offset, AugmentaRecording::FRecordHeader& OutHeader) const;
+
+	/** Returns the offset of the record following the one at the given offset. */
+	static int64 GetNextRecordOffset(int64 Offset, const AugmentaRecording::FRecordHeader& Header);
+
+	/** Rebuilds the index of a recording that was not closed. */
+	void ScanRecords();
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	const uint8* Data = nullptr;
+	/** The end of the records, i.e. the start of the index. */
+	int64 RecordsEnd = 0;
+	int64 ReadOffset = 0;
+
+	TArray<AugmentaRecording::FIndexEntry> Index;
+	uint64 NumRecords = 0;
+	uint64 DurationMicros = 0;
+};
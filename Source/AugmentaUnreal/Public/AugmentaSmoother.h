@@ -0,0 +1,115 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaObjectStore.h"
+
+/** Forward Declarations */
+struct FAugmentaFrameEvents;
+
+/**
+ * Estimates when the Augmenta frames were sent from their Frame field and their arrival times, with an alpha-beta filter.
+ * The arrival times jitter with the network and the game thread ticks, the frame times advance at the estimated frame period.
+ */
+class AUGMENTAUNREAL_API FAugmentaFrameClock
+{
+public:
+	/** Forgets the frames received so far. */
+	void Reset();
+
+	/**
+	 * Returns the time of a frame, updating the estimation when it is a new frame.
+	 *
+	 * @param Frame The Augmenta frame number.
+	 * @param ArrivalTime When the frame was received, in seconds.
+	 *
+	 * @return The filtered time of the frame, in seconds.
+	 */
+	double GetFrameTime(int32 Frame, double ArrivalTime);
+
+	/** The estimated duration of a frame, in seconds. Zero until two frames were received. */
+	double GetFramePeriod() const { return FramePeriod; }
+
+private:
+	/** The last frame received, and its filtered time. INDEX_NONE before the first frame. */
+	int32 LastFrame = INDEX_NONE;
+	double LastFrameTime = 0.0;
+	double FramePeriod = 0.0;
+};
+
+/**
+ * Smooths the motion of the Augmenta Objects between the network frames, so that the objects move at the render frame rate.
+ *
+ * The last few centroids of every object are kept with the time of their frame (see FAugmentaFrameClock). Once per tick,
+ * every object is sampled at the render time in a single pass, four objects per SIMD instruction : the centroid is interpolated
+ * between the two samples around the render time, or extrapolated from the last sample with the object velocity once the
+ * render time is past it. Sampling a fixed delay in the past trades latency for interpolation, a zero delay only extrapolates.
+ */
+class AUGMENTAUNREAL_API FAugmentaSmoother
+{
+public:
+	/** The number of samples kept per object. */
+	static constexpr int32 HistorySize = 4;
+
+	FAugmentaSmoother();
+
+	/** Removes every object and forgets the frame times. */
+	void Reset();
+
+	/**
+	 * Adds a sample for every entered or updated object and removes the objects that left.
+	 *
+	 * @param Events The changes applied to the tracking state.
+	 * @param ArrivalTime When the changes were received, in seconds.
+	 */
+	void ApplyEvents(const FAugmentaFrameEvents& Events, double ArrivalTime);
+
+	/**
+	 * Samples every object at the given time.
+	 *
+	 * @param RenderTime The time to sample the objects at, in seconds.
+	 * @param MaxExtrapolationTime How far past its last sample an object is extrapolated, in seconds.
+	 */
+	void Sample(double RenderTime, float MaxExtrapolationTime);
+
+	int32 Num() const { return Pids.Num(); }
+
+	/** The Pids of the objects, in the same order as the smoothed centroids. */
+	TConstArrayView<int32> GetPids() const { return Pids; }
+
+	/** The centroids of the last sampling, normalized like FAugmentaPerson::Centroid. */
+	TConstArrayView<float> GetSmoothedX() const { return SmoothedX; }
+	TConstArrayView<float> GetSmoothedY() const { return SmoothedY; }
+
+	/** Returns the smoothed centroid of an object, or false if the object is unknown. */
+	bool FindSmoothedCentroid(int32 Pid, FVector2D& OutCentroid) const;
+
+private:
+	/** Adds a sample to the history of an object, adding the object if needed. */
+	void AddSample(int32 Pid, float Time, const FAugmentaPerson& Object);
+
+	/** Removes an object, moving the last object into its slot. */
+	void Remove(int32 Pid);
+
+	/** Moves the time origin closer to a time, before the float times lose their precision. */
+	void Rebase(double Time);
+
+	FAugmentaFrameClock FrameClock;
+	/** The origin of the float times, in seconds. */
+	double TimeBase = 0.0;
+
+	FAugmentaIdIndex Index;
+	TArray<int32> Pids;
+
+	/** The history of every object, the most recent sample first. A history not full yet repeats its oldest sample. */
+	TArray<float> SampleTimes[HistorySize];
+	TArray<float> SampleX[HistorySize];
+	TArray<float> SampleY[HistorySize];
+	/** The velocity of the most recent sample, in normalized units per second. */
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+
+	TArray<float> SmoothedX;
+	TArray<float> SmoothedY;
+};
@@ -0,0 +1,151 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Two slots found by FAugmentaSpatialGrid::FindPairs, with SlotA < SlotB. */
+struct FAugmentaSlotPair
+{
+	int32 SlotA;
+	int32 SlotB;
+	float Distance;
+};
+
+/**
+ * A uniform grid over the normalized Augmenta scene, indexing the slots of a TAugmentaSlotMap by position.
+ * Every cell holds an intrusive list of the slots it contains, so moving or removing a slot is constant time.
+ * Positions outside of the scene are kept in the border cells.
+ *
+ * The grid only stores the cells : the queries test the exact positions, given as arrays indexed by slot.
+ * Their distances are measured after scaling the normalized positions, e.g. by the scene size to measure them in meters.
+ */
+class AUGMENTAUNREAL_API FAugmentaSpatialGrid
+{
+public:
+	/** The number of cells along each axis of the scene. */
+	static constexpr int32 Resolution = 32;
+
+	FAugmentaSpatialGrid();
+
+	/** Adds a new slot, which must be the next slot of the map. */
+	void Add(int32 Slot, float X, float Y);
+
+	/** Moves a slot to a new position. */
+	void Move(int32 Slot, float X, float Y);
+
+	/**
+	 * Removes a slot from the grid, then moves the last slot into it the way the map moved its value.
+	 *
+	 * @param Slot The removed slot.
+	 * @param LastSlot The last slot of the map before the removal.
+	 */
+	void RemoveSwap(int32 Slot, int32 LastSlot);
+
+	/** Removes every slot, keeping the allocations. */
+	void Reset();
+
+	/** Copies another grid, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaSpatialGrid& Other);
+
+	/**
+	 * Finds the slots inside a rectangle.
+	 *
+	 * @param X The X position of every slot.
+	 * @param Y The Y position of every slot.
+	 * @param Min The normalized minimum corner of the rectangle.
+	 * @param Max The normalized maximum corner of the rectangle.
+	 * @param OutSlots The array the slots are added to.
+	 */
+	void FindInRect(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Min, const FVector2f& Max, TArray<int32>& OutSlots) const;
+
+	/**
+	 * Finds the slots within a distance of a point.
+	 *
+	 * @param X The X position of every slot.
+	 * @param Y The Y position of every slot.
+	 * @param Center The normalized position of the point.
+	 * @param Radius The distance, in scaled units.
+	 * @param Scale The scale applied to the normalized positions to measure distances.
+	 * @param OutSlots The array the slots are added to.
+	 */
+	void FindInRadius(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, float Radius, const FVector2f& Scale, TArray<int32>& OutSlots) const;
+
+	/**
+	 * Finds the slots nearest to a point, searching the cells ring by ring around it.
+	 *
+	 * @param X The X position of every slot.
+	 * @param Y The Y position of every slot.
+	 * @param Center The normalized position of the point.
+	 * @param Count The maximum number of slots to find.
+	 * @param Scale The scale applied to the normalized positions to measure distances.
+	 * @param OutSlots The array the slots are added to, from the nearest to the farthest.
+	 */
+	void FindNearest(TConstArrayView<float> X, TConstArrayView<float> Y, const FVector2f& Center, int32 Count, const FVector2f& Scale, TArray<int32>& OutSlots) const;
+
+	/**
+	 * Finds every pair of slots within a distance of each other, only testing the slots of neighbouring cells.
+	 *
+	 * @param X The X position of every slot.
+	 * @param Y The Y position of every slot.
+	 * @param MaxDistance The distance, in scaled units.
+	 * @param Scale The scale applied to the normalized positions to measure distances.
+	 * @param OutPairs The array the pairs are added to.
+	 */
+	void FindPairs(TConstArrayView<float> X, TConstArrayView<float> Y, float MaxDistance, const FVector2f& Scale, TArray<FAugmentaSlotPair>& OutPairs) const;
+
+	/** Calls Func with every slot of the cells overlapping a normalized rectangle. */
+	template<typename FuncType>
+	void ForEachSlotInRect(const FVector2f& Min, const FVector2f& Max, FuncType&& Func) const
+	{
+		const int32 MinCellX = GetCellCoordinate(Min.X);
+		const int32 MinCellY = GetCellCoordinate(Min.Y);
+		const int32 MaxCellX = GetCellCoordinate(Max.X);
+		const int32 MaxCellY = GetCellCoordinate(Max.Y);
+		for (int32 CellY = MinCellY; CellY <= MaxCellY; ++CellY)
+		{
+			for (int32 CellX = MinCellX; CellX <= MaxCellX; ++CellX)
+			{
+				for (int32 Slot = CellHeads[CellY * Resolution + CellX]; Slot != INDEX_NONE; Slot = Links[Slot].Next)
+				{
+					Func(Slot);
+				}
+			}
+		}
+	}
+
+	/** Returns the squared distance the queries measure between a normalized position and a point, after scaling them. */
+	static float GetDistanceSquared(float X, float Y, const FVector2f& Point, const FVector2f& Scale)
+	{
+		const float DeltaX = (X - Point.X) * Scale.X;
+		const float DeltaY = (Y - Point.Y) * Scale.Y;
+		return DeltaX * DeltaX + DeltaY * DeltaY;
+	}
+
+	/** Returns the cell coordinate of a normalized coordinate, clamped to the grid. */
+	static int32 GetCellCoordinate(float Coordinate)
+	{
+		// Also maps NaN to the first cell
+		const float Clamped = Coordinate >= 0.f ? FMath::Min(Coordinate, 1.f) : 0.f;
+		return FMath::Min(static_cast<int32>(Clamped * Resolution), Resolution - 1);
+	}
+
+	SIZE_T GetAllocatedSize() const { return Links.GetAllocatedSize() + CellHeads.GetAllocatedSize(); }
+
+private:
+	struct FLink
+	{
+		int32 Prev;
+		int32 Next;
+		int32 Cell;
+	};
+
+	static int32 GetCell(float X, float Y) { return GetCellCoordinate(Y) * Resolution + GetCellCoordinate(X); }
+
+	void Link(int32 Slot, int32 Cell);
+	void Unlink(int32 Slot);
+
+	TArray<FLink> Links;
+	/** The first slot of every cell, INDEX_NONE for an empty cell. */
+	TArray<int32> CellHeads;
+};
@@ -0,0 +1,82 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("Augmenta"), STATGROUP_Augmenta, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Receiver Tick"), STAT_AugmentaReceiverTick, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Decode"), STAT_AugmentaDecode, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Objects"), STAT_AugmentaUpdateObjects, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Commit Frame"), STAT_AugmentaCommitFrame, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Evaluate Zones"), STAT_AugmentaEvaluateZones, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Fuse Sources"), STAT_AugmentaFuseSources, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Smooth Objects"), STAT_AugmentaSmoothObjects, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Density Map"), STAT_AugmentaUpdateDensityMap, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Analytics"), STAT_AugmentaUpdateAnalytics, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Object Pool"), STAT_AugmentaUpdateObjectPool, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnFrame"), STAT_AugmentaBroadcastFrame, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Coalesce Events"), STAT_AugmentaCoalesceEvents, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Dispatch Subscriptions"), STAT_AugmentaDispatchSubscriptions, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Publish Cluster"), STAT_AugmentaPublishCluster, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnFrameObjectsEntered"), STAT_AugmentaBroadcastFrameObjectsEntered, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnFrameObjectsUpdated"), STAT_AugmentaBroadcastFrameObjectsUpdated, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnFrameObjectsLeft"), STAT_AugmentaBroadcastFrameObjectsLeft, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnSceneUpdated"), STAT_AugmentaBroadcastSceneUpdated, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnVideoOutputUpdated"), STAT_AugmentaBroadcastVideoOutputUpdated, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnPersonEntered"), STAT_AugmentaBroadcastPersonEntered, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnPersonUpdated"), STAT_AugmentaBroadcastPersonUpdated, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnPersonWillLeave"), STAT_AugmentaBroadcastPersonWillLeave, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnEnteredExtraData"), STAT_AugmentaBroadcastEnteredExtraData, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnUpdatedExtraData"), STAT_AugmentaBroadcastUpdatedExtraData, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Broadcast OnLeaveExtraData"), STAT_AugmentaBroadcastLeaveExtraData, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+
+/** Summed over every receiver. The rates and latencies are refreshed once per second. */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Active Objects"), STAT_AugmentaActiveObjects, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Messages/s"), STAT_AugmentaMessagesPerSecond, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("KB/s"), STAT_AugmentaKilobytesPerSecond, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Latency p99 (ms)"), STAT_AugmentaLatencyP99, STATGROUP_Augmenta, AUGMENTAUNREAL_API);
+
+/**
+ * Times a scope in the Augmenta stat group. Cycle stats are also Unreal Insights events,
+ * so the scope is traced on its own only when the stats are compiled out.
+ */
+#if STATS
+#define AUGMENTA_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat)
+#else
+#define AUGMENTA_SCOPE_CYCLE_COUNTER(Stat) TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#endif
+
+/**
+ * A histogram of latencies with logarithmic buckets, from 10 us to about 650 ms with a resolution of 19%.
+ * Adding a latency is a few instructions and never allocates, so every frame can be measured.
+ */
+class AUGMENTAUNREAL_API FAugmentaLatencyHistogram
+{
+public:
+	/** The number of buckets per doubling of the latency. */
+	static constexpr int32 BucketsPerOctave = 4;
+	static constexpr int32 NumBuckets = 16 * BucketsPerOctave;
+	/** The upper bound of the first bucket, in seconds. */
+	static constexpr double MinLatency = 1e-5;
+
+	FAugmentaLatencyHistogram() { Reset(); }
+
+	/** Adds a latency, in seconds. */
+	void Add(double Latency);
+
+	/** Returns the latency under which the given fraction (0 to 1) of the latencies are, in seconds. Zero if empty. */
+	double GetPercentile(double Fraction) const;
+
+	int64 Num() const { return Count; }
+
+	void Reset();
+
+private:
+	int64 Buckets[NumBuckets];
+	int64 Count = 0;
+};
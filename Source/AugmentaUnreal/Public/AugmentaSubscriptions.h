@@ -0,0 +1,144 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AugmentaData.h"
+#include "AugmentaObjectStore.h"
+#include "AugmentaSubscriptions.generated.h"
+
+/** Forward Declarations */
+struct FAugmentaFrameEvents;
+
+/** The changes of an Augmenta Object reported to a filtered subscription, see FAugmentaEventFilter. */
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class EAugmentaObjectChange : uint8
+{
+	None = 0 UMETA(Hidden),
+	/** The object entered the scene, or started matching the filter. */
+	Entered = 1 << 0,
+	/** The object left the scene, or stopped matching the filter. */
+	Left = 1 << 1,
+	/** The centroid moved by more than the centroid dead-band. */
+	Centroid = 1 << 2,
+	/** The height changed by more than the height dead-band. */
+	Height = 1 << 3,
+	/** The orientation turned by more than the orientation dead-band. */
+	Orientation = 1 << 4,
+};
+ENUM_CLASS_FLAGS(EAugmentaObjectChange)
+
+/**
+ * Which Augmenta Objects and which of their changes a subscription is notified of.
+ * The dead-bands are measured from the value last reported to the subscription, so that slow drifts are still reported
+ * once they add up. A zero dead-band reports any change, but never an update repeating the same values.
+ */
+USTRUCT(BlueprintType, Category = "Augmenta|Data")
+struct FAugmentaEventFilter
+{
+	GENERATED_BODY()
+
+	/** The changes that notify the subscription, see EAugmentaObjectChange. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (Bitmask, BitmaskEnum = "/Script/AugmentaUnreal.EAugmentaObjectChange"))
+	int32 Changes = static_cast<int32>(EAugmentaObjectChange::Entered | EAugmentaObjectChange::Left
+		| EAugmentaObjectChange::Centroid | EAugmentaObjectChange::Height | EAugmentaObjectChange::Orientation);
+
+	/** The distance the centroid must move by to be reported (normalized). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (ClampMin = "0"))
+	float CentroidDeadBand = 0.f;
+
+	/** The change of height to be reported (in m). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (ClampMin = "0"))
+	float HeightDeadBand = 0.f;
+
+	/** The change of orientation to be reported (in degrees). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (ClampMin = "0"))
+	float OrientationDeadBand = 0.f;
+
+	/** Whether only the objects whose centroid is inside Region match the filter. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter")
+	bool bFilterRegion = false;
+
+	/** The region of the scene the centroids must be inside of (normalized). */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (EditCondition = "bFilterRegion"))
+	FBox2D Region = FBox2D(FVector2D(0.0, 0.0), FVector2D(1.0, 1.0));
+
+	/** The smallest Oid matching the filter. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter", meta = (ClampMin = "0"))
+	int32 MinOid = 0;
+
+	/** The largest Oid matching the filter, negative for no limit. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Augmenta|Filter")
+	int32 MaxOid = -1;
+};
+
+/** Delegates */
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FAugmentaFilteredObjectEvent, const FAugmentaPerson&, Object, int32, Changes);
+
+/** Native Delegates */
+DECLARE_DELEGATE_TwoParams(FAugmentaFilteredObjectNativeEvent, const FAugmentaPerson&, EAugmentaObjectChange);
+
+/**
+ * Delegates notified of the Augmenta Objects matching a filter, when they change by more than the dead-bands of the filter.
+ *
+ * The filters are evaluated natively before any delegate is called. Every subscription remembers the values it was last
+ * notified of for every object it follows, and computes a change mask per object and per frame against them : an object
+ * that did not move past the dead-bands costs a few comparisons and no delegate call, so a stationary crowd fires nothing.
+ */
+class AUGMENTAUNREAL_API FAugmentaSubscriptions
+{
+public:
+	/** Adds a subscription. Returns the id to remove it with. */
+	int32 Add(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent Delegate);
+	int32 Add(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectEvent Delegate);
+
+	/** Removes a subscription, also from its own delegate. Returns false if there is no subscription with this id. */
+	bool Remove(int32 SubscriptionId);
+
+	int32 Num() const { return Subscriptions.Num(); }
+
+	/** Forgets the objects followed by every subscription, when the tracking state is reset. */
+	void ResetObjects();
+
+	/** Notifies every subscription of the object events it matches. */
+	void Dispatch(const FAugmentaFrameEvents& Events);
+
+	/** The number of object events evaluated and not fired since the last call to ResetCounters. */
+	int64 GetFilteredEvents() const { return FilteredEvents; }
+
+	void ResetCounters() { FilteredEvents = 0; }
+
+private:
+	/** The values last reported to a subscription for an object. */
+	struct FReportedState
+	{
+		FVector2D Centroid = FVector2D::ZeroVector;
+		float Height = 0.f;
+		float Orientation = 0.f;
+	};
+
+	struct FSubscription
+	{
+		int32 Id = 0;
+		FAugmentaEventFilter Filter;
+		EAugmentaObjectChange Changes = EAugmentaObjectChange::None;
+		FAugmentaFilteredObjectNativeEvent NativeDelegate;
+		FAugmentaFilteredObjectEvent Delegate;
+		TAugmentaSlotMap<FReportedState> Objects;
+		bool bRemoved = false;
+	};
+
+	int32 AddSubscription(const FAugmentaEventFilter& Filter, FAugmentaFilteredObjectNativeEvent NativeDelegate, FAugmentaFilteredObjectEvent Delegate);
+
+	/** Evaluates an object event for a subscription, firing its delegate if the object changed enough. */
+	void Evaluate(FSubscription& Subscription, const FAugmentaPerson& Object, bool bLeft);
+
+	/** Returns whether an object matches the predicates of a filter. */
+	static bool Matches(const FAugmentaEventFilter& Filter, const FAugmentaPerson& Object);
+
+	TArray<TSharedRef<FSubscription>> Subscriptions;
+	int32 NextId = 1;
+	/** Whether the subscriptions are being notified, the removed ones are then only flagged. */
+	bool bDispatching = false;
+	int64 FilteredEvents = 0;
+};
@@ -0,0 +1,46 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "AugmentaSubsystem.generated.h"
+
+/** Forward Declarations */
+struct FAugmentaExpiry;
+class FAugmentaSharedEndpoint;
+
+/**
+ * Shares the sockets of the receivers listening to the same ip address and port, see UAugmentaReceiver::ConnectShared.
+ * Every endpoint is received and decoded once, on its own thread, and read by every receiver attached to it.
+ * The endpoints are owned by their receivers : an endpoint is closed once the last receiver attached to it stops.
+ */
+UCLASS()
+class AUGMENTAUNREAL_API UAugmentaSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Returns the endpoint receiving on the given ip address and port, opening it if no receiver is attached to it.
+	 *
+	 * @param ReceiveIPAddress The ip address to receive on, joined if it is a multicast address.
+	 * @param Port The port to receive on.
+	 * @param Expiry When the objects are considered lost, only used when the endpoint is opened.
+	 *
+	 * @return The endpoint, null if its socket could not be opened.
+	 */
+	TSharedPtr<FAugmentaSharedEndpoint> AcquireEndpoint(const FString& ReceiveIPAddress, int32 Port, const FAugmentaExpiry& Expiry);
+
+	/** Returns the number of endpoints open, i.e. the number of sockets shared by the receivers. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta")
+	int32 GetNumEndpoints() const;
+
+	//~ Begin USubsystem interface
+	virtual void Deinitialize() override;
+	//~ End USubsystem interface
+
+private:
+	/** The endpoints by key (see FAugmentaSharedEndpoint::GetKey), owned by the receivers attached to them. */
+	TMap<FString, TWeakPtr<FAugmentaSharedEndpoint>> Endpoints;
+};
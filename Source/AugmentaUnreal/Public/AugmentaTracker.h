@@ -0,0 +1,303 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/CircularQueue.h"
+#include "AugmentaData.h"
+#include "AugmentaBinaryProtocol.h"
+#include "AugmentaClusterProtocol.h"
+#include "AugmentaOSCDecoder.h"
+#include "AugmentaObjectStore.h"
+
+/** The kind of change recorded in FAugmentaFrameEvents. */
+enum class EAugmentaEventType : uint8
+{
+	SceneUpdated,
+	VideoOutputUpdated,
+	ObjectEntered,
+	ObjectUpdated,
+	ObjectLeft,
+	ExtraDataEntered,
+	ExtraDataUpdated,
+	ExtraDataLeft,
+};
+
+/** A change recorded in FAugmentaFrameEvents, indexing into the array matching its type. */
+struct FAugmentaEventRecord
+{
+	EAugmentaEventType Type;
+	int32 Index;
+};
+
+/** The changes applied to the tracking state, in the order they were received. */
+struct AUGMENTAUNREAL_API FAugmentaFrameEvents
+{
+	/** The order in which the changes were received, indexing into the arrays below. */
+	TArray<FAugmentaEventRecord> Sequence;
+
+	TArray<FAugmentaScene> Scenes;
+	TArray<FAugmentaVideoOutput> VideoOutputs;
+	TArray<FAugmentaPerson> EnteredObjects;
+	TArray<FAugmentaPerson> UpdatedObjects;
+	TArray<FAugmentaPerson> LeftObjects;
+	TArray<FAugmentaObjectExtra> EnteredExtras;
+	TArray<FAugmentaObjectExtra> UpdatedExtras;
+	TArray<FAugmentaObjectExtra> LeftExtras;
+
+	/** Removes every event, keeping the allocations. */
+	void Reset();
+
+	bool IsEmpty() const { return Sequence.Num() == 0; }
+
+	SIZE_T GetAllocatedSize() const;
+};
+
+/** The Augmenta tracking state. */
+struct AUGMENTAUNREAL_API FAugmentaFrameSnapshot
+{
+	/** The Augmenta frame number of the last applied message. */
+	int32 Frame = 0;
+	/** The current Augmenta scene where the Augmenta objects are being tracked. */
+	FAugmentaScene Scene;
+	/** The current Augmenta VideoOutput data. */
+	FAugmentaVideoOutput VideoOutput;
+	/** The Augmenta Objects being tracked with their id as the unique key. */
+	FAugmentaObjectStore Objects;
+	/** The Augmenta Objects extra data with their id as the unique key. */
+	FAugmentaObjectExtraStore ObjectExtras;
+
+	/** Removes every object and resets the scene. */
+	void Reset();
+
+	/** Copies another snapshot, only reallocating if this one is too small. */
+	void CopyFrom(const FAugmentaFrameSnapshot& Other);
+
+	SIZE_T GetAllocatedSize() const { return Objects.GetAllocatedSize() + ObjectExtras.GetAllocatedSize(); }
+};
+
+/** A complete Augmenta frame : the tracking state once all of its messages were applied, and the events that led to it. */
+struct FAugmentaCommittedFrame
+{
+	FAugmentaFrameSnapshot Snapshot;
+	FAugmentaFrameEvents Events;
+	/** When the first datagram of the frame was read from the socket, in seconds. */
+	double ReceiveTime = 0.0;
+};
+
+/** A reference to a committed frame. Committed frames are read only and recycled once nobody references them. */
+using FAugmentaCommittedFrameRef = TSharedPtr<FAugmentaCommittedFrame, ESPMode::ThreadSafe>;
+
+/**
+ * Applies the decoded Augmenta messages to the tracking state.
+ *
+ * In immediate mode every message is applied to the live state and its event is left pending until the caller
+ * broadcasts it. In frame assembly mode the messages of a frame are accumulated in the live state, used as a
+ * back buffer, and the whole frame is committed as a read only snapshot when the first message of the next
+ * frame is received.
+ *
+ * The tracker is not thread safe : it must only be fed from one thread. Committed frames can be dequeued and the
+ * counters read from another thread.
+ */
+class AUGMENTAUNREAL_API FAugmentaTracker : public IAugmentaDecoderListener
+{
+public:
+	/** The number of EAugmentaMessageType values. */
+	static constexpr int32 NumMessageTypes = static_cast<int32>(EAugmentaMessageType::ObjectExtraLeave) + 1;
+
+	FAugmentaTracker();
+
+	/**
+	 * Clears the tracking state and the counters.
+	 *
+	 * @param bInFrameAssembly Whether the frames are assembled and committed as a whole.
+	 */
+	void Reset(bool bInFrameAssembly);
+
+	/** Sets when the objects that are not updated anymore are considered lost, e.g. because their leave message was dropped. */
+	void SetExpiry(const FAugmentaExpiry& InExpiry) { Expiry = InExpiry; }
+
+	/**
+	 * Decodes a datagram, either OSC, binary (see AugmentaBinaryProtocol) or a cluster packet (see AugmentaClusterProtocol),
+	 * and applies its messages to the tracking state. A cluster frame is committed as soon as it is applied.
+	 */
+	void ProcessDatagram(const uint8* Data, int32 Size);
+
+	/**
+	 * Removes the lost objects and extra data, recording their leave events as if their leave message had been received.
+	 * Called when a new frame begins, and should be called periodically while no datagram is received. Nothing expires in
+	 * a cluster stream, whose unchanged objects are not sent and whose frames carry the leaves of the primary.
+	 *
+	 * @param Now The current time, in seconds (see FPlatformTime::Seconds).
+	 *
+	 * @return true if anything expired.
+	 */
+	bool ExpireStaleObjects(double Now);
+
+	/**
+	 * Removes every object and extra data, recording their leave events, e.g. before a replay jumps to another time.
+	 * The latest frame is forgotten too, so that the frames after a jump back in time are not dropped as out of order.
+	 */
+	void RemoveAllObjects();
+
+	/**
+	 * Commits the frame being assembled, if any.
+	 *
+	 * If the committed frames wait to be dequeued and the queue is full, the commit is deferred : the events stay pending and
+	 * are committed with the next frame, whose snapshot supersedes this one. No event is ever dropped.
+	 */
+	void CommitFrame();
+
+	/** Commits the frame whose commit was deferred because the queue was full, if no message was applied since then. */
+	void FlushDeferredCommit();
+
+	/**
+	 * Commits the frame being assembled once nothing was received for a while, e.g. to publish the leave events of the objects
+	 * expired after the stream stopped. A frame still being received is never committed half assembled : while datagrams keep
+	 * arriving, the pending events are committed at the next frame boundary instead.
+	 *
+	 * @param Now The current time, in seconds (see FPlatformTime::Seconds).
+	 */
+	void CommitIdleFrame(double Now);
+
+	/** Returns whether the committed frames waiting to be dequeued fill the queue, so that the next commit would be deferred. */
+	bool IsCommitQueueFull() const { return CommittedFrames.IsFull(); }
+
+	/** Dequeues the oldest committed frame. Returns false if there is none. */
+	bool DequeueCommittedFrame(FAugmentaCommittedFrameRef& OutFrame);
+
+	/** Returns whether the frames are assembled and committed as a whole. */
+	bool IsFrameAssemblyEnabled() const { return bFrameAssembly; }
+
+	/** The tracking state updated message by message. Only safe to read from the thread feeding the tracker. */
+	const FAugmentaFrameSnapshot& GetLiveState() const { return LiveState; }
+
+	/** The events not committed yet. In immediate mode, the caller broadcasts and resets them after each datagram. */
+	FAugmentaFrameEvents& GetPendingEvents() { return PendingEvents; }
+
+	/** The decoder used for the received OSC datagrams. */
+	const FAugmentaOSCDecoder& GetDecoder() const { return Decoder; }
+
+	/** The decoder used for the received binary packets. */
+	const FAugmentaBinaryDecoder& GetBinaryDecoder() const { return BinaryDecoder; }
+
+	/** The decoder used for the received cluster packets. */
+	const FAugmentaClusterDecoder& GetClusterDecoder() const { return ClusterDecoder; }
+
+	/**
+	 * The number of heap allocations made while applying messages and committing frames, i.e. the number of times the live
+	 * state, the pending events, the frame pool or a committed frame had to grow.
+	 */
+	int64 GetDispatchAllocations() const { return DispatchAllocations.Get(); }
+
+	/** The number of frames whose snapshot was superseded by the next frame because nobody dequeued the committed frames. */
+	int64 GetDroppedFrames() const { return DroppedFrames.Get(); }
+
+	/** The number of objects and extra data removed by expiry because their leave message was never received. */
+	int64 GetDroppedLeaves() const { return DroppedLeaves.Get(); }
+
+	/** The number of Augmenta messages of the given type received. */
+	int64 GetMessagesReceived(EAugmentaMessageType Type) const { return MessagesReceived[static_cast<int32>(Type)].Get(); }
+
+	int64 GetDatagramsReceived() const { return DatagramsReceived.Get(); }
+	int64 GetBytesReceived() const { return BytesReceived.Get(); }
+
+	/** The number of frames received, i.e. the number of times the Frame field changed. */
+	int64 GetFramesAssembled() const { return FramesAssembled.Get(); }
+
+	/** The number of times the Frame field skipped frames, and the total number of frames skipped. */
+	int64 GetFrameGaps() const { return FrameGaps.Get(); }
+	int64 GetMissedFrames() const { return MissedFrames.Get(); }
+
+	/** The number of datagrams holding a frame older than the frame being received, whose messages were dropped. */
+	int64 GetOutOfOrderPackets() const { return OutOfOrderPackets.Get(); }
+
+	/** When the last datagram was read from the socket, in seconds. Only safe to read from the thread feeding the tracker. */
+	double GetReceiveTime() const { return ReceiveTime; }
+
+private:
+	//~ Begin IAugmentaDecoderListener interface
+	virtual void OnSceneDecoded(const FAugmentaSceneMessage& Message) override;
+	virtual void OnVideoOutputDecoded(const FAugmentaVideoOutputMessage& Message) override;
+	virtual void OnObjectDecoded(EAugmentaMessageType Type, const FAugmentaObjectMessage& Message) override;
+	virtual void OnObjectExtraDecoded(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Message) override;
+	//~ End IAugmentaDecoderListener interface
+
+	/**
+	 * Commits the frame being assembled if the message belongs to another frame. A message of an older frame than the latest
+	 * one marks its datagram as out of order, whose messages are then dropped (see bDatagramOutOfOrder).
+	 */
+	void BeginMessage(int32 Frame);
+
+	/** Processes the Augmenta Object Entered and Updated OSC Message. */
+	void UpdateObject(const FAugmentaObjectMessage& Message, bool HasEntered);
+	/** Processes the Augmenta Object Will Leave OSC Message. */
+	void RemoveObject(int32 Pid);
+	/** Processes the Augmenta Object enter and update extra data OSC Message. */
+	void UpdateObjectExtraData(const FAugmentaObjectExtraMessage& Message, bool HasEntered);
+	/** Processes the Augmenta Object leave extra data OSC Message. */
+	void RemoveObjectExtraData(int32 Id);
+
+	/** Whether the messages of the datagram being decoded are dropped, see bDatagramOutOfOrder. */
+	bool IsDroppingDatagram() const { return bDatagramOutOfOrder && !bDecodingClusterFrame; }
+
+	/** Returns a committed frame that is not referenced anymore, allocating one if needed. */
+	FAugmentaCommittedFrameRef AcquireFrame();
+
+	/** Records an event in the pending events, counting the allocations of the arrays it is added to. */
+	template <typename EventType>
+	void AddPendingEvent(EAugmentaEventType Type, TArray<EventType>& Events, const EventType& Event);
+
+	/** Decodes the received datagrams into Augmenta data. */
+	FAugmentaOSCDecoder Decoder;
+	FAugmentaBinaryDecoder BinaryDecoder;
+	FAugmentaClusterDecoder ClusterDecoder;
+
+	/** The tracking state updated message by message, used as the back buffer in frame assembly mode. */
+	FAugmentaFrameSnapshot LiveState;
+	/** The events not committed yet. */
+	FAugmentaFrameEvents PendingEvents;
+
+	/** The committed frames, referenced or ready to be recycled. */
+	TArray<FAugmentaCommittedFrameRef> FramePool;
+	/** The committed frames waiting to be dequeued. */
+	TCircularQueue<FAugmentaCommittedFrameRef> CommittedFrames;
+
+	/** When the objects that are not updated anymore are considered lost. */
+	FAugmentaExpiry Expiry;
+	/** The time the datagram being decoded was received, in seconds. */
+	double ReceiveTime = 0.0;
+	/** The time the first datagram of the frame being assembled was received, in seconds. */
+	double FrameReceiveTime = 0.0;
+
+	/** The most recent frame received, to detect the gaps and the out of order datagrams. INDEX_NONE before the first frame. */
+	int32 LatestFrame = INDEX_NONE;
+	/**
+	 * Whether the datagram being decoded holds a frame older than the latest one. Its messages are dropped rather than
+	 * overwriting the newer state, unless it is a cluster frame.
+	 */
+	bool bDatagramOutOfOrder = false;
+	/** Whether the datagram being decoded is a cluster frame, which the cluster decoder already orders and mirrors. */
+	bool bDecodingClusterFrame = false;
+	/** Whether a cluster packet was received since the last reset, which disables the expiry. */
+	bool bClusterStream = false;
+
+	/** Whether the frames are assembled and committed as a whole. */
+	bool bFrameAssembly = false;
+	/** Whether the live state holds changes that were not committed yet. */
+	bool bHasUncommittedChanges = false;
+	/** Whether the live state holds a whole frame whose commit was deferred because the queue was full. */
+	bool bCommitDeferred = false;
+
+	FAugmentaCounter DispatchAllocations;
+	FAugmentaCounter DroppedFrames;
+	FAugmentaCounter DroppedLeaves;
+
+	FAugmentaCounter MessagesReceived[NumMessageTypes];
+	FAugmentaCounter DatagramsReceived;
+	FAugmentaCounter BytesReceived;
+	FAugmentaCounter FramesAssembled;
+	FAugmentaCounter FrameGaps;
+	FAugmentaCounter MissedFrames;
+	FAugmentaCounter OutOfOrderPackets;
+};
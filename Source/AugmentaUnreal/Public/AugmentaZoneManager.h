@@ -0,0 +1,175 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "AugmentaData.h"
+#include "AugmentaZoneManager.generated.h"
+
+struct FAugmentaFrameSnapshot;
+
+/** Delegates */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAugmentaZoneObjectEvent, FName, ZoneName, const FAugmentaPerson&, Object);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FAugmentaZoneDwellEvent, FName, ZoneName, const FAugmentaPerson&, Object, float, DwellTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAugmentaZoneOccupancyEvent, FName, ZoneName, int32, Occupancy);
+
+/** The shape of an Augmenta zone. */
+UENUM(BlueprintType)
+enum class EAugmentaZoneShape : uint8
+{
+	Rect,
+	Circle,
+	Polygon,
+};
+
+/**
+ * Evaluates zones against the Augmenta Objects, natively and once per tick, and fires an event for every change :
+ * an object entering or leaving a zone, an object staying in a zone for its dwell time, or the occupancy of a zone changing.
+ *
+ * The zones are defined in normalized scene coordinates, like FAugmentaPerson::Centroid, and an object is inside a zone
+ * when its centroid is. Only the objects in the grid cells overlapping a zone are tested.
+ */
+UCLASS(BlueprintType, Category = "Augmenta")
+class AUGMENTAUNREAL_API UAugmentaZoneManager : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Adds a rectangular zone, replacing the zone with the same name if any.
+	 *
+	 * @param Name The unique name of the zone, given to its events.
+	 * @param Min The normalized minimum corner of the rectangle.
+	 * @param Max The normalized maximum corner of the rectangle.
+	 * @param DwellTime The time (in s) an object must stay in the zone before OnObjectDwelled is fired, zero to disable it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Zones")
+	void AddRectZone(FName Name, FVector2D Min, FVector2D Max, float DwellTime = 0.f);
+
+	/**
+	 * Adds a circular zone, replacing the zone with the same name if any.
+	 *
+	 * @param Name The unique name of the zone, given to its events.
+	 * @param Center The normalized center of the circle.
+	 * @param Radius The radius of the circle (in m), or in normalized units until the scene size is received.
+	 * @param DwellTime The time (in s) an object must stay in the zone before OnObjectDwelled is fired, zero to disable it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Zones")
+	void AddCircleZone(FName Name, FVector2D Center, float Radius, float DwellTime = 0.f);
+
+	/**
+	 * Adds a polygonal zone, replacing the zone with the same name if any.
+	 *
+	 * @param Name The unique name of the zone, given to its events.
+	 * @param Points The normalized vertices of the polygon, at least three.
+	 * @param DwellTime The time (in s) an object must stay in the zone before OnObjectDwelled is fired, zero to disable it.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Zones")
+	void AddPolygonZone(FName Name, const TArray<FVector2D>& Points, float DwellTime = 0.f);
+
+	/** Removes a zone, without firing any event. Returns false if there is no zone with this name. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Zones")
+	bool RemoveZone(FName Name);
+
+	/** Removes every zone, without firing any event. */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Zones")
+	void RemoveAllZones();
+
+	/** Returns the number of objects inside a zone. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Zones")
+	int32 GetZoneOccupancy(FName Name) const;
+
+	/** Returns the objects inside a zone, as of the last evaluation. */
+	UFUNCTION(BlueprintPure, Category = "Augmenta|Zones")
+	TArray<FAugmentaPerson> GetObjectsInZone(FName Name) const;
+
+	/** A delegate that is fired when an Augmenta Object enters a zone. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Zones")
+	FAugmentaZoneObjectEvent OnObjectEntered;
+
+	/** A delegate that is fired when an Augmenta Object leaves a zone, or leaves the scene while inside a zone. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Zones")
+	FAugmentaZoneObjectEvent OnObjectLeft;
+
+	/** A delegate that is fired once when an Augmenta Object has stayed in a zone for the dwell time of the zone. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Zones")
+	FAugmentaZoneDwellEvent OnObjectDwelled;
+
+	/** A delegate that is fired when the number of objects inside a zone changes. */
+	UPROPERTY(BlueprintAssignable, Category = "Augmenta|Zones")
+	FAugmentaZoneOccupancyEvent OnOccupancyChanged;
+
+	/**
+	 * Evaluates every zone against the tracking state and fires the events of the changes.
+	 *
+	 * @param Snapshot The tracking state.
+	 * @param Now The current time, in seconds (see FPlatformTime::Seconds).
+	 * @param bSnapshotChanged Whether the tracking state changed since the last evaluation. Only the dwell times are checked otherwise.
+	 */
+	void Evaluate(const FAugmentaFrameSnapshot& Snapshot, double Now, bool bSnapshotChanged);
+
+	bool HasZones() const { return Zones.Num() > 0; }
+
+private:
+	/** An object inside a zone. */
+	struct FZoneMember
+	{
+		/** The object as of the last evaluation, given to the leave event once it is gone. */
+		FAugmentaPerson Object;
+		/** When the object entered the zone, in seconds. */
+		double EnterTime;
+		bool bDwelled;
+	};
+
+	struct FZone
+	{
+		FName Name;
+		EAugmentaZoneShape Shape;
+		/** The normalized bounds of a rect or polygon zone. */
+		FVector2f Min;
+		FVector2f Max;
+		/** The normalized center and the radius of a circle zone. */
+		FVector2f Center;
+		float Radius = 0.f;
+		TArray<FVector2f> Points;
+		float DwellTime = 0.f;
+		/** The objects inside the zone, sorted by Pid. */
+		TArray<FZoneMember> Members;
+	};
+
+	/** An event of the evaluation, fired once every zone is evaluated. */
+	struct FPendingEvent
+	{
+		enum class EType : uint8
+		{
+			Entered,
+			Left,
+			Dwelled,
+			OccupancyChanged,
+		};
+
+		EType Type;
+		FName ZoneName;
+		FAugmentaPerson Object;
+		float Value;
+	};
+
+	/** Returns the zone with the given name, adding it if there is none. Its members are kept. */
+	FZone& FindOrAddZone(FName Name);
+
+	/** Tests whether a normalized position is inside a zone. */
+	static bool Contains(const FZone& Zone, const FVector2f& Position, const FVector2f& Scale);
+
+	/** Updates the members of a zone from the objects inside it. */
+	void UpdateMembers(FZone& Zone, const FAugmentaFrameSnapshot& Snapshot, const FVector2f& Scale, double Now);
+
+	TArray<FZone> Zones;
+	/** Whether a zone was added or modified since the last evaluation. */
+	bool bZonesChanged = false;
+
+	/** Scratch arrays reused by every evaluation. */
+	TArray<int32> InsideSlots;
+	TArray<FZoneMember> NewMembers;
+	TArray<FPendingEvent> PendingEvents;
+};
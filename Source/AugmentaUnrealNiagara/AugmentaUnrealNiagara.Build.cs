@@ -0,0 +1,31 @@
+// Copyright Augmenta, All Rights Reserved.
+
+using UnrealBuildTool;
+
+// The Niagara data interface of the Augmenta receiver, kept apart so that the AugmentaUnreal module does not depend on Niagara
+public class AugmentaUnrealNiagara : ModuleRules
+{
+	public AugmentaUnrealNiagara(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"AugmentaUnreal",
+				"Niagara"
+			}
+			);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Engine",
+				"NiagaraCore",
+				"VectorVM"
+			}
+			);
+	}
+}
@@ -0,0 +1,306 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "AugmentaNiagaraDataInterface.h"
+#include "AugmentaReceiver.h"
+#include "AugmentaTracker.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraTypes.h"
+
+#define LOCTEXT_NAMESPACE "AugmentaNiagaraDataInterface"
+
+namespace AugmentaNiagaraDataInterface
+{
+	const FName GetNumObjectsName(TEXT("GetNumObjects"));
+	const FName GetSceneSizeName(TEXT("GetSceneSize"));
+	const FName GetObjectName(TEXT("GetObject"));
+	const FName GetObjectByPidName(TEXT("GetObjectByPid"));
+	const FName GetObjectIndexName(TEXT("GetObjectIndex"));
+
+	/** The frame a system instance reads during a tick. */
+	struct FInstanceData
+	{
+		/** The committed frame of the receiver, held so that it is not recycled while it is read. */
+		FAugmentaCommittedFrameRef Frame;
+		/** The copy of the tracking state, when the receiver does not assemble the frames. */
+		FAugmentaFrameSnapshot Copy;
+		/** The snapshot read by the VM functions, never null. */
+		const FAugmentaFrameSnapshot* Snapshot = nullptr;
+	};
+
+	const FAugmentaFrameSnapshot EmptySnapshot;
+
+	/** The outputs of GetObject and GetObjectByPid, in the order they are declared. */
+	struct FObjectOutputs
+	{
+		FNDIOutputParam<bool> Valid;
+		FNDIOutputParam<int32> Pid;
+		FNDIOutputParam<FVector2f> Position;
+		FNDIOutputParam<FVector2f> Velocity;
+		FNDIOutputParam<FVector2f> BoundingRectPosition;
+		FNDIOutputParam<FVector2f> BoundingRectSize;
+		FNDIOutputParam<float> BoundingRectRotation;
+		FNDIOutputParam<float> Height;
+
+		explicit FObjectOutputs(FVectorVMExternalFunctionContext& Context)
+			: Valid(Context)
+			, Pid(Context)
+			, Position(Context)
+			, Velocity(Context)
+			, BoundingRectPosition(Context)
+			, BoundingRectSize(Context)
+			, BoundingRectRotation(Context)
+			, Height(Context)
+		{
+		}
+
+		/** Writes an object, or zeros if it is null. */
+		void SetAndAdvance(const FAugmentaPerson* Object)
+		{
+			static const FAugmentaPerson NoObject;
+			const FAugmentaPerson& Value = Object ? *Object : NoObject;
+			Valid.SetAndAdvance(Object != nullptr);
+			Pid.SetAndAdvance(Object ? Value.Pid : INDEX_NONE);
+			Position.SetAndAdvance(FVector2f(Value.Centroid));
+			Velocity.SetAndAdvance(FVector2f(Value.Velocity));
+			BoundingRectPosition.SetAndAdvance(FVector2f(Value.BoundingRectPos));
+			BoundingRectSize.SetAndAdvance(FVector2f(Value.BoundingRectSize));
+			BoundingRectRotation.SetAndAdvance(Value.BoundingRectRotation);
+			Height.SetAndAdvance(Value.Height);
+		}
+	};
+
+	FNiagaraFunctionSignature MakeSignature(UClass* Class, FName Name)
+	{
+		FNiagaraFunctionSignature Signature;
+		Signature.Name = Name;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition(Class), TEXT("Augmenta")));
+		return Signature;
+	}
+
+	void AddObjectOutputs(FNiagaraFunctionSignature& Signature)
+	{
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetBoolDef(), TEXT("Valid")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Pid")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("Position")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("Velocity")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("BoundingRectPosition")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("BoundingRectSize")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("BoundingRectRotation")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Height")));
+	}
+}
+
+void UAugmentaNiagaraDataInterface::SetNiagaraAugmentaReceiver(UNiagaraComponent* NiagaraComponent, FName OverrideName, UAugmentaReceiver* InReceiver)
+{
+	if (UAugmentaNiagaraDataInterface* DataInterface = UNiagaraFunctionLibrary::GetDataInterface<UAugmentaNiagaraDataInterface>(NiagaraComponent, OverrideName))
+	{
+		DataInterface->Receiver = InReceiver;
+	}
+}
+
+void UAugmentaNiagaraDataInterface::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// Make the interface available as a user parameter, so that the receiver can be set on the component
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter);
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+	using namespace AugmentaNiagaraDataInterface;
+
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetNumObjectsName));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Num")));
+#if WITH_EDITORONLY_DATA
+		Signature.Description = LOCTEXT("GetNumObjectsDescription", "Returns the number of Augmenta Objects.");
+#endif
+	}
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetSceneSizeName));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec2Def(), TEXT("SceneSize")));
+#if WITH_EDITORONLY_DATA
+		Signature.Description = LOCTEXT("GetSceneSizeDescription", "Returns the size of the Augmenta scene (in m), the normalized positions and sizes are scaled by.");
+#endif
+	}
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetObjectName));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index")));
+		AddObjectOutputs(Signature);
+#if WITH_EDITORONLY_DATA
+		Signature.Description = LOCTEXT("GetObjectDescription", "Returns the Augmenta Object at an index between 0 and GetNumObjects, Valid is false outside of this range.");
+#endif
+	}
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetObjectByPidName));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Pid")));
+		AddObjectOutputs(Signature);
+#if WITH_EDITORONLY_DATA
+		Signature.Description = LOCTEXT("GetObjectByPidDescription", "Returns the Augmenta Object with a Pid, Valid is false if it is not in the scene.");
+#endif
+	}
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.Add_GetRef(MakeSignature(GetClass(), GetObjectIndexName));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Pid")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index")));
+#if WITH_EDITORONLY_DATA
+		Signature.Description = LOCTEXT("GetObjectIndexDescription", "Returns the index of the Augmenta Object with a Pid, or -1 if it is not in the scene. The indices are only stable for a tick.");
+#endif
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	using namespace AugmentaNiagaraDataInterface;
+
+	if (BindingInfo.Name == GetNumObjectsName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UAugmentaNiagaraDataInterface::GetNumObjects);
+	}
+	else if (BindingInfo.Name == GetSceneSizeName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UAugmentaNiagaraDataInterface::GetSceneSize);
+	}
+	else if (BindingInfo.Name == GetObjectName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UAugmentaNiagaraDataInterface::GetObject);
+	}
+	else if (BindingInfo.Name == GetObjectByPidName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UAugmentaNiagaraDataInterface::GetObjectByPid);
+	}
+	else if (BindingInfo.Name == GetObjectIndexName)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UAugmentaNiagaraDataInterface::GetObjectIndex);
+	}
+}
+
+bool UAugmentaNiagaraDataInterface::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	AugmentaNiagaraDataInterface::FInstanceData* InstanceData = new (PerInstanceData) AugmentaNiagaraDataInterface::FInstanceData();
+	InstanceData->Snapshot = &AugmentaNiagaraDataInterface::EmptySnapshot;
+	return true;
+}
+
+void UAugmentaNiagaraDataInterface::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	static_cast<AugmentaNiagaraDataInterface::FInstanceData*>(PerInstanceData)->~FInstanceData();
+}
+
+int32 UAugmentaNiagaraDataInterface::PerInstanceDataSize() const
+{
+	return sizeof(AugmentaNiagaraDataInterface::FInstanceData);
+}
+
+bool UAugmentaNiagaraDataInterface::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	using namespace AugmentaNiagaraDataInterface;
+
+	// Pick the frame of the tick on the game thread, the simulation may then read it from any thread while the receiver ticks
+	FInstanceData& InstanceData = *static_cast<FInstanceData*>(PerInstanceData);
+	InstanceData.Frame.Reset();
+	InstanceData.Snapshot = &EmptySnapshot;
+	if (!Receiver)
+	{
+		return false;
+	}
+
+	InstanceData.Frame = Receiver->GetCommittedFrame();
+	if (InstanceData.Frame)
+	{
+		InstanceData.Snapshot = &InstanceData.Frame->Snapshot;
+	}
+	else
+	{
+		InstanceData.Copy.CopyFrom(Receiver->GetFrameSnapshot());
+		InstanceData.Snapshot = &InstanceData.Copy;
+	}
+	return false;
+}
+
+bool UAugmentaNiagaraDataInterface::Equals(const UNiagaraDataInterface* Other) const
+{
+	return Super::Equals(Other) && CastChecked<UAugmentaNiagaraDataInterface>(Other)->Receiver == Receiver;
+}
+
+bool UAugmentaNiagaraDataInterface::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+	CastChecked<UAugmentaNiagaraDataInterface>(Destination)->Receiver = Receiver;
+	return true;
+}
+
+void UAugmentaNiagaraDataInterface::GetNumObjects(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<AugmentaNiagaraDataInterface::FInstanceData> InstanceData(Context);
+	FNDIOutputParam<int32> OutNum(Context);
+
+	const int32 Num = InstanceData->Snapshot->Objects.Num();
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		OutNum.SetAndAdvance(Num);
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetSceneSize(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<AugmentaNiagaraDataInterface::FInstanceData> InstanceData(Context);
+	FNDIOutputParam<FVector2f> OutSceneSize(Context);
+
+	const FVector2f SceneSize(InstanceData->Snapshot->Scene.SceneSize);
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		OutSceneSize.SetAndAdvance(SceneSize);
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetObject(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<AugmentaNiagaraDataInterface::FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InIndex(Context);
+	AugmentaNiagaraDataInterface::FObjectOutputs Outputs(Context);
+
+	const TConstArrayView<FAugmentaPerson> Objects = InstanceData->Snapshot->Objects.GetObjects();
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		const int32 Index = InIndex.GetAndAdvance();
+		Outputs.SetAndAdvance(Objects.IsValidIndex(Index) ? &Objects[Index] : nullptr);
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetObjectByPid(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<AugmentaNiagaraDataInterface::FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InPid(Context);
+	AugmentaNiagaraDataInterface::FObjectOutputs Outputs(Context);
+
+	const FAugmentaObjectStore& Objects = InstanceData->Snapshot->Objects;
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		Outputs.SetAndAdvance(Objects.Find(InPid.GetAndAdvance()));
+	}
+}
+
+void UAugmentaNiagaraDataInterface::GetObjectIndex(FVectorVMExternalFunctionContext& Context)
+{
+	VectorVM::FUserPtrHandler<AugmentaNiagaraDataInterface::FInstanceData> InstanceData(Context);
+	FNDIInputParam<int32> InPid(Context);
+	FNDIOutputParam<int32> OutIndex(Context);
+
+	const FAugmentaObjectStore& Objects = InstanceData->Snapshot->Objects;
+	for (int32 Instance = 0; Instance < Context.GetNumInstances(); ++Instance)
+	{
+		OutIndex.SetAndAdvance(Objects.FindSlot(InPid.GetAndAdvance()));
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
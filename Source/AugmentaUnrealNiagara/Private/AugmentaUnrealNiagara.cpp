@@ -0,0 +1,5 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, AugmentaUnrealNiagara)
@@ -0,0 +1,72 @@
+// Copyright Augmenta, All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "AugmentaNiagaraDataInterface.generated.h"
+
+/** Forward Declarations */
+class UAugmentaReceiver;
+class UNiagaraComponent;
+
+/**
+ * Exposes the Augmenta Objects of a receiver to the CPU simulations of a Niagara system, read in place from the object store
+ * of the receiver : the number of objects, then by index or by Pid their position, velocity, bounding rectangle and height.
+ * The positions and sizes are normalized, like FAugmentaPerson::Centroid, GetSceneSize gives the size of the scene in meters.
+ *
+ * The system reads the same frame for a whole tick. In frame assembly mode (see UAugmentaReceiver::bFrameAssembly), the
+ * interface holds a reference to the committed frame of the receiver and nothing is copied. Otherwise the tracking state is
+ * copied once per tick, into a buffer reused from one tick to the next.
+ *
+ * The receiver is set at runtime on the user parameter of a Niagara component, see SetNiagaraAugmentaReceiver.
+ */
+UCLASS(EditInlineNew, Category = "Augmenta", meta = (DisplayName = "Augmenta Objects"))
+class AUGMENTAUNREALNIAGARA_API UAugmentaNiagaraDataInterface : public UNiagaraDataInterface
+{
+	GENERATED_BODY()
+
+public:
+	/** The receiver whose objects are read, see SetNiagaraAugmentaReceiver. */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Augmenta")
+	TObjectPtr<UAugmentaReceiver> Receiver;
+
+	/**
+	 * Sets the receiver read by the Augmenta Objects user parameter of a Niagara component.
+	 *
+	 * @param NiagaraComponent The component running the system.
+	 * @param OverrideName The name of the user parameter, e.g. User.Augmenta.
+	 * @param InReceiver The receiver whose objects are read.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Augmenta|Niagara")
+	static void SetNiagaraAugmentaReceiver(UNiagaraComponent* NiagaraComponent, FName OverrideName, UAugmentaReceiver* InReceiver);
+
+	//~ Begin UObject interface
+	virtual void PostInitProperties() override;
+	//~ End UObject interface
+
+	//~ Begin UNiagaraDataInterface interface
+	virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc) override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return Target == ENiagaraSimTarget::CPUSim; }
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual int32 PerInstanceDataSize() const override;
+	virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+	virtual bool HasPreSimulateTick() const override { return true; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+	//~ End UNiagaraDataInterface interface
+
+protected:
+	//~ Begin UNiagaraDataInterface interface
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+	//~ End UNiagaraDataInterface interface
+
+private:
+	/** The VM functions, see GetFunctions. */
+	void GetNumObjects(FVectorVMExternalFunctionContext& Context);
+	void GetSceneSize(FVectorVMExternalFunctionContext& Context);
+	void GetObject(FVectorVMExternalFunctionContext& Context);
+	void GetObjectByPid(FVectorVMExternalFunctionContext& Context);
+	void GetObjectIndex(FVectorVMExternalFunctionContext& Context);
+};
@@ -0,0 +1,372 @@
+// Copyright Augmenta, All Rights Reserved.
+
+// Measures the decoding cost of the OSC and binary Augmenta protocols without the engine, see CMakeLists.txt.
+//
+// AugmentaProtocolBenchmark [--objects=50,200,1000] [--frames=1000] [--datagram-size=1400] [--no-extra]
+
+#include "AugmentaBinaryProtocol.h"
+#include "AugmentaOSCEncoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace AugmentaProtocolBenchmark
+{
+	/** The number of heap allocations made by the process, counted by the global operator new below. */
+	uint64_t NumAllocations = 0;
+
+	/** The datagrams are stored at this alignment, like in a receive buffer. */
+	constexpr size_t DatagramAlignment = 16;
+
+	struct FSettings
+	{
+		std::vector<int32_t> ObjectCounts = { 50, 200, 1000 };
+		int32_t NumFrames = 1000;
+		size_t DatagramSize = 1400;
+		bool bSendExtraData = true;
+	};
+
+	/** The datagrams of an encoded stream, stored back to back. */
+	struct FEncodedStream
+	{
+		std::vector<uint8_t> Bytes;
+		/** The offset and size of every datagram. */
+		std::vector<std::pair<size_t, size_t>> Datagrams;
+		/** The size of the datagrams, without the alignment padding. */
+		size_t NumBytes = 0;
+		uint64_t NumMessages = 0;
+	};
+
+	struct FDecodeResult
+	{
+		double Seconds = 0.0;
+		uint64_t MessagesDecoded = 0;
+		uint64_t Allocations = 0;
+	};
+
+	/** Applies the decoded objects to a dense state indexed by id, standing in for the tracker of the plugin. */
+	class FStateListener : public IAugmentaDecoderListener
+	{
+	public:
+		explicit FStateListener(size_t NumObjects)
+			: Objects(NumObjects)
+			, Extras(NumObjects)
+		{
+		}
+
+		virtual void OnSceneDecoded(const FAugmentaSceneMessage& InScene) override { Scene = InScene; }
+		virtual void OnVideoOutputDecoded(const FAugmentaVideoOutputMessage& InVideoOutput) override { VideoOutput = InVideoOutput; }
+		virtual void OnObjectDecoded(EAugmentaMessageType, const FAugmentaObjectMessage& Object) override
+		{
+			if (Object.Pid >= 0 && static_cast<size_t>(Object.Pid) < Objects.size())
+			{
+				Objects[Object.Pid] = Object;
+			}
+		}
+		virtual void OnObjectExtraDecoded(EAugmentaMessageType, const FAugmentaObjectExtraMessage& Extra) override
+		{
+			if (Extra.Id >= 0 && static_cast<size_t>(Extra.Id) < Extras.size())
+			{
+				Extras[Extra.Id] = Extra;
+			}
+		}
+
+		/** A value depending on the whole state, so that the decoding cannot be optimized away. */
+		double GetChecksum() const
+		{
+			double Checksum = Scene.SizeX + VideoOutput.SizeX;
+			for (const FAugmentaObjectMessage& Object : Objects)
+			{
+				Checksum += Object.CentroidX + Object.CentroidY + Object.Height;
+			}
+			for (const FAugmentaObjectExtraMessage& Extra : Extras)
+			{
+				Checksum += Extra.Distance;
+			}
+			return Checksum;
+		}
+
+	private:
+		FAugmentaSceneMessage Scene;
+		FAugmentaVideoOutputMessage VideoOutput;
+		std::vector<FAugmentaObjectMessage> Objects;
+		std::vector<FAugmentaObjectExtraMessage> Extras;
+	};
+
+	void BeginDatagram(FAugmentaOSCEncoder& Encoder)
+	{
+		Encoder.Reset();
+		Encoder.BeginBundle();
+	}
+
+	void BeginDatagram(FAugmentaBinaryEncoder& Encoder)
+	{
+		Encoder.Reset();
+	}
+
+	void EndDatagram(FAugmentaOSCEncoder& Encoder)
+	{
+		Encoder.EndBundle();
+	}
+
+	void EndDatagram(FAugmentaBinaryEncoder&)
+	{
+	}
+
+	/** Appends the current datagram to the stream and opens a new one. */
+	template <typename EncoderType>
+	void FlushDatagram(EncoderType& Encoder, FEncodedStream& Stream)
+	{
+		if (Encoder.GetNumMessages() == 0)
+		{
+			return;
+		}
+		EndDatagram(Encoder);
+
+		const size_t Offset = (Stream.Bytes.size() + DatagramAlignment - 1) & ~(DatagramAlignment - 1);
+		Stream.Bytes.resize(Offset + Encoder.GetSize());
+		memcpy(Stream.Bytes.data() + Offset, Encoder.GetData(), Encoder.GetSize());
+		Stream.Datagrams.emplace_back(Offset, Encoder.GetSize());
+		Stream.NumBytes += Encoder.GetSize();
+		Stream.NumMessages += Encoder.GetNumMessages();
+
+		BeginDatagram(Encoder);
+	}
+
+	/** Writes a message, flushing the current datagram first when it is full. */
+	template <typename EncoderType, typename WriteFuncType>
+	void WriteMessage(EncoderType& Encoder, FEncodedStream& Stream, WriteFuncType&& WriteFunc)
+	{
+		if (!WriteFunc(Encoder))
+		{
+			FlushDatagram(Encoder, Stream);
+			if (!WriteFunc(Encoder))
+			{
+				fprintf(stderr, "A message does not fit in a datagram.\n");
+				exit(1);
+			}
+		}
+	}
+
+	/** Encodes the frames of a crowd wandering in the scene, all the objects first, then all their extra data. */
+	template <typename EncoderType>
+	FEncodedStream EncodeFrames(const FSettings& Settings, int32_t NumObjects)
+	{
+		std::mt19937 Random(0);
+		std::uniform_real_distribution<float> Position(0.f, 1.f);
+		std::uniform_real_distribution<float> Speed(-0.01f, 0.01f);
+
+		std::vector<FAugmentaObjectMessage> Objects(NumObjects);
+		for (int32_t Index = 0; Index < NumObjects; ++Index)
+		{
+			FAugmentaObjectMessage& Object = Objects[Index];
+			Object.Pid = Index;
+			Object.Oid = Index;
+			Object.CentroidX = Position(Random);
+			Object.CentroidY = Position(Random);
+			Object.VelocityX = Speed(Random);
+			Object.VelocityY = Speed(Random);
+			Object.BoundingRectSizeX = 0.05f;
+			Object.BoundingRectSizeY = 0.05f;
+			Object.Height = 1.f + Position(Random);
+		}
+
+		FEncodedStream Stream;
+		std::vector<uint8_t> DatagramBuffer(Settings.DatagramSize);
+		EncoderType Encoder(DatagramBuffer.data(), DatagramBuffer.size());
+		BeginDatagram(Encoder);
+
+		for (int32_t Frame = 0; Frame < Settings.NumFrames; ++Frame)
+		{
+			FAugmentaSceneMessage Scene;
+			Scene.Frame = Frame;
+			Scene.ObjectCount = NumObjects;
+			Scene.SizeX = 20.f;
+			Scene.SizeY = 10.f;
+			WriteMessage(Encoder, Stream, [&Scene](EncoderType& Target) { return Target.WriteScene(Scene); });
+
+			const EAugmentaMessageType Type = Frame == 0 ? EAugmentaMessageType::ObjectEnter : EAugmentaMessageType::ObjectUpdate;
+			for (FAugmentaObjectMessage& Object : Objects)
+			{
+				Object.Frame = Frame;
+				Object.Age += 1.f / 60.f;
+				Object.CentroidX = Object.CentroidX + Object.VelocityX - std::floor(Object.CentroidX + Object.VelocityX);
+				Object.CentroidY = Object.CentroidY + Object.VelocityY - std::floor(Object.CentroidY + Object.VelocityY);
+				Object.BoundingRectPosX = Object.CentroidX;
+				Object.BoundingRectPosY = Object.CentroidY;
+				WriteMessage(Encoder, Stream, [Type, &Object](EncoderType& Target) { return Target.WriteObject(Type, Object); });
+			}
+
+			if (Settings.bSendExtraData)
+			{
+				const EAugmentaMessageType ExtraType = Frame == 0 ? EAugmentaMessageType::ObjectExtraEnter : EAugmentaMessageType::ObjectExtraUpdate;
+				for (const FAugmentaObjectMessage& Object : Objects)
+				{
+					FAugmentaObjectExtraMessage Extra;
+					Extra.Frame = Frame;
+					Extra.Id = Object.Pid;
+					Extra.Oid = Object.Oid;
+					Extra.HighestX = Object.CentroidX;
+					Extra.HighestY = Object.CentroidY;
+					Extra.Distance = Object.Height;
+					Extra.Reflectivity = 0.5f;
+					WriteMessage(Encoder, Stream, [ExtraType, &Extra](EncoderType& Target) { return Target.WriteObjectExtra(ExtraType, Extra); });
+				}
+			}
+
+			// Every frame starts a new datagram, like the Augmenta servers do
+			FlushDatagram(Encoder, Stream);
+		}
+		return Stream;
+	}
+
+	/** Decodes a stream, once to warm up and once measured. */
+	template <typename DecoderType>
+	FDecodeResult DecodeStream(const FEncodedStream& Stream, int32_t NumObjects, double& OutChecksum)
+	{
+		FDecodeResult Result;
+		for (int32_t Pass = 0; Pass < 2; ++Pass)
+		{
+			DecoderType Decoder;
+			if constexpr (std::is_same_v<DecoderType, FAugmentaOSCDecoder>)
+			{
+				Decoder.BuildDispatchTable();
+			}
+			FStateListener Listener(NumObjects);
+
+			const uint64_t StartAllocations = NumAllocations;
+			const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+			for (const std::pair<size_t, size_t>& Datagram : Stream.Datagrams)
+			{
+				Decoder.Decode(Stream.Bytes.data() + Datagram.first, Datagram.second, Listener);
+			}
+			Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+			Result.Allocations = NumAllocations - StartAllocations;
+			Result.MessagesDecoded = Decoder.GetMessagesDecoded();
+			OutChecksum += Listener.GetChecksum();
+		}
+		return Result;
+	}
+
+	bool ReportResult(const char* Name, const FEncodedStream& Stream, const FDecodeResult& Result, const FSettings& Settings, int32_t NumObjects)
+	{
+		const double NumFrames = Settings.NumFrames;
+		const double Seconds = std::max(Result.Seconds, 1e-9);
+		printf("  %-6s : %9.0f messages/s, %7.1f ns/object, %8.2f us/frame, %8.1f bytes/frame, %.2f allocations/frame, %llu/%llu messages decoded\n",
+			Name,
+			static_cast<double>(Result.MessagesDecoded) / Seconds,
+			Seconds / (NumFrames * std::max(NumObjects, 1)) * 1e9,
+			Seconds / NumFrames * 1e6,
+			static_cast<double>(Stream.NumBytes) / NumFrames,
+			static_cast<double>(Result.Allocations) / NumFrames,
+			static_cast<unsigned long long>(Result.MessagesDecoded), static_cast<unsigned long long>(Stream.NumMessages));
+
+		return Result.MessagesDecoded == Stream.NumMessages && Result.Allocations == 0;
+	}
+
+	bool ParseSettings(int Argc, char** Argv, FSettings& OutSettings)
+	{
+		for (int Index = 1; Index < Argc; ++Index)
+		{
+			const std::string Argument = Argv[Index];
+			if (Argument.rfind("--objects=", 0) == 0)
+			{
+				OutSettings.ObjectCounts.clear();
+				const char* Cursor = Argument.c_str() + strlen("--objects=");
+				while (*Cursor)
+				{
+					char* End;
+					OutSettings.ObjectCounts.push_back(std::max(static_cast<int32_t>(strtol(Cursor, &End, 10)), 0));
+					Cursor = *End == ',' ? End + 1 : End;
+					if (End == Cursor && *Cursor)
+					{
+						return false;
+					}
+				}
+			}
+			else if (Argument.rfind("--frames=", 0) == 0)
+			{
+				OutSettings.NumFrames = std::max(atoi(Argument.c_str() + strlen("--frames=")), 1);
+			}
+			else if (Argument.rfind("--datagram-size=", 0) == 0)
+			{
+				// The largest record or message must fit in a datagram
+				OutSettings.DatagramSize = std::clamp(atoi(Argument.c_str() + strlen("--datagram-size=")), 128, 65507);
+			}
+			else if (Argument == "--no-extra")
+			{
+				OutSettings.bSendExtraData = false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return !OutSettings.ObjectCounts.empty();
+	}
+}
+
+void* operator new(size_t Size)
+{
+	++AugmentaProtocolBenchmark::NumAllocations;
+	if (void* Pointer = malloc(Size ? Size : 1))
+	{
+		return Pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* Pointer) noexcept
+{
+	free(Pointer);
+}
+
+void operator delete(void* Pointer, size_t) noexcept
+{
+	free(Pointer);
+}
+
+int main(int Argc, char** Argv)
+{
+	using namespace AugmentaProtocolBenchmark;
+
+	FSettings Settings;
+	if (!ParseSettings(Argc, Argv, Settings))
+	{
+		fprintf(stderr, "Usage: %s [--objects=50,200,1000] [--frames=1000] [--datagram-size=1400] [--no-extra]\n", Argv[0]);
+		return 2;
+	}
+
+	bool bSucceeded = true;
+	double Checksum = 0.0;
+	for (const int32_t NumObjects : Settings.ObjectCounts)
+	{
+		printf("%d objects%s, %d frames, datagrams of %zu bytes\n",
+			NumObjects, Settings.bSendExtraData ? " with extra data" : "", Settings.NumFrames, Settings.DatagramSize);
+
+		const FEncodedStream OSCStream = EncodeFrames<FAugmentaOSCEncoder>(Settings, NumObjects);
+		const FEncodedStream BinaryStream = EncodeFrames<FAugmentaBinaryEncoder>(Settings, NumObjects);
+		const FDecodeResult OSCResult = DecodeStream<FAugmentaOSCDecoder>(OSCStream, NumObjects, Checksum);
+		const FDecodeResult BinaryResult = DecodeStream<FAugmentaBinaryDecoder>(BinaryStream, NumObjects, Checksum);
+
+		bSucceeded &= ReportResult("OSC", OSCStream, OSCResult, Settings, NumObjects);
+		bSucceeded &= ReportResult("Binary", BinaryStream, BinaryResult, Settings, NumObjects);
+	}
+
+	if (!bSucceeded)
+	{
+		fprintf(stderr, "Some messages were not decoded, or decoding allocated memory.\n");
+		return 1;
+	}
+	// Printed so that the decoded state is used
+	printf("checksum %g\n", Checksum);
+	return 0;
+}
@@ -0,0 +1,254 @@
+// Copyright Augmenta, All Rights Reserved.
+
+// Native tests of the engine independent protocol sources, see CMakeLists.txt.
+
+#include "AugmentaBinaryProtocol.h"
+#include "AugmentaOSCEncoder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace AugmentaProtocolTests
+{
+	int32_t NumChecks = 0;
+	int32_t NumFailures = 0;
+
+	void Check(bool bCondition, const char* Expression, const char* File, int32_t Line)
+	{
+		++NumChecks;
+		if (!bCondition)
+		{
+			++NumFailures;
+			fprintf(stderr, "%s(%d): check failed: %s\n", File, Line, Expression);
+		}
+	}
+
+	/** Records every decoded message, in the order they were decoded. */
+	class FRecordingListener : public IAugmentaDecoderListener
+	{
+	public:
+		std::vector<FAugmentaSceneMessage> Scenes;
+		std::vector<FAugmentaVideoOutputMessage> VideoOutputs;
+		std::vector<EAugmentaMessageType> ObjectTypes;
+		std::vector<FAugmentaObjectMessage> Objects;
+		std::vector<EAugmentaMessageType> ExtraTypes;
+		std::vector<FAugmentaObjectExtraMessage> Extras;
+
+		virtual void OnSceneDecoded(const FAugmentaSceneMessage& Scene) override { Scenes.push_back(Scene); }
+		virtual void OnVideoOutputDecoded(const FAugmentaVideoOutputMessage& VideoOutput) override { VideoOutputs.push_back(VideoOutput); }
+		virtual void OnObjectDecoded(EAugmentaMessageType Type, const FAugmentaObjectMessage& Object) override
+		{
+			ObjectTypes.push_back(Type);
+			Objects.push_back(Object);
+		}
+		virtual void OnObjectExtraDecoded(EAugmentaMessageType Type, const FAugmentaObjectExtraMessage& Extra) override
+		{
+			ExtraTypes.push_back(Type);
+			Extras.push_back(Extra);
+		}
+	};
+
+	FAugmentaObjectMessage MakeObject(int32_t Frame, int32_t Pid)
+	{
+		FAugmentaObjectMessage Object;
+		Object.Frame = Frame;
+		Object.Pid = Pid;
+		Object.Oid = Pid + 100;
+		Object.Age = 1.5f;
+		Object.CentroidX = 0.25f + static_cast<float>(Pid) * 0.01f;
+		Object.CentroidY = 0.75f;
+		Object.VelocityX = -0.125f;
+		Object.VelocityY = 0.0625f;
+		Object.Orientation = 90.f;
+		Object.BoundingRectPosX = Object.CentroidX;
+		Object.BoundingRectPosY = Object.CentroidY;
+		Object.BoundingRectSizeX = 0.05f;
+		Object.BoundingRectSizeY = 0.04f;
+		Object.BoundingRectRotation = 45.f;
+		Object.Height = 1.75f;
+		return Object;
+	}
+
+	FAugmentaObjectExtraMessage MakeExtra(int32_t Frame, int32_t Id)
+	{
+		FAugmentaObjectExtraMessage Extra;
+		Extra.Frame = Frame;
+		Extra.Id = Id;
+		Extra.Oid = Id + 100;
+		Extra.HighestX = 0.5f;
+		Extra.HighestY = 0.25f;
+		Extra.Distance = 3.f;
+		Extra.Reflectivity = 0.5f;
+		return Extra;
+	}
+
+	bool Equals(const FAugmentaObjectMessage& A, const FAugmentaObjectMessage& B)
+	{
+		return memcmp(&A, &B, sizeof(A)) == 0;
+	}
+
+	bool Equals(const FAugmentaObjectExtraMessage& A, const FAugmentaObjectExtraMessage& B)
+	{
+		return memcmp(&A, &B, sizeof(A)) == 0;
+	}
+}
+
+#define AUGMENTA_CHECK(Expression) AugmentaProtocolTests::Check(static_cast<bool>(Expression), #Expression, __FILE__, __LINE__)
+
+namespace AugmentaProtocolTests
+{
+	/** Every message type survives an OSC round trip, in nested bundles, with all of its arguments. */
+	void TestOSCRoundTrip()
+	{
+		uint8_t Buffer[2048];
+		FAugmentaOSCEncoder Encoder(Buffer, sizeof(Buffer));
+		AUGMENTA_CHECK(Encoder.BeginBundle(FAugmentaOSCEncoder::SecondsToTimeTag(12.5)));
+
+		FAugmentaSceneMessage Scene;
+		Scene.Frame = 7;
+		Scene.ObjectCount = 3;
+		Scene.SizeX = 20.f;
+		Scene.SizeY = 10.f;
+		AUGMENTA_CHECK(Encoder.WriteScene(Scene));
+
+		FAugmentaVideoOutputMessage VideoOutput;
+		VideoOutput.SizeX = 20.f;
+		VideoOutput.ResolutionX = 1920;
+		VideoOutput.ResolutionY = 1080;
+		AUGMENTA_CHECK(Encoder.WriteVideoOutput(VideoOutput));
+
+		AUGMENTA_CHECK(Encoder.BeginBundle());
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectEnter, MakeObject(7, 1)));
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectUpdate, MakeObject(7, 2)));
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectLeave, MakeObject(7, 3)));
+		Encoder.EndBundle();
+		AUGMENTA_CHECK(Encoder.WriteObjectExtra(EAugmentaMessageType::ObjectExtraUpdate, MakeExtra(7, 2)));
+		Encoder.EndBundle();
+		AUGMENTA_CHECK(Encoder.GetNumMessages() == 6);
+
+		FAugmentaOSCDecoder Decoder;
+		Decoder.BuildDispatchTable();
+		FRecordingListener Listener;
+		AUGMENTA_CHECK(Decoder.Decode(Encoder.GetData(), Encoder.GetSize(), Listener));
+
+		AUGMENTA_CHECK(Listener.Scenes.size() == 1 && Listener.Scenes[0].Frame == 7 && Listener.Scenes[0].ObjectCount == 3 && Listener.Scenes[0].SizeY == 10.f);
+		AUGMENTA_CHECK(Listener.VideoOutputs.size() == 1 && Listener.VideoOutputs[0].ResolutionX == 1920 && Listener.VideoOutputs[0].ResolutionY == 1080);
+		AUGMENTA_CHECK(Listener.Objects.size() == 3);
+		if (Listener.Objects.size() == 3)
+		{
+			AUGMENTA_CHECK(Listener.ObjectTypes[0] == EAugmentaMessageType::ObjectEnter && Equals(Listener.Objects[0], MakeObject(7, 1)));
+			AUGMENTA_CHECK(Listener.ObjectTypes[1] == EAugmentaMessageType::ObjectUpdate && Equals(Listener.Objects[1], MakeObject(7, 2)));
+			AUGMENTA_CHECK(Listener.ObjectTypes[2] == EAugmentaMessageType::ObjectLeave && Listener.Objects[2].Pid == 3);
+		}
+		AUGMENTA_CHECK(Listener.Extras.size() == 1 && Listener.ExtraTypes[0] == EAugmentaMessageType::ObjectExtraUpdate && Equals(Listener.Extras[0], MakeExtra(7, 2)));
+		AUGMENTA_CHECK(Decoder.GetMessagesDecoded() == 6 && Decoder.GetMalformedPackets() == 0);
+		AUGMENTA_CHECK(Decoder.GetDispatchTableHits() == 6 && Decoder.GetDispatchTableMisses() == 0);
+		AUGMENTA_CHECK(FAugmentaOSCEncoder::TimeTagToSeconds(FAugmentaOSCEncoder::SecondsToTimeTag(12.5)) == 12.5);
+	}
+
+	/** The messages that do not fit are not written, and what was written is still a valid datagram. */
+	void TestOSCFullBuffer()
+	{
+		uint8_t Buffer[512];
+		FAugmentaOSCEncoder Encoder(Buffer, sizeof(Buffer));
+		AUGMENTA_CHECK(Encoder.BeginBundle());
+		int32_t NumWritten = 0;
+		while (Encoder.WriteObject(EAugmentaMessageType::ObjectUpdate, MakeObject(1, NumWritten)))
+		{
+			++NumWritten;
+		}
+		Encoder.EndBundle();
+		AUGMENTA_CHECK(NumWritten > 0 && Encoder.GetSize() <= sizeof(Buffer));
+
+		FAugmentaOSCDecoder Decoder;
+		Decoder.BuildDispatchTable();
+		FRecordingListener Listener;
+		AUGMENTA_CHECK(Decoder.Decode(Encoder.GetData(), Encoder.GetSize(), Listener));
+		AUGMENTA_CHECK(static_cast<int32_t>(Listener.Objects.size()) == NumWritten);
+	}
+
+	/** Truncated and corrupted datagrams are rejected and counted, other OSC messages are ignored. */
+	void TestOSCMalformed()
+	{
+		uint8_t Buffer[256];
+		FAugmentaOSCEncoder Encoder(Buffer, sizeof(Buffer));
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectUpdate, MakeObject(1, 1)));
+
+		FAugmentaOSCDecoder Decoder;
+		Decoder.BuildDispatchTable();
+		FRecordingListener Listener;
+		AUGMENTA_CHECK(!Decoder.Decode(Encoder.GetData(), Encoder.GetSize() - 4, Listener));
+		AUGMENTA_CHECK(!Decoder.Decode(Encoder.GetData(), 3, Listener));
+		AUGMENTA_CHECK(Listener.Objects.empty());
+		AUGMENTA_CHECK(Decoder.GetMalformedPackets() == 2);
+
+		const uint8_t Other[] = { '/', 'f', 'o', 'o', 0, 0, 0, 0, ',', 0, 0, 0 };
+		AUGMENTA_CHECK(Decoder.Decode(Other, sizeof(Other), Listener));
+		AUGMENTA_CHECK(Decoder.GetMessagesIgnored() == 1 && Decoder.GetMessagesDecoded() == 0);
+
+		AUGMENTA_CHECK(FAugmentaOSCDecoder::ClassifyAddress("/object/update", 14) == EAugmentaMessageType::ObjectUpdate);
+		AUGMENTA_CHECK(FAugmentaOSCDecoder::ClassifyAddress("/object/leave/extra", 19) == EAugmentaMessageType::ObjectExtraLeave);
+		AUGMENTA_CHECK(FAugmentaOSCDecoder::ClassifyAddress("/objects", 8) == EAugmentaMessageType::Unknown);
+	}
+
+	/** Every message type survives a binary round trip, whether the packet is aligned or not. */
+	void TestBinaryRoundTrip()
+	{
+		alignas(16) uint8_t Buffer[1400];
+		FAugmentaBinaryEncoder Encoder(Buffer, sizeof(Buffer));
+
+		FAugmentaSceneMessage Scene;
+		Scene.Frame = 9;
+		Scene.ObjectCount = 2;
+		AUGMENTA_CHECK(Encoder.WriteScene(Scene));
+		FAugmentaVideoOutputMessage VideoOutput;
+		VideoOutput.ResolutionX = 640;
+		AUGMENTA_CHECK(Encoder.WriteVideoOutput(VideoOutput));
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectEnter, MakeObject(9, 1)));
+		AUGMENTA_CHECK(Encoder.WriteObject(EAugmentaMessageType::ObjectUpdate, MakeObject(9, 2)));
+		AUGMENTA_CHECK(Encoder.WriteObjectExtra(EAugmentaMessageType::ObjectExtraEnter, MakeExtra(9, 1)));
+		AUGMENTA_CHECK(!Encoder.WriteObject(EAugmentaMessageType::Scene, MakeObject(9, 3)));
+		AUGMENTA_CHECK(Encoder.GetNumMessages() == 5);
+		AUGMENTA_CHECK(FAugmentaBinaryDecoder::IsBinaryPacket(Encoder.GetData(), Encoder.GetSize()));
+		AUGMENTA_CHECK(!FAugmentaBinaryDecoder::IsBinaryPacket(reinterpret_cast<const uint8_t*>("/scene\0\0"), 8));
+
+		FAugmentaBinaryDecoder Decoder;
+		for (size_t Offset : { size_t(0), size_t(1) })
+		{
+			alignas(16) uint8_t Copy[1408];
+			memcpy(Copy + Offset, Encoder.GetData(), Encoder.GetSize());
+
+			FRecordingListener Listener;
+			AUGMENTA_CHECK(Decoder.Decode(Copy + Offset, Encoder.GetSize(), Listener));
+			AUGMENTA_CHECK(Listener.Scenes.size() == 1 && Listener.Scenes[0].Frame == 9 && Listener.Scenes[0].ObjectCount == 2);
+			AUGMENTA_CHECK(Listener.VideoOutputs.size() == 1 && Listener.VideoOutputs[0].ResolutionX == 640);
+			AUGMENTA_CHECK(Listener.Objects.size() == 2);
+			if (Listener.Objects.size() == 2)
+			{
+				AUGMENTA_CHECK(Listener.ObjectTypes[0] == EAugmentaMessageType::ObjectEnter && Equals(Listener.Objects[0], MakeObject(9, 1)));
+				AUGMENTA_CHECK(Listener.ObjectTypes[1] == EAugmentaMessageType::ObjectUpdate && Equals(Listener.Objects[1], MakeObject(9, 2)));
+			}
+			AUGMENTA_CHECK(Listener.Extras.size() == 1 && Listener.ExtraTypes[0] == EAugmentaMessageType::ObjectExtraEnter && Equals(Listener.Extras[0], MakeExtra(9, 1)));
+		}
+		AUGMENTA_CHECK(Decoder.GetRecordsInPlace() > 0);
+
+		// A truncated packet is rejected as a whole
+		FRecordingListener Listener;
+		AUGMENTA_CHECK(!Decoder.Decode(Encoder.GetData(), Encoder.GetSize() - 4, Listener));
+		AUGMENTA_CHECK(Listener.Objects.empty() && Decoder.GetMalformedPackets() == 1);
+	}
+}
+
+int main()
+{
+	using namespace AugmentaProtocolTests;
+
+	TestOSCRoundTrip();
+	TestOSCFullBuffer();
+	TestOSCMalformed();
+	TestBinaryRoundTrip();
+
+	printf("%d checks, %d failed\n", NumChecks, NumFailures);
+	return NumFailures == 0 ? 0 : 1;
+}